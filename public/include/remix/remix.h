@@ -172,6 +172,8 @@ namespace remix {
     Result< remixapi_LightHandle >    CreateLight(const remixapi_LightInfo& info);
     Result< void >                    DestroyLight(remixapi_LightHandle handle);
     Result< void >                    DrawLightInstance(remixapi_LightHandle handle);
+    Result< void >                    DrawInstances(const remixapi_InstanceInfo* infos_values, uint32_t infos_count);
+    Result< void >                    DrawLightInstances(const remixapi_LightHandle* handles_values, uint32_t handles_count);
     Result< void >                    SetConfigVariable(const char* key, const char* value);
 
     // DXVK interoperability
@@ -208,7 +210,7 @@ namespace remix {
         return status;
       }
 
-      static_assert(sizeof(remixapi_Interface) == 168,
+      static_assert(sizeof(remixapi_Interface) == 184,
                     "Change version, update C++ wrapper when adding new functions");
 
       remix::Interface interfaceInCpp = {};
@@ -702,6 +704,14 @@ namespace remix {
     return m_CInterface.DrawLightInstance(handle);
   }
 
+  inline Result< void > Interface::DrawInstances(const remixapi_InstanceInfo* infos_values, uint32_t infos_count) {
+    return m_CInterface.DrawInstances(infos_values, infos_count);
+  }
+
+  inline Result< void > Interface::DrawLightInstances(const remixapi_LightHandle* handles_values, uint32_t handles_count) {
+    return m_CInterface.DrawLightInstances(handles_values, handles_count);
+  }
+
   namespace detail {
     struct dxvk_ExternalSwapchain {
       uint64_t vkImage;
@@ -52,7 +52,7 @@
 
 #define REMIXAPI_VERSION_MAJOR 0
 #define REMIXAPI_VERSION_MINOR 4
-#define REMIXAPI_VERSION_PATCH 1
+#define REMIXAPI_VERSION_PATCH 2
 
 
 // External
@@ -421,6 +421,14 @@ extern "C" {
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawInstance)(
     const remixapi_InstanceInfo* info);
 
+  // Batched version of 'DrawInstance'. Can be called concurrently from multiple threads without
+  // contention: instances are recorded into a buffer of the calling thread, and all buffers are
+  // submitted to the renderer at 'Present'. Meshes referenced by the instances must stay alive
+  // until then.
+  typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawInstances)(
+    const remixapi_InstanceInfo* infos_values,
+    uint32_t                     infos_count);
+
 
 
   typedef struct remixapi_LightInfoLightShaping {
@@ -541,6 +549,11 @@ extern "C" {
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawLightInstance)(
     remixapi_LightHandle      lightHandle);
 
+  // Batched version of 'DrawLightInstance', recorded and submitted like 'DrawInstances'.
+  typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawLightInstances)(
+    const remixapi_LightHandle* lightHandles_values,
+    uint32_t                    lightHandles_count);
+
 
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_SetConfigVariable)(
     const char*               key,
@@ -640,6 +653,11 @@ extern "C" {
 
     PFN_remixapi_Startup            Startup;
     PFN_remixapi_Present            Present;
+
+    // Batched submission, since 0.4.2. Only filled in for clients requesting at least that version,
+    // older clients pass a smaller struct which ends right before these members.
+    PFN_remixapi_DrawInstances      DrawInstances;
+    PFN_remixapi_DrawLightInstances DrawLightInstances;
   } remixapi_Interface;
 
   REMIXAPI remixapi_ErrorCode REMIXAPI_CALL remixapi_InitializeLibrary(
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <sstream>
 #include "../dxvk/imgui/dxvk_imgui.h"
+#include "../dxvk/rtx_render/rtx_hash_collision_detection.h"
 
 #include <charconv>
 
@@ -669,6 +670,8 @@ namespace dxvk {
     } else {
       imageHash = XXH3_64bits(buffer->mapPtr(0), buffer->info().size);
     }
+
+    HashCollisionDetection::registerHashedSourceData(imageHash, buffer->mapPtr(0), buffer->info().size, HashSourceDataCategory::Textures);
     // save hash to dxvkImage
     m_image->setHash(imageHash);
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "d3d9_caps.h"
+// NV-DXVK start: register granular constant dirty tracking
+#include "d3d9_common_buffer.h"
+// NV-DXVK end
 
 #include "../dxvk/dxvk_buffer.h"
 
@@ -10,6 +13,7 @@
 #include "../util/util_vector.h"
 
 #include <cstdint>
+#include <cstring>
 
 namespace dxvk {
 
@@ -49,6 +53,66 @@ namespace dxvk {
     Rc<DxvkBuffer>            buffer;
     DxsoShaderMetaInfo        meta  = {};
     bool                      dirty = true;
+    // NV-DXVK start: register granular constant dirty tracking
+    // Float and int registers whose value changed since the last upload,
+    // a new upload is only needed if the bound shader reads any of them.
+    D3D9Range                 dirtyFloats;
+    D3D9Range                 dirtyInts;
+
+    bool NeedsUpload() {
+      return dirty
+          || dirtyFloats.Overlaps(D3D9Range(0, meta.maxConstIndexF))
+          || dirtyInts.Overlaps(D3D9Range(0, meta.maxConstIndexI));
+    }
+
+    void ClearDirty() {
+      dirty = false;
+      dirtyFloats.Clear();
+      dirtyInts.Clear();
+    }
+    // NV-DXVK end
   };
 
+  // NV-DXVK start: register granular constant dirty tracking
+  /**
+   * \brief Finds the float or int registers an update would change
+   *
+   * Many games set the same constants again for every draw,
+   * those updates do not require a new constant buffer upload.
+   * \param [in] pCurrent Current value of the first register
+   * \param [in] pNew New values of the registers
+   * \param [in] StartRegister Index of the first register
+   * \param [in] Count Number of registers
+   * \returns Registers whose value differs, degenerate if none do
+   */
+  inline D3D9Range FindChangedConstants(
+    const void*    pCurrent,
+    const void*    pNew,
+          uint32_t StartRegister,
+          uint32_t Count) {
+    static_assert(sizeof(Vector4) == sizeof(Vector4i));
+    constexpr size_t RegisterSize = sizeof(Vector4);
+
+    auto current = reinterpret_cast<const uint8_t*>(pCurrent);
+    auto next    = reinterpret_cast<const uint8_t*>(pNew);
+
+    auto changed = [&] (uint32_t i) {
+      return std::memcmp(current + i * RegisterSize, next + i * RegisterSize, RegisterSize) != 0;
+    };
+
+    uint32_t first = 0;
+    while (first < Count && !changed(first))
+      first++;
+
+    if (first == Count)
+      return D3D9Range();
+
+    uint32_t last = Count;
+    while (!changed(last - 1))
+      last--;
+
+    return D3D9Range(StartRegister + first, StartRegister + last);
+  }
+  // NV-DXVK end
+
 }
\ No newline at end of file
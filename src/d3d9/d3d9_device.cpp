@@ -45,6 +45,7 @@
 #include "../dxvk/rtx_render/rtx_context.h"
 #include "../dxvk/rtx_render/rtx_options.h"
 #include "../dxvk/rtx_render/rtx_terrain_baker.h"
+#include "../dxvk/rtx_render/rtx_frame_profiler.h"
 
 #include "d3d9_initializer.h"
 
@@ -121,6 +122,11 @@ namespace dxvk {
 
     m_dxsoOptions = DxsoOptions(this, m_d3d9Options);
 
+    // NV-DXVK start: persistent shader cache
+    if (m_d3d9Options.enableShaderCache && env::getEnvVar("DXVK_SHADER_CACHE") != "0")
+      m_shaderCache = new D3D9ShaderCache(D3D9ShaderCache::GetDefaultFilePath(), uint64_t(m_d3d9Options.shaderCacheMaxSize) << 20);
+    // NV-DXVK end
+
     const bool supportsRobustness2 = m_dxvkDevice->features().extRobustness2.robustBufferAccess2;
     bool useRobustConstantAccess = supportsRobustness2;
     if (useRobustConstantAccess) {
@@ -3643,6 +3649,7 @@ namespace dxvk {
     const RGNDATA* pDirtyRegion,
           DWORD dwFlags) {
     FrameMark;
+    RtxFrameProfiler::onFrameEnd();
     
     HRESULT result = m_implicitSwapchain->Present(
       pSourceRect,
@@ -5269,10 +5276,12 @@ namespace dxvk {
 
     D3D9ConstantSets& constSet = m_consts[DxsoProgramType::VertexShader];
 
-    if (!constSet.dirty)
+    // NV-DXVK start: register granular constant dirty tracking
+    if (!constSet.NeedsUpload())
       return;
 
-    constSet.dirty = false;
+    constSet.ClearDirty();
+    // NV-DXVK end
 
     uint32_t floatCount = m_vsFloatConstsCount;
     if (constSet.meta.needsConstantCopies) {
@@ -5350,10 +5359,12 @@ namespace dxvk {
     */
     D3D9ConstantSets& constSet = m_consts[ShaderStage];
 
-    if (!constSet.dirty)
+    // NV-DXVK start: register granular constant dirty tracking
+    if (!constSet.NeedsUpload())
       return;
 
-    constSet.dirty = false;
+    constSet.ClearDirty();
+    // NV-DXVK end
 
     uint32_t floatCount = ShaderStage == DxsoProgramType::VertexShader ? m_vsFloatConstsCount : m_psFloatConstsCount;
     if (constSet.meta.needsConstantCopies) {
@@ -6800,17 +6811,35 @@ namespace dxvk {
       }
     }
 
+    // NV-DXVK start: register granular constant dirty tracking
     if constexpr (ConstantType != D3D9ConstantType::Bool) {
-      uint32_t maxCount = ConstantType == D3D9ConstantType::Float
-        ? m_consts[ProgramType].meta.maxConstIndexF
-        : m_consts[ProgramType].meta.maxConstIndexI;
+      auto currentData = [&] (const auto& set) -> const void* {
+        if constexpr (ConstantType == D3D9ConstantType::Float)
+          return set.fConsts[StartRegister].data;
+        else
+          return set.iConsts[StartRegister].data;
+      };
 
-      m_consts[ProgramType].dirty |= StartRegister < maxCount;
+      D3D9Range changed = FindChangedConstants(
+        ProgramType == DxsoProgramTypes::VertexShader
+          ? currentData(m_state.vsConsts)
+          : currentData(m_state.psConsts),
+        pConstantData, StartRegister, Count);
+
+      if (changed.IsDegenerate())
+        return D3D_OK;
+
+      // Whether the bound shader reads these registers is checked at upload time
+      if constexpr (ConstantType == D3D9ConstantType::Float)
+        m_consts[ProgramType].dirtyFloats.Conjoin(changed);
+      else
+        m_consts[ProgramType].dirtyInts.Conjoin(changed);
     } else if constexpr (ProgramType == DxsoProgramType::VertexShader) {
       if (unlikely(CanSWVP())) {
         m_consts[DxsoProgramType::VertexShader].dirty |= StartRegister < m_consts[ProgramType].meta.maxConstIndexB;
       }
     }
+    // NV-DXVK end
 
     UpdateStateConstants<ProgramType, ConstantType, T>(
       &m_state,
@@ -25,6 +25,9 @@
 #include "d3d9_swvp_emu.h"
 
 #include "d3d9_shader_permutations.h"
+// NV-DXVK start: persistent shader cache
+#include "d3d9_shader_cache.h"
+// NV-DXVK end
 
 #include <vector>
 #include <type_traits>
@@ -924,6 +927,10 @@ namespace dxvk {
             VkImageLayout            OldLayout,
             VkImageLayout            NewLayout);
 
+    // NV-DXVK start: persistent shader cache
+    D3D9ShaderCache* GetShaderCache() { return m_shaderCache.ptr(); }
+    // NV-DXVK end
+
     const D3D9ConstantLayout& GetVertexConstantLayout() { return m_vsLayout; }
     const D3D9ConstantLayout& GetPixelConstantLayout()  { return m_psLayout; }
 
@@ -1176,6 +1183,9 @@ namespace dxvk {
     Com<D3D9StateBlock, false>      m_recorder;
 
     Rc<D3D9ShaderModuleSet>         m_shaderModules;
+    // NV-DXVK start: persistent shader cache
+    Rc<D3D9ShaderCache>             m_shaderCache;
+    // NV-DXVK end
 
     Rc<DxvkBuffer>                  m_vsClipPlanes;
 
@@ -2685,6 +2685,42 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: persistent shader cache
+  template <typename T>
+  static D3D9CachedShaderModule CompileFFShader(
+          D3D9DeviceEx*         pDevice,
+    const T&                    Key,
+    const DxvkShaderKey&        ShaderKey,
+    const std::string&          Name) {
+    const D3D9FixedFunctionOptions options(pDevice->GetOptions());
+
+    D3D9ShaderCache* pCache = pDevice->GetShaderCache();
+    D3D9CachedShaderModule module;
+    Sha1Hash cacheKey;
+
+    if (pCache != nullptr) {
+      cacheKey = D3D9ShaderCache::ComputeKey(VkShaderStageFlagBits(ShaderKey.type()), ShaderKey.sha1(), options);
+
+      if (pCache->Lookup(cacheKey, module))
+        return module;
+    }
+
+    D3D9FFShaderCompiler compiler(
+      pDevice->GetDXVKDevice(),
+      Key, Name,
+      options);
+
+    module.shaders[D3D9ShaderPermutations::None] = compiler.compile();
+    module.isgn = compiler.isgn();
+
+    if (pCache != nullptr)
+      pCache->Store(cacheKey, module);
+
+    return module;
+  }
+  // NV-DXVK end
+
+
   D3D9FFShader::D3D9FFShader(
           D3D9DeviceEx*         pDevice,
     const D3D9FFShaderKeyVS&    Key) {
@@ -2693,13 +2729,12 @@ namespace dxvk {
 
     std::string name = str::format("FF_", shaderKey.toString());
 
-    D3D9FFShaderCompiler compiler(
-      pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
+    // NV-DXVK start: persistent shader cache
+    D3D9CachedShaderModule module = CompileFFShader(pDevice, Key, shaderKey, name);
 
-    m_shader = compiler.compile();
-    m_isgn   = compiler.isgn();
+    m_shader = module.shaders[D3D9ShaderPermutations::None];
+    m_isgn   = module.isgn;
+    // NV-DXVK end
 
     Dump(Key, name);
 
@@ -2716,13 +2751,12 @@ namespace dxvk {
 
     std::string name = str::format("FF_", shaderKey.toString());
 
-    D3D9FFShaderCompiler compiler(
-      pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
+    // NV-DXVK start: persistent shader cache
+    D3D9CachedShaderModule module = CompileFFShader(pDevice, Key, shaderKey, name);
 
-    m_shader = compiler.compile();
-    m_isgn   = compiler.isgn();
+    m_shader = module.shaders[D3D9ShaderPermutations::None];
+    m_isgn   = module.isgn;
+    // NV-DXVK end
 
     Dump(Key, name);
 
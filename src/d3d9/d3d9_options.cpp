@@ -102,6 +102,10 @@ namespace dxvk {
     this->alphaTestWiggleRoom           = config.getOption<bool>        ("d3d9.alphaTestWiggleRoom",           false);
     this->apitraceMode                  = config.getOption<bool>        ("d3d9.apitraceMode",                  false);
     this->deviceLocalConstantBuffers    = config.getOption<bool>        ("d3d9.deviceLocalConstantBuffers",    false);
+    // NV-DXVK start: persistent shader cache
+    this->enableShaderCache             = config.getOption<bool>        ("d3d9.enableShaderCache",             true);
+    this->shaderCacheMaxSize            = std::max(config.getOption<int32_t>("d3d9.shaderCacheMaxSize", 256), 1);
+    // NV-DXVK end
     this->maxEnabledLights              = config.getOption<int32_t>     ("d3d9.maxEnabledLights",              caps::MaxEnabledLights);
     // NV-DXVK start: adapter override conf
     this->adapterOverride = config.getOption<int32_t>("d3d9.adapterOverride", -1);
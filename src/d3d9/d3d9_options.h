@@ -193,6 +193,14 @@ namespace dxvk {
     /// Use device local memory for constant buffers.
     bool deviceLocalConstantBuffers;
 
+    // NV-DXVK start: persistent shader cache
+    /// Store compiled DXSO and fixed function shaders on disk
+    bool enableShaderCache;
+
+    /// Maximum size of the shader cache file in MiB
+    int32_t shaderCacheMaxSize;
+    // NV-DXVK end
+
     // NV-DXVK start: adapter override conf
     /// Override the adapter/GPU used for D3D9 (-1 = use application defined)
     int adapterOverride;
@@ -11,6 +11,7 @@
 
 #include "../util/util_fastops.h"
 #include "../util/util_math.h"
+#include "../util/log/metrics.h"
 #include "d3d9_rtx_utils.h"
 #include "d3d9_texture.h"
 
@@ -487,6 +488,9 @@ namespace dxvk {
   PrepareDrawFlags D3D9Rtx::internalPrepareDraw(const IndexContext& indexContext, const VertexContext vertexContext[caps::MaxStreams], const DrawContext& drawContext) {
     ScopedCpuProfileZone();
 
+    static MetricCounter& s_drawCalls = Metrics::counter("d3d9_rtx.draw_calls");
+    s_drawCalls.add();
+
     // RTX was injected => treat everything else as rasterized 
     if (m_rtxInjectTriggered) {
       return RtxOptions::Get()->skipDrawCallsPostRTXInjection()
@@ -643,6 +647,10 @@ namespace dxvk {
 
   void D3D9Rtx::CommitGeometryToRT(const DrawContext& drawContext) {
     ScopedCpuProfileZone();
+
+    static MetricCounter& s_committedDrawCalls = Metrics::counter("d3d9_rtx.committed_draw_calls");
+    s_committedDrawCalls.add();
+
     auto drawInfo = m_parent->GenerateDrawInfo(drawContext.PrimitiveType, drawContext.PrimitiveCount, m_parent->GetInstanceCount());
 
     DrawParameters params;
@@ -1099,6 +1107,11 @@ namespace dxvk {
     m_seenCameraPositionsPrev = std::move(m_seenCameraPositions);
 
     m_stagedBonesCount = 0;
+
+    if (m_pGeometryWorkers) {
+      static MetricGauge& s_queueDepth = Metrics::gauge("thread_pool.geometry_processing.queue_depth");
+      s_queueDepth.set(m_pGeometryWorkers->getNumQueuedTasks());
+    }
   }
 
   void D3D9Rtx::OnPresent(const Rc<DxvkImage>& targetImage) {
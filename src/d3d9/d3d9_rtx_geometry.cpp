@@ -5,6 +5,7 @@
 #include "d3d9_state.h"
 #include "../dxvk/dxvk_buffer.h"
 #include "../dxvk/rtx_render/rtx_hashing.h"
+#include "../dxvk/rtx_render/rtx_hash_collision_detection.h"
 #include "../util/util_fastops.h"
 
 namespace dxvk {
@@ -84,6 +85,8 @@ namespace dxvk {
 
       if (globalHashRule.test(HashComponents::Indices)) {
         hashesOut[HashComponents::Indices] = hashContiguousMemory(pIndexData, indexCount * sizeof(T));
+
+        HashCollisionDetection::registerHashedSourceData(hashesOut[HashComponents::Indices], pIndexData, indexCount * sizeof(T), HashSourceDataCategory::GeometryHashes);
       }
 
       // TODO (REMIX-656): Remove this once we can transition content to new hash
@@ -106,6 +109,13 @@ namespace dxvk {
       }
     }
 
+    // Positions are hashed per unique vertex, so their fingerprint is the same hash chain with a different seed
+    const XXH64_hash_t positionHash = hashesOut[HashComponents::VertexPosition];
+    if (globalHashRule.test(HashComponents::VertexPosition) && HashCollisionDetection::isSampled(positionHash)) {
+      const XXH64_hash_t fingerprint = hashVertexRegionIndexed(vertexRegions[VertexRegions::Position], uniqueIndices, HashCollisionDetection::kFingerprintSeed);
+      HashCollisionDetection::registerHashFingerprint(positionHash, fingerprint, HashSourceDataCategory::GeometryHashes);
+    }
+
     // TODO (REMIX-656): Remove this once we can transition content to new hash
     if (globalHashRule.test(HashComponents::LegacyPositions0) || globalHashRule.test(HashComponents::LegacyPositions1)) {
       hashRegionLegacy(vertexRegions[VertexRegions::Position], hashesOut[HashComponents::LegacyPositions0], hashesOut[HashComponents::LegacyPositions1]);
@@ -58,12 +58,33 @@ namespace dxvk {
     const D3D9ConstantLayout& constantLayout = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
       ? pDevice->GetVertexConstantLayout()
       : pDevice->GetPixelConstantLayout();
-    m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
-    m_isgn         = pModule->isgn();
-    // NV-DXVK start: expose shader outputs for vertex capture
-    m_osgn = pModule->osgn();
+    // NV-DXVK start: persistent shader cache
+    D3D9ShaderCache* pCache = pDevice->GetShaderCache();
+    D3D9CachedShaderModule compiled;
+    Sha1Hash cacheKey;
+
+    if (pCache != nullptr)
+      cacheKey = D3D9ShaderCache::ComputeKey(ShaderStage, Key.sha1(), pDxsoModuleInfo->options, constantLayout);
+
+    if (pCache == nullptr || !pCache->Lookup(cacheKey, compiled)) {
+      compiled.shaders         = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
+      compiled.isgn            = pModule->isgn();
+      compiled.osgn            = pModule->osgn();
+      compiled.usedSamplers    = pModule->usedSamplers();
+      compiled.usedRTs         = pModule->usedRTs();
+      compiled.meta            = pModule->meta();
+      compiled.constants       = pModule->constants();
+      compiled.maxDefinedConst = pModule->maxDefinedConstant();
+
+      if (pCache != nullptr)
+        pCache->Store(cacheKey, compiled);
+    }
+
+    m_shaders      = std::move(compiled.shaders);
+    m_isgn         = compiled.isgn;
+    m_osgn         = compiled.osgn;
+    m_usedSamplers = compiled.usedSamplers;
     // NV-DXVK end
-    m_usedSamplers = pModule->usedSamplers();
 
     // Shift up these sampler bits so we can just
     // do an or per-draw in the device.
@@ -71,12 +92,12 @@ namespace dxvk {
     if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
       m_usedSamplers <<= caps::MaxTexturesPS + 1;
 
-    m_usedRTs      = pModule->usedRTs();
+    m_usedRTs      = compiled.usedRTs;
 
     m_info      = pModule->info();
-    m_meta      = pModule->meta();
-    m_constants = pModule->constants();
-    m_maxDefinedConst = pModule->maxDefinedConstant();
+    m_meta      = compiled.meta;
+    m_constants = std::move(compiled.constants);
+    m_maxDefinedConst = compiled.maxDefinedConst;
 
     m_shaders[0]->setShaderKey(Key);
 
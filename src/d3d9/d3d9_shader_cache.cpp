@@ -0,0 +1,578 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "d3d9_shader_cache.h"
+#include "d3d9_fixed_function.h"
+
+#include "../dxvk/rtx_render/rtx_terrain_baker.h"
+#include "../util/xxHash/xxhash.h"
+
+#include <fstream>
+#include <version.h>
+#include <type_traits>
+
+namespace dxvk {
+
+  namespace {
+
+    /**
+     * \brief Identifies the build that produced a cache
+     *
+     * The manual cache version is easily forgotten when the
+     * compilers change, so both the file header and every key
+     * also depend on the version string of the build.
+     */
+    uint64_t getShaderCacheBuildHash() {
+      static const uint64_t s_buildHash = XXH3_64bits(DXVK_VERSION, sizeof(DXVK_VERSION) - 1);
+      return s_buildHash;
+    }
+
+    struct D3D9ShaderCacheHeader {
+      char     magic[4]  = { 'D', 'X', 'S', 'C' };
+      uint32_t version   = D3D9ShaderCacheVersion;
+      uint64_t buildHash = getShaderCacheBuildHash();
+      uint32_t entrySize = 0;
+      uint32_t reserved  = 0;
+    };
+
+    struct D3D9ShaderCacheEntryHeader {
+      Sha1Hash key;
+      uint32_t size;
+      uint64_t checksum;
+    };
+
+    class CacheWriter {
+
+    public:
+
+      CacheWriter(std::vector<uint8_t>& data)
+      : m_data(data) { }
+
+      template<typename T>
+      void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        writeBytes(&value, sizeof(T));
+      }
+
+      template<typename T>
+      void writeVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(uint32_t(values.size()));
+        writeBytes(values.data(), values.size() * sizeof(T));
+      }
+
+      void writeBytes(const void* data, size_t size) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+      }
+
+    private:
+
+      std::vector<uint8_t>& m_data;
+
+    };
+
+    class CacheReader {
+
+    public:
+
+      CacheReader(const std::vector<uint8_t>& data)
+      : m_data(data) { }
+
+      template<typename T>
+      bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return readBytes(&value, sizeof(T));
+      }
+
+      template<typename T>
+      bool readVector(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint32_t count = 0;
+
+        if (!read(count) || count > (m_data.size() - m_offset) / sizeof(T))
+          return false;
+
+        values.resize(count);
+        return readBytes(values.data(), count * sizeof(T));
+      }
+
+      bool readBytes(void* data, size_t size) {
+        if (size > m_data.size() - m_offset)
+          return false;
+
+        std::memcpy(data, m_data.data() + m_offset, size);
+        m_offset += size;
+        return true;
+      }
+
+      bool atEnd() const {
+        return m_offset == m_data.size();
+      }
+
+    private:
+
+      const std::vector<uint8_t>& m_data;
+      size_t                      m_offset = 0;
+
+    };
+
+    void writeKeyCommon(CacheWriter& writer, const char (&tag)[5], VkShaderStageFlagBits stage, const Sha1Hash& sourceHash) {
+      writer.writeBytes(tag, 4);
+      writer.write(D3D9ShaderCacheVersion);
+      writer.write(getShaderCacheBuildHash());
+      writer.write(stage);
+      writer.write(sourceHash);
+    }
+
+    void writeShader(CacheWriter& writer, const Rc<DxvkShader>& shader) {
+      writer.write(uint8_t(shader != nullptr));
+
+      if (shader == nullptr)
+        return;
+
+      const DxvkShaderOptions options = shader->shaderOptions();
+      const DxvkShaderConstData& constData = shader->shaderConstants();
+      const SpirvCompressedBuffer& code = shader->compressedCode();
+
+      writer.write(shader->stage());
+      writer.writeVector(shader->resourceSlots());
+      writer.write(shader->interfaceSlots());
+      writer.write(options.rasterizedStream);
+      writer.write(options.xfbStrides);
+      writer.writeVector(std::vector<uint32_t>(constData.data(), constData.data() + constData.sizeInBytes() / sizeof(uint32_t)));
+      writer.write(code.dwords());
+      writer.writeVector(code.getData());
+    }
+
+    void writeEntry(std::ofstream& file, const Sha1Hash& key, const std::vector<uint8_t>& data) {
+      D3D9ShaderCacheEntryHeader entryHeader;
+      entryHeader.key      = key;
+      entryHeader.size     = uint32_t(data.size());
+      entryHeader.checksum = XXH3_64bits(data.data(), data.size());
+
+      file.write(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader));
+      file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    bool readShader(CacheReader& reader, Rc<DxvkShader>& shader) {
+      uint8_t present = 0;
+
+      if (!reader.read(present))
+        return false;
+
+      if (!present) {
+        shader = nullptr;
+        return true;
+      }
+
+      VkShaderStageFlagBits stage;
+      std::vector<DxvkResourceSlot> slots;
+      DxvkInterfaceSlots iface;
+      DxvkShaderOptions options = { };
+      std::vector<uint32_t> constDwords;
+      uint32_t dwords = 0;
+      std::vector<uint8_t> codeBytes;
+
+      if (!reader.read(stage)
+       || !reader.readVector(slots)
+       || !reader.read(iface)
+       || !reader.read(options.rasterizedStream)
+       || !reader.read(options.xfbStrides)
+       || !reader.readVector(constDwords)
+       || !reader.read(dwords)
+       || !reader.readVector(codeBytes))
+        return false;
+
+      SpirvCompressedBuffer code(dwords, std::move(codeBytes));
+
+      if (!code.isValid())
+        return false;
+
+      shader = new DxvkShader(stage,
+        slots.size(), slots.data(), iface,
+        code.decompress(), options,
+        DxvkShaderConstData(constDwords.size(), constDwords.data()));
+      return true;
+    }
+
+  }
+
+
+  D3D9ShaderCache::D3D9ShaderCache(const std::string& filePath, uint64_t maxFileSize)
+  : m_filePath(filePath), m_maxFileSize(maxFileSize) {
+    m_readerThread = dxvk::thread([this] () { readerFunc(); });
+    m_writerThread = dxvk::thread([this] () { writerFunc(); });
+  }
+
+
+  D3D9ShaderCache::~D3D9ShaderCache() {
+    m_readerThread.join();
+
+    { std::lock_guard<dxvk::mutex> lock(m_writerLock);
+      m_stopWriter = true;
+      m_writerCond.notify_all();
+    }
+
+    m_writerThread.join();
+
+    Logger::info(str::format("D3D9: Shader cache: ", m_numHits.load(), " hits, ", m_numMisses.load(), " misses"));
+  }
+
+
+  std::string D3D9ShaderCache::GetDefaultFilePath() {
+    std::string path = env::getEnvVar("DXVK_SHADER_CACHE_PATH");
+
+    if (!path.empty()) {
+      if (*path.rbegin() != '/')
+        path += '/';
+
+      env::createDirectory(path);
+    }
+
+    return path + env::getExeBaseName() + ".dxvk-shaders";
+  }
+
+
+  Sha1Hash D3D9ShaderCache::ComputeKey(
+          VkShaderStageFlagBits     Stage,
+    const Sha1Hash&                 BytecodeHash,
+    const DxsoOptions&              Options,
+    const D3D9ConstantLayout&       Layout) {
+    std::vector<uint8_t> data;
+    CacheWriter writer(data);
+
+    writeKeyCommon(writer, "DXSO", Stage, BytecodeHash);
+
+    // Options are written field by field so that struct padding never ends up in the key
+    writer.write(Options.useDemoteToHelperInvocation);
+    writer.write(Options.useSubgroupOpsForEarlyDiscard);
+    writer.write(Options.strictConstantCopies);
+    writer.write(Options.d3d9FloatEmulation);
+    writer.write(Options.strictPow);
+    writer.write(Options.shaderModel);
+    writer.write(Options.invariantPosition);
+    writer.write(Options.forceSamplerTypeSpecConstants);
+    writer.write(Options.vertexFloatConstantBufferAsSSBO);
+    writer.write(Options.longMad);
+    writer.write(Options.alphaTestWiggleRoom);
+    writer.write(Options.robustness2Supported);
+
+    writer.write(Layout.floatCount);
+    writer.write(Layout.intCount);
+    writer.write(Layout.boolCount);
+    writer.write(Layout.bitmaskCount);
+
+    writer.write(TerrainBaker::Material::replacementSupportInPS_programmableShaders());
+
+    return Sha1Hash::compute(data.data(), data.size());
+  }
+
+
+  Sha1Hash D3D9ShaderCache::ComputeKey(
+          VkShaderStageFlagBits     Stage,
+    const Sha1Hash&                 FFKeyHash,
+    const D3D9FixedFunctionOptions& Options) {
+    std::vector<uint8_t> data;
+    CacheWriter writer(data);
+
+    writeKeyCommon(writer, "FFSH", Stage, FFKeyHash);
+
+    writer.write(Options.invariantPosition);
+
+    writer.write(TerrainBaker::Material::replacementSupportInPS_fixedFunction());
+
+    return Sha1Hash::compute(data.data(), data.size());
+  }
+
+
+  bool D3D9ShaderCache::Lookup(const Sha1Hash& Key, D3D9CachedShaderModule& Module) {
+    // Never wait for the cache file, compiling is what we'd be doing without a cache anyways
+    if (!m_loaded.load()) {
+      m_numMisses++;
+      return false;
+    }
+
+    std::vector<uint8_t> data;
+
+    { std::lock_guard<dxvk::mutex> lock(m_entryLock);
+      auto entry = m_entries.find(Key);
+
+      if (entry == m_entries.end()) {
+        m_numMisses++;
+        return false;
+      }
+
+      data = entry->second;
+      m_usedKeys.insert(Key);
+    }
+
+    if (!Deserialize(data, Module)) {
+      Logger::warn(str::format("D3D9: Invalid shader cache entry ", Key.toString()));
+      m_numMisses++;
+      return false;
+    }
+
+    m_numHits++;
+    return true;
+  }
+
+
+  void D3D9ShaderCache::Store(const Sha1Hash& Key, const D3D9CachedShaderModule& Module) {
+    for (const auto& shader : Module.shaders) {
+      // Descriptor set layouts are device objects and can't be persisted
+      if (shader != nullptr && !shader->shaderOptions().extraLayouts.empty())
+        return;
+    }
+
+    WriterItem item;
+    item.key = Key;
+    Serialize(Module, item.data);
+
+    { std::lock_guard<dxvk::mutex> lock(m_entryLock);
+      m_usedKeys.insert(Key);
+
+      if (!m_entries.insert({ Key, item.data }).second)
+        return;
+    }
+
+    { std::lock_guard<dxvk::mutex> lock(m_writerLock);
+      m_writerQueue.push(std::move(item));
+      m_writerCond.notify_one();
+    }
+  }
+
+
+  void D3D9ShaderCache::Serialize(
+    const D3D9CachedShaderModule& Module,
+          std::vector<uint8_t>&   Data) {
+    CacheWriter writer(Data);
+
+    writer.write(Module.isgn);
+    writer.write(Module.osgn);
+    writer.write(Module.usedSamplers);
+    writer.write(Module.usedRTs);
+    writer.write(Module.meta);
+    writer.writeVector(Module.constants);
+    writer.write(Module.maxDefinedConst);
+
+    writer.write(uint32_t(Module.shaders.size()));
+
+    for (const auto& shader : Module.shaders)
+      writeShader(writer, shader);
+  }
+
+
+  bool D3D9ShaderCache::Deserialize(
+    const std::vector<uint8_t>&   Data,
+          D3D9CachedShaderModule& Module) {
+    CacheReader reader(Data);
+    uint32_t numShaders = 0;
+
+    if (!reader.read(Module.isgn)
+     || !reader.read(Module.osgn)
+     || !reader.read(Module.usedSamplers)
+     || !reader.read(Module.usedRTs)
+     || !reader.read(Module.meta)
+     || !reader.readVector(Module.constants)
+     || !reader.read(Module.maxDefinedConst)
+     || !reader.read(numShaders)
+     || numShaders != Module.shaders.size())
+      return false;
+
+    for (auto& shader : Module.shaders) {
+      if (!readShader(reader, shader))
+        return false;
+    }
+
+    return reader.atEnd();
+  }
+
+
+  void D3D9ShaderCache::readerFunc() {
+    env::setThreadName("dxvk-shader-cache");
+
+    EntryMap entries;
+    bool rewriteFile = true;
+    uint64_t fileSize = 0;
+
+    std::ifstream file(str::tows(m_filePath.c_str()).c_str(), std::ios_base::binary);
+    D3D9ShaderCacheHeader expected;
+    expected.entrySize = sizeof(D3D9ShaderCacheEntryHeader);
+    D3D9ShaderCacheHeader header;
+
+    if (!file) {
+      Logger::info(str::format("D3D9: No shader cache found at ", m_filePath));
+    } else if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(&header, &expected, sizeof(header))) {
+      Logger::warn("D3D9: Shader cache out of date, discarding");
+    } else {
+      rewriteFile = false;
+      fileSize = sizeof(header);
+
+      D3D9ShaderCacheEntryHeader entryHeader;
+
+      while (file.read(reinterpret_cast<char*>(&entryHeader), sizeof(entryHeader))) {
+        std::vector<uint8_t> data(entryHeader.size);
+
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size())
+         || XXH3_64bits(data.data(), data.size()) != entryHeader.checksum) {
+          // Most likely a write was interrupted. Keep what we have and
+          // rewrite the file without the broken tail.
+          Logger::warn("D3D9: Corrupted shader cache entry, discarding the remainder");
+          rewriteFile = true;
+          break;
+        }
+
+        fileSize += sizeof(entryHeader) + data.size();
+        entries.insert({ entryHeader.key, std::move(data) });
+      }
+
+      Logger::info(str::format("D3D9: Read ", entries.size(), " shader cache entries"));
+    }
+
+    file.close();
+
+    { std::lock_guard<dxvk::mutex> lock(m_entryLock);
+      // Modules compiled while we were loading are already queued for writing
+      for (auto& entry : entries)
+        m_entries.insert(std::move(entry));
+    }
+
+    { std::lock_guard<dxvk::mutex> lock(m_writerLock);
+      m_rewriteFile = rewriteFile;
+      m_fileSize = fileSize;
+      m_loaded.store(true);
+      m_writerCond.notify_one();
+    }
+  }
+
+
+  void D3D9ShaderCache::writerFunc() {
+    env::setThreadName("dxvk-shader-cache-writer");
+
+    std::ofstream file;
+
+    { std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+      // Appending is only safe once the reader is done with the file
+      m_writerCond.wait(lock, [this] () {
+        return m_loaded.load() || m_stopWriter;
+      });
+
+      if (!m_loaded.load())
+        return;
+
+      if (m_rewriteFile) {
+        rewriteFile(file, false);
+      } else {
+        file.open(str::tows(m_filePath.c_str()).c_str(), std::ios_base::binary | std::ios_base::app);
+      }
+    }
+
+    if (!file) {
+      Logger::warn(str::format("D3D9: Failed to open shader cache file ", m_filePath));
+      return;
+    }
+
+    // Set once the modules used by this run alone don't fit into the size limit
+    bool full = false;
+
+    while (true) {
+      WriterItem item;
+
+      { std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+        m_writerCond.wait(lock, [this] () {
+          return !m_writerQueue.empty()
+              || m_stopWriter;
+        });
+
+        // Unlike the state cache, drain the queue on shutdown so that
+        // shaders compiled right before exiting are not lost
+        if (m_writerQueue.empty()) {
+          // The file may have been loaded above the limit, e.g. after the limit was lowered
+          if (!full && m_fileSize > m_maxFileSize)
+            rewriteFile(file, true);
+          break;
+        }
+
+        item = std::move(m_writerQueue.front());
+        m_writerQueue.pop();
+
+        const uint64_t entrySize = sizeof(D3D9ShaderCacheEntryHeader) + item.data.size();
+
+        if (m_fileSize + entrySize > m_maxFileSize) {
+          if (!full) {
+            // The item is a used module in the entry map, so the rewrite includes it if it fits
+            full = !rewriteFile(file, true);
+
+            if (full)
+              Logger::warn(str::format("D3D9: Shader cache reached its size limit, no longer adding shaders to ", m_filePath));
+          }
+          continue;
+        }
+
+        m_fileSize += entrySize;
+      }
+
+      writeEntry(file, item.key, item.data);
+      file.flush();
+    }
+  }
+
+
+  bool D3D9ShaderCache::rewriteFile(std::ofstream& file, bool usedOnly) {
+    file.close();
+    file.open(str::tows(m_filePath.c_str()).c_str(), std::ios_base::binary | std::ios_base::trunc);
+
+    D3D9ShaderCacheHeader header;
+    header.entrySize = sizeof(D3D9ShaderCacheEntryHeader);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_fileSize = sizeof(header);
+
+    // Every queued module is already in the entry map, so writing out
+    // the map covers both valid entries of the old file and the queue
+    std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+    bool complete = true;
+
+    for (const auto& entry : m_entries) {
+      if (usedOnly && m_usedKeys.find(entry.first) == m_usedKeys.end())
+        continue;
+
+      const uint64_t entrySize = sizeof(D3D9ShaderCacheEntryHeader) + entry.second.size();
+
+      if (m_fileSize + entrySize > m_maxFileSize) {
+        complete = false;
+        continue;
+      }
+
+      writeEntry(file, entry.first, entry.second);
+      m_fileSize += entrySize;
+    }
+
+    file.flush();
+    m_writerQueue = std::queue<WriterItem>();
+    return complete;
+  }
+
+}
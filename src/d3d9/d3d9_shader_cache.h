@@ -0,0 +1,210 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "d3d9_constant_layout.h"
+#include "d3d9_shader_permutations.h"
+
+#include "../dxso/dxso_isgn.h"
+#include "../dxso/dxso_options.h"
+
+#include "../dxvk/dxvk_shader.h"
+
+#include "../util/sha1/sha1_util.h"
+#include "../util/thread.h"
+
+namespace dxvk {
+
+  struct D3D9FixedFunctionOptions;
+
+  /**
+   * \brief Shader cache version
+   *
+   * Must be bumped whenever the output of the DXSO or
+   * fixed function compilers, or the serialized layout
+   * of cached modules changes. Entries written by a
+   * different version or a different build (see the
+   * DXVK version string) are discarded on load.
+   */
+  constexpr uint32_t D3D9ShaderCacheVersion = 2;
+
+  /**
+   * \brief Cached shader module
+   *
+   * Everything a D3D9 shader object needs from the compiler,
+   * i.e. the compiled permutations plus the interface info
+   * gathered while compiling. Fixed function shaders only
+   * use the first permutation and the input signature.
+   */
+  struct D3D9CachedShaderModule {
+    DxsoIsgn              isgn;
+    DxsoIsgn              osgn;
+    uint32_t              usedSamplers    = 0;
+    uint32_t              usedRTs         = 0;
+    DxsoShaderMetaInfo    meta;
+    DxsoDefinedConstants  constants;
+    uint32_t              maxDefinedConst = 0;
+    DxsoPermutations      shaders = { };
+  };
+
+  struct D3D9ShaderCacheKeyHash {
+    size_t operator () (const Sha1Hash& key) const {
+      return size_t(key.dword(0)) | (size_t(key.dword(1)) << 32);
+    }
+  };
+
+  /**
+   * \brief Persistent DXSO to SPIR-V cache
+   *
+   * Content addressed: entries are keyed by a hash of the shader
+   * source (DXSO bytecode or fixed function key), the compile
+   * options, the constant layout, the cache version and the build
+   * version string, so stale entries are simply never looked up
+   * again.
+   *
+   * The cache file is loaded on a worker thread. Lookups never wait
+   * for it, shaders requested before the file is loaded are compiled
+   * as usual. Newly compiled modules are appended to the file by a
+   * writer thread. Once the file would grow past its size limit, it
+   * is rewritten with only the modules used by this run, and nothing
+   * more is written if those alone don't fit. This class is
+   * thread-safe.
+   */
+  class D3D9ShaderCache : public RcObject {
+
+  public:
+
+    D3D9ShaderCache(const std::string& filePath, uint64_t maxFileSize);
+
+    ~D3D9ShaderCache();
+
+    /**
+     * \brief Default cache file path
+     *
+     * Stored next to the executable unless
+     * \c DXVK_SHADER_CACHE_PATH is set.
+     */
+    static std::string GetDefaultFilePath();
+
+    /**
+     * \brief Computes the cache key of a DXSO shader
+     *
+     * \param [in] Stage Shader stage
+     * \param [in] BytecodeHash Hash of the DXSO bytecode
+     * \param [in] Options Compile options
+     * \param [in] Layout Constant buffer layout
+     */
+    static Sha1Hash ComputeKey(
+            VkShaderStageFlagBits     Stage,
+      const Sha1Hash&                 BytecodeHash,
+      const DxsoOptions&              Options,
+      const D3D9ConstantLayout&       Layout);
+
+    /**
+     * \brief Computes the cache key of a fixed function shader
+     *
+     * \param [in] Stage Shader stage
+     * \param [in] FFKeyHash Hash of the fixed function shader key
+     * \param [in] Options Compile options
+     */
+    static Sha1Hash ComputeKey(
+            VkShaderStageFlagBits     Stage,
+      const Sha1Hash&                 FFKeyHash,
+      const D3D9FixedFunctionOptions& Options);
+
+    /**
+     * \brief Looks up a cached module
+     *
+     * \param [in] Key Cache key
+     * \param [out] Module Restored module, shader objects are newly created
+     * \returns \c true if the module was found and is valid
+     */
+    bool Lookup(const Sha1Hash& Key, D3D9CachedShaderModule& Module);
+
+    /**
+     * \brief Adds a newly compiled module to the cache
+     *
+     * Serializes the module and queues it for writing. Has no
+     * effect if the key is already cached.
+     * \param [in] Key Cache key
+     * \param [in] Module Compiled module
+     */
+    void Store(const Sha1Hash& Key, const D3D9CachedShaderModule& Module);
+
+    static void Serialize(
+      const D3D9CachedShaderModule& Module,
+            std::vector<uint8_t>&   Data);
+
+    static bool Deserialize(
+      const std::vector<uint8_t>&   Data,
+            D3D9CachedShaderModule& Module);
+
+  private:
+
+    struct WriterItem {
+      Sha1Hash             key;
+      std::vector<uint8_t> data;
+    };
+
+    using EntryMap = std::unordered_map<Sha1Hash, std::vector<uint8_t>, D3D9ShaderCacheKeyHash>;
+
+    using KeySet = std::unordered_set<Sha1Hash, D3D9ShaderCacheKeyHash>;
+
+    std::string               m_filePath;
+    uint64_t                  m_maxFileSize;
+
+    dxvk::mutex               m_entryLock;
+    EntryMap                  m_entries;
+    // Modules looked up or stored by this run, the ones kept when compacting
+    KeySet                    m_usedKeys;
+    std::atomic<bool>         m_loaded = { false };
+
+    std::atomic<uint32_t>     m_numHits   = { 0u };
+    std::atomic<uint32_t>     m_numMisses = { 0u };
+
+    dxvk::mutex               m_writerLock;
+    dxvk::condition_variable  m_writerCond;
+    std::queue<WriterItem>    m_writerQueue;
+    bool                      m_stopWriter = false;
+    // Set by the reader when the file is missing, outdated or corrupted
+    bool                      m_rewriteFile = false;
+    uint64_t                  m_fileSize = 0;
+
+    dxvk::thread              m_readerThread;
+    dxvk::thread              m_writerThread;
+
+    void readerFunc();
+
+    void writerFunc();
+
+    bool rewriteFile(std::ofstream& file, bool usedOnly);
+
+  };
+
+}
@@ -1,6 +1,10 @@
 #include "dxvk_cs.h"
 #include "dxvk_scoped_annotation.h"
 
+// NV-DXVK start: per-thread chunk caches
+#include <unordered_map>
+// NV-DXVK end
+
 // NV-DXVK start: notify user and kill process on exception in CS thread to avoid silent hangs
 #include "rtx_render/rtx_env.h"
 // NV-DXVK end
@@ -64,12 +68,82 @@ namespace dxvk {
   }
   
   
-  DxvkCsChunkPool::DxvkCsChunkPool() {
-    
+  // NV-DXVK start: per-thread chunk caches
+  namespace {
+    constexpr uint32_t CsChunkCacheSize  = 16;
+    constexpr uint32_t CsChunkCacheBatch = CsChunkCacheSize / 2;
+
+    std::atomic<uint64_t> g_nextCsChunkPoolId = { 1ull };
+
+    // Pools that are still alive, so that thread caches
+    // know whether they can return chunks to their pool
+    dxvk::mutex g_csChunkPoolMutex;
+    std::unordered_map<uint64_t, DxvkCsChunkPool*> g_csChunkPools;
+  }
+
+
+  struct DxvkCsChunkPool::ThreadCache {
+    uint64_t      poolId = 0;
+    uint32_t      count  = 0;
+    DxvkCsChunk*  chunks[CsChunkCacheSize];
+
+    ~ThreadCache() {
+      attach(0);
+    }
+
+    void attach(uint64_t id) {
+      if (count) {
+        std::lock_guard<dxvk::mutex> lock(g_csChunkPoolMutex);
+        auto entry = g_csChunkPools.find(poolId);
+
+        if (entry != g_csChunkPools.end()) {
+          DxvkCsChunkPool* pool = entry->second;
+
+          std::lock_guard<sync::Spinlock> poolLock(pool->m_mutex);
+          pool->m_chunks.insert(pool->m_chunks.end(), chunks, chunks + count);
+        } else {
+          for (uint32_t i = 0; i < count; i++)
+            delete chunks[i];
+        }
+
+        count = 0;
+      }
+
+      poolId = id;
+    }
+  };
+
+
+  DxvkCsChunkPool::ThreadCache& DxvkCsChunkPool::getThreadCache() {
+    thread_local ThreadCache t_cache;
+    return t_cache;
+  }
+  // NV-DXVK end
+
+
+  DxvkCsChunkPool::DxvkCsChunkPool()
+  // NV-DXVK start: per-thread chunk caches
+  : m_id(g_nextCsChunkPoolId++) {
+    std::lock_guard<dxvk::mutex> lock(g_csChunkPoolMutex);
+    g_csChunkPools.emplace(m_id, this);
+    // NV-DXVK end
   }
   
   
   DxvkCsChunkPool::~DxvkCsChunkPool() {
+    // NV-DXVK start: per-thread chunk caches
+    { std::lock_guard<dxvk::mutex> lock(g_csChunkPoolMutex);
+      g_csChunkPools.erase(m_id);
+    }
+
+    // Caches of other threads delete their chunks once
+    // they move on to another pool or the thread exits
+    ThreadCache& cache = getThreadCache();
+
+    if (cache.poolId == m_id)
+      cache.attach(0);
+    // NV-DXVK end
+
     for (DxvkCsChunk* chunk : m_chunks)
       delete chunk;
   }
@@ -78,13 +152,24 @@ namespace dxvk {
   DxvkCsChunk* DxvkCsChunkPool::allocChunk(DxvkCsChunkFlags flags) {
     DxvkCsChunk* chunk = nullptr;
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+    // NV-DXVK start: per-thread chunk caches
+    ThreadCache& cache = getThreadCache();
+
+    if (unlikely(cache.poolId != m_id))
+      cache.attach(m_id);
+
+    if (!cache.count) {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
       
-      if (m_chunks.size() != 0) {
-        chunk = m_chunks.back();
-        m_chunks.pop_back();
-      }
+      uint32_t count = std::min<uint32_t>(m_chunks.size(), CsChunkCacheBatch);
+      std::copy(m_chunks.end() - count, m_chunks.end(), cache.chunks);
+      m_chunks.resize(m_chunks.size() - count);
+      cache.count = count;
     }
+
+    if (cache.count)
+      chunk = cache.chunks[--cache.count];
+    // NV-DXVK end
     
     if (!chunk)
       chunk = new DxvkCsChunk();
@@ -97,8 +182,23 @@ namespace dxvk {
   void DxvkCsChunkPool::freeChunk(DxvkCsChunk* chunk) {
     chunk->reset();
     
-    std::lock_guard<sync::Spinlock> lock(m_mutex);
-    m_chunks.push_back(chunk);
+    // NV-DXVK start: per-thread chunk caches
+    ThreadCache& cache = getThreadCache();
+
+    if (unlikely(cache.poolId != m_id))
+      cache.attach(m_id);
+
+    if (cache.count == CsChunkCacheSize) {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+      cache.count -= CsChunkCacheBatch;
+      m_chunks.insert(m_chunks.end(),
+        cache.chunks + cache.count,
+        cache.chunks + cache.count + CsChunkCacheBatch);
+    }
+
+    cache.chunks[cache.count++] = chunk;
+    // NV-DXVK end
   }
   
   
@@ -112,11 +212,10 @@ namespace dxvk {
   
   
   DxvkCsThread::~DxvkCsThread() {
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      m_stopped.store(true);
-    }
-    
-    m_condOnAdd.notify_one();
+    // NV-DXVK start: lock-free CS chunk submission
+    m_stopped.store(true);
+    m_eventOnAdd.notify();
+    // NV-DXVK end
     m_thread.join();
   }
   
@@ -124,42 +223,52 @@ namespace dxvk {
   uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
     ScopedCpuProfileZone();
 
-    uint64_t seq;
+    // NV-DXVK start: lock-free CS chunk submission
+    uint64_t pos;
 
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      seq = ++m_chunksDispatched;
-      m_chunksQueued.push(std::move(chunk));
+    while (unlikely(!m_chunksQueued.push(std::move(chunk), pos))) {
+      // The queue only rejects the chunk when it is full,
+      // so wait for the CS thread to retire at least one
+      waitForChunks(m_chunksExecuted.load(std::memory_order_acquire) + 1);
     }
     
-    m_condOnAdd.notify_one();
-    return seq;
+    m_eventOnAdd.notify();
+    return pos + 1;
+    // NV-DXVK end
   }
   
   
   void DxvkCsThread::synchronize(uint64_t seq) {
     ScopedCpuProfileZone();
 
-    // Avoid locking if we know the sync is a no-op, may
+    // NV-DXVK start: lock-free CS chunk submission
+    if (seq == SynchronizeAll)
+      seq = m_chunksQueued.getPushCount();
+
+    // Avoid waiting if we know the sync is a no-op, may
     // reduce overhead if this is being called frequently
     if (seq > m_chunksExecuted.load(std::memory_order_acquire)) {
-      std::unique_lock<dxvk::mutex> lock(m_mutex);
-
-      if (seq == SynchronizeAll)
-        seq = m_chunksDispatched.load();
-
       auto t0 = dxvk::high_resolution_clock::now();
-      m_condOnSync.wait(lock, [this, seq] {
-        return m_chunksExecuted.load() >= seq;
-      });
+      waitForChunks(seq);
       auto t1 = dxvk::high_resolution_clock::now();
       auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
 
       m_device->addStatCtr(DxvkStatCounter::CsSyncCount, 1);
       m_device->addStatCtr(DxvkStatCounter::CsSyncTicks, ticks.count());
     }
+    // NV-DXVK end
   }
   
   
+  // NV-DXVK start: lock-free CS chunk submission
+  void DxvkCsThread::waitForChunks(uint64_t seq) {
+    m_eventOnSync.wait([this, seq] {
+      return m_chunksExecuted.load(std::memory_order_acquire) >= seq;
+    });
+  }
+  // NV-DXVK end
+
+
   void DxvkCsThread::threadFunc() {
     ScopedCpuProfileZone();
 
@@ -169,31 +278,23 @@ namespace dxvk {
 
     try {
       while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
-          if (chunk) {
-            m_chunksExecuted++;
-            m_condOnSync.notify_one();
-            
-            chunk = DxvkCsChunkRef();
-          }
-          
-          if (m_chunksQueued.size() == 0) {
-            m_condOnAdd.wait(lock, [this] {
-              return (m_chunksQueued.size() != 0)
-                  || (m_stopped.load());
-            });
-          }
-          
-          if (m_chunksQueued.size() != 0) {
-            chunk = std::move(m_chunksQueued.front());
-            m_chunksQueued.pop();
-          }
+        // NV-DXVK start: lock-free CS chunk submission
+        if (!m_chunksQueued.pop(chunk)) {
+          m_eventOnAdd.wait([this] {
+            return !m_chunksQueued.isEmpty()
+                || m_stopped.load();
+          });
+
+          continue;
         }
         
-        if (chunk) {
-          m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
-          chunk->executeAll(m_context.ptr());
-        }
+        m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
+        chunk->executeAll(m_context.ptr());
+        chunk = DxvkCsChunkRef();
+
+        m_chunksExecuted.fetch_add(1, std::memory_order_release);
+        m_eventOnSync.notify();
+        // NV-DXVK end
       }
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
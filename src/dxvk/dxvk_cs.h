@@ -6,6 +6,10 @@
 #include <queue>
 
 #include "../util/thread.h"
+// NV-DXVK start: lock-free CS chunk submission
+#include "../util/util_atomic_queue.h"
+#include "../util/sync/sync_adaptive_event.h"
+// NV-DXVK end
 
 #include "dxvk_device.h"
 #include "dxvk_context.h"
@@ -286,6 +290,18 @@ namespace dxvk {
     
   private:
     
+    // NV-DXVK start: per-thread chunk caches
+    // Each thread keeps a small cache of free chunks for the pool it
+    // used last, so that allocating and freeing chunks usually does not
+    // touch the shared list. Caches exchange chunks with the shared list
+    // in batches, which covers chunks being recorded on one thread and
+    // released on the CS thread.
+    struct ThreadCache;
+
+    const uint64_t            m_id;
+
+    static ThreadCache& getThreadCache();
+    // NV-DXVK end
     sync::Spinlock            m_mutex;
     std::vector<DxvkCsChunk*> m_chunks;
     
@@ -422,20 +438,27 @@ namespace dxvk {
 
   private:
     
+    // NV-DXVK start: lock-free CS chunk submission
+    // Maximum number of chunks in flight. Producers wait
+    // for the CS thread to catch up once this is reached.
+    constexpr static uint32_t MaxChunksInFlight = 4096;
+
     Rc<DxvkDevice>              m_device;
     Rc<DxvkContext>             m_context;
 
-    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    alignas(64)
     std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
     
     std::atomic<bool>           m_stopped = { false };
-    dxvk::mutex                 m_mutex;
-    dxvk::condition_variable    m_condOnAdd;
-    dxvk::condition_variable    m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
+    sync::AdaptiveEvent         m_eventOnAdd;
+    sync::AdaptiveEvent         m_eventOnSync;
+    AtomicMpscQueue<DxvkCsChunkRef, MaxChunksInFlight> m_chunksQueued;
     dxvk::thread                m_thread;
     
+    void waitForChunks(uint64_t seq);
+
     void threadFunc();
+    // NV-DXVK end
     
   };
   
@@ -5,9 +5,15 @@
 #include "dxvk_include.h"
 #include "../tracy/Tracy.hpp"
 #include "../tracy/TracyVulkan.hpp"
+#include "../util/util_frame_profiler.h"
 
+#define __FrameProfilerConcatImpl(a, b) a##b
+#define __FrameProfilerConcat(a, b) __FrameProfilerConcatImpl(a, b)
+
+// Note: Zones are recorded by Tracy when it is compiled in, and by the built-in frame profiler when it is active.
 #define ScopedCpuProfileZoneN(name) \
-        ZoneScopedN(name)
+        ZoneScopedN(name); \
+        ::dxvk::FrameProfilerZone __FrameProfilerConcat(__frameProfilerZone, __LINE__)(name)
 
 #define ScopedCpuProfileZone() \
         ScopedCpuProfileZoneN(__FUNCTION__)
@@ -57,10 +57,22 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: create modules from plain code pointers
   DxvkShaderModule::DxvkShaderModule(
     const Rc<vk::DeviceFn>&     vkd,
     const Rc<DxvkShader>&       shader,
     const SpirvCodeBuffer&      code)
+  : DxvkShaderModule(vkd, shader, code.data(), code.dwords()) {
+
+  }
+
+
+  DxvkShaderModule::DxvkShaderModule(
+    const Rc<vk::DeviceFn>&     vkd,
+    const Rc<DxvkShader>&       shader,
+    const uint32_t*             code,
+          size_t                dwords)
+  // NV-DXVK end
   : m_vkd(vkd), m_stage() {
     ScopedCpuProfileZone();
     m_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -75,8 +87,10 @@ namespace dxvk {
     info.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     info.pNext    = nullptr;
     info.flags    = 0;
-    info.codeSize = code.size();
-    info.pCode    = code.data();
+    // NV-DXVK start: create modules from plain code pointers
+    info.codeSize = dwords * sizeof(uint32_t);
+    info.pCode    = code;
+    // NV-DXVK end
     
     if (m_vkd->vkCreateShaderModule(m_vkd->device(), &info, nullptr, &m_stage.module) != VK_SUCCESS)
       throw DxvkError("DxvkComputePipeline::DxvkComputePipeline: Failed to create shader module");
@@ -176,8 +190,13 @@ namespace dxvk {
     const Rc<vk::DeviceFn>&          vkd,
     const DxvkDescriptorSlotMapping& mapping,
     const DxvkShaderModuleCreateInfo& info) {
-    SpirvCodeBuffer spirvCode = m_code.decompress();
-    uint32_t* code = spirvCode.data();
+    // NV-DXVK start: decode into a reusable per-thread buffer
+    // Modules are created on the pipeline compiler threads, which
+    // keeps the scratch buffer warm for the next module to create.
+    static thread_local std::vector<uint32_t> s_scratch;
+    m_code.decompress(s_scratch);
+    uint32_t* code = s_scratch.data();
+    // NV-DXVK end
     
     // Remap resource binding IDs
     for (uint32_t ofs : m_idOffsets) {
@@ -190,6 +209,13 @@ namespace dxvk {
     if (info.fsDualSrcBlend && m_o1IdxOffset && m_o1LocOffset)
       std::swap(code[m_o1IdxOffset], code[m_o1LocOffset]);
     
+    // NV-DXVK start: only copy the code if it needs to be rewritten
+    if (!info.undefinedInputs)
+      return DxvkShaderModule(vkd, this, code, s_scratch.size());
+
+    SpirvCodeBuffer spirvCode(s_scratch.size(), code);
+    // NV-DXVK end
+
     // Replace undefined input variables with zero
     for (uint32_t u : bit::BitMask(info.undefinedInputs))
       eliminateInput(spirvCode, u);
@@ -391,9 +417,8 @@ namespace dxvk {
 
   void DxvkShader::generateShaderKey()
   {
-    const std::vector<uint64_t>& code = m_code.getCode();
-    size_t sizeInBytes = 8 * code.size();
-    Sha1Hash hash = Sha1Hash::compute(code.data(), sizeInBytes);
+    const std::vector<uint8_t>& code = m_code.getData();
+    Sha1Hash hash = Sha1Hash::compute(code.data(), code.size());
     setShaderKey(DxvkShaderKey{ m_stage , hash });
   }
   
@@ -184,6 +184,14 @@ namespace dxvk {
       return !m_slots.empty();
     }
 
+    /**
+     * \brief Resource slots used by the shader
+     * \returns Resource slot infos
+     */
+    const std::vector<DxvkResourceSlot>& resourceSlots() const {
+      return m_slots;
+    }
+
     /**
      * \brief Creates a shader module
      * 
@@ -236,6 +244,17 @@ namespace dxvk {
      * \param [in] outputStream Stream to write to 
      */
     void dump(std::ostream& outputStream) const;
+
+    /**
+     * \brief Compressed SPIR-V code
+     *
+     * Unmodified code as passed in at creation time,
+     * i.e. before any resource slot remapping.
+     * \returns Compressed code buffer
+     */
+    const SpirvCompressedBuffer& compressedCode() const {
+      return m_code;
+    }
     
     /**
      * \brief Sets the shader key
@@ -346,6 +365,14 @@ namespace dxvk {
       const Rc<vk::DeviceFn>&     vkd,
       const Rc<DxvkShader>&       shader,
       const SpirvCodeBuffer&      code);
+
+    // NV-DXVK start: create modules from plain code pointers
+    DxvkShaderModule(
+      const Rc<vk::DeviceFn>&     vkd,
+      const Rc<DxvkShader>&       shader,
+      const uint32_t*             code,
+            size_t                dwords);
+    // NV-DXVK end
     
     ~DxvkShaderModule();
 
@@ -39,6 +39,7 @@
 #include "rtx_render/rtx_camera.h"
 #include "rtx_render/rtx_context.h"
 #include "rtx_render/rtx_hash_collision_detection.h"
+#include "rtx_render/rtx_frame_profiler.h"
 #include "rtx_render/rtx_options.h"
 #include "rtx_render/rtx_terrain_baker.h"
 #include "dxvk_image.h"
@@ -671,6 +672,10 @@ namespace dxvk {
       opts.blockInputToGameInUIRef() = !opts.blockInputToGameInUI();
       sendUIActivationMessage();
     }
+
+    if (checkHotkeyState(RtxFrameProfiler::captureHotKey())) {
+      RtxFrameProfiler::requestCapture();
+    }
   }
 
   void ImGUI::sendUIActivationMessage() {
@@ -1335,7 +1340,7 @@ namespace dxvk {
     std::vector<std::string> hudMessages;
 
     if(common->getSceneManager().areReplacementsLoading())
-      hudMessages.emplace_back("Loading enhancements...");
+      hudMessages.emplace_back(str::format("Loading enhancements... ", uint32_t(common->getSceneManager().getReplacementLoadingProgress() * 100.f), "%"));
 
     if (!hudMessages.empty()) {
       ImGui::SetNextWindowPos(ImVec2(0, viewport->Size.y), ImGuiCond_Always, ImVec2(0.0f, 1.0f));
@@ -1513,7 +1518,23 @@ namespace dxvk {
         ImGui::Unindent();
       }
       ImGui::Checkbox("Hash Collision Detection", &HashCollisionDetectionOptions::enableObject());
+      if (HashCollisionDetectionOptions::enable()) {
+        ImGui::Indent();
+        ImGui::DragInt("Sample Rate", &HashCollisionDetectionOptions::sampleRateObject(), 1.f, 1, 1024, "%d", sliderFlags);
+        ImGui::Checkbox("Store Full Source Data", &HashCollisionDetectionOptions::storeFullSourceDataObject());
+        ImGui::Text("Collisions: %llu opacity micromap, %llu geometry, %llu textures",
+                    HashCollisionDetection::getCollisionCount(HashSourceDataCategory::OpacityMicromap),
+                    HashCollisionDetection::getCollisionCount(HashSourceDataCategory::GeometryHashes),
+                    HashCollisionDetection::getCollisionCount(HashSourceDataCategory::Textures));
+        ImGui::Unindent();
+      }
       ImGui::Checkbox("Validate CPU index data", &RtxOptions::Get()->validateCPUIndexDataObject());
+
+      if (ImGui::CollapsingHeader("Frame Profiler", collapsingHeaderClosedFlags)) {
+        ImGui::Indent();
+        RtxFrameProfiler::showImguiSettings();
+        ImGui::Unindent();
+      }
     }
 
     ImGui::PopItemWidth();
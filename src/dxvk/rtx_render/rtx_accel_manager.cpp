@@ -31,6 +31,7 @@
 
 #include "../d3d9/d3d9_state.h"
 #include "rtx_matrix_helpers.h"
+#include "../util/log/metrics.h"
 
 #include "dxvk_scoped_annotation.h"
 #include "rtx_options.h"
@@ -912,7 +913,8 @@ namespace dxvk {
       return;
 
     // Surface buffer
-    const auto surfacesGPUSize = m_reorderedSurfaces.size() * kSurfaceGPUSize;
+    m_surfaceTable.resize(m_reorderedSurfaces.size());
+    const auto surfacesGPUSize = m_surfaceTable.getData().size();
 
     // Allocate the instance buffer and copy its contents from host to device memory
     DxvkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
@@ -921,27 +923,30 @@ namespace dxvk {
     info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
     info.size = align(surfacesGPUSize, kBufferAlignment);
+    bool surfaceBufferRecreated = false;
     if (m_surfaceBuffer == nullptr || info.size > m_surfaceBuffer->info().size) {
       m_surfaceBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXAccelerationStructure);
+      surfaceBufferRecreated = true;
     }
 
-    // Write surface data
-    std::size_t dataOffset = 0;
-    std::vector<unsigned char> surfacesGPUData(surfacesGPUSize);
-
+    // Write surface data, instances have no change tracking so every surface is serialized and
+    // compared against the host copy of the buffer, only the surfaces that differ are uploaded.
     for (uint32_t i = 0; i < m_reorderedSurfaces.size(); ++i) {
       const auto& currentInstance = *m_reorderedSurfaces[i];
 
       // Split instance geometry need to have their first index offset set in their corresponding surface instances
       m_reorderedSurfaces[i]->surface.firstIndex += m_reorderedSurfacesFirstIndexOffset[i];
-      currentInstance.surface.writeGPUData(surfacesGPUData.data(), dataOffset);
+      m_surfaceTable.writeIfChanged(i, [&](unsigned char* data, std::size_t& dataOffset) {
+        currentInstance.surface.writeGPUData(data, dataOffset);
+      });
       m_reorderedSurfaces[i]->surface.firstIndex -= m_reorderedSurfacesFirstIndexOffset[i];
     }
 
-    assert(dataOffset == surfacesGPUSize);
-    assert(surfacesGPUData.size() == surfacesGPUSize);
+    assert(surfacesGPUSize == m_reorderedSurfaces.size() * kSurfaceGPUSize);
 
-    ctx->writeToBuffer(m_surfaceBuffer, 0, surfacesGPUData.size(), surfacesGPUData.data());
+    m_surfaceTable.upload(surfaceBufferRecreated, [&](size_t offset, size_t size, const unsigned char* data) {
+      ctx->writeToBuffer(m_surfaceBuffer, offset, size, data);
+    });
 
     // Find the size of the surface mapping buffer
     uint32_t maxPreviousSurfaceIndex = 0;
@@ -1045,6 +1050,9 @@ namespace dxvk {
     if (!blasToBuild.empty()) {
       assert(blasToBuild.size() == blasRangesToBuild.size());
       ctx->vkCmdBuildAccelerationStructuresKHR(blasToBuild.size(), blasToBuild.data(), blasRangesToBuild.data());
+
+      static MetricCounter& s_blasBuilds = Metrics::counter("accel.blas_builds");
+      s_blasBuilds.add(blasToBuild.size());
     }
   }
 
@@ -29,6 +29,7 @@
 #include "rtx_types.h"
 #include "rtx_common_object.h"
 #include "rtx_staging.h"
+#include "rtx_gpu_table_uploader.h"
 #include "../util/util_vector.h"
 #include "../util/util_matrix.h"
 
@@ -144,6 +145,7 @@ private:
 
   Rc<DxvkBuffer> m_vkInstanceBuffer; // Note: Holds Vulkan AS Instances, not RtInstances
   Rc<DxvkBuffer> m_surfaceBuffer;
+  GpuTableUploader m_surfaceTable { kSurfaceGPUSize }; // Host copy of m_surfaceBuffer
   Rc<DxvkBuffer> m_surfaceMappingBuffer;
   Rc<DxvkBuffer> m_transformBuffer;
   Rc<DxvkBuffer> m_primitiveIDPrefixSumBuffer;
@@ -33,6 +33,7 @@
 #include <string>
 #include <charconv>
 #include <functional>
+#include <thread>
 
 namespace {
   VkFormat normalizeTargetFormat(VkFormat format) {
@@ -69,20 +70,44 @@ namespace {
 
 namespace dxvk {
 
+  AssetExporter::AssetExporter() = default;
+
+  AssetExporter::~AssetExporter() = default;
+
   void AssetExporter::waitForAllExportsToComplete(const float numSecsToWait) {
 
     if (m_numExportsInFlight > 0) {
       Logger::info(str::format("RTX: Waiting for ", m_numExportsInFlight, " asset exports to complete"));
 
-      auto startTime = std::chrono::system_clock::now();
-      while (m_numExportsInFlight > 0 &&
-             std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - startTime).count() < numSecsToWait) {
-        Sleep(1);
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float>(numSecsToWait);
+      {
+        std::unique_lock lock(m_progressMutex);
+        while (m_numExportsInFlight > 0) {
+          const auto now = std::chrono::steady_clock::now();
+          if (now >= deadline) {
+            break;
+          }
+          m_progressCond.wait_for(lock, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) + std::chrono::milliseconds(1));
+        }
       }
 
       if (m_numExportsInFlight > 0)
         Logger::err(str::format("RTX: Timed-out waiting on all asset exports to complete"));
     }
+
+    // The capture is done with, don't hold on to its staging memory for the rest of the session
+    if (m_numExportsInFlight == 0) {
+      trimReadbackImagePool();
+    }
+  }
+
+  template<typename Fn>
+  void AssetExporter::signalProgress(Fn&& fn) {
+    {
+      std::lock_guard lock(m_progressMutex);
+      fn();
+    }
+    m_progressCond.notify_all();
   }
 
   std::unique_ptr<AssetExporter::ThreadPool>& AssetExporter::getExporterThread() {
@@ -92,6 +117,102 @@ namespace dxvk {
     return m_exporterThread;
   }
 
+  std::unique_ptr<AssetExporter::EncodeThreadPool>& AssetExporter::getEncodeThreads() {
+    if (m_encodeThreads == nullptr) {
+      // Encoding is CPU bound (packing + DDS writes), leave room for the game and render threads
+      const uint32_t numThreads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+      m_encodeThreads = std::make_unique<EncodeThreadPool>(static_cast<uint8_t>(numThreads), "rtx-asset-encoder");
+    }
+    return m_encodeThreads;
+  }
+
+  void AssetExporter::waitForImageReadbackCapacity(Rc<DxvkContext> ctx) {
+    if (m_numImageReadbacksInFlight < kMaxImageReadbacksInFlight) {
+      return;
+    }
+
+    ScopedCpuProfileZone();
+    // The readback thread can only make progress once the copies it waits on are submitted
+    ctx->flushCommandList();
+    std::unique_lock lock(m_progressMutex);
+    m_progressCond.wait(lock, [this] { return m_numImageReadbacksInFlight < kMaxImageReadbacksInFlight; });
+  }
+
+  template<typename Task>
+  void AssetExporter::scheduleReadback(Rc<DxvkContext> ctx, Task&& task) {
+    // Every readback reports when it leaves the queue, which is what unblocks a stalled producer below
+    auto readback = [this, task = std::forward<Task>(task)]() mutable {
+      signalProgress([this] { m_numReadbacksStarted++; });
+      task();
+    };
+
+    uint64_t numReadbacksStarted;
+    {
+      std::lock_guard lock(m_progressMutex);
+      numReadbacksStarted = m_numReadbacksStarted;
+    }
+
+    // Note: Schedule only consumes the task on success, but a fresh copy is handed over on each attempt regardless
+    auto attempt = readback;
+    if (getExporterThread()->Schedule(std::move(attempt)).valid()) {
+      return;
+    }
+
+    // Readback queue is saturated, apply backpressure rather than dropping the export
+    ScopedCpuProfileZoneN("Export Readback Stall");
+    ctx->flushCommandList();
+    while (true) {
+      {
+        std::unique_lock lock(m_progressMutex);
+        m_progressCond.wait(lock, [this, numReadbacksStarted] { return m_numReadbacksStarted != numReadbacksStarted; });
+        numReadbacksStarted = m_numReadbacksStarted;
+      }
+      auto retry = readback;
+      if (getExporterThread()->Schedule(std::move(retry)).valid()) {
+        return;
+      }
+    }
+  }
+
+  Rc<DxvkImage> AssetExporter::acquireReadbackImage(Rc<DxvkContext> ctx, const DxvkImageCreateInfo& desc) {
+    const size_t key = desc.hash();
+    {
+      std::lock_guard lock(m_readbackImagePoolMutex);
+      auto range = m_readbackImagePool.equal_range(key);
+      for (auto it = range.first; it != range.second; ++it) {
+        const DxvkImageCreateInfo& info = it->second->info();
+        if (info.format == desc.format &&
+            info.extent.width == desc.extent.width &&
+            info.extent.height == desc.extent.height &&
+            info.extent.depth == desc.extent.depth) {
+          Rc<DxvkImage> image = std::move(it->second);
+          m_readbackImagePool.erase(it);
+          m_readbackImagePoolBytes -= image->memSize();
+          return image;
+        }
+      }
+    }
+
+    // Make the image where we'll copy the GPU resource to CPU accessible mem
+    return ctx->getDevice()->createImage(desc, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, DxvkMemoryStats::Category::RTXMaterialTexture, "exportimage blit dest");
+  }
+
+  void AssetExporter::releaseReadbackImage(Rc<DxvkImage>&& image) {
+    std::lock_guard lock(m_readbackImagePoolMutex);
+    if (m_readbackImagePoolBytes + image->memSize() <= kMaxPooledReadbackBytes) {
+      m_readbackImagePoolBytes += image->memSize();
+      m_readbackImagePool.emplace(image->info().hash(), std::move(image));
+    } else {
+      image = nullptr;
+    }
+  }
+
+  void AssetExporter::trimReadbackImagePool() {
+    std::lock_guard lock(m_readbackImagePoolMutex);
+    m_readbackImagePool.clear();
+    m_readbackImagePoolBytes = 0;
+  }
+
   void AssetExporter::exportImage(Rc<DxvkContext> ctx, const std::string& filename, Rc<DxvkImage> image, bool thumbnail/* = false*/) {
     ScopedCpuProfileZone();
     // NOTE: Should use a mutex here...
@@ -102,7 +223,10 @@ namespace dxvk {
       }
     }
 
+    waitForImageReadbackCapacity(ctx);
+
     m_numExportsInFlight++;
+    m_numImageReadbacksInFlight++;
 
     // We want to retain most of the src image state
     DxvkImageCreateInfo srcDesc = image->info();
@@ -187,8 +311,7 @@ namespace dxvk {
         desc.numLayers = 1; // Can only export 1 layer at a time.
         desc.extent = dstExtent;
 
-        // Make the image where we'll copy the GPU resource to CPU accessible mem
-        pBlitDests[level] = ctx->getDevice()->createImage(desc, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, DxvkMemoryStats::Category::RTXMaterialTexture, "exportimage blit dest");
+        pBlitDests[level] = acquireReadbackImage(ctx, desc);
       }
 
       VkOffset3D srcOffset = VkOffset3D { 0,0,0 };
@@ -240,58 +363,73 @@ namespace dxvk {
     const uint64_t syncValue = ++m_signalValue;
     ctx->signal(m_readbackSignal, syncValue);
 
-    // Spawn a thread so we dont sync with the GPU here...(remember, GPU runs async with CPU!).  
-    Future<void> result = getExporterThread()->Schedule([this, device = ctx->getDevice(), pBlitDests, pBlitTemps, syncValue, filename, outFormat, dstDesc, swizzle] {
-      ScopedCpuProfileZoneN("Export Image Finalize");
+    // Readback happens on the exporter thread (in submission order) so we dont sync with the GPU here...(remember, GPU runs async with CPU!).
+    // Once the data is CPU visible, packing and writing the file is handed off to the encoder threads.
+    const gli::extent3d outExtent = { dstDesc.extent.width, dstDesc.extent.height, 1 };
+    const uint32_t outMipLevels = dstDesc.mipLevels;
+    scheduleReadback(ctx, [this, pBlitDests, pBlitTemps, syncValue, filename, outFormat, outExtent, outMipLevels, swizzle] {
+      ScopedCpuProfileZoneN("Export Image Readback");
       // Stall until the GPU has completed its copy to system memory (GPU->CPU)
       this->m_readbackSignal->wait(syncValue);
-    
-      // Push texture header to the GLI container
-      const gli::extent3d outExtent = { dstDesc.extent.width, dstDesc.extent.height, 1 };
-      gli::texture2d exportTex(outFormat, outExtent, dstDesc.mipLevels, swizzle);
 
-      const DxvkFormatInfo* formatInfo = imageFormatInfo(gliFormatToVk(exportTex.format()));
+      // Blit temps are device local and only needed by the GPU
+      delete[] pBlitTemps;
 
-      for (uint32_t level = 0; level < exportTex.levels(); ++level) {
-        const Rc<DxvkImage>& image = pBlitDests[level];
+      auto encode = [this, pBlitDests, filename, outFormat, outExtent, outMipLevels, swizzle] {
+        ScopedCpuProfileZoneN("Export Image Encode");
+        // Push texture header to the GLI container
+        gli::texture2d exportTex(outFormat, outExtent, outMipLevels, swizzle);
 
-        // Calculate the Subresource Layout for the Image
+        const DxvkFormatInfo* formatInfo = imageFormatInfo(gliFormatToVk(exportTex.format()));
 
-        VkImageSubresource subresource;
-        subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        subresource.mipLevel = 0; // pBlitDests is an array implicitly separated by mip levels, indexing into it selects the level
-        subresource.arrayLayer = 0;
-        const VkSubresourceLayout subresourceLayout = image->querySubresourceLayout(subresource);
+        for (uint32_t level = 0; level < exportTex.levels(); ++level) {
+          const Rc<DxvkImage>& image = pBlitDests[level];
 
-        // Get destination and source pointers for writing/reading
+          // Calculate the Subresource Layout for the Image
 
-        void* pDst = (void*)exportTex.data(exportTex.base_layer(), exportTex.base_face(), level);
-        const void* pSrc = image->mapPtr(0);
+          VkImageSubresource subresource;
+          subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          subresource.mipLevel = 0; // pBlitDests is an array implicitly separated by mip levels, indexing into it selects the level
+          subresource.arrayLayer = 0;
+          const VkSubresourceLayout subresourceLayout = image->querySubresourceLayout(subresource);
 
-        const VkExtent3D levelExtent = gliExtentToVk(exportTex.extent(level));
-        const VkExtent3D elementCount = util::computeBlockCount(levelExtent, formatInfo->blockSize);
-        const uint32_t rowPitch = elementCount.width * formatInfo->elementSize;
-        const uint32_t layerPitch = rowPitch * elementCount.height;
+          // Get destination and source pointers for writing/reading
 
-        util::packImageData(pDst, pSrc, subresourceLayout.rowPitch, subresourceLayout.arrayPitch,
-                            rowPitch, layerPitch, VK_IMAGE_TYPE_2D, levelExtent, 1, formatInfo,
-                            subresource.aspectMask);
-      }
+          void* pDst = (void*)exportTex.data(exportTex.base_layer(), exportTex.base_face(), level);
+          const void* pSrc = image->mapPtr(0);
 
-      // Write our file, converting its format first if nessecary
-      const bool success = gli::save(exportTex, filename);
-      if (!success) {
-        Logger::err(str::format("RTX: Failed to write texture \"", filename, "\""));
-      }
+          const VkExtent3D levelExtent = gliExtentToVk(exportTex.extent(level));
+          const VkExtent3D elementCount = util::computeBlockCount(levelExtent, formatInfo->blockSize);
+          const uint32_t rowPitch = elementCount.width * formatInfo->elementSize;
+          const uint32_t layerPitch = rowPitch * elementCount.height;
 
-      delete[] pBlitTemps;
-      delete[] pBlitDests;
-      m_numExportsInFlight--;
-    });
+          util::packImageData(pDst, pSrc, subresourceLayout.rowPitch, subresourceLayout.arrayPitch,
+                              rowPitch, layerPitch, VK_IMAGE_TYPE_2D, levelExtent, 1, formatInfo,
+                              subresource.aspectMask);
+        }
 
-    if (!result.valid()) {
-      Logger::err(str::format("RTX: Failed to write texture \"", filename, "\".  Coding error, kMaxConcurrentExports, may be too low (currently: ", kMaxConcurrentExports, ")."));
-    }
+        // Readback images are no longer needed once packed, recycle them for subsequent exports
+        for (uint32_t level = 0; level < outMipLevels; ++level) {
+          releaseReadbackImage(std::move(pBlitDests[level]));
+        }
+        delete[] pBlitDests;
+        signalProgress([this] { m_numImageReadbacksInFlight--; });
+
+        // Write our file, converting its format first if nessecary
+        const bool success = gli::save(exportTex, filename);
+        if (!success) {
+          Logger::err(str::format("RTX: Failed to write texture \"", filename, "\""));
+        }
+
+        signalProgress([this] { m_numExportsInFlight--; });
+      };
+
+      // Encode inline when the encoders are saturated, this throttles further readbacks
+      auto task = encode;
+      if (!getEncodeThreads()->Schedule(std::move(task)).valid()) {
+        encode();
+      }
+    });
   }
 
   void AssetExporter::exportBuffer(Rc<DxvkContext> ctx, const DxvkBufferSlice& buffer, BufferCallback bufferCallback) {
@@ -331,17 +469,13 @@ namespace dxvk {
     const uint64_t syncValue = ++m_signalValue;
     ctx->signal(m_readbackSignal, syncValue);
 
-    Future<void> result = getExporterThread()->Schedule([this, cDestBuffer = bufferDest, syncValue, bufferCallback] {
+    scheduleReadback(ctx, [this, cDestBuffer = bufferDest, syncValue, bufferCallback] {
       ScopedCpuProfileZoneN("Export Buffer Finalize");
       // Stall until the GPU has completed its copy to system memory (GPU->CPU)
       this->m_readbackSignal->wait(syncValue);
       bufferCallback(cDestBuffer);
-      m_numExportsInFlight--;
+      signalProgress([this] { m_numExportsInFlight--; });
     });
-    
-    if (!result.valid()) {
-      Logger::err(str::format("RTX: Failed to dump buffer.  Coding error, kMaxConcurrentExports, may be too low (currently: ", kMaxConcurrentExports, ")."));
-    }
   }
 
   void AssetExporter::generateSceneThumbnail(Rc<DxvkContext> ctx, const std::string& dir, const std::string& filename) {
@@ -22,10 +22,12 @@
 #pragma once
 
 #include "../util/sync/sync_signal.h"
+#include "../../util/thread.h"
 #include "../util/rc/util_rc_ptr.h"
 #include <atomic>
 #include <future>
 #include <mutex>
+#include <unordered_map>
 #include "../util/util_env.h"
 #include "rtx_constants.h"
 
@@ -37,12 +39,25 @@ namespace dxvk {
   class DxvkImage;
   class DxvkBuffer;
   class DxvkBufferSlice;
+  struct DxvkImageCreateInfo;
   template<size_t NumTasksPerThread, bool WorkStealing, bool LowLatency> class WorkerThreadPool;
 
+  /**
+    * \brief Exports GPU images and buffers to the CPU (and disk)
+    *
+    *  Exports are pipelined in stages: the GPU copies into CPU visible
+    *  staging images/buffers, a readback thread waits for those copies
+    *  in submission order, and a pool of encoder threads packs and saves
+    *  images in parallel. When any stage is saturated the producer blocks
+    *  (after flushing outstanding GPU work) rather than dropping the export.
+    */
   class AssetExporter {
   public:
     using BufferCallback = std::function<void(Rc<DxvkBuffer>)>;
 
+    AssetExporter();
+    ~AssetExporter();
+
     void waitForAllExportsToComplete(const float numSecsToWait = 10);
 
     void dumpImageToFile(Rc<DxvkContext> ctx, const std::string& dir, const std::string& filename, Rc<DxvkImage> image) {
@@ -67,15 +82,52 @@ namespace dxvk {
     std::atomic<uint64_t> m_signalValue = 1;
     dxvk::mutex m_readbackSignalMutex;
     std::atomic<uint64_t> m_numExportsInFlight = 0;
+
+    // Signalled whenever an export completes, an image readback is released or a readback task is dequeued,
+    // so that producers applying backpressure (and waitForAllExportsToComplete) can sleep instead of polling
+    dxvk::mutex m_progressMutex;
+    dxvk::condition_variable m_progressCond;
+    uint64_t m_numReadbacksStarted = 0;
+
     inline static const size_t kMaxConcurrentExports = 64*1024 - 11; // Sized to match the buffer cache size in scene manager
     static_assert(kMaxConcurrentExports == kBufferCacheLimit, "When changing the maximum number of unique buffers, we also must consider that this limit may need changing also, since the number of buffers is proportional to the number of concurrent exports.");
     using ThreadPool = WorkerThreadPool<kMaxConcurrentExports, false, false>;
     std::unique_ptr<ThreadPool> m_exporterThread;
 
+    // Bounds the CPU visible staging memory held by image exports which have not been encoded yet
+    inline static const size_t kMaxImageReadbacksInFlight = 256;
+    std::atomic<uint64_t> m_numImageReadbacksInFlight = 0;
+
+    inline static const size_t kMaxEncodesPerThread = 64;
+    using EncodeThreadPool = WorkerThreadPool<kMaxEncodesPerThread, true, false>;
+    std::unique_ptr<EncodeThreadPool> m_encodeThreads;
+
+    // Linear readback images are recycled between exports, keyed by format and extent
+    inline static const VkDeviceSize kMaxPooledReadbackBytes = 256ull << 20;
+    dxvk::mutex m_readbackImagePoolMutex;
+    VkDeviceSize m_readbackImagePoolBytes = 0;
+    std::unordered_multimap<size_t, Rc<DxvkImage>> m_readbackImagePool;
+
     void exportImage(Rc<DxvkContext> ctx, const std::string& filename, Rc<DxvkImage> image, bool thumbnail = false);
 
     void exportBuffer(Rc<DxvkContext> ctx, const DxvkBufferSlice& buffer, BufferCallback bufferCallback);
 
+    void waitForImageReadbackCapacity(Rc<DxvkContext> ctx);
+
+    template<typename Task>
+    void scheduleReadback(Rc<DxvkContext> ctx, Task&& task);
+
+    Rc<DxvkImage> acquireReadbackImage(Rc<DxvkContext> ctx, const DxvkImageCreateInfo& desc);
+
+    void releaseReadbackImage(Rc<DxvkImage>&& image);
+
+    void trimReadbackImagePool();
+
+    template<typename Fn>
+    void signalProgress(Fn&& fn);
+
     std::unique_ptr<ThreadPool>& getExporterThread();
+
+    std::unique_ptr<EncodeThreadPool>& getEncodeThreads();
   };
 } // namespace dxvk
\ No newline at end of file
@@ -32,6 +32,33 @@
 
 namespace dxvk {
 
+void AssetReplacements::publish() {
+  ScopedCpuProfileZone();
+
+  // Note: Freed once the lock is released, to not stall writers
+  Retired expired;
+  {
+    std::lock_guard<sync::Spinlock> lock(m_spinlock);
+
+    // Readers had a whole frame to drop any pointers into what the previous call retired
+    expired = std::move(m_retired);
+    m_retired = std::move(m_retiring);
+    m_retiring = Retired();
+
+    if (m_dirty) {
+      std::unique_ptr<const Snapshot> snapshot(new Snapshot {
+        fast_frozen_cache<std::vector<AssetReplacement>>(m_meshReplacers),
+        fast_frozen_cache<std::vector<AssetReplacement>>(m_lightReplacers),
+        fast_frozen_cache<MaterialData>(m_materials) });
+
+      m_snapshot.store(snapshot.get(), std::memory_order_release);
+      m_retired.snapshots.emplace_back(std::move(m_publishedSnapshot));
+      m_publishedSnapshot = std::move(snapshot);
+      m_dirty = false;
+    }
+  }
+}
+
 std::vector<AssetReplacement>* AssetReplacer::getReplacementsForMesh(XXH64_hash_t hash) {
   if (!RtxOptions::Get()->getEnableReplacementMeshes())
     return nullptr;
@@ -43,7 +70,7 @@ std::vector<AssetReplacement>* AssetReplacer::getReplacementsForMesh(XXH64_hash_
   }
 
   for (auto& mod : m_modManager.mods()) {
-    if (auto replacement = mod->replacements().get<AssetReplacement::eMesh>(hash)) {
+    if (auto replacement = mod->replacements().find<AssetReplacement::eMesh>(hash)) {
       return replacement;
     }
   }
@@ -56,7 +83,7 @@ std::vector<AssetReplacement>* AssetReplacer::getReplacementsForLight(XXH64_hash
     return nullptr;
 
   for (auto& mod : m_modManager.mods()) {
-    if (auto replacement = mod->replacements().get<AssetReplacement::eLight>(hash)) {
+    if (auto replacement = mod->replacements().find<AssetReplacement::eLight>(hash)) {
       return replacement;
     }
   }
@@ -69,8 +96,7 @@ MaterialData* AssetReplacer::getReplacementMaterial(XXH64_hash_t hash) {
     return nullptr;
 
   for (auto& mod : m_modManager.mods()) {
-    MaterialData* material;
-    if (mod->replacements().getObject(hash, material)) {
+    if (MaterialData* material = mod->replacements().findMaterial(hash)) {
       return material;
     }
   }
@@ -81,10 +107,17 @@ MaterialData* AssetReplacer::getReplacementMaterial(XXH64_hash_t hash) {
 void AssetReplacer::initialize(const Rc<DxvkContext>& context) {
   for (auto& mod : m_modManager.mods()) {
     mod->load(context);
+    mod->replacements().publish();
   }
   updateSecretReplacements();
 }
 
+void AssetReplacer::onFrameEnd() {
+  for (auto& mod : m_modManager.mods()) {
+    mod->replacements().publish();
+  }
+}
+
 bool AssetReplacer::checkForChanges(const Rc<DxvkContext>& context) {
   ScopedCpuProfileZone();
 
@@ -114,6 +147,18 @@ bool AssetReplacer::areReplacementsLoading() const {
   return loading;
 }
 
+float AssetReplacer::getReplacementLoadingProgress() const {
+  float progress = 0.f;
+  uint32_t numLoading = 0;
+  for (auto& mod : m_modManager.mods()) {
+    if (mod->state() == Mod::State::Loading) {
+      progress += mod->loadingProgress();
+      ++numLoading;
+    }
+  }
+  return numLoading == 0 ? 1.f : progress / float(numLoading);
+}
+
 const std::string& AssetReplacer::getReplacementStatus() const {
   // TODO: make an array?
   for (auto& mod : m_modManager.mods()) {
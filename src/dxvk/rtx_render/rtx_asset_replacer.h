@@ -82,6 +82,11 @@ namespace dxvk {
 
   // Asset replacements storage class.
   // Contains and owns the replacements, material and geometry objects.
+  //
+  // Writers modify the storage under a lock. The renderer instead looks up replacements in an
+  // immutable snapshot of the storage, which publish() rebuilds after any modification. Objects
+  // removed from the storage stay alive until the snapshots that may refer to them are retired
+  // by the next publish(), so pointers returned by lookups are valid until then.
   class AssetReplacements {
   public:
     // Returns a pointer to replacements of type T for a given hash value,
@@ -97,12 +102,29 @@ namespace dxvk {
       return nullptr;
     }
 
+    // Lock free variant of get() for the render thread, looks up the last published snapshot.
+    template<AssetReplacement::Type T>
+    std::vector<AssetReplacement>* find(XXH64_hash_t hash) const {
+      const Snapshot* snapshot = m_snapshot.load(std::memory_order_acquire);
+      if (snapshot == nullptr) {
+        return nullptr;
+      }
+      return T == AssetReplacement::eMesh ? snapshot->meshReplacers.find(hash) : snapshot->lightReplacers.find(hash);
+    }
+
+    // Lock free lookup of a material in the last published snapshot.
+    MaterialData* findMaterial(XXH64_hash_t hash) const {
+      const Snapshot* snapshot = m_snapshot.load(std::memory_order_acquire);
+      return snapshot != nullptr ? snapshot->materials.find(hash) : nullptr;
+    }
+
     // Stores replacements of type T for a hash value.
     template<AssetReplacement::Type T>
     void set(XXH64_hash_t hash, std::vector<AssetReplacement>&& v) {
       std::lock_guard<sync::Spinlock> lock(m_spinlock);
       auto& map = T == AssetReplacement::eMesh ? m_meshReplacers : m_lightReplacers;
       map.emplace(hash, std::move(v));
+      m_dirty = true;
     }
 
     // Returns a pointer to the stored object of type T for a given hash value.
@@ -128,11 +150,13 @@ namespace dxvk {
       return false;
     }
 
-    // Stores the object of type T for a hash value.
+    // Stores the object of type T for a hash value. Materials and meshes already stored for the hash are
+    // kept and returned instead, the returned object may be shared with other threads and must not be modified.
     template<typename T>
     T& storeObject(XXH64_hash_t hash, T&& obj) {
       std::lock_guard<sync::Spinlock> lock(m_spinlock);
       if constexpr (std::is_same_v<T, MaterialData>) {
+        m_dirty = true;
         return m_materials.try_emplace(hash, std::move(obj)).first->second;
       } else if constexpr (std::is_same_v<T, MeshReplacement>) {
         return m_geometries.try_emplace(hash, std::move(obj)).first->second;
@@ -146,29 +170,77 @@ namespace dxvk {
     void removeObject(XXH64_hash_t hash) {
       std::lock_guard<sync::Spinlock> lock(m_spinlock);
       if constexpr (std::is_same_v<T, MaterialData>) {
-        m_materials.erase(hash);
+        retire(m_retiring.materials, m_materials.extract(hash));
+        m_dirty = true;
       } else if constexpr (std::is_same_v<T, MeshReplacement>) {
-        m_geometries.erase(hash);
+        retire(m_retiring.geometries, m_geometries.extract(hash));
       } else {
         m_secretReplacements.erase(hash);
       }
     }
 
-    // Destroys all replacements and stored objects.
+    // Moves all replacements and stored objects of other into this storage. The objects are
+    // not copied, so pointers to the objects of other stay valid and now point into this storage.
+    // Note: entries of other with a hash already present here are dropped, merge into an empty
+    // storage when replacements of other point to its objects.
+    void merge(AssetReplacements& other) {
+      std::lock_guard<sync::Spinlock> lock(m_spinlock);
+      std::lock_guard<sync::Spinlock> otherLock(other.m_spinlock);
+      m_meshReplacers.merge(other.m_meshReplacers);
+      m_lightReplacers.merge(other.m_lightReplacers);
+      m_materials.merge(other.m_materials);
+      m_geometries.merge(other.m_geometries);
+      m_secretReplacements.merge(other.m_secretReplacements);
+      m_dirty = true;
+    }
+
+    // Destroys all replacements and stored objects, once no published snapshot refers to them anymore.
     void clear() {
       std::lock_guard<sync::Spinlock> lock(m_spinlock);
+      m_retiring.replacers.emplace_back(std::move(m_meshReplacers));
+      m_retiring.replacers.emplace_back(std::move(m_lightReplacers));
+      m_retiring.materials.emplace_back(std::move(m_materials));
+      m_retiring.geometries.emplace_back(std::move(m_geometries));
       m_meshReplacers.clear();
       m_lightReplacers.clear();
       m_materials.clear();
       m_geometries.clear();
       m_secretReplacements.clear();
+      m_dirty = true;
     }
 
+    // Makes the modifications since the last call visible to find() and findMaterial(), and frees
+    // the snapshots and objects retired by the previous call. Called once per frame, lookups
+    // must not hold on to the returned pointers for longer than that.
+    void publish();
+
     const SecretReplacements& secretReplacements() const {
       return m_secretReplacements;
     }
 
   private:
+    // Immutable lookup tables pointing into the storage maps
+    struct Snapshot {
+      fast_frozen_cache<std::vector<AssetReplacement>> meshReplacers;
+      fast_frozen_cache<std::vector<AssetReplacement>> lightReplacers;
+      fast_frozen_cache<MaterialData> materials;
+    };
+
+    // Snapshots and objects which published snapshots may still refer to
+    struct Retired {
+      std::vector<std::unique_ptr<const Snapshot>> snapshots;
+      std::vector<fast_unordered_cache<std::vector<AssetReplacement>>> replacers;
+      std::vector<fast_unordered_cache<MaterialData>> materials;
+      std::vector<fast_unordered_cache<MeshReplacement>> geometries;
+    };
+
+    template<typename T, typename Node>
+    static void retire(std::vector<fast_unordered_cache<T>>& retired, Node&& node) {
+      if (!node.empty()) {
+        retired.emplace_back().insert(std::move(node));
+      }
+    }
+
     mutable sync::Spinlock m_spinlock;
 
     // Replacements ready to be fed to the renderer
@@ -183,6 +255,16 @@ namespace dxvk {
 
     // Secret replacements if any
     SecretReplacements m_secretReplacements;
+
+    // Set by writers when the published snapshot is out of date
+    bool m_dirty = false;
+
+    std::unique_ptr<const Snapshot> m_publishedSnapshot;
+    std::atomic<const Snapshot*> m_snapshot { nullptr };
+
+    // Retired since the last and before the last publish() respectively
+    Retired m_retiring;
+    Retired m_retired;
   };
 
   struct AssetReplacer {
@@ -196,8 +278,13 @@ namespace dxvk {
     // returns true if the state of replacements has changed.
     bool checkForChanges(const Rc<DxvkContext>& context);
 
+    // publishes replacement changes to the lookups above, must be called at the end of every frame.
+    void onFrameEnd();
+
     bool areReplacementsLoaded() const;
     bool areReplacementsLoading() const;
+    // Progress of the mods currently loading, from 0 to 1
+    float getReplacementLoadingProgress() const;
     const std::string& getReplacementStatus() const;
 
     const bool hasNewSecretReplacementInfo() const {
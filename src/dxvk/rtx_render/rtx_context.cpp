@@ -188,6 +188,8 @@ namespace dxvk {
     if (m_screenshotFrameNum != -1 || m_terminateAppFrameNum != -1) {
       Metrics::serialize();
     }
+
+    Metrics::exportTimeSeries();
   }
 
   SceneManager& RtxContext::getSceneManager() {
@@ -318,10 +320,10 @@ namespace dxvk {
     auto logRenderPassRaytraceModeRayQuery = [=](const char* renderPassName, auto mode) {
       switch (mode) {
       case decltype(mode)::RayQuery:
-        Logger::info(str::format("RenderPass ", renderPassName, " Raytrace Mode: Ray Query (CS)"));
+        Logger::info("RenderPass ", renderPassName, " Raytrace Mode: Ray Query (CS)");
         break;
       case decltype(mode)::RayQueryRayGen:
-        Logger::info(str::format("RenderPass ", renderPassName, " Raytrace Mode: Ray Query (RGS)"));
+        Logger::info("RenderPass ", renderPassName, " Raytrace Mode: Ray Query (RGS)");
         break;
       }
     };
@@ -333,7 +335,7 @@ namespace dxvk {
         logRenderPassRaytraceModeRayQuery(renderPassName, mode);
         break;
       case decltype(mode)::TraceRay:
-        Logger::info(str::format("RenderPass ", renderPassName, " Raytrace Mode: Trace Ray (RGS)"));
+        Logger::info("RenderPass ", renderPassName, " Raytrace Mode: Trace Ray (RGS)");
         break;
       }
     };
@@ -685,6 +687,7 @@ namespace dxvk {
         m_common->capturer()->isIdle()) {
       Logger::info(str::format("RTX: Terminating application"));
       Metrics::serialize();
+      Metrics::exportTimeSeries();
       getCommonObjects()->metaExporter().waitForAllExportsToComplete();
 
       env::killProcess();
@@ -710,6 +713,17 @@ namespace dxvk {
     }
     Metrics::log(Metric::vid_memory_usage, static_cast<float>(vidUsageMib)); // In MB
     Metrics::log(Metric::sys_memory_usage, static_cast<float>(sysUsageMib)); // In MB
+
+    static MetricGauge& s_frameTime = Metrics::gauge("frame_time_ms");
+    static MetricGauge& s_gpuIdleTime = Metrics::gauge("gpu_idle_ms");
+    static MetricGauge& s_vidMemoryUsage = Metrics::gauge("vid_memory_usage_mb");
+    static MetricGauge& s_sysMemoryUsage = Metrics::gauge("sys_memory_usage_mb");
+    s_frameTime.set(frameTimeMilliseconds);
+    s_gpuIdleTime.set(gpuIdleTimeMilliseconds);
+    s_vidMemoryUsage.set(static_cast<double>(vidUsageMib));
+    s_sysMemoryUsage.set(static_cast<double>(sysUsageMib));
+
+    Metrics::endFrame(m_device->getCurrentFrameId());
   }
 
   void RtxContext::setConstantBuffers(const uint32_t vsFixedFunctionConstants, const uint32_t psSharedStateConstants, Rc<DxvkBuffer> vertexCaptureCB) {
@@ -21,6 +21,7 @@
 */
 #include "rtx_draw_call_cache.h"
 #include "../d3d9/d3d9_state.h"
+#include "../util/log/metrics.h"
 
 namespace dxvk 
 {
@@ -42,27 +43,39 @@ namespace {
 }
 
 DrawCallCache::DrawCallCache(DxvkDevice* device) : CommonDeviceObject(device) {
-  m_entries.reserve(1024);
+  m_slots.reserve(1024);
+  m_dense.reserve(1024);
+  m_buckets.reserve(1024);
+}
+DrawCallCache::~DrawCallCache() {
+  clear();
 }
-DrawCallCache::~DrawCallCache() {}
 
 DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, BlasEntry** out) {
+  static MetricCounter& s_hits = Metrics::counter("draw_call_cache.hits");
+  static MetricCounter& s_misses = Metrics::counter("draw_call_cache.misses");
+
+  const CacheState state = get(drawCall, out, m_device->getCurrentFrameId());
+  (state == CacheState::kExisted ? s_hits : s_misses).add();
+  return state;
+}
+
+DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, BlasEntry** out, uint32_t currentFrameId) {
   // First, find the right bucket:
   const XXH64_hash_t hash = drawCall.getGeometryData().getHashForRule<rules::TopologicalHash>();
-  auto range = m_entries.equal_range(hash);
-  if (range.first == m_entries.end()) {
+  auto bucketIter = m_buckets.find(hash);
+  if (bucketIter == m_buckets.end()) {
     // New bucket
-    *out = allocateEntry(hash, drawCall);
+    *out = allocateEntry(hash, drawCall, currentFrameId);
     return CacheState::kNew;
   }
+  const Bucket& bucket = bucketIter->second;
   // Handle buckets with 1 entry:
-  auto iter = range.first;
-  iter++;
-  if (iter == range.second) {
+  if (bucket.size() == 1) {
     // Only 1 element
-    BlasEntry& entry = range.first->second;
+    BlasEntry& entry = *getEntry(bucket[0]);
 
-    const bool updatedThisFrame = entry.frameLastTouched == m_device->getCurrentFrameId();
+    const bool updatedThisFrame = entry.frameLastTouched == currentFrameId;
     const bool vertexDataMatches = entry.input.getGeometryData().getHashForRule<rules::VertexDataHash>() == drawCall.getGeometryData().getHashForRule<rules::VertexDataHash>();
     const bool boneHashesMatch = entry.input.getSkinningState().boneHash == drawCall.getSkinningState().boneHash;
     const bool materialHashesMatch = entry.input.getMaterialData().getHash() == drawCall.getMaterialData().getHash();
@@ -76,7 +89,7 @@ DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, Blas
     } else {
       // First frame of having two mismatching instances, and the first instance has already 
       // been paired with the existing BlasEntry.
-      *out = allocateEntry(hash, drawCall);
+      *out = allocateEntry(hash, drawCall, currentFrameId);
       return CacheState::kNew;
     }
   }
@@ -87,13 +100,13 @@ DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, Blas
   Matrix4 newTransform = drawCall.getTransformData().objectToWorld;
   const Vector3 newWorldPosition = drawCall.getGeometryData().boundingBox.getTransformedCentroid(newTransform);
 
-  for (auto bucketIter = range.first; bucketIter != range.second; bucketIter++) {
-    BlasEntry& blas  = bucketIter->second;
+  for (size_t i = 0; i < bucket.size(); i++) {
+    BlasEntry& blas = *getEntry(bucket[i]);
     if (exactMatch(drawCall, blas)) {
       *out = &blas;
       return CacheState::kExisted;
     }
-    if (blas.frameLastTouched == m_device->getCurrentFrameId()) {
+    if (blas.frameLastTouched == currentFrameId) {
       continue;
     }
     // TODO these heuristics could use more refinement.
@@ -120,18 +133,154 @@ DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, Blas
   }
   if (*out == nullptr) {
     // Failed to find similar blas, so allocate a new one
-    *out = allocateEntry(hash, drawCall);
+    *out = allocateEntry(hash, drawCall, currentFrameId);
     return CacheState::kNew;
   }
   return CacheState::kExisted;
 
 }
 
-BlasEntry* DrawCallCache::allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall) {
-  auto iter = m_entries.emplace(hash, drawCall);
-  BlasEntry* result = &iter->second;
-  result->frameCreated = m_device->getCurrentFrameId();
+void DrawCallCache::touch(BlasEntry* blas, uint32_t frameId) {
+  Entry* entry = static_cast<Entry*>(blas);
+  entry->frameLastTouched = frameId;
+
+  const uint32_t slot = entry->slot;
+  if (m_ageHead == slot) {
+    return;
+  }
+
+  unlinkAge(slot);
+
+  Slot& info = m_slots[slot];
+  info.newer = kInvalidSlot;
+  info.older = m_ageHead;
+  info.inAgeList = true;
+  if (m_ageHead != kInvalidSlot) {
+    m_slots[m_ageHead].newer = slot;
+  } else {
+    m_ageTail = slot;
+  }
+  m_ageHead = slot;
+}
+
+DrawCallCache::Handle DrawCallCache::getHandle(const BlasEntry* blas) const {
+  const uint32_t slot = static_cast<const Entry*>(blas)->slot;
+  return Handle { slot, m_slots[slot].generation };
+}
+
+BlasEntry* DrawCallCache::resolve(const Handle& handle) const {
+  if (handle.slot >= m_slots.size()) {
+    return nullptr;
+  }
+  const Slot& info = m_slots[handle.slot];
+  if (!info.alive || info.generation != handle.generation) {
+    return nullptr;
+  }
+  return getEntry(handle.slot);
+}
+
+void DrawCallCache::clear() {
+  for (uint32_t slot : m_dense) {
+    getEntry(slot)->~Entry();
+  }
+  // Pages are kept around, the cache usually fills up to a similar size again
+  const uint32_t numSlots = static_cast<uint32_t>(m_slots.size());
+  for (uint32_t slot = 0; slot < numSlots; slot++) {
+    Slot& info = m_slots[slot];
+    info.generation += info.alive ? 1 : 0;
+    info.alive = false;
+    info.inAgeList = false;
+    info.newer = kInvalidSlot;
+    info.older = kInvalidSlot;
+    // Rebuild the free list in slot order, so reuse stays compact
+    info.denseIndexOrNextFree = slot + 1 < numSlots ? slot + 1 : kInvalidSlot;
+  }
+  m_freeList = numSlots > 0 ? 0 : kInvalidSlot;
+  m_dense.clear();
+  m_buckets.clear();
+  m_ageHead = kInvalidSlot;
+  m_ageTail = kInvalidSlot;
+}
+
+BlasEntry* DrawCallCache::allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall, uint32_t currentFrameId) {
+  uint32_t slot = m_freeList;
+  if (slot != kInvalidSlot) {
+    m_freeList = m_slots[slot].denseIndexOrNextFree;
+  } else {
+    slot = static_cast<uint32_t>(m_slots.size());
+    if (slot % kEntriesPerPage == 0) {
+      m_pages.emplace_back(new EntryStorage[kEntriesPerPage]);
+    }
+    m_slots.emplace_back();
+  }
+
+  Entry* result = new (getEntry(slot)) Entry(drawCall, hash, slot);
+  result->frameCreated = currentFrameId;
+
+  Slot& info = m_slots[slot];
+  info.alive = true;
+  info.denseIndexOrNextFree = static_cast<uint32_t>(m_dense.size());
+  m_dense.push_back(slot);
+  m_buckets[hash].push_back(slot);
+
+  // Note: entries join the age list on their first touch, untouched entries are never expired
   return result;
 }
 
+void DrawCallCache::eraseEntry(Entry* entry) {
+  const uint32_t slot = entry->slot;
+  Slot& info = m_slots[slot];
+
+  unlinkAge(slot);
+
+  // Swap remove from the bucket, order within a bucket carries no meaning
+  auto bucketIter = m_buckets.find(entry->hash);
+  Bucket& bucket = bucketIter->second;
+  for (size_t i = 0; i < bucket.size(); i++) {
+    if (bucket[i] == slot) {
+      bucket[i] = bucket.back();
+      bucket.pop_back();
+      break;
+    }
+  }
+  if (bucket.size() == 0) {
+    m_buckets.erase(bucketIter);
+  }
+
+  // Swap remove from the dense array
+  const uint32_t denseIndex = info.denseIndexOrNextFree;
+  const uint32_t lastSlot = m_dense.back();
+  m_dense[denseIndex] = lastSlot;
+  m_slots[lastSlot].denseIndexOrNextFree = denseIndex;
+  m_dense.pop_back();
+
+  entry->~Entry();
+
+  info.alive = false;
+  info.generation++;
+  info.denseIndexOrNextFree = m_freeList;
+  m_freeList = slot;
+}
+
+void DrawCallCache::unlinkAge(uint32_t slot) {
+  Slot& info = m_slots[slot];
+  if (!info.inAgeList) {
+    return;
+  }
+
+  if (info.newer != kInvalidSlot) {
+    m_slots[info.newer].older = info.older;
+  } else {
+    m_ageHead = info.older;
+  }
+  if (info.older != kInvalidSlot) {
+    m_slots[info.older].newer = info.newer;
+  } else {
+    m_ageTail = info.newer;
+  }
+  info.newer = kInvalidSlot;
+  info.older = kInvalidSlot;
+  info.inAgeList = false;
+}
+
 }  // namespace nvvk
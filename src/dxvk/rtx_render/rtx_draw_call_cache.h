@@ -23,9 +23,11 @@
 
 #include <vector>
 #include <limits>
+#include <memory>
 #include <unordered_map>
 
 #include "../util/util_vector.h"
+#include "../util/util_small_vector.h"
 #include "dxvk_scoped_annotation.h"
 
 #include "rtx_types.h"
@@ -38,16 +40,25 @@ class DxvkDevice;
 
 // A cache of the BlasEntries across frames.  This maintains stable BlasEntry pointers until that BlasEntry
 // is erased by sceneManager's garbage collection.
+//
+// Entries live in fixed size pages and are addressed through a slot map: a dense array of live slots
+// for iteration, a hash index with a small inline bucket per topological hash, and an intrusive list
+// ordered by frameLastTouched so garbage collection only visits the entries that actually expired.
 class DrawCallCache : public CommonDeviceObject {
 public:
-  using MultimapType = std::unordered_multimap<XXH64_hash_t, BlasEntry, XXH64_hash_passthrough>;
-
   enum class CacheState
   {
     kNew = 0,
     kExisted = 1,
   };
 
+  // A generation checked reference to an entry, resolves to nullptr once that entry was erased
+  // even if its slot has been reused since.
+  struct Handle {
+    uint32_t slot = kInvalidSlot;
+    uint32_t generation = 0;
+  };
+
   DrawCallCache(DrawCallCache const&) = delete;
   DrawCallCache& operator=(DrawCallCache const&) = delete;
 
@@ -56,22 +67,97 @@ public:
 
   CacheState get(const DrawCallState& drawCall, BlasEntry** out);
 
-  MultimapType& getEntries() {return m_entries;}
+  // Same as above, against an explicit current frame rather than the device's. Used to
+  // drive the cache without a device, e.g. when replaying a draw call trace.
+  CacheState get(const DrawCallState& drawCall, BlasEntry** out, uint32_t currentFrameId);
+
+  // Marks an entry as used in the given frame. Must be used instead of writing frameLastTouched
+  // directly, and with non-decreasing frame ids, as it keeps the age list ordered.
+  void touch(BlasEntry* entry, uint32_t frameId);
+
+  // Erases all entries last touched before oldestFrame, oldest first. Only the expired entries are
+  // visited. onErase is called for every entry right before it is destroyed.
+  template<typename Fn>
+  void eraseExpired(uint32_t oldestFrame, Fn&& onErase) {
+    while (m_ageTail != kInvalidSlot && getEntry(m_ageTail)->frameLastTouched < oldestFrame) {
+      Entry* entry = getEntry(m_ageTail);
+      onErase(static_cast<BlasEntry&>(*entry));
+      eraseEntry(entry);
+    }
+  }
+
+  // Erases all entries for which pred returns true. Visits every entry, so only meant for the
+  // cases where each entry needs to be inspected anyway.
+  template<typename Pred>
+  void eraseIf(Pred&& pred) {
+    // Walk backwards, erasing swaps the last dense element into the current position
+    for (size_t i = m_dense.size(); i-- > 0; ) {
+      Entry* entry = getEntry(m_dense[i]);
+      if (pred(static_cast<BlasEntry&>(*entry))) {
+        eraseEntry(entry);
+      }
+    }
+  }
 
-  void clear() {
-    m_entries.clear();
+  template<typename Fn>
+  void forEach(Fn&& fn) {
+    for (uint32_t slot : m_dense) {
+      fn(static_cast<BlasEntry&>(*getEntry(slot)));
+    }
   }
+
+  Handle getHandle(const BlasEntry* entry) const;
+  BlasEntry* resolve(const Handle& handle) const;
+
+  size_t size() const { return m_dense.size(); }
+
+  void clear();
   
   void rebuildSpatialMaps() {
-    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
-      iter->second.rebuildSpatialMap();
-    }
+    forEach([](BlasEntry& entry) { entry.rebuildSpatialMap(); });
   }
 
 private:
-  MultimapType m_entries;
+  static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+  static constexpr uint32_t kEntriesPerPage = 256;
+
+  struct Entry : public BlasEntry {
+    Entry(const DrawCallState& drawCall, XXH64_hash_t hash_, uint32_t slot_)
+      : BlasEntry(drawCall), hash(hash_), slot(slot_) { }
+
+    const XXH64_hash_t hash;
+    const uint32_t slot;
+  };
+
+  struct Slot {
+    uint32_t generation = 0;
+    // Position in m_dense while alive, next free slot otherwise
+    uint32_t denseIndexOrNextFree = kInvalidSlot;
+    // Age list links, towards the most and least recently touched entries
+    uint32_t newer = kInvalidSlot;
+    uint32_t older = kInvalidSlot;
+    bool alive = false;
+    bool inAgeList = false;
+  };
+
+  using EntryStorage = std::aligned_storage_t<sizeof(Entry), alignof(Entry)>;
+  using Bucket = small_vector<uint32_t, 4>;
+
+  std::vector<std::unique_ptr<EntryStorage[]>> m_pages;
+  std::vector<Slot> m_slots;
+  std::vector<uint32_t> m_dense;
+  std::unordered_map<XXH64_hash_t, Bucket, XXH64_hash_passthrough> m_buckets;
+  uint32_t m_freeList = kInvalidSlot;
+  uint32_t m_ageHead = kInvalidSlot;
+  uint32_t m_ageTail = kInvalidSlot;
+
+  Entry* getEntry(uint32_t slot) const {
+    return reinterpret_cast<Entry*>(&m_pages[slot / kEntriesPerPage][slot % kEntriesPerPage]);
+  }
 
-  BlasEntry* allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall);
+  BlasEntry* allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall, uint32_t currentFrameId);
+  void eraseEntry(Entry* entry);
+  void unlinkAge(uint32_t slot);
 };
 
 }  // namespace nvvk
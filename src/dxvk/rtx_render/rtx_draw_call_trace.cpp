@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "rtx_draw_call_trace.h"
+
+#include "../../util/util_env.h"
+#include "../../util/log/log.h"
+
+namespace dxvk {
+
+  namespace {
+    template<typename T>
+    bool readRecord(const uint8_t* data, size_t size, size_t& offset, T& record) {
+      if (size - offset < sizeof(T)) {
+        return false;
+      }
+      memcpy(&record, data + offset, sizeof(T));
+      offset += sizeof(T);
+      return true;
+    }
+  }
+
+  bool DrawCallTrace::parse(const uint8_t* data, size_t size, DrawCallTrace& trace) {
+    trace.frames.clear();
+
+    size_t offset = 0;
+    DrawCallTraceHeader header;
+    if (!readRecord(data, size, offset, header) ||
+        header.magic != kDrawCallTraceMagic ||
+        header.version != kDrawCallTraceVersion) {
+      return false;
+    }
+
+    Frame current;
+    while (offset < size) {
+      DrawCallTraceRecordType type;
+      if (!readRecord(data, size, offset, type)) {
+        return false;
+      }
+
+      bool valid = false;
+      switch (type) {
+      case DrawCallTraceRecordType::Draw:
+        valid = readRecord(data, size, offset, current.draws.emplace_back());
+        break;
+      case DrawCallTraceRecordType::Light:
+        valid = readRecord(data, size, offset, current.lights.emplace_back());
+        break;
+      case DrawCallTraceRecordType::Frame:
+        valid = readRecord(data, size, offset, current.frame);
+        if (valid) {
+          trace.frames.emplace_back(std::move(current));
+          current = Frame();
+        }
+        break;
+      }
+
+      if (!valid) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool DrawCallTrace::load(const std::string& filePath, DrawCallTrace& trace) {
+    std::ifstream file(str::tows(filePath.c_str()).c_str(), std::ios_base::binary | std::ios_base::ate);
+    if (!file) {
+      return false;
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+      return false;
+    }
+
+    return parse(data.data(), data.size(), trace);
+  }
+
+  DrawCallTraceDraw DrawCallTrace::fromDrawCallState(const DrawCallState& drawCall) {
+    const RasterGeometry& geometry = drawCall.getGeometryData();
+
+    DrawCallTraceDraw draw;
+    for (uint32_t i = 0; i < (uint32_t) HashComponents::Count; i++) {
+      draw.geometryHashes[i] = geometry.hashes[(HashComponents) i];
+    }
+    draw.materialHash = drawCall.getMaterialData().getHash();
+    draw.boneHash = drawCall.getSkinningState().boneHash;
+    draw.objectToWorld = drawCall.getTransformData().objectToWorld;
+    draw.boundingBoxMin = geometry.boundingBox.minPos;
+    draw.boundingBoxMax = geometry.boundingBox.maxPos;
+    draw.vertexCount = geometry.vertexCount;
+    draw.indexCount = geometry.indexCount;
+    draw.numBones = drawCall.getSkinningState().numBones;
+    draw.categories = drawCall.getCategoryFlags().raw();
+    draw.cameraType = (uint32_t) drawCall.cameraType;
+    draw.drawCallID = drawCall.drawCallID;
+    return draw;
+  }
+
+  DrawCallTraceLight DrawCallTrace::fromLight(const RtLight& light) {
+    DrawCallTraceLight record;
+    record.hash = light.getInitialHash();
+    record.type = (uint32_t) light.getType();
+    record.position = light.getPosition();
+    record.direction = light.getDirection();
+    record.radiance = light.getRadiance();
+    record.radius = light.getType() == RtLightType::Sphere ? light.getSphereLight().getRadius() : 0.f;
+    record.halfAngle = light.getType() == RtLightType::Distant ? light.getDistantLight().getHalfAngle() : 0.f;
+    return record;
+  }
+
+  DrawCallState DrawCallTrace::toDrawCallState(const DrawCallTraceDraw& draw) {
+    DrawCallState drawCall;
+
+    RasterGeometry& geometry = drawCall.geometryData;
+    for (uint32_t i = 0; i < (uint32_t) HashComponents::Count; i++) {
+      geometry.hashes[(HashComponents) i] = draw.geometryHashes[i];
+    }
+    geometry.hashes.precombine();
+    geometry.boundingBox.minPos = draw.boundingBoxMin;
+    geometry.boundingBox.maxPos = draw.boundingBoxMax;
+    geometry.vertexCount = draw.vertexCount;
+    geometry.indexCount = draw.indexCount;
+
+    drawCall.materialData.setHashOverride(draw.materialHash);
+    drawCall.transformData.objectToWorld = draw.objectToWorld;
+    drawCall.skinningData.boneHash = draw.boneHash;
+    drawCall.skinningData.numBones = draw.numBones;
+    drawCall.categories = CategoryFlags(draw.categories);
+    drawCall.cameraType = (CameraType::Enum) draw.cameraType;
+    drawCall.drawCallID = draw.drawCallID;
+    return drawCall;
+  }
+
+  RtLight DrawCallTrace::toLight(const DrawCallTraceLight& light) {
+    // Only the recorded hash is needed to identify the light, so anything but
+    // distant lights is replayed as a sphere light.
+    if ((RtLightType) light.type == RtLightType::Distant) {
+      return RtLight(RtDistantLight(light.direction, light.halfAngle, light.radiance, light.hash));
+    }
+    return RtLight(RtSphereLight(light.position, light.radiance, light.radius, RtLightShaping(), light.hash));
+  }
+
+  DrawCallTraceWriter::DrawCallTraceWriter(const std::string& filePath)
+    : m_file(str::tows(filePath.c_str()).c_str(), std::ios_base::binary | std::ios_base::trunc) {
+    if (!m_file) {
+      Logger::err(str::format("[DrawCallTrace] Failed to open ", filePath, " for writing."));
+      return;
+    }
+
+    const DrawCallTraceHeader header;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    Logger::info(str::format("[DrawCallTrace] Recording draw calls to ", filePath));
+  }
+
+  DrawCallTraceWriter::~DrawCallTraceWriter() {
+    if (isOpen()) {
+      // Any records of an incomplete frame are dropped on purpose, a trace only contains full frames
+      Logger::info(str::format("[DrawCallTrace] Recorded ", m_numFrames, " frames."));
+    }
+  }
+
+  template<typename T>
+  void DrawCallTraceWriter::write(DrawCallTraceRecordType type, const T& record) {
+    const size_t offset = m_buffer.size();
+    m_buffer.resize(offset + sizeof(type) + sizeof(T));
+    memcpy(m_buffer.data() + offset, &type, sizeof(type));
+    memcpy(m_buffer.data() + offset + sizeof(type), &record, sizeof(T));
+  }
+
+  void DrawCallTraceWriter::recordDraw(const DrawCallState& drawCall) {
+    write(DrawCallTraceRecordType::Draw, DrawCallTrace::fromDrawCallState(drawCall));
+  }
+
+  void DrawCallTraceWriter::recordLight(const RtLight& light) {
+    write(DrawCallTraceRecordType::Light, DrawCallTrace::fromLight(light));
+  }
+
+  void DrawCallTraceWriter::recordFrameEnd(uint32_t frameId, const Matrix4& worldToView, const Matrix4& viewToProjection) {
+    DrawCallTraceFrame frame;
+    frame.frameId = frameId;
+    frame.worldToView = worldToView;
+    frame.viewToProjection = viewToProjection;
+    write(DrawCallTraceRecordType::Frame, frame);
+
+    if (isOpen()) {
+      m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+      m_file.flush();
+    }
+    m_buffer.clear();
+    m_numFrames++;
+  }
+
+  std::string DrawCallTraceWriter::getDefaultFilePath() {
+    return env::getExeBaseName() + ".rdct";
+  }
+
+}
@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "rtx_types.h"
+#include "rtx_lights.h"
+#include "rtx_option.h"
+
+namespace dxvk {
+
+  // Draw call traces capture the CPU side inputs of the scene manager (draw call hashes, transforms,
+  // materials, lights and camera) so the scene building hot path can be replayed without a GPU.
+  //
+  // File layout: a DrawCallTraceHeader, followed by a stream of records. Every record is a
+  // DrawCallTraceRecordType tag followed by the matching POD struct. A frame is made of all
+  // draw and light records preceding its DrawCallTraceFrame record.
+
+  constexpr uint32_t kDrawCallTraceMagic = 0x54434452; // "RDCT"
+  constexpr uint32_t kDrawCallTraceVersion = 1;
+
+  struct DrawCallTraceHeader {
+    uint32_t magic = kDrawCallTraceMagic;
+    uint32_t version = kDrawCallTraceVersion;
+  };
+
+  enum class DrawCallTraceRecordType : uint32_t {
+    Draw = 0,
+    Light,
+    Frame,
+  };
+
+  struct DrawCallTraceDraw {
+    XXH64_hash_t geometryHashes[(uint32_t) HashComponents::Count];
+    XXH64_hash_t materialHash;
+    XXH64_hash_t boneHash;
+    Matrix4 objectToWorld;
+    Vector3 boundingBoxMin;
+    Vector3 boundingBoxMax;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t numBones;
+    uint32_t categories;
+    uint32_t cameraType;
+    uint32_t drawCallID;
+  };
+
+  struct DrawCallTraceLight {
+    XXH64_hash_t hash;
+    uint32_t type;
+    Vector3 position;
+    Vector3 direction;
+    Vector3 radiance;
+    // Sphere lights only
+    float radius;
+    // Distant lights only
+    float halfAngle;
+  };
+
+  struct DrawCallTraceFrame {
+    uint32_t frameId;
+    Matrix4 worldToView;
+    Matrix4 viewToProjection;
+  };
+
+  static_assert(std::is_trivially_copyable_v<DrawCallTraceDraw>);
+  static_assert(std::is_trivially_copyable_v<DrawCallTraceLight>);
+  static_assert(std::is_trivially_copyable_v<DrawCallTraceFrame>);
+
+  struct DrawCallTrace {
+    struct Frame {
+      DrawCallTraceFrame frame;
+      std::vector<DrawCallTraceDraw> draws;
+      std::vector<DrawCallTraceLight> lights;
+    };
+
+    std::vector<Frame> frames;
+
+    // Parses a serialized trace. Records of an unterminated last frame are dropped.
+    // Returns false if the data is not a trace of the current version, or is truncated.
+    static bool parse(const uint8_t* data, size_t size, DrawCallTrace& trace);
+
+    static bool load(const std::string& filePath, DrawCallTrace& trace);
+
+    static DrawCallTraceDraw fromDrawCallState(const DrawCallState& drawCall);
+    static DrawCallTraceLight fromLight(const RtLight& light);
+
+    // Rebuilds the parts of a draw call state the scene managers match on. No buffers
+    // or textures are attached, so the result can only be used for CPU side processing.
+    static DrawCallState toDrawCallState(const DrawCallTraceDraw& draw);
+    static RtLight toLight(const DrawCallTraceLight& light);
+  };
+
+  // Records the draw call stream of the scene manager to a trace file. Records are
+  // buffered and written out once per frame.
+  class DrawCallTraceWriter {
+  public:
+    explicit DrawCallTraceWriter(const std::string& filePath);
+    ~DrawCallTraceWriter();
+
+    bool isOpen() const {
+      return m_file.is_open();
+    }
+
+    uint32_t getNumFrames() const {
+      return m_numFrames;
+    }
+
+    void recordDraw(const DrawCallState& drawCall);
+    void recordLight(const RtLight& light);
+    void recordFrameEnd(uint32_t frameId, const Matrix4& worldToView, const Matrix4& viewToProjection);
+
+    static std::string getDefaultFilePath();
+
+    RTX_OPTION("rtx.drawCallTrace", bool, enableRecording, false,
+               "Records the draw calls, lights and main camera submitted to the scene manager into a binary trace.\n"
+               "Traces can be replayed without a GPU by the draw_call_trace_replay benchmark to profile scene building.");
+    RTX_OPTION("rtx.drawCallTrace", std::string, filePath, "",
+               "Path of the recorded draw call trace. When empty, the trace is written to the working directory and named after the executable.");
+    RTX_OPTION("rtx.drawCallTrace", uint32_t, maxFrames, 600,
+               "Number of frames after which draw call trace recording stops. 0 records until recording is disabled.");
+
+  private:
+    template<typename T>
+    void write(DrawCallTraceRecordType type, const T& record);
+
+    std::ofstream m_file;
+    std::vector<uint8_t> m_buffer;
+    uint32_t m_numFrames = 0;
+  };
+
+}
@@ -0,0 +1,105 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+
+#include "rtx_frame_profiler.h"
+#include "rtx_imgui.h"
+
+#include "../../util/util_env.h"
+#include "../../util/util_frame_profiler.h"
+#include "../../util/log/log.h"
+
+namespace dxvk {
+
+  void RtxFrameProfiler::onFrameEnd() {
+    FrameProfiler& profiler = FrameProfiler::get();
+
+    profiler.setEnabled(enable());
+
+    if (++s_frameIndex == static_cast<uint32_t>(captureStartFrame())) {
+      requestCapture();
+    }
+
+    profiler.endFrame();
+  }
+
+  void RtxFrameProfiler::requestCapture() {
+    std::string filePath = capturePath();
+    if (filePath.empty()) {
+      filePath = str::format(env::getExeBaseName(), "_profile_", s_numCaptures.load(), ".json");
+    }
+
+    const uint32_t numFrames = static_cast<uint32_t>(std::max(captureFrames(), 1));
+    if (FrameProfiler::get().requestCapture(numFrames, filePath)) {
+      s_numCaptures++;
+      Logger::info(str::format("[FrameProfiler] Capturing ", numFrames, " frames to ", filePath));
+    }
+  }
+
+  void RtxFrameProfiler::showImguiSettings() {
+    FrameProfiler& profiler = FrameProfiler::get();
+
+    ImGui::Checkbox("Enable Frame Profiler", &enableObject());
+    ImGui::DragInt("Capture Frames", &captureFramesObject(), 1.f, 1, 10000, "%d", ImGuiSliderFlags_AlwaysClamp);
+
+    const bool capturing = profiler.isCapturing();
+    ImGui::BeginDisabled(capturing);
+    if (ImGui::Button(capturing ? "Capturing..." : "Capture")) {
+      requestCapture();
+    }
+    ImGui::EndDisabled();
+
+    if (!enable()) {
+      return;
+    }
+
+    const std::vector<FrameProfiler::ZoneStats> stats = profiler.getFrameStats();
+
+    ImGui::Text("Frame: %.2f ms, %zu zones, %llu events dropped", profiler.getLastFrameTimeMs(), stats.size(),
+                static_cast<unsigned long long>(profiler.getNumDroppedEvents()));
+
+    constexpr ImGuiTableFlags tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("Frame Profiler Zones", 4, tableFlags, ImVec2(0.f, 300.f))) {
+      ImGui::TableSetupScrollFreeze(0, 1);
+      ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+      ImGui::TableSetupColumn("Calls");
+      ImGui::TableSetupColumn("Total [ms]");
+      ImGui::TableSetupColumn("Max [ms]");
+      ImGui::TableHeadersRow();
+
+      for (const FrameProfiler::ZoneStats& zone : stats) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(zone.name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", zone.count);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", zone.totalMs);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", zone.maxMs);
+      }
+
+      ImGui::EndTable();
+    }
+  }
+
+}
@@ -0,0 +1,66 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include "rtx_option.h"
+#include "../../util/util_keybind.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Options and UI of the built-in frame profiler
+   *
+   * Drives FrameProfiler from the RTX options once per presented
+   * frame, see FrameProfiler for the recording itself.
+   */
+  class RtxFrameProfiler {
+  public:
+    RTX_OPTION("rtx.profiler", bool, enable, false,
+               "Enables the built-in frame profiler, which records CPU profile zones without Tracy and shows per-frame aggregates in the developer menu.");
+    RTX_OPTION("rtx.profiler", int, captureFrames, 60,
+               "Number of frames recorded by a frame profiler capture.");
+    RTX_OPTION("rtx.profiler", int, captureStartFrame, 0,
+               "Starts a frame profiler capture automatically once this many frames have been presented. 0 disables the automatic capture.");
+    RTX_OPTION("rtx.profiler", std::string, capturePath, "",
+               "Path of the Chrome trace JSON file written by a frame profiler capture, which can be opened in chrome://tracing or Perfetto.\n"
+               "When empty, captures are written to the working directory, named after the executable.");
+    inline static const VirtualKeys kDefaultCaptureHotKey { VirtualKey{VK_CONTROL},VirtualKey{VK_SHIFT},VirtualKey{'P'} };
+    RTX_OPTION("rtx.profiler", VirtualKeys, captureHotKey, kDefaultCaptureHotKey,
+               "Hotkey to start a frame profiler capture.");
+
+    /**
+     * \brief Collects the zones of the presented frame
+     *
+     * Called once per presented frame.
+     */
+    static void onFrameEnd();
+
+    static void requestCapture();
+
+    static void showImguiSettings();
+
+  private:
+    inline static std::atomic<uint32_t> s_numCaptures = { 0u };
+    inline static uint32_t s_frameIndex = 0;
+  };
+
+}
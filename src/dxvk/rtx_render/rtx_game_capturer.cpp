@@ -505,12 +505,23 @@ namespace dxvk {
     const std::string matName = dxvk::hashToString(materialData.getHash());
     lssMat.matName = matName;
     // Export Textures
-    const std::string albedoTexFilename(matName + lss::ext::dds);
-    m_exporter.dumpImageToFile(ctx, BASE_DIR + lss::commonDirName::texDir,
-                               albedoTexFilename,
-                               materialData.getColorTexture().getImageView()->image());
-    const std::string albedoTexPath = str::format(BASE_DIR + lss::commonDirName::texDir, albedoTexFilename);
-    lssMat.albedoTexPath = albedoTexPath;
+    // Note: Many materials share the same albedo texture (differing only by sampler or blend state),
+    //       so only export each unique image once and point every material at that file.
+    const XXH64_hash_t albedoImageHash = materialData.getColorTexture().getImageHash();
+    const auto exportedTexIt = m_pCap->exportedTextures.find(albedoImageHash);
+    if (albedoImageHash != kEmptyHash && exportedTexIt != m_pCap->exportedTextures.end()) {
+      lssMat.albedoTexPath = exportedTexIt->second;
+    } else {
+      const std::string albedoTexFilename(matName + lss::ext::dds);
+      m_exporter.dumpImageToFile(ctx, BASE_DIR + lss::commonDirName::texDir,
+                                 albedoTexFilename,
+                                 materialData.getColorTexture().getImageView()->image());
+      const std::string albedoTexPath = str::format(BASE_DIR + lss::commonDirName::texDir, albedoTexFilename);
+      lssMat.albedoTexPath = albedoTexPath;
+      if (albedoImageHash != kEmptyHash) {
+        m_pCap->exportedTextures[albedoImageHash] = albedoTexPath;
+      }
+    }
     // Opacity
     lssMat.enableOpacity = bEnableOpacity;
     // Collect sampler info
@@ -949,12 +960,40 @@ namespace dxvk {
     }
     // Cache VtArray if there is a large enough delta
     if (bSufficientlyDifferent) {
+      if (deduplicateMeshSamples()) {
+        deduplicateSample(*pMesh, newBuffer);
+      }
       bufferCache[currentFrameNum] = std::move(newBuffer);
+      ++pMesh->numSamples;
     }
     pMesh->meshSync.numOutstanding--;
     pMesh->meshSync.cond.notify_all();
   }
 
+  template <typename T>
+  void GameCapturer::deduplicateSample(Mesh& mesh, pxr::VtArray<T>& newBuffer) {
+    // Note: Caller must hold mesh.meshSync.mutex
+    const size_t numBytes = newBuffer.size() * sizeof(T);
+    // Seed with the element size so differently typed buffers with identical bytes don't collide in the common case
+    const XXH64_hash_t sampleHash = XXH3_64bits_withSeed(newBuffer.cdata(), numBytes, sizeof(T));
+    const auto [begin, end] = mesh.uniqueSamples.equal_range(sampleHash);
+    for (auto it = begin; it != end; ++it) {
+      if (!it->second.IsHolding<pxr::VtArray<T>>()) {
+        continue;
+      }
+      const auto& uniqueSample = it->second.UncheckedGet<pxr::VtArray<T>>();
+      if (uniqueSample.size() == newBuffer.size() &&
+          memcmp(uniqueSample.cdata(), newBuffer.cdata(), numBytes) == 0) {
+        // VtArray is copy-on-write, so this shares the existing storage rather than copying it,
+        // and the USD crate writer in turn only writes the shared array once.
+        newBuffer = uniqueSample;
+        ++mesh.numSharedSamples;
+        return;
+      }
+    }
+    mesh.uniqueSamples.emplace(sampleHash, pxr::VtValue(newBuffer));
+  }
+
   void GameCapturer::exportUsd(const Rc<DxvkContext> ctx) {
     assert(m_state.has<State::BeginExport>());
     assert(!m_state.has<State::PreppingExport>());
@@ -1062,10 +1101,16 @@ namespace dxvk {
 
   void GameCapturer::prepExportMeshes(const Capture& cap, lss::Export& exportPrep) {
     OriginCalc stageOriginCalc;
+    size_t numSamples = 0;
+    size_t numSharedSamples = 0;
     for (auto& [hash, pMesh] : cap.meshes) {
       std::unique_lock lock(pMesh->meshSync.mutex);
       pMesh->meshSync.cond.wait(lock,
         [pNumOutstanding = &pMesh->meshSync.numOutstanding] { return *pNumOutstanding == 0; });
+      numSamples += pMesh->numSamples;
+      numSharedSamples += pMesh->numSharedSamples;
+      // Samples are now referenced by the buffer sets alone
+      pMesh->uniqueSamples.clear();
       if (pMesh->lssData.numIndices == 0 && pMesh->lssData.numVertices == 0) {
         continue;
       }
@@ -1081,6 +1126,8 @@ namespace dxvk {
     if(m_correctBakedTransforms) {
       exportPrep.stageOrigin = stageOriginCalc.calc();
     }
+    Logger::info(str::format("[GameCapturer][", cap.idStr, "] Mesh buffer time samples: ", numSamples,
+                             ", shared with an identical earlier sample: ", numSharedSamples));
   }
 
   void GameCapturer::prepExportInstances(const Capture& cap, lss::Export& exportPrep) {
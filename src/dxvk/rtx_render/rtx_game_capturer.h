@@ -114,6 +114,10 @@ public:
                 "to all have identity xform matrices, enabling will attempt to correct this and\n"
                 "improve stage + mesh viewability in tools.\n"
                 "Hashes are unaffected.");
+  RW_RTX_OPTION("rtx.capture", bool, deduplicateMeshSamples, true,
+                "When enabled, mesh buffer time samples with identical contents are stored only once and\n"
+                "shared between all frames referencing them, so capture memory grows with the number of\n"
+                "distinct samples rather than the number of captured frames.");
 
   GameCapturer(DxvkDevice* const pDevice, SceneManager& sceneManager, AssetExporter& exporter);
   ~GameCapturer();
@@ -188,6 +192,10 @@ private:
     XXH64_hash_t     matHash;
     MeshSync         meshSync;
     AtomicOriginCalc originCalc;
+    // Content hash -> previously cached buffer time sample (any buffer type), guarded by meshSync.mutex
+    std::unordered_multimap<XXH64_hash_t, pxr::VtValue> uniqueSamples;
+    size_t           numSamples = 0;
+    size_t           numSharedSamples = 0;
   };
 
   struct Instance {
@@ -253,6 +261,8 @@ private:
                                     pxr::VtArray<T>& newBuffer,
                                     const float currentCaptureTime,
                                     CompareTReturnBool compareT);
+  template <typename T>
+  static void deduplicateSample(Mesh& mesh, pxr::VtArray<T>& newBuffer);
   void exportUsd(const Rc<DxvkContext> ctx);
   struct Capture;
   static lss::Export prepExport(const Capture& cap,
@@ -334,6 +344,8 @@ private:
     std::unordered_map<XXH64_hash_t, lss::DistantLight> distantLights;
     std::unordered_map<XXH64_hash_t, std::shared_ptr<Mesh>> meshes;
     std::unordered_map<XXH64_hash_t, Material> materials;
+    // Image hash -> path of the texture already exported for it
+    std::unordered_map<XXH64_hash_t, std::string> exportedTextures;
     std::unordered_map<XXH64_hash_t, Instance> instances;
     std::unordered_map<XXH64_hash_t, uint8_t> instanceFlags;
     HWND hwnd;
@@ -31,6 +31,7 @@
 #include <rtx_shaders/decode_and_add_opacity.h>
 #include <rtx_shaders/interleave_geometry.h>
 #include "dxvk_scoped_annotation.h"
+#include <version.h>
 
 #include "rtx_context.h"
 #include "rtx_options.h"
@@ -440,6 +441,13 @@ namespace dxvk {
     return numMicroTrianglesToBake;
   }
 
+  XXH64_hash_t RtxGeometryUtils::getBakeOpacityMicromapCodeHash() {
+    static const XXH64_hash_t s_hash = XXH3_64bits_withSeed(
+      BakeOpacityMicromapShader::getStaticCodeData(), BakeOpacityMicromapShader::getStaticCodeSize(),
+      XXH3_64bits(DXVK_VERSION, sizeof(DXVK_VERSION) - 1));
+    return s_hash;
+  }
+
   void RtxGeometryUtils::dispatchBakeOpacityMicromap(
     Rc<DxvkContext> ctx,
     const RaytraceGeometry& geo,
@@ -126,6 +126,14 @@ namespace dxvk {
       uint32_t& availableBakingBudget,
       Rc<DxvkBuffer> opacityMicromapBuffer) const;
 
+    /**
+     * \brief Identifies the code baking opacity micromaps
+     *
+     * Hash of the bake shader and the build version, changes
+     * whenever baked arrays may differ for the same inputs.
+     */
+    static XXH64_hash_t getBakeOpacityMicromapCodeHash();
+
     struct TextureConversionInfo {
       ReplacementMaterialTextureType::Enum type = ReplacementMaterialTextureType::Count;
       const TextureRef* sourceTexture = nullptr;
@@ -0,0 +1,169 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace dxvk 
+{
+// Host copy of a GPU table of fixed size entries, which tracks the entries written since the last
+// upload and uploads them in coalesced ranges instead of rewriting the whole table every frame.
+//
+// Entries are serialized with the same writeGPUData(data, offset) convention used by the surfaces
+// and materials. Writing an entry is not thread safe, but different tables may be written concurrently.
+class GpuTableUploader {
+public:
+  // Clean entries between two dirty ones are uploaded along with them when the gap is at most this
+  // many entries, a few redundant bytes are cheaper than another copy command.
+  static constexpr uint32_t kMaxMergeGap = 4;
+
+  explicit GpuTableUploader(size_t entrySize)
+    : m_entrySize(entrySize)
+    , m_scratch(entrySize) { }
+
+  GpuTableUploader(GpuTableUploader const&) = delete;
+  GpuTableUploader& operator=(GpuTableUploader const&) = delete;
+
+  size_t getEntrySize() const { return m_entrySize; }
+  uint32_t size() const { return m_numEntries; }
+  size_t getNumDirty() const { return m_dirtyIndices.size(); }
+  const std::vector<unsigned char>& getData() const { return m_data; }
+
+  // Entries added by growing the table are dirty, as the GPU copy of them is unknown
+  void resize(uint32_t numEntries) {
+    if (numEntries < m_numEntries) {
+      m_dirtyIndices.erase(std::remove_if(m_dirtyIndices.begin(), m_dirtyIndices.end(),
+                                          [numEntries](uint32_t index) { return index >= numEntries; }),
+                           m_dirtyIndices.end());
+    }
+
+    m_data.resize(numEntries * m_entrySize);
+    m_dirtyFlags.resize(numEntries, false);
+
+    for (uint32_t i = m_numEntries; i < numEntries; i++) {
+      markDirty(i);
+    }
+    m_numEntries = numEntries;
+  }
+
+  void markDirty(uint32_t index) {
+    if (!m_dirtyFlags[index]) {
+      m_dirtyFlags[index] = true;
+      m_dirtyIndices.push_back(index);
+    }
+  }
+
+  // Serializes an entry and marks it dirty
+  template<typename WriteFn>
+  void write(uint32_t index, WriteFn&& writeGPUData) {
+    size_t offset = index * m_entrySize;
+    writeGPUData(m_data.data(), offset);
+    assert(offset == (index + 1) * m_entrySize);
+    markDirty(index);
+  }
+
+  // Serializes an entry and marks it dirty only if its data changed, for tables without
+  // tracking of which entries were modified. Returns true if the entry changed.
+  template<typename WriteFn>
+  bool writeIfChanged(uint32_t index, WriteFn&& writeGPUData) {
+    size_t offset = 0;
+    writeGPUData(m_scratch.data(), offset);
+    assert(offset == m_entrySize);
+
+    unsigned char* entry = m_data.data() + index * m_entrySize;
+    if (memcmp(entry, m_scratch.data(), m_entrySize) == 0) {
+      return false;
+    }
+    memcpy(entry, m_scratch.data(), m_entrySize);
+    markDirty(index);
+    return true;
+  }
+
+  // Calls upload(offset, size, data) for every coalesced dirty range, or once for the whole table
+  // when everything is set, e.g. because the GPU buffer was recreated. Clears the dirty entries.
+  template<typename UploadFn>
+  void upload(bool everything, UploadFn&& upload) {
+    if (everything) {
+      if (m_numEntries > 0) {
+        upload(size_t(0), m_data.size(), m_data.data());
+      }
+    } else {
+      std::sort(m_dirtyIndices.begin(), m_dirtyIndices.end());
+
+      size_t i = 0;
+      while (i < m_dirtyIndices.size()) {
+        const uint32_t begin = m_dirtyIndices[i];
+        uint32_t end = begin + 1;
+        while (++i < m_dirtyIndices.size() && m_dirtyIndices[i] - end <= kMaxMergeGap) {
+          end = m_dirtyIndices[i] + 1;
+        }
+
+        const size_t offset = begin * m_entrySize;
+        upload(offset, (end - begin) * m_entrySize, m_data.data() + offset);
+      }
+    }
+
+    for (uint32_t index : m_dirtyIndices) {
+      m_dirtyFlags[index] = false;
+    }
+    m_dirtyIndices.clear();
+  }
+
+private:
+  const size_t m_entrySize;
+  uint32_t m_numEntries = 0;
+  std::vector<unsigned char> m_data;
+  std::vector<unsigned char> m_scratch;
+  std::vector<uint32_t> m_dirtyIndices;
+  std::vector<bool> m_dirtyFlags;
+};
+
+// Repacks the entries of a dirty tracking SparseUniqueCache which were added or freed since the last call.
+// Every entry is repacked when repackAll is set, e.g. when a global option read by writeGPUData changed.
+template<typename Cache>
+void packDirtyEntries(Cache& cache, GpuTableUploader& table, bool repackAll) {
+  table.resize(cache.getTotalCount());
+
+  auto pack = [&](uint32_t index) {
+    table.write(index, [&](unsigned char* data, size_t& offset) {
+      cache.getObjectTable()[index].writeGPUData(data, offset);
+    });
+  };
+
+  if (repackAll) {
+    for (uint32_t index = 0; index < cache.getTotalCount(); index++) {
+      pack(index);
+    }
+  } else {
+    for (uint32_t index : cache.getDirtyIndices()) {
+      pack(index);
+    }
+  }
+
+  cache.clearDirty();
+}
+
+}  // namespace dxvk
@@ -23,77 +23,145 @@
 
 #include "rtx_opacity_micromap_manager.h"
 #include "dxvk_device.h"
+#include "../util/log/metrics.h"
 
 namespace dxvk {
 
   static constexpr const char* HashSourceDataCategoryName[] = {
     "OpacityMicromap",
+    "GeometryHashes",
+    "Textures",
   };
   static_assert(std::size(HashSourceDataCategoryName) == static_cast<size_t>(HashSourceDataCategory::Count));
 
 
-  HashSourceDataCache::~HashSourceDataCache() {
+  HashCollisionDetection::Shard::~Shard() {
     release();
   }
 
-  void HashSourceDataCache::release(HashSourceDataCategory category) {
-    for (auto& cacheItem : m_hashSourceDataCaches[static_cast<uint8_t>(category)]) {
-      free(cacheItem.second);
-    }
-  }
-
-  void HashSourceDataCache::release() {
-    for (uint8_t i = 0; i < static_cast<uint8_t>(HashSourceDataCategory::Count); i++) {
-      release(static_cast<HashSourceDataCategory>(i));
+  void HashCollisionDetection::Shard::release() {
+    for (auto& cache : caches) {
+      for (auto& cacheItem : cache) {
+        free(cacheItem.second.data);
+      }
+      cache.clear();
     }
   }
 
-  fast_unordered_cache<void*>& HashSourceDataCache::getCache(HashSourceDataCategory category) {
-    return m_hashSourceDataCaches[static_cast<uint8_t>(category)];
-  }
-
   uint32_t HashCollisionDetection::getHashSourceDataSize(HashSourceDataCategory category) {
     switch (category) {
     case HashSourceDataCategory::OpacityMicromap: return sizeof(OpacityMicromapHashSourceData);
     default:
-      assert(!"Invalid category specified.");
+      assert(!"Category has no fixed source data size.");
       return 0;
     }
   }
 
-  void HashCollisionDetection::registerHashedSourceData(XXH64_hash_t hash, void* hashSourceData, HashSourceDataCategory category) {
+  HashCollisionDetection::Shard& HashCollisionDetection::getShard(XXH64_hash_t hash) {
+    // The low bits of the hash decide whether it is sampled, so pick the shard from the high ones
+    return s_shards[(hash >> 32) % kNumShards];
+  }
+
+  bool HashCollisionDetection::isSampled(XXH64_hash_t hash) {
     if (!HashCollisionDetectionOptions::enable()) {
-      return;
+      return false;
     }
 
-    auto bitExactMatch = [](const void* data0, const void* data1, uint32_t dataSize) {
-      return memcmp(data0, data1, dataSize) == 0;
-    };
+    const uint32_t sampleRate = std::max(HashCollisionDetectionOptions::sampleRate(), 1u);
+    return hash % sampleRate == 0;
+  }
 
-    std::lock_guard lock(s_cacheAccessMutex);
-    
-    fast_unordered_cache<void*>& cache = s_caches.getCache(category);
-    auto cacheItemIter = cache.find(hash);
+  void HashCollisionDetection::registerHashedSourceData(XXH64_hash_t hash, const void* hashSourceData, HashSourceDataCategory category) {
+    if (!isSampled(hash)) {
+      return;
+    }
 
     const uint32_t hashSourceDataSize = getHashSourceDataSize(category);
+    const XXH64_hash_t fingerprint = XXH3_64bits_withSeed(hashSourceData, hashSourceDataSize, kFingerprintSeed);
+
+    validate(hash, fingerprint, HashCollisionDetectionOptions::storeFullSourceData() ? hashSourceData : nullptr, category);
+  }
 
-    // Hash is in the cache
-    if (cacheItemIter != cache.end()) {
-      const void* cachedHashSourceData = cacheItemIter->second;
+  void HashCollisionDetection::registerHashedSourceData(XXH64_hash_t hash, const void* hashSourceData, size_t hashSourceDataSize, HashSourceDataCategory category) {
+    if (!isSampled(hash)) {
+      return;
+    }
 
-      // Validate the source data matches
-      if (!bitExactMatch(hashSourceData, cachedHashSourceData, hashSourceDataSize)) {
-        std::stringstream ssHash;
-        ssHash << "0x" << std::uppercase << std::setfill('0') << std::hex << hash;
+    validate(hash, XXH3_64bits_withSeed(hashSourceData, hashSourceDataSize, kFingerprintSeed), nullptr, category);
+  }
+
+  void HashCollisionDetection::registerHashFingerprint(XXH64_hash_t hash, XXH64_hash_t fingerprint, HashSourceDataCategory category) {
+    if (!isSampled(hash)) {
+      return;
+    }
+
+    validate(hash, fingerprint, nullptr, category);
+  }
 
-        Logger::err(str::format("[RTX Hash Collision Detection] Found a hash collision for hash ", ssHash.str(), " in category ", HashSourceDataCategoryName[static_cast<uint8_t>(category)]));
+  void HashCollisionDetection::validate(XXH64_hash_t hash, XXH64_hash_t fingerprint, const void* fullSourceData, HashSourceDataCategory category) {
+    static MetricCounter& s_validated = Metrics::counter("hash_collision.validated");
+    s_validated.add();
+
+    Shard& shard = getShard(hash);
+    std::lock_guard lock(shard.mutex);
+
+    auto [cacheItemIter, inserted] = shard.caches[static_cast<uint8_t>(category)].try_emplace(hash);
+    SourceData& sourceData = cacheItemIter->second;
+
+    // Hash is not in the cache, keep its source data for validating future registrations
+    if (inserted) {
+      sourceData.fingerprint = fingerprint;
+
+      if (fullSourceData) {
+        const uint32_t hashSourceDataSize = getHashSourceDataSize(category);
+        sourceData.data = malloc(hashSourceDataSize);
+        memcpy(sourceData.data, fullSourceData, hashSourceDataSize);
       }
-    } 
-    else { // Hash is not in the cache
-      // Insert it
-      void* hashSourceDataCopy = malloc(hashSourceDataSize);
-      memcpy(hashSourceDataCopy, hashSourceData, hashSourceDataSize);
-      cache.insert({ hash, hashSourceDataCopy });
+      return;
+    }
+
+    // Validate the source data matches, bit exactly if a full copy was kept
+    bool match = sourceData.fingerprint == fingerprint;
+    if (match && fullSourceData && sourceData.data) {
+      match = memcmp(fullSourceData, sourceData.data, getHashSourceDataSize(category)) == 0;
+    }
+
+    if (!match && !sourceData.reported) {
+      // Report every colliding hash once, it would otherwise flood the log every frame
+      sourceData.reported = true;
+      reportCollision(hash, category);
+    }
+  }
+
+  void HashCollisionDetection::reportCollision(XXH64_hash_t hash, HashSourceDataCategory category) {
+    static MetricCounter* s_collisionCounters[] = {
+      &Metrics::counter("hash_collision.opacity_micromap"),
+      &Metrics::counter("hash_collision.geometry"),
+      &Metrics::counter("hash_collision.textures"),
+    };
+    static_assert(std::size(s_collisionCounters) == static_cast<size_t>(HashSourceDataCategory::Count));
+
+    s_collisionCounts[static_cast<uint8_t>(category)].fetch_add(1, std::memory_order_relaxed);
+    s_collisionCounters[static_cast<uint8_t>(category)]->add();
+
+    std::stringstream ssHash;
+    ssHash << "0x" << std::uppercase << std::setfill('0') << std::hex << hash;
+
+    Logger::err(str::format("[RTX Hash Collision Detection] Found a hash collision for hash ", ssHash.str(), " in category ", HashSourceDataCategoryName[static_cast<uint8_t>(category)]));
+  }
+
+  uint64_t HashCollisionDetection::getCollisionCount(HashSourceDataCategory category) {
+    return s_collisionCounts[static_cast<uint8_t>(category)].load(std::memory_order_relaxed);
+  }
+
+  void HashCollisionDetection::reset() {
+    for (Shard& shard : s_shards) {
+      std::lock_guard lock(shard.mutex);
+      shard.release();
+    }
+
+    for (auto& count : s_collisionCounts) {
+      count.store(0, std::memory_order_relaxed);
     }
   }
 
@@ -29,6 +29,8 @@ namespace dxvk {
 
   enum class HashSourceDataCategory : uint8_t {
     OpacityMicromap = 0,
+    GeometryHashes,
+    Textures,
 
     Count
   };
@@ -37,33 +39,65 @@ namespace dxvk {
     friend class ImGUI;
 
     RTX_OPTION_ENV("rtx.hashCollisionDetection", bool, enable, false, "RTX_HASH_COLLISION_DETECTION", "Enables hash collision detection.");
+    RTX_OPTION("rtx.hashCollisionDetection", uint32_t, sampleRate, 1,
+               "Only one in this many hashes is validated, picked deterministically from the hash value so a sampled hash is validated every time it is seen.\n"
+               "A value of 1 validates every hash, higher values lower the overhead of leaving detection enabled at the cost of missing collisions.");
+    RTX_OPTION("rtx.hashCollisionDetection", bool, storeFullSourceData, true,
+               "Stores a full copy of fixed size hash source data, i.e. opacity micromap source data, and validates it bit exactly.\n"
+               "When disabled, a 64 bit fingerprint of the source data computed with a different seed is stored instead, which lowers the memory overhead.\n"
+               "Geometry and texture data is always validated with fingerprints.");
   };
 
-  class HashSourceDataCache {
+  // Validates that any hash of a category is always produced from the same source data.
+  // Each sampled hash keeps a secondary fingerprint of its source data, i.e. a hash of the same bytes with a different seed,
+  // and a later registration with a different fingerprint is reported as a collision.
+  // The tracked hashes are spread over shards with their own lock, so registration from multiple threads rarely contends.
+  class HashCollisionDetection {
   public:
-    ~HashSourceDataCache();
+    // Seed of the secondary fingerprints, source data hashes use the default seed of 0
+    static constexpr XXH64_hash_t kFingerprintSeed = 0x5bd1e9955bd1e995ull;
 
-    void release();
-    void release(HashSourceDataCategory category);
-    fast_unordered_cache<void* /*hashSourceData*/>& getCache(HashSourceDataCategory category);
+    // Returns true if registrations of this hash are validated, callers can skip computing the fingerprint otherwise
+    static bool isSampled(XXH64_hash_t hash);
 
-  private:
-    fast_unordered_cache<void* /*hashSourceData*/> m_hashSourceDataCaches[static_cast<uint8_t>(HashSourceDataCategory::Count)];
-  };
+    // Registers fixed size source data, see getHashSourceDataSize
+    // Expects hash source data to be fully padded and initialized
+    static void registerHashedSourceData(XXH64_hash_t hash, const void* hashSourceData, HashSourceDataCategory category);
 
-  // Caches hash source data and validates that any future hash source data instances have a matching hash source data for a given hash and a category
-  // Expects hash source data to be fully padded and initialized
-  class HashCollisionDetection {
-  public:
-    ~HashCollisionDetection();
+    // Registers contiguous source data of any size
+    static void registerHashedSourceData(XXH64_hash_t hash, const void* hashSourceData, size_t hashSourceDataSize, HashSourceDataCategory category);
+
+    // Registers a fingerprint of the source data of a hash, for source data which is not contiguous
+    static void registerHashFingerprint(XXH64_hash_t hash, XXH64_hash_t fingerprint, HashSourceDataCategory category);
+
+    static uint64_t getCollisionCount(HashSourceDataCategory category);
+
+    // Drops all tracked hashes and collision counts
+    static void reset();
 
-    static void registerHashedSourceData(XXH64_hash_t hash, void* hashSourceData, HashSourceDataCategory category);
-  
   private:
+    struct SourceData {
+      XXH64_hash_t fingerprint = 0;
+      void* data = nullptr; // Full copy, only with storeFullSourceData
+      bool reported = false;
+    };
+
+    struct Shard {
+      dxvk::mutex mutex;
+      fast_unordered_cache<SourceData> caches[static_cast<uint8_t>(HashSourceDataCategory::Count)];
+
+      ~Shard();
+      void release();
+    };
+
+    static constexpr uint32_t kNumShards = 16;
+
     static uint32_t getHashSourceDataSize(HashSourceDataCategory category);
+    static Shard& getShard(XXH64_hash_t hash);
+    static void validate(XXH64_hash_t hash, XXH64_hash_t fingerprint, const void* fullSourceData, HashSourceDataCategory category);
+    static void reportCollision(XXH64_hash_t hash, HashSourceDataCategory category);
 
-    inline static HashSourceDataCache s_caches;
-    inline static dxvk::mutex s_cacheAccessMutex;
-   };
+    inline static Shard s_shards[kNumShards];
+    inline static std::atomic<uint64_t> s_collisionCounts[static_cast<uint8_t>(HashSourceDataCategory::Count)] = {};
+  };
 }  // namespace dxvk
-
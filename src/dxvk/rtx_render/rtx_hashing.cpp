@@ -103,10 +103,10 @@ namespace dxvk {
   }
 
   template<typename T>
-  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices) {
+  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices, XXH64_hash_t seed) {
     ScopedCpuProfileZone();
 
-    XXH64_hash_t result = 0;
+    XXH64_hash_t result = seed;
 
     constexpr bool hasIndices = std::is_same<T, uint16_t>::value || std::is_same<T, uint32_t>::value;
 
@@ -217,9 +217,9 @@ namespace dxvk {
   }
 
   // Supported template params
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint16_t>& uniqueIndices);
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint32_t>& uniqueIndices);
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<int>& uniqueIndices);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint16_t>& uniqueIndices, XXH64_hash_t seed);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint32_t>& uniqueIndices, XXH64_hash_t seed);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<int>& uniqueIndices, XXH64_hash_t seed);
 
   template XXH64_hash_t hashIndicesLegacy<uint16_t>(const void* pIndexData, const size_t indexCount);
   template XXH64_hash_t hashIndicesLegacy<uint32_t>(const void* pIndexData, const size_t indexCount);
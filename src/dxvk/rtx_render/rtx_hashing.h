@@ -208,9 +208,10 @@ namespace dxvk {
     *
     *   query [in]: structure containing information about the region
     *   uniqueIndices [in]: indices (byte offsets as multiples of query.stride) to hash
+    *   seed [in]: seed of the hash chain, a different seed yields an independent fingerprint of the same data
     */
   template<typename T>
-  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices);
+  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices, XXH64_hash_t seed = 0);
 
   template<typename T>
   [[deprecated("(REMIX-656): Remove this once we can transition content to new hash)")]]
@@ -632,6 +632,44 @@ namespace dxvk {
     // NOTE: In the future we could extend this with heuristics as needed...
   }
 
+  RtInstance* InstanceManager::findSimilarInstance(const BlasEntry& blas, const XXH64_hash_t materialHash, const Matrix4& transform, const uint32_t currentFrameIdx, const float uniqueObjectDistanceSqr, float& nearestDistSqr) {
+    RtInstance* result = nullptr;
+
+    const Vector3 worldPosition = blas.input.getGeometryData().boundingBox.getTransformedCentroid(transform);
+
+    // Search the BLAS for an instance matching ours
+    const auto adjacentCells = blas.getSpatialMap().getDataNearPos(worldPosition);
+    for (const std::vector<const RtInstance*>* cellPtr : adjacentCells){
+      for (const RtInstance* instance : *cellPtr) {
+        if (instance->m_frameLastUpdated == currentFrameIdx) {
+          // If the transform is an exact match and the instance has already been touched this frame,
+          // then this is a second draw call on a single mesh.
+          const Matrix4 instanceTransform = instance->getTransform();
+          if (memcmp(&transform, &instanceTransform, sizeof(instanceTransform)) == 0) {
+            nearestDistSqr = 0.0f;
+            return const_cast<RtInstance*>(instance);
+          }
+        } else if (instance->m_materialHash == materialHash) {
+          // Instance hasn't been touched yet this frame.
+
+          const Vector3& prevInstanceWorldPosition = instance->getSpatialCachePosition();
+
+          const float distSqr = lengthSqr(prevInstanceWorldPosition - worldPosition);
+          if (distSqr <= uniqueObjectDistanceSqr && distSqr < nearestDistSqr) {
+            nearestDistSqr = distSqr;
+            result = const_cast<RtInstance*>(instance);
+            if (distSqr == 0.0f) {
+              // Not going to find anything closer.
+              return result;
+            }
+          }
+        }
+      }
+    }
+
+    return result;
+  }
+
   RtInstance* InstanceManager::findSimilarInstance(const BlasEntry& blas, const RtSurfaceMaterial& material, const Matrix4& transform, CameraType::Enum cameraType, const RayPortalManager& rayPortalManager) {
 
     // Disable temporal correlation between instances so that duplicate instances are not created
@@ -640,52 +678,18 @@ namespace dxvk {
       return nullptr;
     }
 
-    RtInstance* result = nullptr;
-
     const uint32_t currentFrameIdx = m_device->getCurrentFrameId();
-    const Vector3 worldPosition = blas.input.getGeometryData().boundingBox.getTransformedCentroid(transform);
-    
-    const float uniqueObjectDistanceSqr = RtxOptions::Get()->getUniqueObjectDistanceSqr();
+    const float uniqueObjectDistanceSqr = RtxOptions::getUniqueObjectDistanceSqr();
 
-    RtInstance* pSimilar = nullptr;
     float nearestDistSqr = FLT_MAX;
-
-    // Search the BLAS for an instance matching ours
-    {
-      const auto adjacentCells = blas.getSpatialMap().getDataNearPos(worldPosition);
-      for (const std::vector<const RtInstance*>* cellPtr : adjacentCells){
-        for (const RtInstance* instance : *cellPtr) {
-          if (instance->m_frameLastUpdated == currentFrameIdx) {
-            // If the transform is an exact match and the instance has already been touched this frame,
-            // then this is a second draw call on a single mesh.
-            const Matrix4 instanceTransform = instance->getTransform();
-            if (memcmp(&transform, &instanceTransform, sizeof(instanceTransform)) == 0) {
-              return const_cast<RtInstance*>(instance);
-            }
-          } else if (instance->m_materialHash == material.getHash()) {
-            // Instance hasn't been touched yet this frame.
-
-            const Vector3& prevInstanceWorldPosition = instance->getSpatialCachePosition();
-
-            const float distSqr = lengthSqr(prevInstanceWorldPosition - worldPosition);
-            if (distSqr <= uniqueObjectDistanceSqr && distSqr < nearestDistSqr) {
-              if (distSqr == 0.0f) {
-                // Not going to find anything closer.
-                return const_cast<RtInstance*>(instance);
-              }
-              nearestDistSqr = distSqr;
-              result = const_cast<RtInstance*>(instance);
-            }
-          }
-        }
-      }
-    }
+    RtInstance* result = findSimilarInstance(blas, material.getHash(), transform, currentFrameIdx, uniqueObjectDistanceSqr, nearestDistSqr);
 
     // For portal gun and other objects that were drawn in the ViewModel, need to check the
     // virtual version of the instance from previous frame.
     if (nearestDistSqr > 0.0f &&
         cameraType == CameraType::ViewModel && 
         RtxOptions::Get()->isRayPortalVirtualInstanceMatchingEnabled() ) {
+      const Vector3 worldPosition = blas.input.getGeometryData().boundingBox.getTransformedCentroid(transform);
       const Matrix4* teleportMatrix = nullptr;
       for (const RtInstance* instance : blas.getLinkedInstances()) {
         if (instance->m_frameLastUpdated != currentFrameIdx - 1 || 
@@ -56,6 +56,7 @@ public:
 
   BlasEntry* getBlas() const { return m_linkedBlas; }
   const XXH64_hash_t& getMaterialHash() const { return m_materialHash; }
+  void setMaterialHash(const XXH64_hash_t materialHash) { m_materialHash = materialHash; }
   const XXH64_hash_t& getMaterialDataHash() const { return m_materialDataHash; }
   const XXH64_hash_t& getTexcoordHash() const { return m_texcoordHash; }
   const XXH64_hash_t& getIndexHash() const { return m_indexHash; }
@@ -308,6 +309,11 @@ public:
   void resetSurfaceIndices();
 
   const std::vector<IntersectionBillboard>& getBillboards() const { return m_billboards; }
+
+  // Device independent part of the instance matching (also used by the draw call trace replay): searches the BLAS spatial map
+  // for an instance drawn this frame with the same transform, or the nearest one of the previous frames with the same material.
+  // nearestDistSqr is updated with the squared distance of the returned instance.
+  static RtInstance* findSimilarInstance(const BlasEntry& blas, const XXH64_hash_t materialHash, const Matrix4& transform, const uint32_t currentFrameIdx, const float uniqueObjectDistanceSqr, float& nearestDistSqr);
   
 private:
   ResourceCache* m_pResourceCache;
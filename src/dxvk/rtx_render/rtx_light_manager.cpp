@@ -99,12 +99,15 @@ namespace dxvk {
   }
 
   void LightManager::garbageCollectionInternal() {
-    const uint32_t currentFrame = m_device->getCurrentFrameId();
-    const uint32_t framesToKeep = RtxOptions::Get()->getNumFramesToKeepLights();
-    const uint32_t framesToSleep = RtxOptions::Get()->getNumFramesToPutLightsToSleep();
+    garbageCollectLights(m_lights, m_device->getCurrentFrameId());
+  }
+
+  void LightManager::garbageCollectLights(std::unordered_map<XXH64_hash_t, RtLight>& lights, const uint32_t currentFrame) {
+    const uint32_t framesToKeep = RtxOptions::getNumFramesToKeepLights();
+    const uint32_t framesToSleep = RtxOptions::getNumFramesToPutLightsToSleep();
 
-    const bool forceGarbageCollection = (m_lights.size() >= RtxOptions::AntiCulling::Light::numLightsToKeep());
-    for (auto it = m_lights.begin(); it != m_lights.end();) {
+    const bool forceGarbageCollection = (lights.size() >= RtxOptions::AntiCulling::Light::numLightsToKeep());
+    for (auto it = lights.begin(); it != lights.end();) {
       const RtLight& light = it->second;
       const uint32_t frameLastTouched = light.getFrameLastTouched();
       if (!RtxOptions::AntiCulling::Light::enable() || // It's always True if anti-culling is disabled
@@ -112,11 +115,11 @@ namespace dxvk {
            frameLastTouched + RtxOptions::AntiCulling::Light::numFramesToExtendLightLifetime() <= currentFrame)) {
         if (light.isChildOfMesh() || light.isDynamic || suppressLightKeeping()) {
           if (light.getFrameLastTouched() < currentFrame) {
-            it = m_lights.erase(it);
+            it = lights.erase(it);
             continue;
           }
         } else if ((light.isStaticCount < framesToSleep) && (frameLastTouched + framesToKeep) <= currentFrame) {
-          it = m_lights.erase(it);
+          it = lights.erase(it);
           continue;
         }
       }
@@ -348,7 +351,7 @@ namespace dxvk {
 
       // Note: Highest light index reserved for the invalid index sentinel.
       if (m_currentActiveLightCount == LIGHT_INDEX_INVALID) {
-        ONCE(Logger::info(str::format("[RTX-Compatibility-Info] Raytracing support more than 65535 lights currently, skipping some lights for now.")));
+        ONCE(Logger::info("[RTX-Compatibility-Info] Raytracing support more than 65535 lights currently, skipping some lights for now."));
         break;
       }
     }
@@ -571,19 +574,23 @@ namespace dxvk {
 
     rtLight.setLightAntiCullingType(antiCullingType);
 
+    matchLight(m_lights, rtLight, lightToReplace, m_device->getCurrentFrameId());
+  }
+
+  void LightManager::matchLight(std::unordered_map<XXH64_hash_t, RtLight>& lights, const RtLight& rtLight, const XXH64_hash_t lightToReplace, const uint32_t currentFrameId) {
     // Replacement lights can have a unique hash from game lights, and so, we need to remember and
     //  remove the light specified as a parameter.
     if (lightToReplace != kEmptyHash && lightToReplace != rtLight.getInstanceHash()) {
-      const auto& lightToReplaceIt = m_lights.find(lightToReplace);
-      if (lightToReplaceIt != m_lights.end()) {
-        m_lights.erase(lightToReplaceIt);
+      const auto& lightToReplaceIt = lights.find(lightToReplace);
+      if (lightToReplaceIt != lights.end()) {
+        lights.erase(lightToReplaceIt);
       }
     }
 
-    const auto& foundLightIt = m_lights.find(rtLight.getInstanceHash());
-    if (foundLightIt != m_lights.end()) {
+    const auto& foundLightIt = lights.find(rtLight.getInstanceHash());
+    if (foundLightIt != lights.end()) {
       // Ignore changes in the same frame
-      if (foundLightIt->second.getFrameLastTouched() != m_device->getCurrentFrameId()) {
+      if (foundLightIt->second.getFrameLastTouched() != currentFrameId) {
         if (rtLight.isChildOfMesh()) {
           // If light transform changed, update it.
           if (foundLightIt->second.getTransformedHash() != rtLight.getTransformedHash()) {
@@ -596,7 +603,7 @@ namespace dxvk {
           const uint32_t isStaticCount = foundLightIt->second.isStaticCount;
 
           // If this light hasnt moved for N frames, put it to sleep.  This is a defeat device to stop games aggressively ramping up/down intensity as lights 
-          if (isStaticCount < RtxOptions::Get()->getNumFramesToPutLightsToSleep()) {
+          if (isStaticCount < RtxOptions::getNumFramesToPutLightsToSleep()) {
             uint16_t bufferIdx = foundLightIt->second.getBufferIdx();
             foundLightIt->second = rtLight;
             foundLightIt->second.setBufferIdx(bufferIdx);
@@ -611,19 +618,19 @@ namespace dxvk {
         }
 
         // We saw this light so bump its frame counter.
-        foundLightIt->second.setFrameLastTouched(m_device->getCurrentFrameId());
+        foundLightIt->second.setFrameLastTouched(currentFrameId);
       }
 
     } else {
       //  Try find a similar light
       std::optional<RtLight> similarLight;
       float bestSimilarity = kNotSimilar;
-      for (auto&& pair : m_lights) {
+      for (auto&& pair : lights) {
         const RtLight& light = pair.second;
 
         // Update the cached light if it's similar.  This should catch minor perturbations in static lights (e.g. due to precision loss)
         const float kDistanceThresholdMeters = 0.02f;
-        const float kDistanceThresholdWorldUnits = kDistanceThresholdMeters * RtxOptions::Get()->getMeterToWorldUnitScale();
+        const float kDistanceThresholdWorldUnits = kDistanceThresholdMeters * RtxOptions::getMeterToWorldUnitScale();
         const float thisLightsSimilarity = isSimilar(light, rtLight, kDistanceThresholdWorldUnits);
 
         if (thisLightsSimilarity >= 0.f && thisLightsSimilarity > bestSimilarity) {
@@ -635,11 +642,11 @@ namespace dxvk {
 
       if (similarLight.has_value()) {
         // Remove it, since we want to re-add it with a (potentially) new hash
-        m_lights.erase(similarLight->getInstanceHash());
+        lights.erase(similarLight->getInstanceHash());
       }
 
       // Add as a new light (with/out updated data depending on if a similar light was found)
-      const auto& [localLightIterator, addedSuccessfully] = m_lights.try_emplace(rtLight.getInstanceHash(), rtLight);
+      const auto& [localLightIterator, addedSuccessfully] = lights.try_emplace(rtLight.getInstanceHash(), rtLight);
       RtLight& localLight = localLightIterator->second;
 
       // Note: Ensure that the new light was added successfully (meaning that no existing light existed in the light map at the
@@ -654,7 +661,7 @@ namespace dxvk {
         updateLight(similarLight.value(), localLight);
 
       // Record we saw this light
-      localLight.setFrameLastTouched(m_device->getCurrentFrameId());
+      localLight.setFrameLastTouched(currentFrameId);
     }
   }
 
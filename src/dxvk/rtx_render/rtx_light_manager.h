@@ -89,6 +89,11 @@ public:
   void addLight(const RtLight& light, const RtLightAntiCullingType antiCullingType, const XXH64_hash_t lightToReplace = kEmptyHash);
   void addLight(const RtLight& light, const DrawCallState& drawCallState, const RtLightAntiCullingType antiCullingType);
 
+  // Device independent parts of the light tracking, operating on a light table (also used by the draw call trace replay).
+  // Updates a tracked light in place or adds it, inheriting the state of a similar light from previous frames if there is one.
+  static void matchLight(std::unordered_map<XXH64_hash_t, RtLight>& lights, const RtLight& light, const XXH64_hash_t lightToReplace, const uint32_t currentFrameId);
+  static void garbageCollectLights(std::unordered_map<XXH64_hash_t, RtLight>& lights, const uint32_t currentFrame);
+
   void addExternalLight(remixapi_LightHandle handle, const RtLight& rtlight);
   void addExternalDomeLight(remixapi_LightHandle handle, const DomeLight& domeLight);
   void removeExternalLight(remixapi_LightHandle handle);
@@ -21,6 +21,10 @@
 */
 #pragma once
 
+#include <array>
+#include <cstring>
+#include <type_traits>
+
 #include "../../lssusd/mdl_helpers.h"
 
 #include "../../lssusd/usd_include_begin.h"
@@ -195,11 +199,23 @@
 #define WRITE_CONSTANT_SANITIZATION(name, usd_attr, type, minVal, maxVal, defaultVal) \
       m_##name = clamp(m_##name, ranges.Min##name, ranges.Max##name);
 
-#define WRITE_TEXTURE_HASH(name, usd_attr, type, minVal, maxVal, defaultVal) \
-      h ^= m_##name.getImageHash();
+#define WRITE_TEXTURE_HASH_SIZE(name, usd_attr, type, minVal, maxVal, defaultVal) \
+      + sizeof(XXH64_hash_t)
+
+#define WRITE_CONSTANT_HASH_SIZE(name, usd_attr, type, minVal, maxVal, defaultVal) \
+      + sizeof(type)
+
+#define WRITE_TEXTURE_HASH_DATA(name, usd_attr, type, minVal, maxVal, defaultVal) \
+      { \
+        const XXH64_hash_t imageHash = m_##name.getImageHash(); \
+        memcpy(dst, &imageHash, sizeof(imageHash)); \
+        dst += sizeof(imageHash); \
+      }
 
-#define WRITE_CONSTANT_HASH(name, usd_attr, type, minVal, maxVal, defaultVal) \
-      h = XXH64(&m_##name, sizeof(m_##name), h);
+#define WRITE_CONSTANT_HASH_DATA(name, usd_attr, type, minVal, maxVal, defaultVal) \
+      static_assert(std::is_trivially_copyable_v<type>); \
+      memcpy(dst, &m_##name, sizeof(m_##name)); \
+      dst += sizeof(m_##name);
 
 #define WRITE_PARAMETER_MEMBERS(name, usd_attr, type, minVal, maxVal, defaultVal) \
       type m_##name = defaultVal;
@@ -248,8 +264,31 @@ struct name##Data {
     return m_cachedHash;                                                                             \
   }                                                                                                  \
                                                                                                      \
+  /* Note: Compares the hashed data rather than only the hash to rule out collisions. */             \
+  bool operator==(const name##Data& r) const {                                                       \
+    return m_cachedHash == r.m_cachedHash && getHashData() == r.getHashData();                       \
+  }                                                                                                  \
+                                                                                                     \
+  bool operator!=(const name##Data& r) const {                                                       \
+    return !(*this == r);                                                                            \
+  }                                                                                                  \
+                                                                                                     \
 private:                                                                                             \
                                                                                                      \
+  /* Note: All hashed values packed back to back in declaration order, i.e. without any padding */   \
+  /*       bytes, so the whole material can be hashed and compared in one go.                   */   \
+  using HashData = std::array<uint8_t,                                                               \
+    0 X_TEXTURES(WRITE_TEXTURE_HASH_SIZE) X_CONSTANTS(WRITE_CONSTANT_HASH_SIZE)>;                    \
+                                                                                                     \
+  HashData getHashData() const {                                                                     \
+    HashData data;                                                                                   \
+    uint8_t* dst = data.data();                                                                      \
+    X_TEXTURES(WRITE_TEXTURE_HASH_DATA)                                                              \
+    X_CONSTANTS(WRITE_CONSTANT_HASH_DATA)                                                            \
+    assert(dst == data.data() + data.size());                                                        \
+    return data;                                                                                     \
+  }                                                                                                  \
+                                                                                                     \
   struct Ranges {                                                                                    \
     X_CONSTANTS(WRITE_CONSTANT_RANGES)                                                               \
   };                                                                                                 \
@@ -262,10 +301,8 @@ private:
   }                                                                                                  \
                                                                                                      \
   void updateCachedHash() {                                                                          \
-    XXH64_hash_t h = 0;                                                                              \
-    X_TEXTURES(WRITE_TEXTURE_HASH)                                                                   \
-    X_CONSTANTS(WRITE_CONSTANT_HASH)                                                                 \
-    m_cachedHash = h;                                                                                \
+    const HashData data = getHashData();                                                             \
+    m_cachedHash = XXH3_64bits(data.data(), data.size());                                            \
   }                                                                                                  \
                                                                                                      \
   X_PARAMS(WRITE_PARAMETER_MEMBERS)                                                                  \
@@ -302,8 +339,10 @@ namespace dxvk {
 #undef WRITE_PARAMETER_MERGE
 #undef WRITE_CONSTANT_RANGES
 #undef WRITE_CONSTANT_SANITIZATION
-#undef WRITE_TEXTURE_HASH
-#undef WRITE_CONSTANT_HASH
+#undef WRITE_TEXTURE_HASH_SIZE
+#undef WRITE_CONSTANT_HASH_SIZE
+#undef WRITE_TEXTURE_HASH_DATA
+#undef WRITE_CONSTANT_HASH_DATA
 #undef WRITE_PARAMETER_MEMBERS
 #undef WRITE_DIRTY_FLAGS
 
@@ -27,7 +27,7 @@
 namespace dxvk {
 
 bool getEnableDiffuseLayerOverrideHack() {
-  return RtxOptions::Get()->translucentMaterialOptions.enableDiffuseLayerOverride();
+  return TranslucentMaterialOptions::enableDiffuseLayerOverride();
 }
 
 float getEmissiveIntensity() {
@@ -78,6 +78,29 @@ bool getEnableDiffuseLayerOverrideHack();
 float getEmissiveIntensity();
 float getDisplacementFactor();
 
+// Global options read when serializing surface materials with writeGPUData. The packed data of every
+// cached material is stale when any of these change, so the material tables need to be repacked in full.
+struct SurfaceMaterialGPUOptions {
+  float displacementFactor = 0.f;
+  bool enableDiffuseLayerOverride = false;
+
+  static SurfaceMaterialGPUOptions get() {
+    SurfaceMaterialGPUOptions options;
+    options.displacementFactor = getDisplacementFactor();
+    options.enableDiffuseLayerOverride = getEnableDiffuseLayerOverrideHack();
+    return options;
+  }
+
+  bool operator==(const SurfaceMaterialGPUOptions& other) const {
+    return displacementFactor == other.displacementFactor &&
+           enableDiffuseLayerOverride == other.enableDiffuseLayerOverride;
+  }
+
+  bool operator!=(const SurfaceMaterialGPUOptions& other) const {
+    return !(*this == other);
+  }
+};
+
 struct RtSurface {
   RtSurface() {
   }
@@ -507,7 +530,7 @@ struct RtOpaqueSurfaceMaterial {
   }
 
   bool operator==(const RtOpaqueSurfaceMaterial& r) const {
-    return m_cachedHash == r.m_cachedHash;
+    return m_cachedHash == r.m_cachedHash && getHashData() == r.getHashData();
   }
 
   XXH64_hash_t getHash() const {
@@ -579,31 +602,61 @@ struct RtOpaqueSurfaceMaterial {
   }
 
 private:
-  void updateCachedHash() {
-    XXH64_hash_t h = 0;
-
-    h = XXH64(&m_albedoOpacityTextureIndex, sizeof(m_albedoOpacityTextureIndex), h);
-    h = XXH64(&m_normalTextureIndex, sizeof(m_normalTextureIndex), h);
-    h = XXH64(&m_tangentTextureIndex, sizeof(m_tangentTextureIndex), h);
-    h = XXH64(&m_heightTextureIndex, sizeof(m_heightTextureIndex), h);
-    h = XXH64(&m_roughnessTextureIndex, sizeof(m_roughnessTextureIndex), h);
-    h = XXH64(&m_metallicTextureIndex, sizeof(m_metallicTextureIndex), h);
-    h = XXH64(&m_emissiveColorTextureIndex, sizeof(m_emissiveColorTextureIndex), h);
-    h = XXH64(&m_anisotropy, sizeof(m_anisotropy), h);
-    h = XXH64(&m_emissiveIntensity, sizeof(m_emissiveIntensity), h);
-    h = XXH64(&m_albedoOpacityConstant, sizeof(m_albedoOpacityConstant), h);
-    h = XXH64(&m_roughnessConstant, sizeof(m_roughnessConstant), h);
-    h = XXH64(&m_metallicConstant, sizeof(m_metallicConstant), h);
-    h = XXH64(&m_emissiveColorConstant, sizeof(m_emissiveColorConstant), h);
-    h = XXH64(&m_enableEmission, sizeof(m_enableEmission), h);
-    h = XXH64(&m_enableThinFilm, sizeof(m_enableThinFilm), h);
-    h = XXH64(&m_alphaIsThinFilmThickness, sizeof(m_alphaIsThinFilmThickness), h);
-    h = XXH64(&m_thinFilmThicknessConstant, sizeof(m_thinFilmThicknessConstant), h);
-    h = XXH64(&m_samplerIndex, sizeof(m_samplerIndex), h);
-    h = XXH64(&m_displaceIn, sizeof(m_displaceIn), h);
-    h = XXH64(&m_subsurfaceMaterialIndex, sizeof(m_subsurfaceMaterialIndex), h);
+  // Note: Members are all 4 bytes wide so the struct has no padding to hash or compare.
+  struct HashStruct {
+    uint32_t m_albedoOpacityTextureIndex;
+    uint32_t m_normalTextureIndex;
+    uint32_t m_tangentTextureIndex;
+    uint32_t m_heightTextureIndex;
+    uint32_t m_roughnessTextureIndex;
+    uint32_t m_metallicTextureIndex;
+    uint32_t m_emissiveColorTextureIndex;
+    uint32_t m_samplerIndex;
+    uint32_t m_subsurfaceMaterialIndex;
+    float m_anisotropy;
+    float m_emissiveIntensity;
+    Vector4 m_albedoOpacityConstant;
+    float m_roughnessConstant;
+    float m_metallicConstant;
+    Vector3 m_emissiveColorConstant;
+    float m_thinFilmThicknessConstant;
+    float m_displaceIn;
+    uint32_t m_flags;
+
+    XXH64_hash_t calculateHash() const {
+      static_assert(sizeof(HashStruct) == sizeof(uint32_t) * 23);
+      return XXH3_64bits(this, sizeof(HashStruct));
+    }
 
-    m_cachedHash = h;
+    bool operator==(const HashStruct& r) const {
+      return memcmp(this, &r, sizeof(HashStruct)) == 0;
+    }
+  };
+
+  HashStruct getHashData() const {
+    return HashStruct {
+      m_albedoOpacityTextureIndex,
+      m_normalTextureIndex,
+      m_tangentTextureIndex,
+      m_heightTextureIndex,
+      m_roughnessTextureIndex,
+      m_metallicTextureIndex,
+      m_emissiveColorTextureIndex,
+      m_samplerIndex,
+      m_subsurfaceMaterialIndex,
+      m_anisotropy,
+      m_emissiveIntensity,
+      m_albedoOpacityConstant,
+      m_roughnessConstant,
+      m_metallicConstant,
+      m_emissiveColorConstant,
+      m_thinFilmThicknessConstant,
+      m_displaceIn,
+      uint32_t(m_enableEmission) | uint32_t(m_enableThinFilm) << 1 | uint32_t(m_alphaIsThinFilmThickness) << 2 };
+  }
+
+  void updateCachedHash() {
+    m_cachedHash = getHashData().calculateHash();
   }
 
   void updateCachedData() {
@@ -739,31 +792,54 @@ struct RtTranslucentSurfaceMaterial {
   }
 
   bool operator==(const RtTranslucentSurfaceMaterial& r) const {
-    return m_cachedHash == r.m_cachedHash;
+    return m_cachedHash == r.m_cachedHash && getHashData() == r.getHashData();
   }
 
   XXH64_hash_t getHash() const {
     return m_cachedHash;
   }
 private:
-  void updateCachedHash() {
-    XXH64_hash_t h = 0;
-
-    h = XXH64(&m_normalTextureIndex, sizeof(m_normalTextureIndex), h);
-    h = XXH64(&m_transmittanceTextureIndex, sizeof(m_transmittanceTextureIndex), h);
-    h = XXH64(&m_emissiveColorTextureIndex, sizeof(m_emissiveColorTextureIndex), h);
-    h = XXH64(&m_refractiveIndex, sizeof(m_refractiveIndex), h);
-    h = XXH64(&m_transmittanceColor, sizeof(m_transmittanceColor), h);
-    h = XXH64(&m_transmittanceMeasurementDistance, sizeof(m_transmittanceMeasurementDistance), h);
-    h = XXH64(&m_enableEmission, sizeof(m_enableEmission), h);
-    h = XXH64(&m_emissiveIntensity, sizeof(m_emissiveIntensity), h);
-    h = XXH64(&m_emissiveColorConstant, sizeof(m_emissiveColorConstant), h);
-    h = XXH64(&m_isThinWalled, sizeof(m_isThinWalled), h);
-    h = XXH64(&m_thinWallThickness, sizeof(m_thinWallThickness), h);
-    h = XXH64(&m_useDiffuseLayer, sizeof(m_useDiffuseLayer), h);
-    h = XXH64(&m_samplerIndex, sizeof(m_samplerIndex), h);
+  // Note: Members are all 4 bytes wide so the struct has no padding to hash or compare.
+  struct HashStruct {
+    uint32_t m_normalTextureIndex;
+    uint32_t m_transmittanceTextureIndex;
+    uint32_t m_emissiveColorTextureIndex;
+    uint32_t m_samplerIndex;
+    float m_refractiveIndex;
+    Vector3 m_transmittanceColor;
+    float m_transmittanceMeasurementDistance;
+    float m_emissiveIntensity;
+    Vector3 m_emissiveColorConstant;
+    float m_thinWallThickness;
+    uint32_t m_flags;
+
+    XXH64_hash_t calculateHash() const {
+      static_assert(sizeof(HashStruct) == sizeof(uint32_t) * 15);
+      return XXH3_64bits(this, sizeof(HashStruct));
+    }
 
-    m_cachedHash = h;
+    bool operator==(const HashStruct& r) const {
+      return memcmp(this, &r, sizeof(HashStruct)) == 0;
+    }
+  };
+
+  HashStruct getHashData() const {
+    return HashStruct {
+      m_normalTextureIndex,
+      m_transmittanceTextureIndex,
+      m_emissiveColorTextureIndex,
+      m_samplerIndex,
+      m_refractiveIndex,
+      m_transmittanceColor,
+      m_transmittanceMeasurementDistance,
+      m_emissiveIntensity,
+      m_emissiveColorConstant,
+      m_thinWallThickness,
+      uint32_t(m_enableEmission) | uint32_t(m_isThinWalled) << 1 | uint32_t(m_useDiffuseLayer) << 2 };
+  }
+
+  void updateCachedHash() {
+    m_cachedHash = getHashData().calculateHash();
   }
 
   void updateCachedData() {
@@ -854,7 +930,7 @@ struct RtRayPortalSurfaceMaterial {
   }
 
   bool operator==(const RtRayPortalSurfaceMaterial& r) const {
-    return m_cachedHash == r.m_cachedHash;
+    return m_cachedHash == r.m_cachedHash && getHashData() == r.getHashData();
   }
 
   XXH64_hash_t getHash() const {
@@ -894,19 +970,41 @@ struct RtRayPortalSurfaceMaterial {
   }
 
 private:
-  void updateCachedHash() {
-    XXH64_hash_t h = 0;
+  // Note: Members are all 4 bytes wide so the struct has no padding to hash or compare.
+  struct HashStruct {
+    uint32_t m_maskTextureIndex;
+    uint32_t m_maskTextureIndex2;
+    uint32_t m_samplerIndex;
+    uint32_t m_samplerIndex2;
+    uint32_t m_rayPortalIndex;
+    float m_rotationSpeed;
+    float m_emissiveIntensity;
+    uint32_t m_enableEmission;
+
+    XXH64_hash_t calculateHash() const {
+      static_assert(sizeof(HashStruct) == sizeof(uint32_t) * 8);
+      return XXH3_64bits(this, sizeof(HashStruct));
+    }
 
-    h = XXH64(&m_maskTextureIndex, sizeof(m_maskTextureIndex), h);
-    h = XXH64(&m_maskTextureIndex2, sizeof(m_maskTextureIndex2), h);
-    h = XXH64(&m_rayPortalIndex, sizeof(m_rayPortalIndex), h);
-    h = XXH64(&m_rotationSpeed, sizeof(m_rotationSpeed), h);
-    h = XXH64(&m_enableEmission, sizeof(m_enableEmission), h);
-    h = XXH64(&m_emissiveIntensity, sizeof(m_emissiveIntensity), h);
-    h = XXH64(&m_samplerIndex, sizeof(m_samplerIndex), h);
-    h = XXH64(&m_samplerIndex2, sizeof(m_samplerIndex2), h);
+    bool operator==(const HashStruct& r) const {
+      return memcmp(this, &r, sizeof(HashStruct)) == 0;
+    }
+  };
 
-    m_cachedHash = h;
+  HashStruct getHashData() const {
+    return HashStruct {
+      m_maskTextureIndex,
+      m_maskTextureIndex2,
+      m_samplerIndex,
+      m_samplerIndex2,
+      m_rayPortalIndex,
+      m_rotationSpeed,
+      m_emissiveIntensity,
+      uint32_t(m_enableEmission) };
+  }
+
+  void updateCachedHash() {
+    m_cachedHash = getHashData().calculateHash();
   }
 
   uint32_t m_maskTextureIndex;
@@ -1004,7 +1102,7 @@ struct RtSubsurfaceMaterial {
   }
 
   bool operator==(const RtSubsurfaceMaterial& r) const {
-    return m_cachedHash == r.m_cachedHash;
+    return m_cachedHash == r.m_cachedHash && getHashData() == r.getHashData();
   }
 
   bool validate() const {
@@ -1054,14 +1152,18 @@ private:
     float m_subsurfaceVolumetricAnisotropy;
     Vector3 m_subsurfaceVolumetricAttenuationCoefficient;
 
-    XXH64_hash_t calculateHash() {
+    XXH64_hash_t calculateHash() const {
       static_assert(sizeof(HashStruct) == sizeof(uint32_t) * 14);
       return XXH3_64bits(this, sizeof(HashStruct));
     }
+
+    bool operator==(const HashStruct& r) const {
+      return memcmp(this, &r, sizeof(HashStruct)) == 0;
+    }
   };
 
-  void updateCachedHash() {
-    HashStruct hashData = {
+  HashStruct getHashData() const {
+    return HashStruct {
       m_subsurfaceTransmittanceTextureIndex,
       m_subsurfaceThicknessTextureIndex,
       m_subsurfaceSingleScatteringAlbedoTextureIndex,
@@ -1070,7 +1172,10 @@ private:
       m_subsurfaceSingleScatteringAlbedo,
       m_subsurfaceVolumetricAnisotropy,
       m_subsurfaceVolumetricAttenuationCoefficient };
-    m_cachedHash = hashData.calculateHash();
+  }
+
+  void updateCachedHash() {
+    m_cachedHash = getHashData().calculateHash();
   }
 
   // Thin Opaque Textures Index
@@ -52,11 +52,11 @@ public:
 
   virtual ~Mod();
 
-  // Loads the mod and initializes the replacements.
+  // Starts loading the mod, the mod may stay in the Loading state until a later checkForChanges.
   virtual void load(const Rc<DxvkContext>& context) = 0;
   // Unloads the mod and destroys the replacements.
   virtual void unload() = 0;
-  // Updates the replacements if mod changed.
+  // Updates the replacements if mod changed or finished loading. Returns true if they changed.
   virtual bool checkForChanges(const Rc<DxvkContext>& context) = 0;
 
   State state() const {
@@ -67,6 +67,12 @@ public:
     return m_status;
   }
 
+  // Fraction of the mod processed so far, only meaningful while Loading.
+  float loadingProgress() const {
+    const uint32_t numItems = m_numLoadingItems.load();
+    return numItems == 0 ? 0.f : float(m_numLoadedItems.load()) / float(numItems);
+  }
+
   AssetReplacements& replacements() {
     return *m_replacements.get();
   }
@@ -94,6 +100,15 @@ protected:
     m_state = state;
   }
 
+  void beginLoadingProgress(uint32_t numItems) {
+    m_numLoadedItems = 0;
+    m_numLoadingItems = numItems;
+  }
+
+  void advanceLoadingProgress(uint32_t numItems = 1) {
+    m_numLoadedItems += numItems;
+  }
+
   const Path m_filePath;
   std::string m_name;
   size_t m_priority;
@@ -101,6 +116,9 @@ protected:
   std::atomic<State> m_state;
   std::string m_status = "Unloaded";
 
+  std::atomic<uint32_t> m_numLoadingItems { 0 };
+  std::atomic<uint32_t> m_numLoadedItems { 0 };
+
   std::unique_ptr<AssetReplacements> m_replacements;
 };
 
@@ -56,6 +56,7 @@
 #include <pxr/base/arch/fileSystem.h>
 #include "../../lssusd/usd_include_end.h"
 #include "../util/util_watchdog.h"
+#include "../util/util_threadpool.h"
 
 #include "../../lssusd/game_exporter_common.h"
 #include "../../lssusd/game_exporter_paths.h"
@@ -79,6 +80,8 @@ public:
     , m_usdChangeWatchdog([this] { return this->haveFilesChanged(); }, "usd-mod-watchdog")
   {}
 
+  ~Impl();
+
   void load(const Rc<DxvkContext>& context);
   void unload();
   bool checkForChanges(const Rc<DxvkContext>& context);
@@ -86,22 +89,71 @@ public:
 private:
   UsdMod& m_owner;
 
+  // Material bound to an entry of a replacement, resolved once all prims are processed
+  struct PendingMaterial {
+    pxr::UsdPrim material;
+    // Used when material does not resolve, i.e. the material bound to the mesh of a geom subset
+    pxr::UsdPrim fallback;
+  };
+
+  // A replacement root prim, processed on the loader threads
+  struct PendingReplacement {
+    XXH64_hash_t hash;
+    AssetReplacement::Type type;
+    pxr::UsdPrim rootPrim;
+
+    std::vector<AssetReplacement> replacements;
+    // Parallel to replacements
+    std::vector<PendingMaterial> materials;
+  };
+
   struct Args {
     Rc<DxvkContext> context;
     pxr::UsdGeomXformCache& xformCache;
 
     pxr::UsdPrim& rootPrim;
     std::vector<AssetReplacement>& meshes;
+    std::vector<PendingMaterial>& materials;
+
+    // Staging storage, merged into the mod replacements once loading completed
+    AssetReplacements& replacements;
+  };
+
+  // A load in flight. The stage is parsed and the replacement meshes are imported on the loading
+  // thread, the results are finished and merged into the mod on the render thread by finishLoading.
+  struct LoadingState {
+    dxvk::thread thread;
+    std::atomic<bool> done = false;
+    bool succeeded = false;
+
+    std::vector<std::filesystem::path> searchPaths;
+    std::string status;
+
+    // Keeps the prims referenced by the pending replacements alive
+    pxr::UsdStageRefPtr stage;
+    std::vector<pxr::UsdStageRefPtr> variantStages;
+
+    pxr::UsdPrim materialRoot;
+    std::vector<pxr::UsdPrim> materialPrims;
+    std::vector<PendingReplacement> pending;
+
+    // Staging storage, merged into the mod replacements once loading completed
+    AssetReplacements replacements;
   };
 
+  using LoaderThreadPool = WorkerThreadPool<4, true, false>;
+
   bool haveFilesChanged();
 
-  void processUSD(const Rc<DxvkContext>& context);
+  void processUSD(const Rc<DxvkContext>& context, LoadingState& loading);
+  bool finishLoading(const Rc<DxvkContext>& context);
+  void cancelLoading();
+  void processPendingReplacements(const Rc<DxvkContext>& context, std::vector<PendingReplacement>& pending, AssetReplacements& replacements);
 
-  void TEMP_parseSecretReplacementVariants(const fast_unordered_cache<uint32_t>& variants);
+  void TEMP_parseSecretReplacementVariants(const fast_unordered_cache<uint32_t>& variants, AssetReplacements& replacements);
   Rc<ManagedTexture> getTexture(const Args& args, const pxr::UsdPrim& shader, const pxr::TfToken& textureToken, bool forcePreload = false) const;
   MaterialData* processMaterial(Args& args, const pxr::UsdPrim& matPrim);
-  MaterialData* processMaterialUser(Args& args, const pxr::UsdPrim& prim);
+  MaterialData* processPendingMaterial(Args& args, const PendingMaterial& pendingMaterial);
   bool processMesh(const pxr::UsdPrim& prim, Args& args);
   void processPrim(Args& args, pxr::UsdPrim& prim);
 
@@ -112,8 +164,9 @@ private:
 
   // Returns next hash value compatible with geometry and drawcall hashing
   XXH64_hash_t getNextGeomHash() {
-    static size_t id;
-    ++id;
+    // Note: meshes are processed on the loader threads
+    static std::atomic<size_t> s_id;
+    const size_t id = ++s_id;
     return XXH64(&id, sizeof(id), kEmptyHash);
   }
 
@@ -121,6 +174,8 @@ private:
   std::string m_openedFilePath;
 
   Watchdog<1000> m_usdChangeWatchdog;
+
+  std::unique_ptr<LoadingState> m_loading;
 };
 
 // context and member variable arguments to pass down to anonymous functions (to avoid having USD in the header)
@@ -320,7 +375,7 @@ MaterialData* UsdMod::Impl::processMaterial(Args& args, const pxr::UsdPrim& matP
 
   // Check if the material has already been processed
   MaterialData* materialData;
-  if (m_owner.m_replacements->getObject(materialHash, materialData)) {
+  if (args.replacements.getObject(materialHash, materialData)) {
     return materialData;
   }
 
@@ -361,21 +416,35 @@ MaterialData* UsdMod::Impl::processMaterial(Args& args, const pxr::UsdPrim& matP
 
   switch (materialType) {
   case RtSurfaceMaterialType::Opaque:
-    return &m_owner.m_replacements->storeObject(materialHash, MaterialData(OpaqueMaterialData::deserialize(getTextureFunctor, shader), shouldIgnore));
+    return &args.replacements.storeObject(materialHash, MaterialData(OpaqueMaterialData::deserialize(getTextureFunctor, shader), shouldIgnore));
   case RtSurfaceMaterialType::Translucent:
-    return &m_owner.m_replacements->storeObject(materialHash, MaterialData(TranslucentMaterialData::deserialize(getTextureFunctor, shader), shouldIgnore));
+    return &args.replacements.storeObject(materialHash, MaterialData(TranslucentMaterialData::deserialize(getTextureFunctor, shader), shouldIgnore));
   case RtSurfaceMaterialType::RayPortal:
-    return &m_owner.m_replacements->storeObject(materialHash, MaterialData(RayPortalMaterialData::deserialize(getTextureFunctor, shader)));
+    return &args.replacements.storeObject(materialHash, MaterialData(RayPortalMaterialData::deserialize(getTextureFunctor, shader)));
   }
 
   return nullptr;
 }
 
-MaterialData* UsdMod::Impl::processMaterialUser(Args& args, const pxr::UsdPrim& prim) {
+namespace {
+pxr::UsdPrim getBoundMaterial(const pxr::UsdPrim& prim) {
   auto bindAPI = pxr::UsdShadeMaterialBindingAPI(prim);
   auto boundMaterial = bindAPI.ComputeBoundMaterial();
   if (boundMaterial) {
-    return processMaterial(args, boundMaterial.GetPrim());
+    return boundMaterial.GetPrim();
+  }
+  return pxr::UsdPrim();
+}
+}  // namespace
+
+MaterialData* UsdMod::Impl::processPendingMaterial(Args& args, const PendingMaterial& pendingMaterial) {
+  if (pendingMaterial.material.IsValid()) {
+    if (MaterialData* materialData = processMaterial(args, pendingMaterial.material)) {
+      return materialData;
+    }
+  }
+  if (pendingMaterial.fallback.IsValid()) {
+    return processMaterial(args, pendingMaterial.fallback);
   }
   return nullptr;
 }
@@ -387,14 +456,17 @@ void UsdMod::Impl::processPrim(Args& args, pxr::UsdPrim& prim) {
 
 
   MeshReplacement* pTemp;
-  if (!m_owner.m_replacements->getObject(usdOriginHash, pTemp)) {
+  if (!args.replacements.getObject(usdOriginHash, pTemp)) {
     // First time seeing this mesh, then process it.
+    // Note: another loader thread may be processing the same mesh, only the first one stored is kept
+    // and stored meshes are never modified afterwards.
     if (!processMesh(prim, args)) {
       return;
     }
   }
 
-  MaterialData* materialData = processMaterialUser(args, prim);
+  // Materials load textures, which requires the context, so they are resolved after all prims are processed
+  const pxr::UsdPrim material = getBoundMaterial(prim);
 
   pxr::GfMatrix4f localToRoot = pxr::GfMatrix4f(args.xformCache.GetLocalToWorldTransform(prim));
   const auto& replacementToObjectAsArray = reinterpret_cast<const float(&)[4][4]>(localToRoot);
@@ -412,21 +484,19 @@ void UsdMod::Impl::processPrim(Args& args, pxr::UsdPrim& prim) {
 
   if (geomSubsets.empty()) {
     MeshReplacement* pGeometryData;
-    if (m_owner.m_replacements->getObject(usdOriginHash, pGeometryData)) {
-      AssetReplacement newReplacementMesh(pGeometryData, materialData, categoryFlags, replacementToObject);
+    if (args.replacements.getObject(usdOriginHash, pGeometryData)) {
+      AssetReplacement newReplacementMesh(pGeometryData, nullptr, categoryFlags, replacementToObject);
       args.meshes.push_back(newReplacementMesh);
+      args.materials.push_back({ material, pxr::UsdPrim() });
     }
   } else {
     for (auto subset : geomSubsets) {
       const XXH64_hash_t usdChildOriginHash = getStrongestOpinionatedPathHash(subset.GetPrim());
       MeshReplacement* childGeometryData;
-      if (m_owner.m_replacements->getObject(usdChildOriginHash, childGeometryData)) {
-        AssetReplacement newReplacementMesh(childGeometryData, materialData, categoryFlags, replacementToObject);
-        MaterialData* mat = processMaterialUser(args, subset.GetPrim());
-        if (mat) {
-          newReplacementMesh.materialData = mat;
-        }
+      if (args.replacements.getObject(usdChildOriginHash, childGeometryData)) {
+        AssetReplacement newReplacementMesh(childGeometryData, nullptr, categoryFlags, replacementToObject);
         args.meshes.push_back(newReplacementMesh);
+        args.materials.push_back({ getBoundMaterial(subset.GetPrim()), material });
       }
     }
   }
@@ -466,6 +536,7 @@ void UsdMod::Impl::processLight(Args& args, const pxr::UsdPrim& lightPrim, const
   const std::optional<LightData> lightData = LightData::tryCreate(lightPrim, isTransformDefined ? &lightTransform : nullptr, isOverride, isParentTransformDefined);
   if (lightData.has_value()) {
     args.meshes.emplace_back(lightData.value());
+    args.materials.emplace_back();
   }
 }
 
@@ -555,16 +626,38 @@ void UsdMod::Impl::processReplacement(Args& args) {
   }
 }
 
+UsdMod::Impl::~Impl() {
+  cancelLoading();
+}
+
 void UsdMod::Impl::load(const Rc<DxvkContext>& context) {
   ScopedCpuProfileZone();
-  if (m_owner.state() == State::Unloaded) {
-    processUSD(context);
+  if (m_owner.state() == State::Unloaded && !m_loading) {
+    // The renderer keeps drawing the original assets until the load is finished by checkForChanges
+    m_owner.setState(State::Loading);
+    m_owner.beginLoadingProgress(0);
+
+    m_loading = std::make_unique<LoadingState>();
+    LoadingState* loading = m_loading.get();
+    loading->thread = dxvk::thread([this, context, loading] {
+      env::setThreadName("rtx-usd-mod-load");
+      processUSD(context, *loading);
+      loading->done = true;
+    });
+  }
+}
 
-    m_usdChangeWatchdog.start();
+void UsdMod::Impl::cancelLoading() {
+  if (m_loading) {
+    m_loading->thread.join();
+    m_loading.reset();
+    m_owner.setState(State::Unloaded);
   }
 }
 
 void UsdMod::Impl::unload() {
+  cancelLoading();
+
   if (m_owner.state() == State::Loaded) {
     m_usdChangeWatchdog.stop();
 
@@ -597,6 +690,10 @@ bool UsdMod::Impl::haveFilesChanged() {
 }
 
 bool UsdMod::Impl::checkForChanges(const Rc<DxvkContext>& context) {
+  if (finishLoading(context)) {
+    return true;
+  }
+
   if (m_usdChangeWatchdog.hasSignaled()) {
     unload();
     load(context);
@@ -606,53 +703,55 @@ bool UsdMod::Impl::checkForChanges(const Rc<DxvkContext>& context) {
   return false;
 }
 
-void UsdMod::Impl::processUSD(const Rc<DxvkContext>& context) {
+// Runs on the loading thread, only parses the stage and imports the meshes, see finishLoading
+void UsdMod::Impl::processUSD(const Rc<DxvkContext>& context, LoadingState& loading) {
   ScopedCpuProfileZone();
   std::string replacementsUsdPath(m_owner.m_filePath.string());
 
-  m_owner.setState(State::Loading);
-
-  pxr::UsdStageRefPtr stage = pxr::UsdStage::Open(replacementsUsdPath, pxr::UsdStage::LoadAll);
+  loading.stage = pxr::UsdStage::Open(replacementsUsdPath, pxr::UsdStage::LoadAll);
+  const pxr::UsdStageRefPtr& stage = loading.stage;
 
   if (!stage) {
     Logger::err(str::format("USD mod file failed parsing: ", std::filesystem::weakly_canonical(replacementsUsdPath).string()));
     m_openedFilePath.clear();
     m_fileModificationTime = fs::file_time_type();
-    m_owner.setState(State::Unloaded);
     return;
   }
 
   std::filesystem::path modBaseDirectory = std::filesystem::path(replacementsUsdPath).remove_filename();
   m_openedFilePath = replacementsUsdPath;
 
-  // Iterate sublayers in the strength order, resolve the base paths and
-  // populate asset manager search paths.
+  // Iterate sublayers in the strength order and resolve the base paths
+  // for the asset manager search paths, they're added once loading completed.
   auto sublayers = stage->GetRootLayer()->GetSubLayerPaths();
   for (size_t i = 0, s = sublayers.size(); i < s; i++) {
     const std::string& identifier = sublayers[i];
     auto layerBasePath = std::filesystem::path(identifier).remove_filename();
-    auto fullLayerBasePath = modBaseDirectory / layerBasePath;
-    AssetDataManager::get().addSearchPath(i, fullLayerBasePath);
+    loading.searchPaths.push_back(modBaseDirectory / layerBasePath);
   }
 
   // Add stage's base path last.
-  AssetDataManager::get().addSearchPath(sublayers.size(), modBaseDirectory);
+  loading.searchPaths.push_back(modBaseDirectory);
 
   m_fileModificationTime = fs::last_write_time(fs::path(m_openedFilePath));
-  pxr::UsdGeomXformCache xformCache;
 
   pxr::VtDictionary layerData = stage->GetRootLayer()->GetCustomLayerData();
   if (layerData.empty()) {
-    m_owner.m_status = "Layer Data Missing";
+    loading.status = "Layer Data Missing";
   } else {
     const PXR_NS::VtValue* vtExportStatus = layerData.GetValueAtPath(kStatusKey);
     if (vtExportStatus && !vtExportStatus->IsEmpty()) {
-      m_owner.m_status = vtExportStatus->Get<std::string>();
+      loading.status = vtExportStatus->Get<std::string>();
     } else {
-      m_owner.m_status = "Status Missing";
+      loading.status = "Status Missing";
     }
   }
 
+  AssetReplacements& replacements = loading.replacements;
+
+  // Gather the replacement root prims, in the order their replacements are stored
+  std::vector<PendingReplacement>& pending = loading.pending;
+
   fast_unordered_cache<uint32_t> variantCounts;
   pxr::UsdPrim meshes = stage->GetPrimAtPath(pxr::SdfPath("/RootNode/meshes"));
   if (meshes.IsValid()) {
@@ -660,22 +759,16 @@ void UsdMod::Impl::processUSD(const Rc<DxvkContext>& context) {
     for (pxr::UsdPrim child : children) {
       XXH64_hash_t hash = getModelHash(child);
       if (hash != 0) {
-        std::vector<AssetReplacement> replacementVec;
-        
-        Args args = {context, xformCache, child, replacementVec};
-
-        processReplacement(args);
+        pending.push_back({ hash, AssetReplacement::eMesh, child });
 
         variantCounts[hash]++;
-
-        m_owner.m_replacements->set<AssetReplacement::eMesh>(hash, std::move(replacementVec));
       }
     }
   }
 
   // TODO: enter "secrets" section of USD as exported by Kit app
-  TEMP_parseSecretReplacementVariants(variantCounts);
-  for (auto& [hash, secretReplacements] : m_owner.m_replacements->secretReplacements()) {
+  TEMP_parseSecretReplacementVariants(variantCounts, replacements);
+  for (auto& [hash, secretReplacements] : replacements.secretReplacements()) {
     for (auto& secretReplacement : secretReplacements) {
       const std::string variantStage(modBaseDirectory.string() + secretReplacement.replacementPath);
       double dummy;
@@ -690,15 +783,9 @@ void UsdMod::Impl::processUSD(const Rc<DxvkContext>& context) {
           std::string("[SecretReplacement] Failed to open stage: ") + variantStage);
         continue;
       }
-      auto rootPrim = pStage->GetDefaultPrim();
       auto variantHash = hash + secretReplacement.variantId;
-      std::vector<AssetReplacement> replacementVec;
-
-      Args args = {context, xformCache, rootPrim, replacementVec};
-
-      processReplacement(args);
-
-      m_owner.m_replacements->set<AssetReplacement::eMesh>(variantHash, std::move(replacementVec));
+      pending.push_back({ variantHash, AssetReplacement::eMesh, pStage->GetDefaultPrim() });
+      loading.variantStages.push_back(pStage);
     }
   }
 
@@ -708,39 +795,143 @@ void UsdMod::Impl::processUSD(const Rc<DxvkContext>& context) {
     for (pxr::UsdPrim child : children) {
       XXH64_hash_t hash = getLightHash(child);
       if (hash != 0) {
-        std::vector<AssetReplacement> replacementVec;
-        Args args = {context, xformCache, child, replacementVec};
+        pending.push_back({ hash, AssetReplacement::eLight, child });
+      }
+    }
+  }
 
-        processReplacement(args);
+  loading.materialRoot = stage->GetPrimAtPath(pxr::SdfPath("/RootNode/Looks"));
+  if (loading.materialRoot.IsValid()) {
+    auto children = loading.materialRoot.GetFilteredChildren(pxr::UsdPrimIsActive);
+    for (pxr::UsdPrim materialPrim : children) {
+      loading.materialPrims.push_back(materialPrim);
+    }
+  }
+
+  // Progress covers the replacements processed on the loader threads, the rest is finished within a frame
+  m_owner.beginLoadingProgress(static_cast<uint32_t>(pending.size()));
 
-        m_owner.m_replacements->set<AssetReplacement::eLight>(hash, std::move(replacementVec));
+  processPendingReplacements(context, pending, replacements);
+
+  loading.succeeded = true;
+}
+
+// Runs on the render thread once the loading thread is done. Materials are processed here as loading
+// their textures requires the context, then the replacements are merged into the mod all at once.
+bool UsdMod::Impl::finishLoading(const Rc<DxvkContext>& context) {
+  if (!m_loading || !m_loading->done) {
+    return false;
+  }
+
+  ScopedCpuProfileZone();
+
+  m_loading->thread.join();
+  std::unique_ptr<LoadingState> loading = std::move(m_loading);
+
+  if (!loading->succeeded) {
+    m_owner.setState(State::Unloaded);
+    m_usdChangeWatchdog.start();
+    return false;
+  }
+
+  for (size_t i = 0; i < loading->searchPaths.size(); i++) {
+    AssetDataManager::get().addSearchPath(i, loading->searchPaths[i]);
+  }
+
+  m_owner.m_status = loading->status;
+
+  AssetReplacements& replacements = loading->replacements;
+
+  pxr::UsdGeomXformCache xformCache;
+  std::vector<AssetReplacement> placeholder;
+  std::vector<PendingMaterial> placeholderMaterials;
+  Args args = {context, xformCache, loading->materialRoot, placeholder, placeholderMaterials, replacements};
+
+  bool hasMeshes = false;
+  for (PendingReplacement& replacement : loading->pending) {
+    for (size_t i = 0; i < replacement.replacements.size(); i++) {
+      if (replacement.replacements[i].type == AssetReplacement::eMesh) {
+        replacement.replacements[i].materialData = processPendingMaterial(args, replacement.materials[i]);
+        hasMeshes = true;
       }
     }
+
+    if (replacement.type == AssetReplacement::eMesh) {
+      replacements.set<AssetReplacement::eMesh>(replacement.hash, std::move(replacement.replacements));
+    } else {
+      replacements.set<AssetReplacement::eLight>(replacement.hash, std::move(replacement.replacements));
+    }
+  }
+
+  for (pxr::UsdPrim materialPrim : loading->materialPrims) {
+    processMaterial(args, materialPrim);
   }
 
-  pxr::UsdPrim materialRoot = stage->GetPrimAtPath(pxr::SdfPath("/RootNode/Looks"));
-  if (materialRoot.IsValid()) {
-    auto children = materialRoot.GetFilteredChildren(pxr::UsdPrimIsActive);
-    std::vector<AssetReplacement> placeholder;
+  // The mesh buffers were written by the loader threads, flush entire cache, kinda a sledgehammer
+  if (hasMeshes) {
+    context->emitMemoryBarrier(0,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+      VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+  }
 
-    Args args = {context, xformCache, materialRoot, placeholder};
+  m_owner.m_replacements->merge(replacements);
 
-    for (pxr::UsdPrim materialPrim : children) {
-      processMaterial(args, materialPrim);
+  m_owner.setState(State::Loaded);
+  m_usdChangeWatchdog.start();
+  return true;
+}
+
+void UsdMod::Impl::processPendingReplacements(const Rc<DxvkContext>& context, std::vector<PendingReplacement>& pending, AssetReplacements& replacements) {
+  ScopedCpuProfileZone();
+
+  std::atomic<size_t> nextReplacement = 0;
+
+  // Note: only reads the stage, mesh import and buffer creation are safe to run on multiple threads
+  auto processReplacements = [&]() {
+    // Xform caches are not thread safe, use one per thread
+    pxr::UsdGeomXformCache xformCache;
+
+    for (size_t i = nextReplacement++; i < pending.size(); i = nextReplacement++) {
+      PendingReplacement& replacement = pending[i];
+      Args args = {context, xformCache, replacement.rootPrim, replacement.replacements, replacement.materials, replacements};
+
+      try {
+        processReplacement(args);
+      } catch (const DxvkError& e) {
+        Logger::err(str::format("Failed to process replacement ", replacement.rootPrim.GetPath().GetString(), ": ", e.message()));
+      }
+      m_owner.advanceLoadingProgress();
     }
+  };
+
+  // Loading is CPU bound, leave room for the game and render threads
+  const uint32_t numThreads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 8u);
+  if (numThreads == 1 || pending.size() < 2) {
+    processReplacements();
+    return;
   }
 
-  // flush entire cache, kinda a sledgehammer
-  context->emitMemoryBarrier(0,
-    VK_PIPELINE_STAGE_TRANSFER_BIT,
-    VK_ACCESS_TRANSFER_WRITE_BIT,
-    VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-    VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+  LoaderThreadPool threadPool(static_cast<uint8_t>(numThreads), "rtx-usd-mod-loader");
 
-  m_owner.setState(State::Loaded);
+  std::vector<Future<void>> futures;
+  for (uint32_t i = 0; i < numThreads; i++) {
+    Future<void> future = threadPool.Schedule([&processReplacements]() { processReplacements(); });
+    if (future.valid()) {
+      futures.push_back(future);
+    }
+  }
+
+  // Help out until all replacements were taken
+  processReplacements();
+
+  for (const Future<void>& future : futures) {
+    future.get();
+  }
 }
 
-void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cache<uint32_t>& variantCounts) {
+void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cache<uint32_t>& variantCounts, AssetReplacements& replacements) {
   auto lookupCount = [&variantCounts](XXH64_hash_t hash) -> auto {
     // NOTE: If there's no default replacement make sure secret variants are not default.
     return variantCounts.count(hash) ? variantCounts.at(hash) : 1u;
@@ -748,7 +939,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
 
   static constexpr XXH64_hash_t kStorageCubeHash = 0xc728cfe75526c741;
   uint32_t numVariants = lookupCount(kStorageCubeHash);
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Ice","",
     0x60ead40e2269b3c5,
     kStorageCubeHash,
@@ -756,7 +947,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Lens","",
     0xa8e871f4ebc52eab,
     kStorageCubeHash,
@@ -764,7 +955,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Camera","",
     0xd150bdeff3f0299a,
     kStorageCubeHash,
@@ -772,7 +963,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Digital Skull","",
     0xb26578451f75c11a,
     kStorageCubeHash,
@@ -780,7 +971,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Iso-Wheatly","",
     0xc270f63a956c0c71,
     kStorageCubeHash,
@@ -788,7 +979,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Iso-Voyager","",
     0xaaaf0cbd8c8204cd,
     kStorageCubeHash,
@@ -796,7 +987,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Iso-Black-Mesa","",
     0x2f9fe4ce23a83bc2,
     kStorageCubeHash,
@@ -804,7 +995,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","RTX","",
     0xe361f386c03400f3,
     kStorageCubeHash,
@@ -812,7 +1003,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Roll Cage","",
     0x0,
     kStorageCubeHash,
@@ -820,7 +1011,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Health Pack","",
     0x0,
     kStorageCubeHash,
@@ -828,7 +1019,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kStorageCubeHash, SecretReplacement{
+  replacements.storeObject(kStorageCubeHash, SecretReplacement{
     "Storage Cubes","Space","",
     0x0,
     kStorageCubeHash,
@@ -839,7 +1030,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
 
   static constexpr XXH64_hash_t kCompanionCubeHash = 0x6ef165bb7e0b8512;
   numVariants = lookupCount(kCompanionCubeHash);
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Pillow","",
     0xc901411d90916a58,
     kCompanionCubeHash,
@@ -847,7 +1038,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Ceramic","",
     0x3495c5b9d210daa1,
     kCompanionCubeHash,
@@ -855,7 +1046,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Wood","",
     0x5e50cb7c64375acc,
     kCompanionCubeHash,
@@ -863,7 +1054,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Digital","",
     0xf2bda31c09fc42f6,
     kCompanionCubeHash,
@@ -871,7 +1062,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Steampunk","",
     0x0,
     kCompanionCubeHash,
@@ -879,7 +1070,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Arts and Crafts","",
     0x0,
     kCompanionCubeHash,
@@ -887,7 +1078,7 @@ void UsdMod::Impl::TEMP_parseSecretReplacementVariants(const fast_unordered_cach
     true,
     true,
     numVariants++});
-  m_owner.m_replacements->storeObject(kCompanionCubeHash, SecretReplacement{
+  replacements.storeObject(kCompanionCubeHash, SecretReplacement{
     "Companion Cubes","Cubus","",
     0x0,
     kCompanionCubeHash,
@@ -1002,23 +1193,29 @@ bool UsdMod::Impl::processMesh(const pxr::UsdPrim& prim, Args& args) {
 
     XXH64_hash_t usdOriginHash = getStrongestOpinionatedPathHash(submesh.prim);
     MeshReplacement* childGeometryData;
-    if (!m_owner.m_replacements->getObject(usdOriginHash, childGeometryData)) {
-      MeshReplacement& newReplacement = m_owner.m_replacements->storeObject(usdOriginHash, MeshReplacement(replacement));
-      RasterGeometry& newGeomData = newReplacement.data;
-
-      const size_t indexDataSize = submesh.GetNumIndices() * sizeof(uint32_t);
-      info.size = dxvk::align(indexDataSize, CACHE_LINE_SIZE);
-
-      // Buffer contains: indices
-      Rc<DxvkBuffer> indexBuffer = args.context->getDevice()->createBuffer(info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, DxvkMemoryStats::Category::RTXBuffer);
-      const DxvkBufferSlice& indexSlice = DxvkBufferSlice(indexBuffer);
-      memcpy(indexSlice.mapPtr(0), submesh.indexBuffer.data(), indexDataSize);
-      newGeomData.indexBuffer = RasterBuffer(indexSlice, 0, sizeof(uint32_t), VK_INDEX_TYPE_UINT32);
-      newGeomData.indexCount = submesh.GetNumIndices();
-      // Set these as hashed so that the geometryData acts like it's static.
-      newGeomData.hashes[HashComponents::Indices] = newGeomData.hashes[HashComponents::VertexPosition] = getNextGeomHash();
-      newGeomData.hashes.precombine();
+    if (args.replacements.getObject(usdOriginHash, childGeometryData)) {
+      continue;
     }
+
+    // The replacement is completed before it's stored, as stored objects may already be read by other loader threads
+    MeshReplacement newReplacement(replacement);
+    RasterGeometry& newGeomData = newReplacement.data;
+
+    const size_t indexDataSize = submesh.GetNumIndices() * sizeof(uint32_t);
+    info.size = dxvk::align(indexDataSize, CACHE_LINE_SIZE);
+
+    // Buffer contains: indices
+    Rc<DxvkBuffer> indexBuffer = args.context->getDevice()->createBuffer(info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, DxvkMemoryStats::Category::RTXBuffer);
+    const DxvkBufferSlice& indexSlice = DxvkBufferSlice(indexBuffer);
+    memcpy(indexSlice.mapPtr(0), submesh.indexBuffer.data(), indexDataSize);
+    newGeomData.indexBuffer = RasterBuffer(indexSlice, 0, sizeof(uint32_t), VK_INDEX_TYPE_UINT32);
+    newGeomData.indexCount = submesh.GetNumIndices();
+    // Set these as hashed so that the geometryData acts like it's static.
+    newGeomData.hashes[HashComponents::Indices] = newGeomData.hashes[HashComponents::VertexPosition] = getNextGeomHash();
+    newGeomData.hashes.precombine();
+
+    // Another loader thread may have stored the same mesh in the meantime, then this one is dropped
+    args.replacements.storeObject(usdOriginHash, std::move(newReplacement));
   }
 
   return true;
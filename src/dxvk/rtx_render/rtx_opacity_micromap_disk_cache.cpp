@@ -0,0 +1,494 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "rtx_opacity_micromap_disk_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+#include "../../util/util_env.h"
+#include "../../util/util_string.h"
+#include "../../util/log/log.h"
+
+namespace dxvk {
+
+  namespace {
+    struct IndexHeader {
+      uint32_t magic = kOpacityMicromapDiskCacheIndexMagic;
+      uint32_t version = kOpacityMicromapDiskCacheVersion;
+      uint32_t numEntries = 0;
+      uint32_t pad = 0;
+    };
+
+    struct IndexEntry {
+      XXH64_hash_t key;
+      uint64_t size;
+      uint64_t lastUse;
+    };
+
+    // Write the index after this many new entries, so that not much is lost on a crash
+    constexpr uint32_t kNumStoresPerIndexSave = 64;
+
+    // Run length encoding control bytes: values below kRepeatRunFlag are followed by (value + 1)
+    // literal bytes, others by a single byte repeated (value - kRepeatRunFlag + kMinRepeatRun) times
+    constexpr uint8_t kRepeatRunFlag = 0x80;
+    constexpr size_t kMaxLiteralRun = 128;
+    constexpr size_t kMinRepeatRun = 3;
+    constexpr size_t kMaxRepeatRun = 0xFF - kRepeatRunFlag + kMinRepeatRun;
+
+    bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+      std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+      if (!file) {
+        return false;
+      }
+
+      data.resize(static_cast<size_t>(file.tellg()));
+      file.seekg(0);
+      return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), data.size()));
+    }
+
+    bool writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+      // Write to a temporary file first so that a crash never leaves a truncated entry behind
+      std::filesystem::path tempPath = path;
+      tempPath += ".tmp";
+
+      {
+        std::ofstream file(tempPath, std::ios_base::binary | std::ios_base::trunc);
+        if (!file || !file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+          return false;
+        }
+      }
+
+      std::error_code ec;
+      std::filesystem::rename(tempPath, path, ec);
+      if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+      }
+      return true;
+    }
+  }
+
+  void OpacityMicromapDiskCacheEntry::compress(const uint8_t* data, size_t size, std::vector<uint8_t>& compressed) {
+    compressed.clear();
+    compressed.reserve(size / 8 + 16);
+
+    size_t literalStart = 0;
+    auto flushLiterals = [&](size_t end) {
+      while (literalStart < end) {
+        const size_t count = std::min(end - literalStart, kMaxLiteralRun);
+        compressed.push_back(static_cast<uint8_t>(count - 1));
+        compressed.insert(compressed.end(), data + literalStart, data + literalStart + count);
+        literalStart += count;
+      }
+    };
+
+    size_t i = 0;
+    while (i < size) {
+      size_t run = 1;
+      while (i + run < size && run < kMaxRepeatRun && data[i + run] == data[i]) {
+        run++;
+      }
+
+      if (run >= kMinRepeatRun) {
+        flushLiterals(i);
+        compressed.push_back(static_cast<uint8_t>(kRepeatRunFlag + run - kMinRepeatRun));
+        compressed.push_back(data[i]);
+        literalStart = i + run;
+      }
+      i += run;
+    }
+
+    flushLiterals(size);
+  }
+
+  bool OpacityMicromapDiskCacheEntry::decompress(const uint8_t* compressed, size_t compressedSize, uint8_t* data, size_t size) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < compressedSize) {
+      const uint8_t control = compressed[in++];
+
+      if (control < kRepeatRunFlag) {
+        const size_t count = size_t(control) + 1;
+        if (count > compressedSize - in || count > size - out) {
+          return false;
+        }
+        memcpy(data + out, compressed + in, count);
+        in += count;
+        out += count;
+      } else {
+        const size_t count = size_t(control) - kRepeatRunFlag + kMinRepeatRun;
+        if (in == compressedSize || count > size - out) {
+          return false;
+        }
+        memset(data + out, compressed[in++], count);
+        out += count;
+      }
+    }
+
+    return out == size;
+  }
+
+  void OpacityMicromapDiskCacheEntry::serialize(XXH64_hash_t key, const OpacityMicromapDiskCacheEntry& entry, std::vector<uint8_t>& data) {
+    std::vector<uint8_t> compressed;
+    compress(entry.arrayData.data(), entry.arrayData.size(), compressed);
+
+    OpacityMicromapDiskCacheFileHeader header;
+    header.key = key;
+    header.numTriangles = entry.numTriangles;
+    header.subdivisionLevel = entry.subdivisionLevel;
+    header.ommFormat = entry.ommFormat;
+    header.arrayDataSize = static_cast<uint32_t>(entry.arrayData.size());
+    header.compressedSize = static_cast<uint32_t>(compressed.size());
+    header.checksum = XXH3_64bits(entry.arrayData.data(), entry.arrayData.size());
+
+    data.resize(sizeof(header) + compressed.size());
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), compressed.data(), compressed.size());
+  }
+
+  bool OpacityMicromapDiskCacheEntry::deserialize(XXH64_hash_t key, const uint8_t* data, size_t size, OpacityMicromapDiskCacheEntry& entry) {
+    OpacityMicromapDiskCacheFileHeader header;
+    if (size < sizeof(header)) {
+      return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != kOpacityMicromapDiskCacheMagic ||
+        header.version != kOpacityMicromapDiskCacheVersion ||
+        header.key != key ||
+        header.compressedSize != size - sizeof(header)) {
+      return false;
+    }
+
+    entry.numTriangles = header.numTriangles;
+    entry.subdivisionLevel = header.subdivisionLevel;
+    entry.ommFormat = header.ommFormat;
+    entry.arrayData.resize(header.arrayDataSize);
+
+    if (!decompress(data + sizeof(header), header.compressedSize, entry.arrayData.data(), entry.arrayData.size())) {
+      return false;
+    }
+
+    return XXH3_64bits(entry.arrayData.data(), entry.arrayData.size()) == header.checksum;
+  }
+
+  void OpacityMicromapDiskCacheIndex::insert(XXH64_hash_t key, uint64_t size) {
+    auto [iter, inserted] = m_items.try_emplace(key, Item { size, 0 });
+    if (!inserted) {
+      m_totalSize -= iter->second.size;
+      iter->second.size = size;
+    }
+    iter->second.lastUse = ++m_useCounter;
+    m_totalSize += size;
+  }
+
+  void OpacityMicromapDiskCacheIndex::touch(XXH64_hash_t key) {
+    auto iter = m_items.find(key);
+    if (iter != m_items.end()) {
+      iter->second.lastUse = ++m_useCounter;
+    }
+  }
+
+  void OpacityMicromapDiskCacheIndex::erase(XXH64_hash_t key) {
+    auto iter = m_items.find(key);
+    if (iter != m_items.end()) {
+      m_totalSize -= iter->second.size;
+      m_items.erase(iter);
+    }
+  }
+
+  void OpacityMicromapDiskCacheIndex::clear() {
+    m_items.clear();
+    m_totalSize = 0;
+    m_useCounter = 0;
+  }
+
+  std::vector<XXH64_hash_t> OpacityMicromapDiskCacheIndex::evict(uint64_t maxTotalSize) {
+    std::vector<XXH64_hash_t> evicted;
+    if (m_totalSize <= maxTotalSize) {
+      return evicted;
+    }
+
+    std::vector<std::pair<uint64_t, XXH64_hash_t>> usageOrder;
+    usageOrder.reserve(m_items.size());
+    for (const auto& [key, item] : m_items) {
+      usageOrder.emplace_back(item.lastUse, key);
+    }
+    std::sort(usageOrder.begin(), usageOrder.end());
+
+    for (const auto& [lastUse, key] : usageOrder) {
+      if (m_totalSize <= maxTotalSize) {
+        break;
+      }
+      erase(key);
+      evicted.push_back(key);
+    }
+    return evicted;
+  }
+
+  void OpacityMicromapDiskCacheIndex::serialize(std::vector<uint8_t>& data) const {
+    IndexHeader header;
+    header.numEntries = static_cast<uint32_t>(m_items.size());
+
+    data.resize(sizeof(header) + m_items.size() * sizeof(IndexEntry));
+    memcpy(data.data(), &header, sizeof(header));
+
+    IndexEntry* entries = reinterpret_cast<IndexEntry*>(data.data() + sizeof(header));
+    for (const auto& [key, item] : m_items) {
+      *entries++ = IndexEntry { key, item.size, item.lastUse };
+    }
+  }
+
+  bool OpacityMicromapDiskCacheIndex::deserialize(const uint8_t* data, size_t size) {
+    clear();
+
+    IndexHeader header;
+    if (size < sizeof(header)) {
+      return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != kOpacityMicromapDiskCacheIndexMagic ||
+        header.version != kOpacityMicromapDiskCacheVersion ||
+        size != sizeof(header) + size_t(header.numEntries) * sizeof(IndexEntry)) {
+      return false;
+    }
+
+    for (uint32_t i = 0; i < header.numEntries; i++) {
+      IndexEntry entry;
+      memcpy(&entry, data + sizeof(header) + i * sizeof(IndexEntry), sizeof(entry));
+
+      m_items[entry.key] = Item { entry.size, entry.lastUse };
+      m_totalSize += entry.size;
+      m_useCounter = std::max(m_useCounter, entry.lastUse);
+    }
+    return true;
+  }
+
+  OpacityMicromapDiskCache::OpacityMicromapDiskCache(const std::string& directory, uint64_t maxSize)
+    : m_directory(directory)
+    , m_maxSize(maxSize) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+    if (ec) {
+      Logger::err(str::format("[RTX Opacity Micromap] Failed to create disk cache directory ", m_directory));
+    }
+
+    loadIndex();
+
+    m_writerThread = dxvk::thread([this]() { writerFunc(); });
+  }
+
+  OpacityMicromapDiskCache::~OpacityMicromapDiskCache() {
+    {
+      std::lock_guard lock { m_writerMutex };
+      m_stopWriter = true;
+    }
+    m_writerCond.notify_all();
+    m_writerThread.join();
+
+    std::lock_guard lock { m_indexMutex };
+    saveIndex();
+
+    Logger::info(str::format("[RTX Opacity Micromap] Disk cache: ", m_numHits.load(), " hits, ", m_numMisses.load(), " misses, ",
+                             m_index.getNumEntries(), " entries, ", m_index.getTotalSize() / 1024, " KB"));
+  }
+
+  uint64_t OpacityMicromapDiskCache::getTotalSize() const {
+    std::lock_guard lock { m_indexMutex };
+    return m_index.getTotalSize();
+  }
+
+  size_t OpacityMicromapDiskCache::getNumEntries() const {
+    std::lock_guard lock { m_indexMutex };
+    return m_index.getNumEntries();
+  }
+
+  bool OpacityMicromapDiskCache::contains(XXH64_hash_t key) const {
+    std::lock_guard lock { m_indexMutex };
+    return m_index.contains(key);
+  }
+
+  bool OpacityMicromapDiskCache::load(XXH64_hash_t key, OpacityMicromapDiskCacheEntry& entry) {
+    if (!contains(key)) {
+      m_numMisses++;
+      return false;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(getEntryPath(key), data) ||
+        !OpacityMicromapDiskCacheEntry::deserialize(key, data.data(), data.size(), entry)) {
+      // Stale, corrupted or from another version, drop it so it gets baked and stored again
+      Logger::warn(str::format("[RTX Opacity Micromap] Dropping invalid disk cache entry ", std::hex, key));
+
+      std::lock_guard lock { m_indexMutex };
+      m_index.erase(key);
+      removeEntryFile(key);
+      m_numMisses++;
+      return false;
+    }
+
+    std::lock_guard lock { m_indexMutex };
+    m_index.touch(key);
+    m_numHits++;
+    return true;
+  }
+
+  void OpacityMicromapDiskCache::store(XXH64_hash_t key, OpacityMicromapDiskCacheEntry&& entry) {
+    if (contains(key)) {
+      return;
+    }
+
+    {
+      std::lock_guard lock { m_writerMutex };
+      m_writerQueue.push(WriterItem { key, std::move(entry) });
+    }
+    m_writerCond.notify_one();
+  }
+
+  void OpacityMicromapDiskCache::flush() {
+    {
+      std::unique_lock lock { m_writerMutex };
+      m_writerIdleCond.wait(lock, [this]() { return m_writerQueue.empty() && !m_writerBusy; });
+    }
+
+    std::lock_guard lock { m_indexMutex };
+    saveIndex();
+  }
+
+  std::string OpacityMicromapDiskCache::getDefaultDirectory() {
+    return env::getExeBaseName() + ".dxvk-omm";
+  }
+
+  std::string OpacityMicromapDiskCache::getEntryPath(XXH64_hash_t key) const {
+    // Entries are spread over subdirectories by their top byte to keep directories small
+    const std::string name = str::format(std::hex, std::setfill('0'), std::setw(16), key);
+    return m_directory + "/" + name.substr(0, 2) + "/" + name + ".omm";
+  }
+
+  std::string OpacityMicromapDiskCache::getIndexPath() const {
+    return m_directory + "/index.bin";
+  }
+
+  void OpacityMicromapDiskCache::loadIndex() {
+    std::lock_guard lock { m_indexMutex };
+
+    std::vector<uint8_t> data;
+    if (!readFile(getIndexPath(), data) || !m_index.deserialize(data.data(), data.size())) {
+      rebuildIndex();
+    }
+
+    // The max size may have been lowered since the last session
+    for (XXH64_hash_t key : m_index.evict(m_maxSize)) {
+      removeEntryFile(key);
+    }
+  }
+
+  void OpacityMicromapDiskCache::saveIndex() {
+    std::vector<uint8_t> data;
+    m_index.serialize(data);
+
+    if (!writeFile(getIndexPath(), data)) {
+      Logger::warn(str::format("[RTX Opacity Micromap] Failed to write disk cache index ", getIndexPath()));
+    }
+    m_numStoresSinceIndexSave = 0;
+  }
+
+  void OpacityMicromapDiskCache::rebuildIndex() {
+    // Missing or outdated index, recover whatever entries are on disk. Usage order is lost,
+    // and entries of other versions are only dropped once they fail to load.
+    m_index.clear();
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(m_directory, ec)) {
+      const std::filesystem::path& path = file.path();
+      if (!file.is_regular_file() || path.extension() != ".omm") {
+        continue;
+      }
+
+      const std::string stem = path.stem().string();
+      if (stem.size() != 16 || stem.find_first_not_of("0123456789abcdef") != std::string::npos) {
+        continue;
+      }
+
+      m_index.insert(std::stoull(stem, nullptr, 16), file.file_size());
+    }
+  }
+
+  void OpacityMicromapDiskCache::removeEntryFile(XXH64_hash_t key) {
+    std::error_code ec;
+    std::filesystem::remove(getEntryPath(key), ec);
+  }
+
+  void OpacityMicromapDiskCache::writerFunc() {
+    env::setThreadName("rtx-omm-disk-cache");
+
+    while (true) {
+      WriterItem item;
+      {
+        std::unique_lock lock { m_writerMutex };
+        m_writerCond.wait(lock, [this]() { return m_stopWriter || !m_writerQueue.empty(); });
+
+        // Drain the queue before stopping
+        if (m_writerQueue.empty()) {
+          break;
+        }
+
+        item = std::move(m_writerQueue.front());
+        m_writerQueue.pop();
+        m_writerBusy = true;
+      }
+
+      std::vector<uint8_t> data;
+      OpacityMicromapDiskCacheEntry::serialize(item.key, item.entry, data);
+
+      const std::filesystem::path path = getEntryPath(item.key);
+      std::error_code ec;
+      std::filesystem::create_directories(path.parent_path(), ec);
+
+      if (writeFile(path, data)) {
+        std::lock_guard lock { m_indexMutex };
+        m_index.insert(item.key, data.size());
+
+        for (XXH64_hash_t key : m_index.evict(m_maxSize)) {
+          removeEntryFile(key);
+        }
+
+        if (++m_numStoresSinceIndexSave >= kNumStoresPerIndexSave) {
+          saveIndex();
+        }
+      } else {
+        ONCE(Logger::warn(str::format("[RTX Opacity Micromap] Failed to write disk cache entry ", path.string())));
+      }
+
+      {
+        std::lock_guard lock { m_writerMutex };
+        m_writerBusy = false;
+      }
+      m_writerIdleCond.notify_all();
+    }
+  }
+
+}
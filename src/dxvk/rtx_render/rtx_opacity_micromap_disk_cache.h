@@ -0,0 +1,181 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../util/thread.h"
+#include "../../util/xxHash/xxhash.h"
+
+namespace dxvk {
+
+  // On-disk, content addressed store of baked Opacity Micromap arrays.
+  //
+  // Every entry lives in its own file named after its key and starts with an
+  // OpacityMicromapDiskCacheFileHeader, followed by the run length encoded array data.
+  // An index file keeps track of entry sizes and their usage order across sessions,
+  // so that least recently used entries can be evicted once the cache grows past its max size.
+
+  constexpr uint32_t kOpacityMicromapDiskCacheMagic = 0x434d4d4f; // "OMMC"
+  constexpr uint32_t kOpacityMicromapDiskCacheIndexMagic = 0x494d4d4f; // "OMMI"
+  constexpr uint32_t kOpacityMicromapDiskCacheVersion = 1;
+
+  struct OpacityMicromapDiskCacheFileHeader {
+    uint32_t magic = kOpacityMicromapDiskCacheMagic;
+    uint32_t version = kOpacityMicromapDiskCacheVersion;
+    XXH64_hash_t key = 0;
+    uint32_t numTriangles = 0;
+    uint32_t subdivisionLevel = 0;
+    uint32_t ommFormat = 0;
+    uint32_t arrayDataSize = 0;
+    uint32_t compressedSize = 0;
+    uint32_t pad = 0;
+    XXH64_hash_t checksum = 0; // Of the uncompressed array data
+  };
+
+  static_assert(sizeof(OpacityMicromapDiskCacheFileHeader) == 48);
+
+  struct OpacityMicromapDiskCacheEntry {
+    uint32_t numTriangles = 0;
+    uint32_t subdivisionLevel = 0;
+    uint32_t ommFormat = 0;           // VkOpacityMicromapFormatEXT
+    std::vector<uint8_t> arrayData;   // Opacity states per micro triangle, as consumed by a micromap build
+
+    static void serialize(XXH64_hash_t key, const OpacityMicromapDiskCacheEntry& entry, std::vector<uint8_t>& data);
+    // Returns false if the data is not a valid entry of the current version for the given key
+    static bool deserialize(XXH64_hash_t key, const uint8_t* data, size_t size, OpacityMicromapDiskCacheEntry& entry);
+
+    // Byte oriented run length encoding. Baked arrays are dominated by long runs of
+    // fully opaque or fully transparent micro triangles, which this compresses well.
+    static void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& compressed);
+    static bool decompress(const uint8_t* compressed, size_t compressedSize, uint8_t* data, size_t size);
+  };
+
+  // Tracks sizes and usage order of the entries in a disk cache
+  class OpacityMicromapDiskCacheIndex {
+  public:
+    bool contains(XXH64_hash_t key) const {
+      return m_items.find(key) != m_items.end();
+    }
+
+    size_t getNumEntries() const {
+      return m_items.size();
+    }
+
+    uint64_t getTotalSize() const {
+      return m_totalSize;
+    }
+
+    // Adds or replaces an entry, marking it as the most recently used one
+    void insert(XXH64_hash_t key, uint64_t size);
+    void touch(XXH64_hash_t key);
+    void erase(XXH64_hash_t key);
+    void clear();
+
+    // Removes least recently used entries until the total size fits within maxTotalSize.
+    // Returns the keys of the removed entries.
+    std::vector<XXH64_hash_t> evict(uint64_t maxTotalSize);
+
+    void serialize(std::vector<uint8_t>& data) const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+  private:
+    struct Item {
+      uint64_t size;
+      uint64_t lastUse;
+    };
+
+    std::unordered_map<XXH64_hash_t, Item> m_items;
+    uint64_t m_totalSize = 0;
+    uint64_t m_useCounter = 0;
+  };
+
+  // Thread safe. Loads are synchronous, stores are written out by a writer thread.
+  class OpacityMicromapDiskCache {
+  public:
+    OpacityMicromapDiskCache(const std::string& directory, uint64_t maxSize);
+    ~OpacityMicromapDiskCache();
+
+    const std::string& getDirectory() const {
+      return m_directory;
+    }
+
+    uint32_t getNumHits() const {
+      return m_numHits.load();
+    }
+
+    uint32_t getNumMisses() const {
+      return m_numMisses.load();
+    }
+
+    uint64_t getTotalSize() const;
+    size_t getNumEntries() const;
+
+    bool contains(XXH64_hash_t key) const;
+    bool load(XXH64_hash_t key, OpacityMicromapDiskCacheEntry& entry);
+    void store(XXH64_hash_t key, OpacityMicromapDiskCacheEntry&& entry);
+
+    // Waits for all queued stores to be written and saves the index
+    void flush();
+
+    static std::string getDefaultDirectory();
+
+  private:
+    struct WriterItem {
+      XXH64_hash_t key;
+      OpacityMicromapDiskCacheEntry entry;
+    };
+
+    std::string getEntryPath(XXH64_hash_t key) const;
+    std::string getIndexPath() const;
+
+    void loadIndex();
+    void saveIndex();
+    void rebuildIndex();
+    void removeEntryFile(XXH64_hash_t key);
+
+    void writerFunc();
+
+    std::string m_directory;
+    uint64_t m_maxSize;
+
+    mutable dxvk::mutex m_indexMutex;
+    OpacityMicromapDiskCacheIndex m_index;
+    uint32_t m_numStoresSinceIndexSave = 0;
+
+    std::atomic<uint32_t> m_numHits = { 0u };
+    std::atomic<uint32_t> m_numMisses = { 0u };
+
+    dxvk::mutex m_writerMutex;
+    dxvk::condition_variable m_writerCond;
+    dxvk::condition_variable m_writerIdleCond;
+    std::queue<WriterItem> m_writerQueue;
+    bool m_writerBusy = false;
+    bool m_stopWriter = false;
+    dxvk::thread m_writerThread;
+  };
+
+}
@@ -28,6 +28,7 @@
 #include "rtx_options.h"
 #include "rtx_hash_collision_detection.h"
 #include "rtx_texture_manager.h"
+#include "../util/log/metrics.h"
 
 #include "rtx_imgui.h"
 
@@ -43,6 +44,8 @@
 
 const VkDeviceSize kBufferAlignment = 16;
 const VkDeviceSize kBufferInBlasUsageAlignment = 256;
+// Bounds host memory held by disk cache readbacks. Arrays not read back are stored once baked again in a later session.
+const size_t kMaxPendingDiskCacheReadbacks = 64;
 
 namespace dxvk {
   DxvkOpacityMicromap::DxvkOpacityMicromap(DxvkDevice& device) : m_vkd(device.vkd()) { }
@@ -69,16 +72,15 @@ namespace dxvk {
                                                      const uint32_t inputSubdivisionLevel,
                                                      const bool enableVertexAndTextureOperations,
                                                      uint32_t currentFrameIndex,
-                                                     std::list<XXH64_hash_t>::iterator _leastRecentlyUsedListIter,
-                                                     std::list<XXH64_hash_t>::iterator _cacheStateListIter,
+                                                     uint32_t _requestIndex,
                                                      const OmmRequest& ommRequest)
     : cacheState(_cacheState)
     , lastUseFrameIndex(currentFrameIndex)
-    , leastRecentlyUsedListIter(_leastRecentlyUsedListIter)
-    , cacheStateListIter(_cacheStateListIter)
-    , isUnprocessedCacheStateListIterValid(true)
     , numTriangles(ommRequest.numTriangles)
-    , ommFormat(ommRequest.ommFormat) {
+    , ommFormat(ommRequest.ommFormat)
+    , ommSrcHash(ommRequest.ommSrcHash)
+    , isBillboard(ommRequest.isBillboardOmmRequest())
+    , requestIndex(_requestIndex) {
     useVertexAndTextureOperations = enableVertexAndTextureOperations;
     const uint32_t maxSubdivisionLevel =
       ommFormat == VkOpacityMicromapFormatEXT::VK_OPACITY_MICROMAP_FORMAT_2_STATE_EXT
@@ -92,6 +94,36 @@ namespace dxvk {
            ommRequest.numTriangles == numTriangles;
   }
 
+  bool OpacityMicromapWorkPriority::operator()(const OpacityMicromapCacheItem& a, const OpacityMicromapCacheItem& b) const {
+    // Billboard requests go last since they are expected to be changed at high frequency and trigger a lot of builds.
+    // Therefore, we want to prioritize building requests that passed standard OMM registration filter tests first
+    if (a.isBillboard != b.isBillboard) {
+      return a.isBillboard;
+    }
+
+    // Finish partially baked items first so that they don't hold on to their memory
+    if (a.bakingState.initialized != b.bakingState.initialized) {
+      return !a.bakingState.initialized;
+    }
+
+    // Prefer items bound in the most recent frame, followed by ones bound to the most instances.
+    // Such items are the most likely to be on screen.
+    if (a.lastUseFrameIndex != b.lastUseFrameIndex) {
+      return a.lastUseFrameIndex < b.lastUseFrameIndex;
+    }
+    if (a.numUsesInLastUseFrame != b.numUsesInLastUseFrame) {
+      return a.numUsesInLastUseFrame < b.numUsesInLastUseFrame;
+    }
+
+    // Prefer items with least triangles as they are processed with lower overall latency
+    if (a.numTriangles != b.numTriangles) {
+      return a.numTriangles > b.numTriangles;
+    }
+
+    // Oldest requests first
+    return a.requestIndex > b.requestIndex;
+  }
+
   VkDeviceSize OpacityMicromapCacheItem::getDeviceSize() const {
     return blasOmmBuffersDeviceSize + arrayBufferDeviceSize;
   }
@@ -217,6 +249,10 @@ namespace dxvk {
 
   void OpacityMicromapManager::onDestroy() {
     m_scratchAllocator = nullptr;
+
+    // Pending readbacks are dropped, their arrays get baked and stored in a later session instead
+    m_pendingDiskCacheReadbacks.clear();
+    m_diskCache = nullptr;
   }
 
   OmmRequest::OmmRequest(const RtInstance& _instance, const InstanceManager& instanceManager, uint32_t _quadSliceIndex)
@@ -362,19 +398,21 @@ namespace dxvk {
     switch (ommCacheState) {
     case OpacityMicromapCacheState::eStep0_Unprocessed:
     case OpacityMicromapCacheState::eStep1_Baking:
-      // Note the iterator may be invalid if the cache state list element was
-      // already destroyed when source data was unlinked
-      if (ommCacheItem.isUnprocessedCacheStateListIterValid) {
-        m_unprocessedList.erase(ommCacheItem.cacheStateListIter);
-        ommCacheItem.isUnprocessedCacheStateListIterValid = false;
+      // Note the item may not be queued if it was already removed 
+      // from the queue when source data was unlinked
+      if (m_unprocessedQueue.contains(ommCacheItem)) {
+        m_unprocessedQueue.erase(ommCacheItem);
       }
       m_numTexelsPerMicroTriangle.erase(ommSrcHash);
       break;
     case OpacityMicromapCacheState::eStep2_Baked:
-      m_bakedList.erase(ommCacheItem.cacheStateListIter);
+      // Note the item is not queued while it is being processed
+      if (m_bakedQueue.contains(ommCacheItem)) {
+        m_bakedQueue.erase(ommCacheItem);
+      }
       break;
     case OpacityMicromapCacheState::eStep3_Built:
-      m_builtList.erase(ommCacheItem.cacheStateListIter);
+      m_builtList.erase(ommCacheItem);
       break;
     case OpacityMicromapCacheState::eStep4_Ready:
       break;
@@ -386,7 +424,7 @@ namespace dxvk {
     if (ommCacheState <= OpacityMicromapCacheState::eStep2_Baked)
       deleteCachedSourceData(ommSrcHash, ommCacheState, destroyParentInstanceOmmRequestContainer);
 
-    m_leastRecentlyUsedList.erase(ommCacheItemIter->second.leastRecentlyUsedListIter);
+    m_leastRecentlyUsedList.erase(ommCacheItem);
     m_memoryManager.release(ommCacheItemIter->second.getDeviceSize());
     m_ommCache.erase(ommCacheItemIter);
   }
@@ -417,10 +455,9 @@ namespace dxvk {
 
           // If the OMM data has been at least partially baked keep it in the cache
         case OpacityMicromapCacheState::eStep1_Baking:
-          // Remove partially baked OMM items from to be baked list until a new instance is linked with it again
-          if (ommCacheItem.isUnprocessedCacheStateListIterValid) {
-            m_unprocessedList.erase(ommCacheItem.cacheStateListIter);
-            ommCacheItem.isUnprocessedCacheStateListIterValid = false;
+          // Remove partially baked OMM items from to be baked queue until a new instance is linked with it again
+          if (m_unprocessedQueue.contains(ommCacheItem)) {
+            m_unprocessedQueue.erase(ommCacheItem);
             deleteCachedSourceData(ommSrcHash, ommCacheState, destroyParentInstanceOmmRequestContainer);
           }
           return;
@@ -462,8 +499,8 @@ namespace dxvk {
   }
 
   void OpacityMicromapManager::clear() {
-    m_unprocessedList.clear();
-    m_bakedList.clear();
+    m_unprocessedQueue.clear();
+    m_bakedQueue.clear();
     m_builtList.clear();
 
     m_leastRecentlyUsedList.clear();
@@ -509,8 +546,8 @@ namespace dxvk {
       ImGui::Indent();
       ImGui::Text("# Bound/Requested OMMs: %d/%d", m_numBoundOMMs, m_numRequestedOMMBindings);
       ADVANCED(ImGui::Text("# Staged Requested Items: %d", m_ommBuildRequestStatistics.size()));
-      ADVANCED(ImGui::Text("# Unprocessed Items: %d", m_unprocessedList.size()));
-      ADVANCED(ImGui::Text("# Baked Items: %d", m_bakedList.size()));
+      ADVANCED(ImGui::Text("# Unprocessed Items: %d", m_unprocessedQueue.size()));
+      ADVANCED(ImGui::Text("# Baked Items: %d", m_bakedQueue.size()));
       ADVANCED(ImGui::Text("# Built Items: %d", m_builtList.size()));
       ADVANCED(ImGui::Text("# Cache Items: %d", m_ommCache.size()));
       ADVANCED(ImGui::Text("# Black Listed Items: %d", m_blackListedList.size()));
@@ -519,6 +556,11 @@ namespace dxvk {
       ADVANCED(ImGui::Text("# Baked uTriagles [million]: %.1f", m_numMicroTrianglesBaked / 1e6));
 
       ADVANCED(ImGui::Text("# Built uTriagles [million]: %.1f", m_numMicroTrianglesBuilt / 1e6));
+
+      if (m_diskCache) {
+        ADVANCED(ImGui::Text("Disk Cache Hits/Misses: %u/%u", m_diskCache->getNumHits(), m_diskCache->getNumMisses()));
+        ADVANCED(ImGui::Text("Disk Cache Size [MB]: %.1f", m_diskCache->getTotalSize() / (1024.0 * 1024.0)));
+      }
       ImGui::Unindent();
     }
 
@@ -536,6 +578,9 @@ namespace dxvk {
       ImGui::DragInt("Budget: Min Vidmem Free To Not Allocate [MB]", &OpacityMicromapOptions::Cache::minFreeVidmemMBToNotAllocateObject(), 16.f, 0, 256 * 1024, "%d", sliderFlags);
       ADVANCED(ImGui::DragInt("Min Usage Frame Age Before Eviction", &OpacityMicromapOptions::Cache::minUsageFrameAgeBeforeEvictionObject(), 1.f, 0, 60 * 3600, "%d", sliderFlags));
       ADVANCED(ImGui::Checkbox("Hash Instance Index Only", &OpacityMicromapOptions::Cache::hashInstanceIndexOnlyObject()));
+      ImGui::Checkbox("Disk Cache", &OpacityMicromapOptions::DiskCache::enableObject());
+      ADVANCED(ImGui::DragInt("Disk Cache: Max Size [MB]", &OpacityMicromapOptions::DiskCache::maxSizeMBObject(), 16.f, 0, 256 * 1024, "%d", sliderFlags));
+      ADVANCED(ImGui::DragInt("Disk Cache: Max Loaded [MB per Second]", &OpacityMicromapOptions::DiskCache::maxLoadMBPerSecondObject(), 1.f, 1, 64 * 1024, "%d", sliderFlags));
       ImGui::Unindent();
     }
 
@@ -591,12 +636,13 @@ namespace dxvk {
       "[RTX Opacity Micromap] Statistics:\n",
       "\t# Bound/Requested OMMs: ", m_numBoundOMMs, "/", m_numRequestedOMMBindings, "\n",
       "\t# Staged Requested Items: ", m_ommBuildRequestStatistics.size(), "\n",
-      "\t# Unprocessed Items: ", m_unprocessedList.size(), "\n",
-      "\t# Baked Items: ", m_bakedList.size(), "\n",
+      "\t# Unprocessed Items: ", m_unprocessedQueue.size(), "\n",
+      "\t# Baked Items: ", m_bakedQueue.size(), "\n",
       "\t# Built Items: ", m_builtList.size(), "\n",
       "\t# Cache Items: ", m_ommCache.size(), "\n",
       "\t# Black Listed Items: ", m_blackListedList.size(), "\n",
-      "\tVRAM usage/budget [MB]: ", m_memoryManager.getUsed() / (1024 * 1024), "/", m_memoryManager.getBudget() / (1024 * 1024)));
+      "\tVRAM usage/budget [MB]: ", m_memoryManager.getUsed() / (1024 * 1024), "/", m_memoryManager.getBudget() / (1024 * 1024), "\n",
+      "\tDisk cache hits/misses: ", m_diskCache ? m_diskCache->getNumHits() : 0, "/", m_diskCache ? m_diskCache->getNumMisses() : 0));
   }
 
   bool OpacityMicromapManager::checkIsOpacityMicromapSupported(DxvkDevice& device) {
@@ -1122,55 +1168,28 @@ namespace dxvk {
       }
     }
 
-    std::list<XXH64_hash_t>::iterator cacheStateListIter;
-    if (!insertToUnprocessedList(ommRequest, cacheStateListIter))
+    if (registerCachedSourceData(ommRequest) == m_cachedSourceData.end())
       return false;
 
-    // Place the element to the end of the LRU list, and thus marking it as most recent 
-    m_leastRecentlyUsedList.emplace_back(ommSrcHash);
-    auto lastElementIterator = std::next(m_leastRecentlyUsedList.end(), -1);
-    m_ommCache.emplace(
+    OpacityMicromapCacheItem& ommCacheItem = m_ommCache.emplace(
       std::piecewise_construct,
       std::forward_as_tuple(ommSrcHash),
       std::forward_as_tuple(*m_device, OpacityMicromapCacheState::eStep0_Unprocessed, OpacityMicromapOptions::Building::subdivisionLevel(), 
                             OpacityMicromapOptions::Building::enableVertexAndTextureOperations(), m_device->getCurrentFrameId(),
-                            lastElementIterator, cacheStateListIter, ommRequest));
+                            m_numRequestedOmmItems++, ommRequest)).first->second;
+
+    // Place the element to the end of the LRU list, and thus marking it as most recent 
+    m_leastRecentlyUsedList.pushBack(ommCacheItem);
+    m_unprocessedQueue.push(ommCacheItem);
 
     return true;
   }
   
-  bool OpacityMicromapManager::insertToUnprocessedList(const OmmRequest& ommRequest, std::list<XXH64_hash_t>::iterator& cacheStateListIter) {
-    XXH64_hash_t ommSrcHash = ommRequest.ommSrcHash;
-
-    auto sourceDataIter = registerCachedSourceData(ommRequest);
-
-    if (sourceDataIter == m_cachedSourceData.end())
+  bool OpacityMicromapManager::insertToUnprocessedQueue(const OmmRequest& ommRequest, OpacityMicromapCacheItem& ommCacheItem) {
+    if (registerCachedSourceData(ommRequest) == m_cachedSourceData.end())
       return false;
 
-    CachedSourceData& sourceData = sourceDataIter->second;
-
-    // Billboard requests go to the end since they are expected to be changed at high frequency and trigger a lot of builds.
-    // Therefore, we want to prioritize building ommRequests that passed standard OMM registration filter tests first
-    if (!ommRequest.isBillboardOmmRequest()) {
-      // Add the OMM request to the unprocessed list according to the numTriangle count in an ascending order 
-      // so that requests with least triangles are processed first and thus with lower overall latency
-      for (auto itemIter = m_unprocessedList.begin(); itemIter != m_unprocessedList.end(); itemIter++) {
-
-        XXH64_hash_t itemOmmSrcHash = *itemIter;
-
-        CachedSourceData& itemSourceData = m_cachedSourceData[itemOmmSrcHash];
-
-        if (sourceData.numTriangles < itemSourceData.numTriangles ||
-            // insert in front of any billboard requests
-            usesSplitBillboardOpacityMicromap(*itemSourceData.getInstance())) {
-          cacheStateListIter = m_unprocessedList.insert(itemIter, ommSrcHash);
-          return true;
-        }
-      }
-    }
-
-    m_unprocessedList.emplace_back(ommSrcHash);
-    cacheStateListIter = std::prev(m_unprocessedList.end());
+    m_unprocessedQueue.push(ommCacheItem);
 
     return true;
   }
@@ -1296,10 +1315,9 @@ namespace dxvk {
       if (ommCacheItem.cacheState == OpacityMicromapCacheState::eStep1_Baking) {
         auto sourceDataIter = m_cachedSourceData.find(ommSrcHash);
 
-        // Source data has been unlinked and removed from unprocessed list, try adding it back to the unprocessed list
+        // Source data has been unlinked and removed from unprocessed queue, try adding it back to the unprocessed queue
         if (sourceDataIter == m_cachedSourceData.end()) {
-          ommCacheItem.isUnprocessedCacheStateListIterValid = insertToUnprocessedList(ommRequest, ommCacheItem.cacheStateListIter);
-          return ommCacheItem.isUnprocessedCacheStateListIterValid;
+          return insertToUnprocessedQueue(ommRequest, ommCacheItem);
         }
       }
     }
@@ -1357,10 +1375,22 @@ namespace dxvk {
       return kEmptyHash;
     }
 
-    ommCacheItem.lastUseFrameIndex = m_device->getCurrentFrameId();
+    const uint32_t currentFrameIndex = m_device->getCurrentFrameId();
+    if (ommCacheItem.lastUseFrameIndex != currentFrameIndex) {
+      ommCacheItem.lastUseFrameIndex = currentFrameIndex;
+      ommCacheItem.numUsesInLastUseFrame = 0;
+    }
+    ommCacheItem.numUsesInLastUseFrame++;
+
+    // Usage affects the priority of items yet to be baked or built
+    if (m_unprocessedQueue.contains(ommCacheItem)) {
+      m_unprocessedQueue.update(ommCacheItem);
+    } else if (m_bakedQueue.contains(ommCacheItem)) {
+      m_bakedQueue.update(ommCacheItem);
+    }
 
     // Make the item most recently used
-    m_leastRecentlyUsedList.splice(m_leastRecentlyUsedList.end(), m_leastRecentlyUsedList, ommCacheItem.leastRecentlyUsedListIter);
+    m_leastRecentlyUsedList.moveToBack(ommCacheItem);
 
     // Bind OMM if the data is ready
     switch (ommCacheState) {
@@ -1408,11 +1438,10 @@ namespace dxvk {
       }
 
       // All built instances have been synchronized, remove them from the built list
-      {
-        for (auto& ommSrcHash : m_builtList) {
-          m_ommCache[ommSrcHash].cacheState = OpacityMicromapCacheState::eStep4_Ready;
-        }
-        m_builtList.clear();
+      while (!m_builtList.empty()) {
+        OpacityMicromapCacheItem& ommCacheItem = *m_builtList.front();
+        ommCacheItem.cacheState = OpacityMicromapCacheState::eStep4_Ready;
+        m_builtList.erase(ommCacheItem);
       }
 
       m_boundOmmsRequireSynchronization = false;
@@ -1596,35 +1625,54 @@ namespace dxvk {
     uint32_t& availableBakingBudget) {
     
     const RtInstance& instance = *sourceData.getInstance();
+    const uint32_t numTriangles = sourceData.numTriangles;
 
-    if (!areInstanceTexturesResident(instance, textures)) {
-      return OmmResult::DependenciesUnavailable;
-    }
-
-    // Check if the data has already been calculated
-    NumTexelsPerMicroTriangle* numTexelsPerMicroTriangle;
-    const OmmResult texelBudgetCheckResult = getNumTexelsPerMicroTriangle(instance, &numTexelsPerMicroTriangle);
-    if (texelBudgetCheckResult != OmmResult::Success) {
-      // If the instance hasn't been updated this frame, it means it's kept around by other means 
-      // and NumTexelsPerMicroTriangle won't be able to be generated since the draw calls for it are no longer being issued.
-      // Therefore, let's get rid of the instance being linked to OMMs. We can't call destroyInstance() from within baking call stack, 
-      // since multiple OMM items linked to it may get purged because of it and baking iterates through a list of OMMs.
-      // Instead queue up the instance destruction
-      if (instance.getFrameLastUpdated() != m_device->getCurrentFrameId()) {
-        m_instancesToDestroy.push_back(&instance);
+    // Arrays baked in a previous session are uploaded as is, so neither textures nor texel densities are needed for them
+    const XXH64_hash_t diskCacheKey =
+      m_diskCache && !ommCacheItem.bakingState.initialized
+      ? calculateDiskCacheKey(ommSrcHash, ommCacheItem, numTriangles)
+      : kEmptyHash;
+    const bool isInDiskCache = diskCacheKey != kEmptyHash && m_diskCache->contains(diskCacheKey);
+
+    NumTexelsPerMicroTriangle* numTexelsPerMicroTriangle = nullptr;
+
+    if (!isInDiskCache) {
+      if (!areInstanceTexturesResident(instance, textures)) {
+        return OmmResult::DependenciesUnavailable;
+      }
+
+      // Check if the data has already been calculated
+      const OmmResult texelBudgetCheckResult = getNumTexelsPerMicroTriangle(instance, &numTexelsPerMicroTriangle);
+      if (texelBudgetCheckResult != OmmResult::Success) {
+        // If the instance hasn't been updated this frame, it means it's kept around by other means 
+        // and NumTexelsPerMicroTriangle won't be able to be generated since the draw calls for it are no longer being issued.
+        // Therefore, let's get rid of the instance being linked to OMMs. We can't call destroyInstance() from within baking call stack, 
+        // since multiple OMM items linked to it may get purged because of it and baking iterates through a list of OMMs.
+        // Instead queue up the instance destruction
+        if (instance.getFrameLastUpdated() != m_device->getCurrentFrameId()) {
+          m_instancesToDestroy.push_back(&instance);
+        }
+        return texelBudgetCheckResult;
       }
-      return texelBudgetCheckResult;
     }
 
     BlasEntry& blasEntry = *instance.getBlas();
 
-    const uint32_t numTriangles = sourceData.numTriangles;
     const uint32_t numMicroTrianglesPerTriangle = calculateNumMicroTriangles(ommCacheItem.subdivisionLevel);
     const uint32_t numMicroTriangles = numTriangles * numMicroTrianglesPerTriangle;
     const uint8_t numOpacityMicromapBitsPerMicroTriangle = ommCacheItem.ommFormat == VK_OPACITY_MICROMAP_FORMAT_2_STATE_EXT ? 1 : 2;
     const uint32_t opacityMicromapPerTriangleBufferSize = dxvk::util::ceilDivide(numMicroTrianglesPerTriangle * numOpacityMicromapBitsPerMicroTriangle, 8);
     const uint32_t opacityMicromapBufferSize = numTriangles * opacityMicromapPerTriangleBufferSize;
 
+    // Disk cache loads are read and uploaded synchronously, so they are limited per frame as well.
+    // Note: the budget is spent when it's still positive, so that entries larger than it make progress too
+    if (isInDiskCache) {
+      if (m_availableDiskCacheLoadBudget == 0) {
+        return OmmResult::OutOfBudget;
+      }
+      m_availableDiskCacheLoadBudget -= std::min<uint64_t>(m_availableDiskCacheLoadBudget, opacityMicromapBufferSize);
+    }
+
     omm_validation_assert((usesSplitBillboardOpacityMicromap(instance) || numTriangles == instance.getBlas()->input.getGeometryData().calculatePrimitiveCount()) &&
                           instance.getBlas()->input.getGeometryData().calculatePrimitiveCount() ==
                           instance.getBlas()->modifiedGeometryData.calculatePrimitiveCount() &&
@@ -1655,8 +1703,11 @@ namespace dxvk {
     if (!ommCacheItem.ommArrayBuffer.ptr())
     {
       DxvkBufferCreateInfo ommBufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-      ommBufferInfo.usage = VK_BUFFER_USAGE_MICROMAP_BUILD_INPUT_READ_ONLY_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-      ommBufferInfo.access = VK_ACCESS_SHADER_WRITE_BIT;
+      // Transfers upload arrays from and read them back to the disk cache
+      ommBufferInfo.usage = VK_BUFFER_USAGE_MICROMAP_BUILD_INPUT_READ_ONLY_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      ommBufferInfo.stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+      ommBufferInfo.access = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
       ommBufferInfo.size = opacityMicromapBufferSize;
       ommCacheItem.ommArrayBuffer = m_device->createBuffer(ommBufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXOpacityMicromap);
 
@@ -1666,6 +1717,28 @@ namespace dxvk {
       }
     }
 
+    if (isInDiskCache) {
+      OpacityMicromapDiskCacheEntry entry;
+      if (!m_diskCache->load(diskCacheKey, entry) ||
+          entry.numTriangles != numTriangles ||
+          entry.subdivisionLevel != ommCacheItem.subdivisionLevel ||
+          entry.ommFormat != static_cast<uint32_t>(ommCacheItem.ommFormat) ||
+          entry.arrayData.size() != opacityMicromapBufferSize) {
+        // The entry is gone or doesn't match, the item will be baked on the next attempt
+        return OmmResult::DependenciesUnavailable;
+      }
+
+      ctx->writeToBuffer(ommCacheItem.ommArrayBuffer, 0, entry.arrayData.size(), entry.arrayData.data());
+
+      ommCacheItem.bakingState.initialized = true;
+      ommCacheItem.bakingState.numTriangles = numTriangles;
+      ommCacheItem.bakingState.numMicroTrianglesToBake = numMicroTriangles;
+      ommCacheItem.bakingState.numMicroTrianglesBaked = numMicroTriangles;
+      ommCacheItem.bakingState.numMicroTrianglesBakedInLastBake = 0;
+
+      return OmmResult::Success;
+    }
+
     // Generate OMM array
     {
       RtxGeometryUtils::BakeOpacityMicromapDesc desc(*numTexelsPerMicroTriangle);
@@ -1714,6 +1787,11 @@ namespace dxvk {
 
     m_numMicroTrianglesBaked += ommCacheItem.bakingState.numMicroTrianglesBakedInLastBake;
 
+    // Use >= as the number of baked micro triangles is aligned up
+    if (m_diskCache && ommCacheItem.bakingState.numMicroTrianglesBaked >= ommCacheItem.bakingState.numMicroTrianglesToBake) {
+      readBackBakedArrayToDiskCache(ctx, calculateDiskCacheKey(ommSrcHash, ommCacheItem, numTriangles), ommCacheItem, numTriangles);
+    }
+
     return OmmResult::Success;
   }
 
@@ -1867,16 +1945,10 @@ namespace dxvk {
     if (!OpacityMicromapOptions::enableBakingArrays())
       return;
 
+    static MetricHistogram& s_bakeTime = Metrics::histogram("omm.bake_time_ms");
+    ScopedMetricTimer bakeTimer(s_bakeTime);
+
 #ifdef VALIDATION_MODE
-    for (auto iter0 = m_unprocessedList.begin(); iter0 != m_unprocessedList.end(); iter0++) {
-      auto iter1 = iter0;
-      iter1++;
-      for (; iter1 != m_unprocessedList.end(); iter1++) {
-        if (*iter1 == *iter0) {
-          omm_validation_assert(0 && "Duplicate entries found in a list");
-        }
-      }
-    }
     for (auto iter0 = m_cachedSourceData.begin(); iter0 != m_cachedSourceData.end(); iter0++) {
       OpacityMicromapCacheItem& ommCacheItem = m_ommCache[iter0->first];
       if ((ommCacheItem.cacheState <= OpacityMicromapCacheState::eStep0_Unprocessed) &&
@@ -1891,30 +1963,31 @@ namespace dxvk {
       availableBakingBudget = UINT32_MAX;
     }
 
-    for (auto ommSrcHashIter = m_unprocessedList.begin(); ommSrcHashIter != m_unprocessedList.end() && availableBakingBudget > 0; ) {
-      XXH64_hash_t ommSrcHash = *ommSrcHashIter;
+    // Items are popped off the queue in priority order. The ones that can't be completed now are pushed back
+    // once the loop is done. Note: processing an item must not destroy any other items popped off the queue.
+    m_deferredWorkItems.clear();
+
+    while (!m_unprocessedQueue.empty() && availableBakingBudget > 0) {
+      OpacityMicromapCacheItem& ommCacheItem = m_unprocessedQueue.pop();
+      const XXH64_hash_t ommSrcHash = ommCacheItem.ommSrcHash;
 
 #ifdef VALIDATION_MODE
       Logger::warn(str::format("[RTX Opacity Micromap] Baking ", ommSrcHash, " on thread_id ", std::this_thread::get_id()));
 #endif
 
       auto sourceDataIter = m_cachedSourceData.find(ommSrcHash);
-      auto cacheItemIter = m_ommCache.find(ommSrcHash);
 
-      if (sourceDataIter == m_cachedSourceData.end() || cacheItemIter == m_ommCache.end()) {
+      if (sourceDataIter == m_cachedSourceData.end()) {
         // Note: this shouldn't be hit anymore as it was triggered by destroying an instance
         // on a baking failure and destroying source data for all OMMs associated with that instance.
-        // That included OMMs that were still in the unordered list. Now just the failed OMM gets destroyed.
+        // That included OMMs that were still in the unprocessed queue. Now just the failed OMM gets destroyed.
         assert(0 && "OMM inconsistent state");
         ONCE(Logger::err("[RTX Opacity Micromap] Encountered inconsistent state. Opacity Micromap item listed for baking is missing required state data. Skipping it."));
-        // First update the iterator, then destroy any omm data associated with it
-        ommSrcHashIter++;
         destroyOmmData(ommSrcHash);
         continue;
       }
 
       CachedSourceData& sourceData = sourceDataIter->second;
-      OpacityMicromapCacheItem& ommCacheItem = cacheItemIter->second;
       ommCacheItem.cacheState = OpacityMicromapCacheState::eStep1_Baking;
 
       OmmResult result = bakeOpacityMicromapArray(ctx, ommSrcHash, ommCacheItem, sourceData, textures, availableBakingBudget);
@@ -1928,26 +2001,25 @@ namespace dxvk {
 
           m_numTexelsPerMicroTriangle.erase(ommSrcHash);
 
-          // Move the item from the unprocessed list to the end of the baked list
+          // Move the item to the baked queue
           ommCacheItem.cacheState = OpacityMicromapCacheState::eStep2_Baked;
-          auto ommSrcHashIterToMove = ommSrcHashIter++;
-          m_bakedList.splice(m_bakedList.end(), m_unprocessedList, ommSrcHashIterToMove);
-          ommCacheItem.isUnprocessedCacheStateListIterValid = false;
+          m_bakedQueue.push(ommCacheItem);
         }
         else {
-          // Do nothing, else path means all the budget has been used up and thus the loop will exit due to availableBakingBudget == 0
-          //   so don't need to increment the iterator
+          // All the budget has been used up and thus the loop will exit due to availableBakingBudget == 0.
+          // The partially baked item is continued first in a following frame
+          m_deferredWorkItems.push_back(&ommCacheItem);
           if (OpacityMicromapOptions::Building::enableUnlimitedBakingAndBuildingBudgets()) {
             ONCE(Logger::err("[RTX Opacity Micromap] Failed to fully bake an Opacity Micromap due to budget limits even with unlimited budgetting enabled."));
           }
         }
       } else if (result == OmmResult::OutOfMemory) {
-        // Do nothing, try the next one
-        ommSrcHashIter++;
+        // Try the next one
+        m_deferredWorkItems.push_back(&ommCacheItem);
         ONCE(Logger::debug("[RTX Opacity Micromap] Baking Opacity Micromap Array failed as ran out of memory."));
       } else if (result == OmmResult::DependenciesUnavailable) {
         // Textures not available - try the next one
-        ommSrcHashIter++;
+        m_deferredWorkItems.push_back(&ommCacheItem);
       } else if (result == OmmResult::Failure || 
                  result == OmmResult::Rejected) {
         if (result == OmmResult::Failure) {
@@ -1957,19 +2029,21 @@ namespace dxvk {
         Logger::warn(str::format("[RTX Opacity Micromap] Baking Opacity Micromap Array failed for hash ", ommSrcHash, ". Ignoring and black listing the hash."));
 #endif
         // Baking failed, ditch the OMM data
-        // First update the iterator, then remove the element
-        ommSrcHashIter++;
-        destroyOmmData(cacheItemIter);
+        destroyOmmData(ommSrcHash);
         m_blackListedList.insert(ommSrcHash);
       } else { // OutOfBudget
-        omm_validation_assert(0 && "Should not be hit");
-        ommSrcHashIter++;
+        // Disk cache loads for this frame are used up, load it in a following frame and keep baking others
+        m_deferredWorkItems.push_back(&ommCacheItem);
       }
 #ifdef VALIDATION_MODE
       Logger::warn(str::format("[RTX Opacity Micromap] ~Baking ", ommSrcHash, " on thread_id ", std::this_thread::get_id()));
 #endif
     }
 
+    for (OpacityMicromapCacheItem* ommCacheItem : m_deferredWorkItems) {
+      m_unprocessedQueue.push(*ommCacheItem);
+    }
+
     if (OpacityMicromapOptions::Building::enableUnlimitedBakingAndBuildingBudgets()) {
       availableBakingBudget = UINT32_MAX;
     }
@@ -1981,28 +2055,11 @@ namespace dxvk {
     if (!OpacityMicromapOptions::enableBuilding())
       return;
 
-#ifdef VALIDATION_MODE
-    for (auto iter0 = m_bakedList.begin(); iter0 != m_bakedList.end(); iter0++) {
-      auto iter1 = iter0;
-      iter1++;
-      for (; iter1 != m_bakedList.end(); iter1++) {
-        if (*iter1 == *iter0) {
-          omm_validation_assert(0 && "Duplicate entries found in a list");
-        }
-      }
-      for (auto iter2 = m_unprocessedList.begin(); iter2 != m_unprocessedList.end(); iter2++) {
-        if (*iter2 == *iter0) {
-          omm_validation_assert(0 && "Two lists contain same OMM src hash");
-        }
-      }
-    }
-#endif
-
     ScopedGpuProfileZone(ctx, "Build Opacity Micromaps");
 
     // Pre-allocate the arrays because build infos include pointers to usage groups,
     // and reallocating vectors would invalidate these pointers
-    const uint32_t maxBuildItems = m_bakedList.size();
+    const uint32_t maxBuildItems = m_bakedQueue.size();
     std::vector<VkMicromapUsageEXT> micromapUsageGroups(maxBuildItems);
     std::vector<VkMicromapBuildInfoEXT> micromapBuildInfos(maxBuildItems);
     uint32_t buildItemCount = 0;
@@ -2015,22 +2072,23 @@ namespace dxvk {
     // They're cheap regardless, so it should be fine.
     bool forceOmmBuild = maxMicroTrianglesToBuild > 0;  
 
-    for (auto ommSrcHashIter = m_bakedList.begin(); ommSrcHashIter != m_bakedList.end() && maxMicroTrianglesToBuild > 0; ) {
-      XXH64_hash_t ommSrcHash = *ommSrcHashIter;
+    // Items are popped off the queue in priority order. The ones that can't be built now are pushed back once the loop is done
+    m_deferredWorkItems.clear();
+
+    while (!m_bakedQueue.empty() && maxMicroTrianglesToBuild > 0) {
+      OpacityMicromapCacheItem& ommCacheItem = m_bakedQueue.pop();
+      const XXH64_hash_t ommSrcHash = ommCacheItem.ommSrcHash;
 #ifdef VALIDATION_MODE
       Logger::warn(str::format("[RTX Opacity Micromap] Building ", ommSrcHash, " on thread_id ", std::this_thread::get_id()));
 #endif
-      auto ommCacheItemIter = m_ommCache.find(ommSrcHash);
-      OpacityMicromapCacheItem& ommCacheItem = ommCacheItemIter->second;
 
-      OmmResult result = buildOpacityMicromap(ctx, *ommSrcHashIter, ommCacheItem, micromapUsageGroups[buildItemCount],
+      OmmResult result = buildOpacityMicromap(ctx, ommSrcHash, ommCacheItem, micromapUsageGroups[buildItemCount],
                                               micromapBuildInfos[buildItemCount], maxMicroTrianglesToBuild, forceOmmBuild);
       
       if (result == OmmResult::Success) {
         ommCacheItem.cacheState = OpacityMicromapCacheState::eStep3_Built;
-        // Move the item from the baked list to the end of the built list
-        auto ommSrcHashIterToMove = ommSrcHashIter++;
-        m_builtList.splice(m_builtList.end(), m_bakedList, ommSrcHashIterToMove);
+        // Move the item to the end of the built list
+        m_builtList.pushBack(ommCacheItem);
         ++buildItemCount;
 
         forceOmmBuild = false;
@@ -2040,24 +2098,22 @@ namespace dxvk {
         ONCE(Logger::warn(str::format("[RTX Opacity Micromap] Building Opacity Micromap failed for hash ", ommSrcHash, ".Ignoring and black listing the hash.")));
 #endif
         // Building failed, ditch the OMM data
-        // First update the iterator, then remove the element
-        ommSrcHashIter++;
-        destroyOmmData(ommCacheItemIter);
+        destroyOmmData(ommSrcHash);
         m_blackListedList.insert(ommSrcHash);
       } else if (result == OmmResult::OutOfBudget) {
-        // Do nothing, continue onto the next
-        ommSrcHashIter++;
+        // Continue onto the next
+        m_deferredWorkItems.push_back(&ommCacheItem);
 
         if (OpacityMicromapOptions::Building::enableUnlimitedBakingAndBuildingBudgets()) {
           ONCE(Logger::err("[RTX Opacity Micromap] Failed to fully build an Opacity Micromap due to budget limits even with unlimited budgetting enabled."));
         }
       } else if (result == OmmResult::OutOfMemory) {
-        // Do nothing, try the next one
-        ommSrcHashIter++;
+        // Try the next one
+        m_deferredWorkItems.push_back(&ommCacheItem);
         ONCE(Logger::warn("[RTX Opacity Micromap] Building Opacity Micromap Array failed as it ran out of memory."));
       } else {
         omm_validation_assert(0 && "Should not be hit");
-        ommSrcHashIter++;
+        m_deferredWorkItems.push_back(&ommCacheItem);
       }
 #ifdef VALIDATION_MODE
       Logger::warn(str::format("[RTX Opacity Micromap] ~Building ", ommSrcHash, " on thread_id ", std::this_thread::get_id()));
@@ -2068,6 +2124,10 @@ namespace dxvk {
       }
     }
 
+    for (OpacityMicromapCacheItem* ommCacheItem : m_deferredWorkItems) {
+      m_bakedQueue.push(*ommCacheItem);
+    }
+
     if (buildItemCount > 0) {
       // Add a barrier needed for Micromap build reading the triangleArrayBuffer's and triangleIndexBuffer's
       {
@@ -2087,6 +2147,100 @@ namespace dxvk {
     }
   }
 
+  XXH64_hash_t OpacityMicromapManager::calculateDiskCacheKey(XXH64_hash_t ommSrcHash, const OpacityMicromapCacheItem& ommCacheItem, uint32_t numTriangles) const {
+    // hashInstanceIndexOnly produces per-session source hashes, which can't be matched across runs
+    if (OpacityMicromapOptions::Cache::hashInstanceIndexOnly()) {
+      return kEmptyHash;
+    }
+
+    // Baking settings that affect array contents but are not accounted for in the source hash
+    struct DiskCacheKeyData {
+      uint32_t numTriangles;
+      uint32_t subdivisionLevel;
+      uint32_t ommFormat;
+      uint32_t useVertexAndTextureOperations;
+      uint32_t useConservativeEstimation;
+      uint32_t conservativeEstimationMaxTexelTapsPerMicroTriangle;
+      float resolveTransparencyThreshold;
+      float resolveOpaquenessThreshold;
+      float decalsMinResolveTransparencyThreshold;
+    } keyData;
+
+    keyData.numTriangles = numTriangles;
+    keyData.subdivisionLevel = ommCacheItem.subdivisionLevel;
+    keyData.ommFormat = ommCacheItem.ommFormat;
+    keyData.useVertexAndTextureOperations = ommCacheItem.useVertexAndTextureOperations;
+    keyData.useConservativeEstimation = OpacityMicromapOptions::Building::ConservativeEstimation::enable();
+    keyData.conservativeEstimationMaxTexelTapsPerMicroTriangle = OpacityMicromapOptions::Building::ConservativeEstimation::maxTexelTapsPerMicroTriangle();
+    keyData.resolveTransparencyThreshold = RtxOptions::Get()->getResolveTransparencyThreshold();
+    keyData.resolveOpaquenessThreshold = RtxOptions::Get()->getResolveOpaquenessThreshold();
+    keyData.decalsMinResolveTransparencyThreshold = OpacityMicromapOptions::Building::decalsMinResolveTransparencyThreshold();
+
+    // Arrays baked by a different build or bake shader must not be reused, the cache version alone is easily forgotten
+    return XXH3_64bits_withSeed(&keyData, sizeof(keyData), ommSrcHash ^ RtxGeometryUtils::getBakeOpacityMicromapCodeHash());
+  }
+
+  void OpacityMicromapManager::readBackBakedArrayToDiskCache(Rc<DxvkContext> ctx, XXH64_hash_t diskCacheKey, const OpacityMicromapCacheItem& ommCacheItem, uint32_t numTriangles) {
+    if (diskCacheKey == kEmptyHash ||
+        m_pendingDiskCacheReadbacks.size() >= kMaxPendingDiskCacheReadbacks ||
+        m_diskCache->contains(diskCacheKey)) {
+      return;
+    }
+
+    DxvkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferInfo.size = ommCacheItem.ommArrayBuffer->info().size;
+    Rc<DxvkBuffer> readbackBuffer = m_device->createBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, DxvkMemoryStats::Category::RTXOpacityMicromap);
+
+    if (readbackBuffer == nullptr) {
+      return;
+    }
+
+    ctx->copyBuffer(readbackBuffer, 0, ommCacheItem.ommArrayBuffer, 0, bufferInfo.size);
+    ctx->emitMemoryBarrier(0,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      VK_ACCESS_HOST_READ_BIT);
+
+    m_pendingDiskCacheReadbacks.push_back({ diskCacheKey, readbackBuffer, numTriangles, ommCacheItem.subdivisionLevel, ommCacheItem.ommFormat });
+  }
+
+  void OpacityMicromapManager::updateDiskCache() {
+    if (!OpacityMicromapOptions::DiskCache::enable()) {
+      m_pendingDiskCacheReadbacks.clear();
+      m_diskCache = nullptr;
+      return;
+    }
+
+    if (!m_diskCache) {
+      const std::string& path = OpacityMicromapOptions::DiskCache::path();
+      const uint64_t maxSize = uint64_t(std::max(OpacityMicromapOptions::DiskCache::maxSizeMB(), 0)) * 1024 * 1024;
+      m_diskCache = std::make_unique<OpacityMicromapDiskCache>(path.empty() ? OpacityMicromapDiskCache::getDefaultDirectory() : path, maxSize);
+    }
+
+    // Hand over arrays whose readbacks have completed to the disk cache's writer thread
+    for (auto readbackIter = m_pendingDiskCacheReadbacks.begin(); readbackIter != m_pendingDiskCacheReadbacks.end(); ) {
+      if (readbackIter->buffer->isInUse()) {
+        readbackIter++;
+        continue;
+      }
+
+      const uint8_t* data = reinterpret_cast<const uint8_t*>(readbackIter->buffer->mapPtr(0));
+
+      OpacityMicromapDiskCacheEntry entry;
+      entry.numTriangles = readbackIter->numTriangles;
+      entry.subdivisionLevel = readbackIter->subdivisionLevel;
+      entry.ommFormat = readbackIter->ommFormat;
+      entry.arrayData.assign(data, data + readbackIter->buffer->info().size);
+      m_diskCache->store(readbackIter->key, std::move(entry));
+
+      readbackIter = m_pendingDiskCacheReadbacks.erase(readbackIter);
+    }
+  }
+
   void OpacityMicromapManager::onFrameStart(Rc<DxvkContext> ctx) {
     ScopedCpuProfileZone();
     const uint32_t currentFrameIndex = m_device->getCurrentFrameId();
@@ -2094,6 +2248,8 @@ namespace dxvk {
     m_numBoundOMMs = 0;
     m_numRequestedOMMBindings = 0;
 
+    updateDiskCache();
+
     // Clear caches if we need to rebuild OMMs
     {
       bool forceRebuildOMMs = OpacityMicromapOptions::enableResetEveryFrame();
@@ -2155,18 +2311,10 @@ namespace dxvk {
         if (m_amountOfMemoryMissing > 0) {
 
           // Start evicting least recently used items 
-          for (auto lruOmmSrcHashIter = m_leastRecentlyUsedList.begin();
-               lruOmmSrcHashIter != m_leastRecentlyUsedList.end() && m_amountOfMemoryMissing > m_memoryManager.calculatePendingAvailableSize();
-               ) {
-            auto cacheItemIter = m_ommCache.find(*lruOmmSrcHashIter);
-            if (cacheItemIter == m_ommCache.end()) {
-              auto iterToDelete = lruOmmSrcHashIter;
-              // Increment the iterator before any deletion
-              lruOmmSrcHashIter++;
-              ONCE(Logger::err("[RTX] Failed to find Opacity Micromap cache entry on LRU eviction"));
-              m_leastRecentlyUsedList.erase(iterToDelete);
-              continue;
-            }
+          while (!m_leastRecentlyUsedList.empty() && m_amountOfMemoryMissing > m_memoryManager.calculatePendingAvailableSize()) {
+            // Items are linked into the LRU list for as long as they are in the cache
+            auto cacheItemIter = m_ommCache.find(m_leastRecentlyUsedList.front()->ommSrcHash);
+            omm_validation_assert(cacheItemIter != m_ommCache.end());
 
             const uint32_t cacheItemUsageFrameAge = currentFrameIndex - cacheItemIter->second.lastUseFrameIndex;
 
@@ -2176,9 +2324,6 @@ namespace dxvk {
               !hasVRamBudgetDecreased)
               break;
 
-            // Increment the iterator before any deletion
-            lruOmmSrcHashIter++;
-
             destroyOmmData(cacheItemIter);
           }
         }
@@ -2249,19 +2394,25 @@ namespace dxvk {
     // Initialize per frame budgets
     float numMillionMicroTrianglesToBakeAvailable = OpacityMicromapOptions::Building::maxMicroTrianglesToBakeMillionPerSecond() * secondToFrameBudgetScale;
     float numMillionMicroTrianglesToBuildAvailable = OpacityMicromapOptions::Building::maxMicroTrianglesToBuildMillionPerSecond() * secondToFrameBudgetScale;
+    float numMBToLoadFromDiskCacheAvailable = OpacityMicromapOptions::DiskCache::maxLoadMBPerSecond() * secondToFrameBudgetScale;
 
     if (m_device->getCurrentFrameId() - lastCameraCutFrameId < OpacityMicromapOptions::Building::numFramesAtStartToBuildWithHighWorkload()) {
       numMillionMicroTrianglesToBakeAvailable *= OpacityMicromapOptions::Building::highWorkloadMultiplier();
       numMillionMicroTrianglesToBuildAvailable *= OpacityMicromapOptions::Building::highWorkloadMultiplier();
+      numMBToLoadFromDiskCacheAvailable *= OpacityMicromapOptions::Building::highWorkloadMultiplier();
     }
 
     float fNumMicroTrianglesToBakeAvailable = numMillionMicroTrianglesToBakeAvailable * 1e6f;
     uint32_t numMicroTrianglesToBakeAvailable = fNumMicroTrianglesToBakeAvailable < UINT32_MAX ? static_cast<uint32_t>(fNumMicroTrianglesToBakeAvailable) : UINT32_MAX;
     float fNumMicroTrianglesToBuildAvailable = numMillionMicroTrianglesToBuildAvailable * 1e6f;
     uint32_t numMicroTrianglesToBuildAvailable = fNumMicroTrianglesToBuildAvailable < UINT32_MAX ? static_cast<uint32_t>(fNumMicroTrianglesToBuildAvailable) : UINT32_MAX;
+    m_availableDiskCacheLoadBudget =
+      OpacityMicromapOptions::Building::enableUnlimitedBakingAndBuildingBudgets()
+      ? UINT64_MAX
+      : static_cast<uint64_t>(std::max(numMBToLoadFromDiskCacheAvailable, 0.f) * 1024.f * 1024.f);
 
     // Generate opacity micromaps
-    if (!m_unprocessedList.empty() || !m_bakedList.empty()) {
+    if (!m_unprocessedQueue.empty() || !m_bakedQueue.empty()) {
       ScopedGpuProfileZone(ctx, "Process Opacity Micromaps");
 
       bakeOpacityMicromapArrays(ctx, textures, numMicroTrianglesToBakeAvailable);
@@ -27,6 +27,8 @@
 #include "rtx_option.h"
 #include "rtx_common_object.h"
 #include "rtx_staging.h"
+#include "rtx_opacity_micromap_disk_cache.h"
+#include "../../util/util_intrusive_queue.h"
 #include <vector>
 #include <list>
 #include <unordered_map>
@@ -67,6 +69,17 @@ namespace dxvk {
     };
 
 
+    struct DiskCache {
+      friend class OpacityMicromapManager;
+
+      RTX_OPTION("rtx.opacityMicromap.diskCache", bool, enable, true, "Enables a persistent on-disk cache of baked Opacity Micromap arrays. Arrays found in the cache skip baking in subsequent sessions and are built right away.");
+      RTX_OPTION("rtx.opacityMicromap.diskCache", std::string, path, "", "Directory of the Opacity Micromap disk cache. A directory named after the executable is used when empty.");
+      RTX_OPTION("rtx.opacityMicromap.diskCache", int, maxSizeMB, 1024, "Max size [MB] of the Opacity Micromap disk cache. Least recently used entries are evicted once the cache grows past it.");
+      RTX_OPTION("rtx.opacityMicromap.diskCache", int, maxLoadMBPerSecond, 60 * 4,
+                 "Max amount of Opacity Micromap array data to load from the disk cache and upload [MB/Second].\n"
+                 "Entries past this budget are loaded in a following frame. Scaled the same way as the baking budget.");
+    };
+
     struct BuildRequests {
       friend class OpacityMicromapManager;
 
@@ -256,17 +269,19 @@ namespace dxvk {
     uint16_t subdivisionLevel = UINT16_MAX;
     uint32_t numTriangles = UINT32_MAX;
     VkOpacityMicromapFormatEXT ommFormat = VK_OPACITY_MICROMAP_FORMAT_2_STATE_EXT;
-    std::list<XXH64_hash_t>::iterator leastRecentlyUsedListIter;
+    XXH64_hash_t ommSrcHash = kEmptyHash;
 
-    // Iterator to a cache state list for the current cacheState.
-    // Since the iterator is moved between the lists, it is initalized only once
-    // and remains valid until it's removed from a list
-    std::list<XXH64_hash_t>::iterator cacheStateListIter;
+    // Priority inputs for the work queues
+    bool isBillboard = false;
+    uint32_t numUsesInLastUseFrame = 0; // Number of instances the item was bound to in lastUseFrameIndex frame
+    uint32_t requestIndex = 0;          // Order in which the item was requested
 
-    // Whether cacheStateListIter is valid when it corresponds to m_unprocessedList.
-    // This is to handle the iterator state when an OMM cache item is in unprocessed or baking state
-    // but the source data has been unlinked and cacheStateList item was removed
-    bool isUnprocessedCacheStateListIterValid = false;  
+    // Hooks into Opacity Micromap Manager's LRU list and the work queue for the current cacheState.
+    // The unprocessed queue may not contain an item in unprocessed or baking state 
+    // if the source data has been unlinked in the meantime
+    IntrusiveListHook<OpacityMicromapCacheItem> leastRecentlyUsedHook;
+    IntrusiveListHook<OpacityMicromapCacheItem> builtListHook;
+    IntrusivePriorityQueueHook workQueueHook;
 
     // Needed during baking
     Rc<DxvkBuffer> ommArrayBuffer;   // Per micro triangle
@@ -278,8 +293,8 @@ namespace dxvk {
 
     OpacityMicromapCacheItem();
     OpacityMicromapCacheItem(DxvkDevice& device, OpacityMicromapCacheState _cacheState, const uint32_t subdivisionLevel, const bool enableVertexAndTextureOperations,     
-                             uint32_t currentFrameIndex, std::list<XXH64_hash_t>::iterator _mostRecentlyUsedListIter, std::list<XXH64_hash_t>::iterator _cacheStateListIter,
-                             const OmmRequest& ommRequest);
+                             uint32_t currentFrameIndex, uint32_t requestIndex, const OmmRequest& ommRequest);
+    // Note: hooks are not copied, a copy is not linked into any of the lists
     OpacityMicromapCacheItem(const OpacityMicromapCacheItem& src) 
     : cacheState(src.cacheState)
     , blasOmmBuffers(src.blasOmmBuffers)
@@ -287,15 +302,22 @@ namespace dxvk {
     , useVertexAndTextureOperations(src.useVertexAndTextureOperations)
     , subdivisionLevel(src.subdivisionLevel)
     , ommFormat(src.ommFormat)
-    , leastRecentlyUsedListIter(src.leastRecentlyUsedListIter)
-    , cacheStateListIter(src.cacheStateListIter)
-    , isUnprocessedCacheStateListIterValid(src.isUnprocessedCacheStateListIterValid) { }
+    , ommSrcHash(src.ommSrcHash)
+    , isBillboard(src.isBillboard)
+    , numUsesInLastUseFrame(src.numUsesInLastUseFrame)
+    , requestIndex(src.requestIndex) { }
 
     VkDeviceSize getDeviceSize() const;
 
     bool isCompatibleWithOmmRequest(const OmmRequest& ommRequest);
   };
 
+  // Orders OMM work so that budgeted baking and building spend their budgets on the most visible items first
+  struct OpacityMicromapWorkPriority {
+    // Returns true if a has a lower priority than b
+    bool operator()(const OpacityMicromapCacheItem& a, const OpacityMicromapCacheItem& b) const;
+  };
+
   class OpacityMicromapMemoryManager : public CommonDeviceObject {
   public:
     explicit OpacityMicromapMemoryManager(DxvkDevice* device);
@@ -448,7 +470,7 @@ namespace dxvk {
     fast_unordered_cache<CachedSourceData>::iterator registerCachedSourceData(const OmmRequest& ommRequest);
     void deleteCachedSourceData(fast_unordered_cache<CachedSourceData>::iterator sourceDataIter, OpacityMicromapCacheState ommCacheState, bool destroyParentInstanceOmmRequestContainer);
     void deleteCachedSourceData(XXH64_hash_t ommSrcHash, OpacityMicromapCacheState ommCacheState, bool destroyParentInstanceOmmRequestContainer);
-    bool insertToUnprocessedList(const OmmRequest& ommRequest, std::list<XXH64_hash_t>::iterator& cacheStateListIter);
+    bool insertToUnprocessedQueue(const OmmRequest& ommRequest, OpacityMicromapCacheItem& ommCacheItem);
     void destroyOmmData(OpacityMicromapCache::iterator& ommCacheIterator, bool destroyParentInstanceOmmRequestContainer = true);
     void destroyOmmData(XXH64_hash_t ommSrcHash);
     static OpacityMicromapInstanceData& getOmmInstanceData(const RtInstance& instance);
@@ -499,6 +521,12 @@ namespace dxvk {
     OmmResult buildOpacityMicromap(Rc<DxvkContext> ctx, XXH64_hash_t ommSrcHash, OpacityMicromapCacheItem& ommCacheItem, VkMicromapUsageEXT& ommUsageGroup, VkMicromapBuildInfoEXT& ommBuildInfo, uint32_t& maxMicroTrianglesToBuild, bool forceBuild);
     void bakeOpacityMicromapArrays(Rc<DxvkContext> ctx, const std::vector<TextureRef>& textures, uint32_t& availableBakingBudget);
     void buildOpacityMicromapsInternal(Rc<DxvkContext> ctx, uint32_t& maxMicroTrianglesToBuild);
+
+    // Disk cache
+    XXH64_hash_t calculateDiskCacheKey(XXH64_hash_t ommSrcHash, const OpacityMicromapCacheItem& ommCacheItem, uint32_t numTriangles) const;
+    void readBackBakedArrayToDiskCache(Rc<DxvkContext> ctx, XXH64_hash_t diskCacheKey, const OpacityMicromapCacheItem& ommCacheItem, uint32_t numTriangles);
+    void updateDiskCache();
+
     // Bound built OMMs need to be synchronized once before being used. 
     // This tracks if any such OMMs have been bound
     bool m_boundOmmsRequireSynchronization = false;
@@ -511,12 +539,20 @@ namespace dxvk {
     fast_unordered_cache<CachedSourceData> m_cachedSourceData;
     std::vector<Rc<DxvkOpacityMicromap>> m_boundOMMs; // OMMs bound in a frame
 
-    // Ordered lists starting with oldest and/or smallest inserted items 
-    std::list<XXH64_hash_t> m_unprocessedList;   // Contains OMM data requests that are yet to be baked
-    std::list<XXH64_hash_t> m_bakedList;         // Contains OMM items with baked OMM arrays
-    std::list<XXH64_hash_t> m_builtList;         // Contains OMM items with built OMMs but require synchronization
+    typedef IntrusivePriorityQueue<OpacityMicromapCacheItem, &OpacityMicromapCacheItem::workQueueHook, OpacityMicromapWorkPriority> WorkQueue;
+    typedef IntrusiveList<OpacityMicromapCacheItem, &OpacityMicromapCacheItem::builtListHook> BuiltList;
+    typedef IntrusiveList<OpacityMicromapCacheItem, &OpacityMicromapCacheItem::leastRecentlyUsedHook> LeastRecentlyUsedList;
+
+    // Work queues ordered by OpacityMicromapWorkPriority
+    WorkQueue m_unprocessedQueue;   // Contains OMM data requests that are yet to be baked
+    WorkQueue m_bakedQueue;         // Contains OMM items with baked OMM arrays
+    BuiltList m_builtList;          // Contains OMM items with built OMMs but require synchronization
+
+    // Items popped off a work queue that are to be processed again in a later frame
+    std::vector<OpacityMicromapCacheItem*> m_deferredWorkItems;
+    uint32_t m_numRequestedOmmItems = 0;
 
-    std::unordered_set<XXH64_hash_t> m_blackListedList;// Contains OMM surface hashes that failed to get baked or built (in time)
+    fast_unordered_set m_blackListedList;        // Contains OMM surface hashes that failed to get baked or built (in time)
                                                  // and helps avoid wasting resources for such cases
     
     // Tracks statistics for OMM build requests to be able to filter less frequest requests out
@@ -530,7 +566,7 @@ namespace dxvk {
     uint32_t m_numMicroTrianglesBuilt = 0;    // Per frame
 
     // LRU management
-    std::list<XXH64_hash_t> m_leastRecentlyUsedList;  // Items stored in their usage order starting with least recently used item
+    LeastRecentlyUsedList m_leastRecentlyUsedList;  // Items stored in their usage order starting with least recently used item
 
     fast_unordered_cache<OMMBuildRequestStatistics> m_ommBuildRequestStatistics;
 
@@ -539,6 +575,20 @@ namespace dxvk {
     bool m_hasEnoughMemoryToPotentiallyGenerateAnOmm = true; // A quick check to avoid unnecessary computations when there's not enough free budget to handle more OMMs
     std::unique_ptr<RtxStagingDataAlloc> m_scratchAllocator;
 
+    // Baked arrays are read back and stored to the disk cache once their GPU copies complete
+    struct DiskCacheReadback {
+      XXH64_hash_t key;
+      Rc<DxvkBuffer> buffer;
+      uint32_t numTriangles;
+      uint32_t subdivisionLevel;
+      VkOpacityMicromapFormatEXT ommFormat;
+    };
+
+    std::unique_ptr<OpacityMicromapDiskCache> m_diskCache;
+    std::vector<DiskCacheReadback> m_pendingDiskCacheReadbacks;
+    // Bytes that may still be loaded from the disk cache this frame
+    uint64_t m_availableDiskCacheLoadBudget = 0;
+
     // Prev RtxOption states
     bool m_prevConservativeEstimationEnable = OpacityMicromapOptions::Building::ConservativeEstimation::enable();
     int m_prevConservativeEstimationMaxTexelTapsPerMicroTriangle = OpacityMicromapOptions::Building::ConservativeEstimation::maxTexelTapsPerMicroTriangle();
@@ -25,25 +25,50 @@ namespace dxvk {
   Config RtxOptionImpl::s_startupOptions;
   Config RtxOptionImpl::s_customOptions;
 
-  void fillHashTable(const std::vector<std::string>& rawInput, fast_unordered_set& hashTableOutput) {
-    for (auto&& hashStr : rawInput) {
-      const XXH64_hash_t h = std::stoull(hashStr, nullptr, 16);
-      hashTableOutput.insert(h);
-    }
+  // Hash lists are parsed straight from the config value, without splitting them into strings first.
+  // Returns false if any entry was not a valid hash.
+  bool fillHashTable(const std::string& rawInput, fast_unordered_set& hashTableOutput) {
+    // Lists can have tens of thousands of entries, so size the table once up front
+    hashTableOutput.reserve(hashTableOutput.size() + std::count(rawInput.begin(), rawInput.end(), ',') + 1);
+
+    bool valid = true;
+    Config::forEachListEntry(rawInput, [&](std::string_view hashStr) {
+      uint64_t h;
+      if (Config::parseHashListEntry(hashStr, h)) {
+        hashTableOutput.insert(h);
+      } else {
+        valid = false;
+      }
+    });
+    return valid;
   }
 
-  void fillHashVector(const std::vector<std::string>& rawInput, std::vector<XXH64_hash_t>& hashVectorOutput) {
-    for (auto&& hashStr : rawInput) {
-      const XXH64_hash_t h = std::stoull(hashStr, nullptr, 16);
-      hashVectorOutput.emplace_back(h);
-    }
+  bool fillHashVector(const std::string& rawInput, std::vector<XXH64_hash_t>& hashVectorOutput) {
+    hashVectorOutput.reserve(hashVectorOutput.size() + std::count(rawInput.begin(), rawInput.end(), ',') + 1);
+
+    bool valid = true;
+    Config::forEachListEntry(rawInput, [&](std::string_view hashStr) {
+      uint64_t h;
+      if (Config::parseHashListEntry(hashStr, h)) {
+        hashVectorOutput.emplace_back(h);
+      } else {
+        valid = false;
+      }
+    });
+    return valid;
   }
 
-  void fillIntVector(const std::vector<std::string>& rawInput, std::vector<int32_t>& intVectorOutput) {
-    for (auto&& intStr : rawInput) {
-      const int32_t i = std::stoi(intStr);
-      intVectorOutput.emplace_back(i);
-    }
+  bool fillIntVector(const std::string& rawInput, std::vector<int32_t>& intVectorOutput) {
+    bool valid = true;
+    Config::forEachListEntry(rawInput, [&](std::string_view intStr) {
+      int32_t i;
+      if (Config::parseIntListEntry(intStr, i)) {
+        intVectorOutput.emplace_back(i);
+      } else {
+        valid = false;
+      }
+    });
+    return valid;
   }
 
   std::string hashTableToString(const fast_unordered_set& hashTable) {
@@ -143,6 +168,7 @@ namespace dxvk {
     std::string fullName = getFullName();
     const char* env = environment == nullptr || strlen(environment) == 0 ? nullptr : environment;
     auto& value = valueList[(int) valueType];
+    const std::string* rawValue = options.findOptionValue(fullName.c_str());
 
     switch (type) {
     case OptionType::Bool:
@@ -155,13 +181,16 @@ namespace dxvk {
       value.f = options.getOption<float>(fullName.c_str(), value.f, env);
       break;
     case OptionType::HashSet:
-      fillHashTable(options.getOption<std::vector<std::string>>(fullName.c_str()), *value.hashSet);
+      if (rawValue && !fillHashTable(*rawValue, *value.hashSet))
+        Logger::warn(str::format("Skipped invalid hashes in ", fullName));
       break;
     case OptionType::HashVector:
-      fillHashVector(options.getOption<std::vector<std::string>>(fullName.c_str()), *value.hashVector);
+      if (rawValue && !fillHashVector(*rawValue, *value.hashVector))
+        Logger::warn(str::format("Skipped invalid hashes in ", fullName));
       break;
     case OptionType::IntVector:
-      fillIntVector(options.getOption<std::vector<std::string>>(fullName.c_str()), *value.intVector);
+      if (rawValue && !fillIntVector(*rawValue, *value.intVector))
+        Logger::warn(str::format("Skipped invalid integers in ", fullName));
       break;
     case OptionType::Vector2:
       *value.v2 = options.getOption<Vector2>(fullName.c_str(), *value.v2, env);
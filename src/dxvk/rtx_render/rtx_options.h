@@ -419,6 +419,9 @@ namespace dxvk {
     RTX_OPTION("rtx", uint32_t, numFramesToKeepLights, 100, ""); // NOTE: This was the default we've had for a while, can probably be reduced...
     RTX_OPTION("rtx", uint32_t, numFramesToKeepGeometryData, 5, "");
     RTX_OPTION("rtx", uint32_t, numFramesToKeepMaterialTextures, 5, "");
+    RTX_OPTION("rtx", bool, enableParallelSceneBuild, true,
+               "Runs the CPU only stages of the scene build, such as packing the material data for the GPU, on worker threads\n"
+               "overlapping with the stages recording GPU work. Per stage timings are reported through the scene_build metrics.");
     RTX_OPTION("rtx", bool, enablePreviousTLAS, true, "");
     RTX_OPTION("rtx", float, sceneScale, 1, "Defines the ratio of rendering unit (1cm) to game unit, i.e. sceneScale = 1cm / GameUnit.");
 
@@ -1266,15 +1269,15 @@ namespace dxvk {
     bool isLiveShaderEditModeEnabled() const { return useLiveShaderEditMode(); }
     bool isZUp() const { return zUp(); }
     bool isLeftHandedCoordinateSystem() const { return leftHandedCoordinateSystem(); }
-    float getUniqueObjectDistanceSqr() const { return uniqueObjectDistance() * uniqueObjectDistance(); }
+    static float getUniqueObjectDistanceSqr() { return uniqueObjectDistance() * uniqueObjectDistance(); }
     float getResolutionScale() const { return resolutionScale(); }
     DLSSProfile getDLSSQuality() const { return qualityDLSS(); }
-    uint32_t getNumFramesToKeepInstances() const { return numFramesToKeepInstances(); }
-    uint32_t getNumFramesToKeepBLAS() const { return numFramesToKeepBLAS(); }
-    uint32_t getNumFramesToKeepLights() const { return numFramesToKeepLights(); }
-    uint32_t getNumFramesToPutLightsToSleep() const { return numFramesToKeepLights() /2; }
-    float getMeterToWorldUnitScale() const { return 100.f * getSceneScale(); } // RTX Remix world unit is in 1cm 
-    float getSceneScale() const { return sceneScale(); }
+    static uint32_t getNumFramesToKeepInstances() { return numFramesToKeepInstances(); }
+    static uint32_t getNumFramesToKeepBLAS() { return numFramesToKeepBLAS(); }
+    static uint32_t getNumFramesToKeepLights() { return numFramesToKeepLights(); }
+    static uint32_t getNumFramesToPutLightsToSleep() { return numFramesToKeepLights() /2; }
+    static float getMeterToWorldUnitScale() { return 100.f * getSceneScale(); } // RTX Remix world unit is in 1cm 
+    static float getSceneScale() { return sceneScale(); }
 
     // Render Pass Modes
     //RenderPassVolumeIntegrateRaytraceMode getRenderPassVolumeIntegrateRaytraceMode() const { return renderPassVolumeIntegrateRaytraceMode; }
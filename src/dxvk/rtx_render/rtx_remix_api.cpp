@@ -29,6 +29,7 @@
 #include "rtx_option.h"
 #include "rtx_globals.h"
 #include "rtx_options.h"
+#include "rtx_remix_mesh_heap.h"
 
 #include "../dxvk_device.h"
 #include "rtx_texture_manager.h"
@@ -38,14 +39,18 @@
 
 #include "../dxvk_image.h"
 
+#include "../../util/util_env.h"
+#include "../../util/util_fastops.h"
 #include "../../util/util_math.h"
 #include "../../util/util_vector.h"
 #include "../../util/util_string.h"
+#include "../../util/sync/sync_spinlock.h"
 
 #include "../../d3d9/d3d9_swapchain.h"
 
 #include <windows.h>
 
+#include <deque>
 #include <optional>
 
 namespace dxvk {
@@ -682,9 +687,14 @@ namespace {
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 
+  // Batched instances are only committed at Present, see remixapi_DrawInstances
+  void flushSubmissionBuffers(dxvk::D3D9DeviceEx* remixDevice);
+
   remixapi_ErrorCode REMIXAPI_CALL remixapi_DestroyMaterial(
     remixapi_MaterialHandle handle) {
     if (auto remixDevice = tryAsDxvk()) {
+      // Instances recorded before the destroy must be committed while the material still exists
+      flushSubmissionBuffers(remixDevice);
       std::lock_guard lock { s_mutex };
       remixDevice->EmitCs([cHandle = handle](dxvk::DxvkContext* ctx) {
         auto& assets = ctx->getCommonObjects()->getSceneManager().getAssetReplacer();
@@ -695,57 +705,37 @@ namespace {
     return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
   }
 
-  remixapi_ErrorCode REMIXAPI_CALL remixapi_CreateMesh(
-    const remixapi_MeshInfo* info,
-    remixapi_MeshHandle* out_handle) {
-    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
-    if (!remixDevice) {
-      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
-    }
-    if (!out_handle || !info || info->sType != REMIXAPI_STRUCT_TYPE_MESH_INFO) {
-      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
-    }
-    static_assert(sizeof(remixapi_MeshHandle) == sizeof(info->hash));
-    auto handle = reinterpret_cast<remixapi_MeshHandle>(info->hash);
-    if (!handle) {
-      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+  std::shared_ptr<dxvk::RemixMeshHeap> s_meshHeap {};
+
+  std::shared_ptr<dxvk::RemixMeshHeap> getMeshHeap(dxvk::D3D9DeviceEx* remixDevice) {
+    std::lock_guard lock { s_mutex };
+    if (!s_meshHeap) {
+      s_meshHeap = std::make_shared<dxvk::RemixMeshHeap>(remixDevice->GetDXVKDevice());
     }
+    return s_meshHeap;
+  }
 
+  std::vector<dxvk::RasterGeometry> createMeshSurfaces(
+    dxvk::RemixMeshHeap& heap,
+    uint64_t meshHash,
+    const remixapi_MeshInfoSurfaceTriangles* surfaces_values,
+    size_t surfaces_count) {
     auto allocatedSurfaces = std::vector<dxvk::RasterGeometry> {};
+    allocatedSurfaces.reserve(surfaces_count);
 
-    for (size_t i = 0; i < info->surfaces_count; i++) {
-      const remixapi_MeshInfoSurfaceTriangles& src = info->surfaces_values[i];
+    for (size_t i = 0; i < surfaces_count; i++) {
+      const remixapi_MeshInfoSurfaceTriangles& src = surfaces_values[i];
 
       const size_t vertexDataSize = sizeInBytes(src.vertices_values, src.vertices_count);
       const size_t indexDataSize = sizeInBytes(src.indices_values, src.indices_count);
 
-      auto allocBuffer = [](dxvk::D3D9DeviceEx* device, size_t sizeInBytes) -> dxvk::Rc<dxvk::DxvkBuffer> {
-        if (sizeInBytes == 0) {
-          return {};
-        }
-        auto bufferInfo = dxvk::DxvkBufferCreateInfo {};
-        {
-          bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
-          bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
-          bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT;
-          bufferInfo.size = dxvk::align(sizeInBytes, dxvk::CACHE_LINE_SIZE);
-        }
-        return device->GetDXVKDevice()->createBuffer(
-            bufferInfo,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
-            dxvk::DxvkMemoryStats::Category::RTXBuffer);
-      };
-
-      dxvk::Rc<dxvk::DxvkBuffer> vertexBuffer = allocBuffer(remixDevice, vertexDataSize);
-      dxvk::Rc<dxvk::DxvkBuffer> indexBuffer = allocBuffer(remixDevice, indexDataSize);
-      dxvk::Rc<dxvk::DxvkBuffer> skinningBuffer = nullptr;
-
-      auto vertexSlice = dxvk::DxvkBufferSlice { vertexBuffer };
-      memcpy(vertexSlice.mapPtr(0), src.vertices_values, vertexDataSize);
+      auto vertexSlice = heap.allocate(meshHash, vertexDataSize);
+      if (vertexDataSize > 0) {
+        memcpy(vertexSlice.mapPtr(0), src.vertices_values, vertexDataSize);
+      }
 
-      auto indexSlice = dxvk::DxvkBufferSlice {};
+      auto indexSlice = heap.allocate(meshHash, indexDataSize);
       if (indexDataSize > 0) {
-        indexSlice = dxvk::DxvkBufferSlice { indexBuffer };
         memcpy(indexSlice.mapPtr(0), src.indices_values, indexDataSize);
       }
 
@@ -756,31 +746,19 @@ namespace {
         size_t sizeInBytes_weights = sizeInBytes(src.skinning_value.blendWeights_values, src.skinning_value.blendWeights_count);
         size_t sizeInBytes_indices = src.vertices_count * wordsPerCompressedTuple * sizeof(uint32_t);
 
-        skinningBuffer = allocBuffer(remixDevice, sizeInBytes_weights + sizeInBytes_indices);
-
-        // Encode bone indices into compressed byte form
-        auto compressedBlendIndices = std::vector<uint32_t> {};
-        compressedBlendIndices.resize(src.vertices_count * wordsPerCompressedTuple);
-        for (size_t vert = 0; vert < src.vertices_count; vert++) {
-          const uint32_t* dstCompressed = &compressedBlendIndices[vert * wordsPerCompressedTuple];
-          const uint32_t* blendIndicesStorage = &src.skinning_value.blendIndices_values[vert * src.skinning_value.bonesPerVertex];
-
-          for (int j = 0; j < src.skinning_value.bonesPerVertex; j += 4) {
-            uint32_t vertIndices = 0;
-            for (int k = 0; k < 4 && j + k < src.skinning_value.bonesPerVertex; ++k) {
-              vertIndices |= blendIndicesStorage[j + k] << 8 * k;
-            }
-            *(uint32_t*) &dstCompressed[j / 4] = vertIndices;
-          }
-        }
-
-        assert(sizeInBytes_indices == compressedBlendIndices.size() * sizeof(compressedBlendIndices[0]));
+        blendWeightsSlice = heap.allocate(meshHash, sizeInBytes_weights);
+        blendIndicesSlice = heap.allocate(meshHash, sizeInBytes_indices);
 
-        blendWeightsSlice = dxvk::DxvkBufferSlice { skinningBuffer, 0, sizeInBytes_weights };
-        blendIndicesSlice = dxvk::DxvkBufferSlice { skinningBuffer, sizeInBytes_weights, sizeInBytes_indices };
-
-        memcpy(blendWeightsSlice.mapPtr(0), src.skinning_value.blendWeights_values, sizeInBytes_weights);
-        memcpy(blendIndicesSlice.mapPtr(0), compressedBlendIndices.data(), sizeInBytes_indices);
+        if (sizeInBytes_weights > 0) {
+          memcpy(blendWeightsSlice.mapPtr(0), src.skinning_value.blendWeights_values, sizeInBytes_weights);
+        }
+        // Encode bone indices into compressed byte form, directly into the mapped buffer
+        if (sizeInBytes_indices > 0) {
+          fast::packBlendIndices(static_cast<uint32_t*>(blendIndicesSlice.mapPtr(0)),
+                                 src.skinning_value.blendIndices_values,
+                                 static_cast<uint32_t>(src.vertices_count),
+                                 src.skinning_value.bonesPerVertex);
+        }
       }
 
       auto dst = dxvk::RasterGeometry {};
@@ -812,12 +790,164 @@ namespace {
       }
       allocatedSurfaces.push_back(std::move(dst));
     }
-    std::lock_guard lock { s_mutex };
+    return allocatedSurfaces;
+  }
 
-    remixDevice->EmitCs([cHandle = handle, cSurfaces = std::move(allocatedSurfaces)](dxvk::DxvkContext* ctx) mutable {
+  void registerMesh(dxvk::D3D9DeviceEx* remixDevice, remixapi_MeshHandle handle, std::vector<dxvk::RasterGeometry>&& surfaces) {
+    std::lock_guard lock { s_mutex };
+    remixDevice->EmitCs([cHandle = handle, cSurfaces = std::move(surfaces)](dxvk::DxvkContext* ctx) mutable {
       auto& assets = ctx->getCommonObjects()->getSceneManager().getAssetReplacer();
       assets->registerExternalMesh(cHandle, std::move(cSurfaces));
     });
+  }
+
+  // Asynchronous mesh creation: the mesh description is copied, and packing it into the mesh
+  // heap happens on a background thread, which registers the mesh once it's done.
+  struct MeshSurfaceCopy {
+    remixapi_MeshInfoSurfaceTriangles surface;
+    std::vector<remixapi_HardcodedVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<float> blendWeights;
+    std::vector<uint32_t> blendIndices;
+
+    explicit MeshSurfaceCopy(const remixapi_MeshInfoSurfaceTriangles& src)
+      : surface { src }
+      , vertices(src.vertices_values, src.vertices_values + src.vertices_count)
+      , indices(src.indices_values, src.indices_values + src.indices_count) {
+      surface.vertices_values = vertices.data();
+      surface.indices_values = indices.data();
+      if (src.skinning_hasvalue) {
+        const remixapi_MeshInfoSkinning& skinning = src.skinning_value;
+        blendWeights.assign(skinning.blendWeights_values, skinning.blendWeights_values + skinning.blendWeights_count);
+        blendIndices.assign(skinning.blendIndices_values, skinning.blendIndices_values + skinning.blendIndices_count);
+        surface.skinning_value.blendWeights_values = blendWeights.data();
+        surface.skinning_value.blendIndices_values = blendIndices.data();
+      }
+    }
+  };
+
+  struct MeshCreateJob {
+    remixapi_MeshHandle handle;
+    std::vector<MeshSurfaceCopy> surfaces;
+  };
+
+  class AsyncMeshCreator {
+  public:
+    explicit AsyncMeshCreator(dxvk::D3D9DeviceEx* remixDevice)
+      : m_device { remixDevice }
+      , m_thread { [this]() { run(); } } {
+    }
+
+    ~AsyncMeshCreator() {
+      {
+        std::lock_guard lock { m_mutex };
+        m_stopped = true;
+      }
+      m_cond.notify_all();
+      m_thread.join();
+    }
+
+    void push(MeshCreateJob&& job) {
+      {
+        std::lock_guard lock { m_mutex };
+        m_jobs.push_back(std::move(job));
+      }
+      m_cond.notify_all();
+    }
+
+    // Waits until all queued meshes have been registered
+    void flush() {
+      std::unique_lock lock { m_mutex };
+      m_idleCond.wait(lock, [this]() { return m_jobs.empty() && !m_busy; });
+    }
+
+  private:
+    void run() {
+      dxvk::env::setThreadName("rtx-remixapi-mesh");
+
+      while (true) {
+        MeshCreateJob job;
+        {
+          std::unique_lock lock { m_mutex };
+          m_cond.wait(lock, [this]() { return m_stopped || !m_jobs.empty(); });
+          if (m_jobs.empty()) {
+            break;
+          }
+          job = std::move(m_jobs.front());
+          m_jobs.pop_front();
+          m_busy = true;
+        }
+
+        auto surfaces = std::vector<remixapi_MeshInfoSurfaceTriangles> {};
+        surfaces.reserve(job.surfaces.size());
+        for (const MeshSurfaceCopy& copy : job.surfaces) {
+          surfaces.push_back(copy.surface);
+        }
+
+        auto heap = getMeshHeap(m_device);
+        registerMesh(m_device, job.handle,
+                     createMeshSurfaces(*heap, reinterpret_cast<uint64_t>(job.handle), surfaces.data(), surfaces.size()));
+
+        {
+          std::lock_guard lock { m_mutex };
+          m_busy = false;
+        }
+        m_idleCond.notify_all();
+      }
+    }
+
+    dxvk::D3D9DeviceEx* m_device;
+    dxvk::mutex m_mutex;
+    dxvk::condition_variable m_cond;
+    dxvk::condition_variable m_idleCond;
+    std::deque<MeshCreateJob> m_jobs;
+    bool m_busy = false;
+    bool m_stopped = false;
+    dxvk::thread m_thread;
+  };
+
+  std::unique_ptr<AsyncMeshCreator> s_asyncMeshCreator {};
+  dxvk::mutex s_asyncMeshCreatorMutex {};
+
+  void flushAsyncMeshCreation() {
+    std::lock_guard lock { s_asyncMeshCreatorMutex };
+    if (s_asyncMeshCreator) {
+      s_asyncMeshCreator->flush();
+    }
+  }
+
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_CreateMesh(
+    const remixapi_MeshInfo* info,
+    remixapi_MeshHandle* out_handle) {
+    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
+    if (!remixDevice) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (!out_handle || !info || info->sType != REMIXAPI_STRUCT_TYPE_MESH_INFO) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    static_assert(sizeof(remixapi_MeshHandle) == sizeof(info->hash));
+    auto handle = reinterpret_cast<remixapi_MeshHandle>(info->hash);
+    if (!handle) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+
+    if (dxvk::RemixMeshHeap::asyncMeshCreation()) {
+      auto job = MeshCreateJob { handle, {} };
+      job.surfaces.reserve(info->surfaces_count);
+      for (size_t i = 0; i < info->surfaces_count; i++) {
+        job.surfaces.emplace_back(info->surfaces_values[i]);
+      }
+
+      std::lock_guard lock { s_asyncMeshCreatorMutex };
+      if (!s_asyncMeshCreator) {
+        s_asyncMeshCreator = std::make_unique<AsyncMeshCreator>(remixDevice);
+      }
+      s_asyncMeshCreator->push(std::move(job));
+    } else {
+      auto heap = getMeshHeap(remixDevice);
+      registerMesh(remixDevice, handle, createMeshSurfaces(*heap, info->hash, info->surfaces_values, info->surfaces_count));
+    }
 
     *out_handle = handle;
     return REMIXAPI_ERROR_CODE_SUCCESS;
@@ -829,10 +959,20 @@ namespace {
     if (!remixDevice) {
       return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
     }
+    // The mesh might still be queued for creation
+    flushAsyncMeshCreation();
+    // Instances recorded before the destroy must be committed while the mesh still exists
+    flushSubmissionBuffers(remixDevice);
+
     std::lock_guard lock { s_mutex };
-    remixDevice->EmitCs([cHandle = handle](dxvk::DxvkContext* ctx) {
+    // Detach the geometry right away, CreateMesh may reuse the hash before the CS thread gets to the release
+    const uint64_t detachedId = s_meshHeap ? s_meshHeap->detach(reinterpret_cast<uint64_t>(handle)) : 0;
+    remixDevice->EmitCs([cHandle = handle, cHeap = s_meshHeap, detachedId](dxvk::DxvkContext* ctx) {
       auto& assets = ctx->getCommonObjects()->getSceneManager().getAssetReplacer();
       assets->destroyExternalMesh(cHandle);
+      if (cHeap && detachedId != 0) {
+        cHeap->release(detachedId, ctx->getDevice()->getCurrentFrameId());
+      }
     });
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
@@ -951,6 +1091,8 @@ namespace {
     if (!remixDevice) {
       return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
     }
+    // Light instances recorded before the destroy must be committed while the light still exists
+    flushSubmissionBuffers(remixDevice);
     std::lock_guard lock { s_mutex };
     remixDevice->EmitCs([cHandle = handle](dxvk::DxvkContext* ctx) {
       auto& lightMgr = ctx->getCommonObjects()->getSceneManager().getLightManager();
@@ -980,6 +1122,130 @@ namespace {
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 
+  // Batched submission: each submitting thread records into its own buffer, so the only
+  // lock taken per batch is the buffer's own one, which is contended only by Present. All
+  // buffers are merged into a single CS command at Present, or earlier when a mesh, material
+  // or light is destroyed, so recorded instances never outlive what they reference.
+  struct SubmissionBuffer {
+    dxvk::sync::Spinlock lock;
+    std::vector<dxvk::ExternalDrawState> drawStates;
+    std::vector<remixapi_LightHandle> lightInstances;
+  };
+
+  dxvk::mutex s_submissionBuffersMutex {};
+  std::vector<std::shared_ptr<SubmissionBuffer>> s_submissionBuffers {};
+
+  SubmissionBuffer& getThreadSubmissionBuffer() {
+    thread_local std::shared_ptr<SubmissionBuffer> t_buffer;
+    if (!t_buffer) {
+      t_buffer = std::make_shared<SubmissionBuffer>();
+      std::lock_guard lock { s_submissionBuffersMutex };
+      s_submissionBuffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+  }
+
+  void flushSubmissionBuffers(dxvk::D3D9DeviceEx* remixDevice) {
+    std::vector<dxvk::ExternalDrawState> drawStates;
+    std::vector<remixapi_LightHandle> lightInstances;
+    {
+      std::lock_guard lock { s_submissionBuffersMutex };
+      size_t numDrawStates = 0;
+      size_t numLightInstances = 0;
+      for (const auto& buffer : s_submissionBuffers) {
+        std::lock_guard bufferLock { buffer->lock };
+        numDrawStates += buffer->drawStates.size();
+        numLightInstances += buffer->lightInstances.size();
+      }
+      drawStates.reserve(numDrawStates);
+      lightInstances.reserve(numLightInstances);
+
+      for (auto iter = s_submissionBuffers.begin(); iter != s_submissionBuffers.end(); ) {
+        SubmissionBuffer& buffer = **iter;
+        {
+          std::lock_guard bufferLock { buffer.lock };
+          drawStates.insert(drawStates.end(),
+                            std::make_move_iterator(buffer.drawStates.begin()),
+                            std::make_move_iterator(buffer.drawStates.end()));
+          lightInstances.insert(lightInstances.end(), buffer.lightInstances.begin(), buffer.lightInstances.end());
+          // Note: clear() keeps the capacity, so steady state submission doesn't allocate
+          buffer.drawStates.clear();
+          buffer.lightInstances.clear();
+        }
+        // Drop the buffers of threads that have exited
+        if (iter->use_count() == 1) {
+          iter = s_submissionBuffers.erase(iter);
+        } else {
+          ++iter;
+        }
+      }
+    }
+
+    if (drawStates.empty() && lightInstances.empty()) {
+      return;
+    }
+
+    std::lock_guard lock { s_mutex };
+    remixDevice->EmitCs([cDrawStates = std::move(drawStates),
+                         cLightInstances = std::move(lightInstances)](dxvk::DxvkContext* dxvkCtx) mutable {
+      auto* ctx = static_cast<dxvk::RtxContext*>(dxvkCtx);
+      for (dxvk::ExternalDrawState& drawState : cDrawStates) {
+        ctx->commitExternalGeometryToRT(std::move(drawState));
+      }
+      auto& lightMgr = ctx->getCommonObjects()->getSceneManager().getLightManager();
+      for (remixapi_LightHandle lightHandle : cLightInstances) {
+        lightMgr.addExternalLightInstance(lightHandle);
+      }
+    });
+  }
+
+  void discardSubmissionBuffers() {
+    std::lock_guard lock { s_submissionBuffersMutex };
+    for (const auto& buffer : s_submissionBuffers) {
+      std::lock_guard bufferLock { buffer->lock };
+      buffer->drawStates.clear();
+      buffer->lightInstances.clear();
+    }
+  }
+
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_DrawInstances(
+    const remixapi_InstanceInfo* infos_values,
+    uint32_t infos_count) {
+    if (!tryAsDxvk()) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (!infos_values && infos_count > 0) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    SubmissionBuffer& buffer = getThreadSubmissionBuffer();
+    std::lock_guard lock { buffer.lock };
+    buffer.drawStates.reserve(buffer.drawStates.size() + infos_count);
+    for (uint32_t i = 0; i < infos_count; i++) {
+      buffer.drawStates.push_back(convert::toRtDrawState(infos_values[i]));
+    }
+    return REMIXAPI_ERROR_CODE_SUCCESS;
+  }
+
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_DrawLightInstances(
+    const remixapi_LightHandle* lightHandles_values,
+    uint32_t lightHandles_count) {
+    if (!tryAsDxvk()) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (!lightHandles_values && lightHandles_count > 0) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    for (uint32_t i = 0; i < lightHandles_count; i++) {
+      if (!lightHandles_values[i]) {
+        return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+      }
+    }
+    SubmissionBuffer& buffer = getThreadSubmissionBuffer();
+    std::lock_guard lock { buffer.lock };
+    buffer.lightInstances.insert(buffer.lightInstances.end(), lightHandles_values, lightHandles_values + lightHandles_count);
+    return REMIXAPI_ERROR_CODE_SUCCESS;
+  }
+
   remixapi_ErrorCode REMIXAPI_CALL remixapi_SetConfigVariable(
     const char* key,
     const char* value) {
@@ -1351,6 +1617,13 @@ namespace {
   }
 
   remixapi_ErrorCode REMIXAPI_CALL remixapi_Shutdown(void) {
+    discardSubmissionBuffers();
+    {
+      // Finishes the queued meshes before the device goes away
+      std::lock_guard lock { s_asyncMeshCreatorMutex };
+      s_asyncMeshCreator.reset();
+    }
+    s_meshHeap.reset();
     if (s_dxvkDevice) {
       while (true) {
         ULONG left = s_dxvkDevice->Release();
@@ -1377,6 +1650,8 @@ namespace {
     if (!remixDevice) {
       return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
     }
+    flushSubmissionBuffers(remixDevice);
+
     HRESULT hr = remixDevice->Present(NULL, NULL, info ? info->hwndOverride : NULL, NULL);
     if (FAILED(hr)) {
       return REMIXAPI_ERROR_CODE_GENERAL_FAILURE;
@@ -1478,10 +1753,18 @@ extern "C"
       interf.dxvk_SetDefaultOutput = remixapi_dxvk_SetDefaultOutput;
       interf.pick_RequestObjectPicking = remixapi_pick_RequestObjectPicking;
       interf.pick_HighlightObjects = remixapi_pick_HighlightObjects;
-    }
-    static_assert(sizeof(interf) == 168, "Add/remove function registration");
-
-    *out_result = interf;
+      interf.DrawInstances = remixapi_DrawInstances;
+      interf.DrawLightInstances = remixapi_DrawLightInstances;
+    }
+    static_assert(sizeof(interf) == 184, "Add/remove function registration");
+
+    // Batched submission was added in 0.4.2 without breaking 0.4 clients: their
+    // interface struct ends right before it, so only that part is written out
+    constexpr uint64_t kBatchedSubmissionVersion = REMIXAPI_VERSION_MAKE(0, 4, 2);
+    const size_t interfaceSize = info->version >= kBatchedSubmissionVersion
+      ? sizeof(interf)
+      : offsetof(remixapi_Interface, DrawInstances);
+    memcpy(out_result, &interf, interfaceSize);
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 }
@@ -0,0 +1,220 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "rtx_remix_mesh_heap.h"
+
+#include "rtx_options.h"
+#include "rtx_utils.h"
+
+#include "../dxvk_device.h"
+
+namespace dxvk {
+
+  RemixMeshHeap::RemixMeshHeap(const Rc<DxvkDevice>& device)
+    : m_device(device) {
+    const auto& limits = m_device->properties().core.properties.limits;
+    m_alignment = std::max<VkDeviceSize>(CACHE_LINE_SIZE, limits.minStorageBufferOffsetAlignment);
+  }
+
+  RemixMeshHeap::~RemixMeshHeap() {
+    // Buffers are reference counted, anything still in flight keeps its page alive
+    m_pendingReleases.clear();
+    m_detached.clear();
+    m_allocations.clear();
+    m_pages.clear();
+  }
+
+  DxvkBufferSlice RemixMeshHeap::allocate(uint64_t meshHash, VkDeviceSize size) {
+    if (size == 0) {
+      return DxvkBufferSlice();
+    }
+    size = align(size, m_alignment);
+
+    std::lock_guard lock { m_mutex };
+
+    collectGarbage(m_device->getCurrentFrameId());
+
+    const VkDeviceSize pageSize = VkDeviceSize(std::max(meshHeapPageSizeMB(), 1u)) << 20;
+
+    Page* page = nullptr;
+    VkDeviceSize offset = 0;
+
+    if (size > pageSize) {
+      page = createPage(size, true);
+      allocFromPage(*page, size, offset);
+    } else {
+      // Most recently created pages are the most likely to have room left
+      for (auto it = m_pages.rbegin(); it != m_pages.rend(); ++it) {
+        if (!(*it)->dedicated && allocFromPage(**it, size, offset)) {
+          page = it->get();
+          break;
+        }
+      }
+
+      if (!page) {
+        page = createPage(pageSize, false);
+        allocFromPage(*page, size, offset);
+      }
+    }
+
+    m_allocations[meshHash].push_back({ page, offset, size });
+    return DxvkBufferSlice(page->buffer, offset, size);
+  }
+
+  uint64_t RemixMeshHeap::detach(uint64_t meshHash) {
+    std::lock_guard lock { m_mutex };
+
+    auto found = m_allocations.find(meshHash);
+    if (found == m_allocations.end()) {
+      return 0;
+    }
+
+    const uint64_t detachedId = m_nextDetachedId++;
+    m_detached.emplace(detachedId, std::move(found->second));
+    m_allocations.erase(found);
+    return detachedId;
+  }
+
+  void RemixMeshHeap::release(uint64_t detachedId, uint32_t frameId) {
+    std::lock_guard lock { m_mutex };
+
+    auto found = m_detached.find(detachedId);
+    if (found == m_detached.end()) {
+      return;
+    }
+
+    m_pendingReleases.push_back({ frameId, std::move(found->second) });
+    m_detached.erase(found);
+  }
+
+  RemixMeshHeap::Page* RemixMeshHeap::createPage(VkDeviceSize size, bool dedicated) {
+    DxvkBufferCreateInfo bufferInfo {};
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+    bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+    bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferInfo.size = size;
+
+    auto page = std::make_unique<Page>();
+    page->buffer = m_device->createBuffer(bufferInfo,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                          DxvkMemoryStats::Category::RTXBuffer);
+    page->freeList.push_back({ 0, size });
+    page->size = size;
+    page->dedicated = dedicated;
+
+    m_pages.push_back(std::move(page));
+    return m_pages.back().get();
+  }
+
+  bool RemixMeshHeap::allocFromPage(Page& page, VkDeviceSize size, VkDeviceSize& offset) const {
+    if (page.freeList.empty()) {
+      return false;
+    }
+
+    // Worst-fit unless there is an exact match, see DxvkMemoryChunk::alloc. Sizes and
+    // offsets are always multiples of the alignment, so no padding is needed here.
+    auto bestSlice = page.freeList.begin();
+
+    for (auto slice = page.freeList.begin(); slice != page.freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    if (bestSlice->length < size) {
+      return false;
+    }
+
+    offset = bestSlice->offset;
+
+    if (bestSlice->length == size) {
+      page.freeList.erase(bestSlice);
+    } else {
+      bestSlice->offset += size;
+      bestSlice->length -= size;
+    }
+    return true;
+  }
+
+  void RemixMeshHeap::freeToPage(Page& page, VkDeviceSize offset, VkDeviceSize length) {
+    // Merge with adjacent free slices so the range can be reused for larger allocations
+    auto curr = page.freeList.begin();
+
+    while (curr != page.freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = page.freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = page.freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    page.freeList.push_back({ offset, length });
+  }
+
+  void RemixMeshHeap::collectGarbage(uint32_t currentFrameId) {
+    if (m_pendingReleases.empty()) {
+      return;
+    }
+
+    // BLAS inputs of a destroyed mesh are kept around for numFramesToKeepGeometryData frames
+    // after their last use, on top of the frames that may still be in flight on the GPU.
+    const uint32_t latency = kMaxFramesInFlight + RtxOptions::Get()->numFramesToKeepGeometryData() + 1;
+
+    bool freedAny = false;
+    for (auto it = m_pendingReleases.begin(); it != m_pendingReleases.end(); ) {
+      if (currentFrameId < it->frameId + latency) {
+        ++it;
+        continue;
+      }
+
+      for (const Allocation& allocation : it->allocations) {
+        freeToPage(*allocation.page, allocation.offset, allocation.length);
+      }
+      it = m_pendingReleases.erase(it);
+      freedAny = true;
+    }
+
+    if (!freedAny) {
+      return;
+    }
+
+    // Drop empty pages, but keep one shared page around to avoid churn
+    bool keptSharedPage = false;
+    for (auto it = m_pages.begin(); it != m_pages.end(); ) {
+      Page& page = **it;
+      if (page.isEmpty() && (page.dedicated || keptSharedPage)) {
+        it = m_pages.erase(it);
+        continue;
+      }
+      keptSharedPage |= !page.dedicated;
+      ++it;
+    }
+  }
+
+}
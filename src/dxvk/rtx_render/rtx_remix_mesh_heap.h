@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../dxvk_buffer.h"
+#include "../../util/thread.h"
+#include "rtx_option.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  // Host visible storage for the geometry of meshes created through the Remix API.
+  // Surfaces are sub-allocated from large pages instead of getting a buffer each, so
+  // creating many small meshes neither fragments device memory nor hits createBuffer
+  // on every call. Free ranges are tracked per page the same way DxvkMemoryChunk does.
+  class RemixMeshHeap {
+  public:
+    explicit RemixMeshHeap(const Rc<DxvkDevice>& device);
+    ~RemixMeshHeap();
+
+    // Sub-allocates a range of at least size bytes and attributes it to the given mesh.
+    // Returns an empty slice when size is 0. Thread safe.
+    DxvkBufferSlice allocate(uint64_t meshHash, VkDeviceSize size);
+
+    // Detaches all ranges of a mesh from its hash, so a mesh created under the same hash
+    // right after gets ranges of its own. Returns an id for release, or 0 if the mesh has
+    // no ranges. Thread safe.
+    uint64_t detach(uint64_t meshHash);
+
+    // Returns the ranges of a detached mesh to the heap. Geometry may still be referenced by
+    // frames in flight and by cached BLAS inputs, so ranges only become available for new
+    // allocations after a few frames. Thread safe.
+    void release(uint64_t detachedId, uint32_t frameId);
+
+    RTX_OPTION("rtx.remixApi", uint32_t, meshHeapPageSizeMB, 16,
+               "Size of the buffers that geometry of meshes created through the Remix API is sub-allocated from, in megabytes.\n"
+               "Surfaces larger than a page get a dedicated buffer.");
+    RTX_OPTION("rtx.remixApi", bool, asyncMeshCreation, false,
+               "Uploads meshes created through the Remix API on a background thread, remixapi_CreateMesh returns the handle immediately.\n"
+               "Instances of a mesh drawn before its upload is finished are skipped for that frame.");
+
+  private:
+    struct FreeSlice {
+      VkDeviceSize offset;
+      VkDeviceSize length;
+    };
+
+    struct Page {
+      Rc<DxvkBuffer> buffer;
+      std::vector<FreeSlice> freeList;
+      VkDeviceSize size;
+      bool dedicated;
+
+      bool isEmpty() const {
+        return freeList.size() == 1 && freeList[0].length == size;
+      }
+    };
+
+    struct Allocation {
+      Page* page;
+      VkDeviceSize offset;
+      VkDeviceSize length;
+    };
+
+    struct PendingRelease {
+      uint32_t frameId;
+      std::vector<Allocation> allocations;
+    };
+
+    Page* createPage(VkDeviceSize size, bool dedicated);
+    bool allocFromPage(Page& page, VkDeviceSize size, VkDeviceSize& offset) const;
+    void freeToPage(Page& page, VkDeviceSize offset, VkDeviceSize length);
+    void collectGarbage(uint32_t currentFrameId);
+
+    Rc<DxvkDevice> m_device;
+    VkDeviceSize m_alignment;
+
+    dxvk::mutex m_mutex;
+    std::vector<std::unique_ptr<Page>> m_pages;
+    std::unordered_map<uint64_t, std::vector<Allocation>> m_allocations;
+    std::unordered_map<uint64_t, std::vector<Allocation>> m_detached;
+    uint64_t m_nextDetachedId = 1;
+    std::vector<PendingRelease> m_pendingReleases;
+  };
+
+}
@@ -45,8 +45,30 @@
 #include "dxvk_scoped_annotation.h"
 #include "rtx_lights_data.h"
 #include "rtx_light_utils.h"
+#include "../util/util_task_graph.h"
+#include "../util/log/metrics.h"
 
 namespace dxvk {
+
+  namespace {
+    // Resources accessed by the scene build stages, see SceneManager::prepareSceneData
+    namespace SceneResource {
+      enum : TaskGraph::ResourceMask {
+        // Command recording into the context, stages doing so keep their order
+        Context = 1 << 0,
+        Cameras = 1 << 1,
+        Portals = 1 << 2,
+        Instances = 1 << 3,
+        Accel = 1 << 4,
+        Lights = 1 << 5,
+        OpacityMicromaps = 1 << 6,
+        MaterialCaches = 1 << 7,
+        SurfaceMaterialData = 1 << 8,
+        SurfaceMaterialExtensionData = 1 << 9,
+        VolumeMaterialData = 1 << 10,
+      };
+    }
+  }
   SceneManager::SceneManager(DxvkDevice* device)
     : CommonDeviceObject(device)
     , m_instanceManager(device, this)
@@ -86,6 +108,10 @@ namespace dxvk {
     return m_pReplacer->areReplacementsLoading();
   }
 
+  float SceneManager::getReplacementLoadingProgress() const {
+    return m_pReplacer->getReplacementLoadingProgress();
+  }
+
   const std::string SceneManager::getReplacementStatus() const {
     return m_pReplacer->getReplacementStatus();
   }
@@ -189,35 +215,26 @@ namespace dxvk {
   void SceneManager::garbageCollection() {
     ScopedCpuProfileZone();
 
-    const size_t oldestFrame = m_device->getCurrentFrameId() - RtxOptions::Get()->numFramesToKeepGeometryData();
-    auto blasEntryGarbageCollection = [&](auto& iter, auto& entries) -> void {
-      if (iter->second.frameLastTouched < oldestFrame) {
-        onSceneObjectDestroyed(iter->second);
-        iter = entries.erase(iter);
-      } else {
-        ++iter;
-      }
-    };
+    const uint32_t oldestFrame = m_device->getCurrentFrameId() - RtxOptions::Get()->numFramesToKeepGeometryData();
 
     // Garbage collection for BLAS/Scene objects
     //
     // When anti-culling is enabled, we need to check if any instances are outside frustum. Because in such
     // case the life of the instances will be extended and we need to keep the BLAS as well.
     if (!RtxOptions::AntiCulling::Object::enable()) {
-      auto& entries = m_drawCallCache.getEntries();
+      // Only visits the entries which expired, oldest first
       if (m_device->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepGeometryData()) {
-        for (auto iter = entries.begin(); iter != entries.end(); ) {
-          blasEntryGarbageCollection(iter, entries);
-        }
+        m_drawCallCache.eraseExpired(oldestFrame, [&](const BlasEntry& blas) {
+          onSceneObjectDestroyed(blas);
+        });
       }
     }
     else { // Implement anti-culling BLAS/Scene object GC
       fast_unordered_cache<const RtInstance*> outsideFrustumInstancesCache;
 
-      auto& entries = m_drawCallCache.getEntries();
-      for (auto iter = entries.begin(); iter != entries.end();) {
+      m_drawCallCache.eraseIf([&](const BlasEntry& blas) {
         bool isAllInstancesInCurrentBlasInsideFrustum = true;
-        for (const RtInstance* instance : iter->second.getLinkedInstances()) {
+        for (const RtInstance* instance : blas.getLinkedInstances()) {
           const Matrix4 objectToView = getCamera().getWorldToView(false) * instance->getTransform();
 
           bool isInsideFrustum = true;
@@ -275,13 +292,15 @@ namespace dxvk {
         }
 
         // If all instances in current BLAS are inside the frustum, then use original GC logic to recycle BLAS Objects
+        // If any instances are outside of the frustum in current BLAS, we need to keep the entity
         if (isAllInstancesInCurrentBlasInsideFrustum &&
-            m_device->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepGeometryData()) {
-          blasEntryGarbageCollection(iter, entries);
-        } else { // If any instances are outside of the frustum in current BLAS, we need to keep the entity
-          ++iter;
+            m_device->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepGeometryData() &&
+            blas.frameLastTouched < oldestFrame) {
+          onSceneObjectDestroyed(blas);
+          return true;
         }
-      }
+        return false;
+      });
     }
 
     // Perform GC on the other managers
@@ -458,6 +477,9 @@ namespace dxvk {
       m_enqueueDelayedClear = false;
     }
 
+    updateDrawCallTrace();
+
+    m_pReplacer->onFrameEnd();
     m_cameraManager.onFrameEnd();
     m_instanceManager.onFrameEnd();
     m_previousFrameSceneAvailable = true;
@@ -489,6 +511,38 @@ namespace dxvk {
     }
   }
 
+  void SceneManager::updateDrawCallTrace() {
+    if (!DrawCallTraceWriter::enableRecording()) {
+      m_drawCallTraceWriter.reset();
+      m_drawCallTraceFinished = false;
+      return;
+    }
+
+    if (m_drawCallTraceFinished) {
+      return;
+    }
+
+    if (!m_drawCallTraceWriter) {
+      // Recording starts with the next frame, so the trace only contains complete frames
+      const std::string& filePath = DrawCallTraceWriter::filePath();
+      m_drawCallTraceWriter = std::make_unique<DrawCallTraceWriter>(filePath.empty() ? DrawCallTraceWriter::getDefaultFilePath() : filePath);
+      if (!m_drawCallTraceWriter->isOpen()) {
+        m_drawCallTraceWriter.reset();
+        m_drawCallTraceFinished = true;
+      }
+      return;
+    }
+
+    const RtCamera& camera = getCamera();
+    m_drawCallTraceWriter->recordFrameEnd(m_device->getCurrentFrameId(), Matrix4(camera.getWorldToView(false)), Matrix4(camera.getViewToProjection()));
+
+    const uint32_t maxFrames = DrawCallTraceWriter::maxFrames();
+    if (maxFrames != 0 && m_drawCallTraceWriter->getNumFrames() >= maxFrames) {
+      m_drawCallTraceWriter.reset();
+      m_drawCallTraceFinished = true;
+    }
+  }
+
   void SceneManager::onFrameEndNoRTX() {
     m_cameraManager.onFrameEnd();
   }
@@ -503,6 +557,10 @@ namespace dxvk {
       return;
     }
 
+    if (m_drawCallTraceWriter) {
+      m_drawCallTraceWriter->recordDraw(input);
+    }
+
     if (m_fog.mode == D3DFOG_NONE && input.getFogState().mode != D3DFOG_NONE) {
       m_fog = input.getFogState();
     }
@@ -863,7 +921,7 @@ namespace dxvk {
     }
 
     // Update the input state, so we always have a reference to the original draw call state
-    pBlas->frameLastTouched = m_device->getCurrentFrameId();
+    m_drawCallCache.touch(pBlas, m_device->getCurrentFrameId());
 
     if (drawCallState.getSkinningState().numBones > 0 &&
         drawCallState.getGeometryData().numBonesPerVertex > 0 &&
@@ -1238,6 +1296,10 @@ namespace dxvk {
     }
 
     const RtLight rtLight = lightData->toRtLight();
+
+    if (m_drawCallTraceWriter) {
+      m_drawCallTraceWriter->recordLight(rtLight);
+    }
     const std::vector<AssetReplacement>* pReplacements = m_pReplacer->getReplacementsForLight(rtLight.getInitialHash());
 
     if (pReplacements) {
@@ -1301,147 +1363,167 @@ namespace dxvk {
       return;
     }
 
-    m_rayPortalManager.prepareSceneData(ctx, frameTimeMilliseconds);
-    // Note: only main camera needs to be teleportation corrected as only that one is used for ray tracing & denoising
-    m_rayPortalManager.fixCameraInBetweenPortals(m_cameraManager.getCamera(CameraType::Main));
-    m_rayPortalManager.fixCameraInBetweenPortals(m_cameraManager.getCamera(CameraType::ViewModel));
-    m_rayPortalManager.createVirtualCameras(m_cameraManager);
-    const bool didTeleport = m_rayPortalManager.detectTeleportationAndCorrectCameraHistory(
-      m_cameraManager.getCamera(CameraType::Main),
-      m_cameraManager.isCameraValid(CameraType::ViewModel) ? &m_cameraManager.getCamera(CameraType::ViewModel) : nullptr);
+    // The rest of the scene build runs as a task graph. Everything recording commands into the context stays on
+    // this thread in its original order, packing the material data for the GPU only reads the material caches
+    // (which are not modified past this point) and overlaps with instance, BLAS, light and TLAS processing.
+    TaskGraph graph;
+
+    // Surface materials bake some global options into their packed data, so all of them are repacked when those change
+    const SurfaceMaterialGPUOptions surfaceMaterialGPUOptions = SurfaceMaterialGPUOptions::get();
+    const bool repackAllMaterials = surfaceMaterialGPUOptions != m_packedSurfaceMaterialGPUOptions;
+    m_packedSurfaceMaterialGPUOptions = surfaceMaterialGPUOptions;
+
+    graph.addTask("scene_build.ray_portals_and_cameras", TaskGraph::Affinity::Main,
+                  0, SceneResource::Context | SceneResource::Cameras | SceneResource::Portals | SceneResource::OpacityMicromaps, [&] {
+      m_rayPortalManager.prepareSceneData(ctx, frameTimeMilliseconds);
+      // Note: only main camera needs to be teleportation corrected as only that one is used for ray tracing & denoising
+      m_rayPortalManager.fixCameraInBetweenPortals(m_cameraManager.getCamera(CameraType::Main));
+      m_rayPortalManager.fixCameraInBetweenPortals(m_cameraManager.getCamera(CameraType::ViewModel));
+      m_rayPortalManager.createVirtualCameras(m_cameraManager);
+      const bool didTeleport = m_rayPortalManager.detectTeleportationAndCorrectCameraHistory(
+        m_cameraManager.getCamera(CameraType::Main),
+        m_cameraManager.isCameraValid(CameraType::ViewModel) ? &m_cameraManager.getCamera(CameraType::ViewModel) : nullptr);
+
+      if (m_cameraManager.isCameraCutThisFrame()) {
+        // Ignore camera cut events on teleportation so we don't flush the caches
+        if (!didTeleport) {
+          Logger::info(str::format("Camera cut detected on frame ", m_device->getCurrentFrameId()));
+          m_enqueueDelayedClear = true;
+        }
+      }
 
-    if (m_cameraManager.isCameraCutThisFrame()) {
-      // Ignore camera cut events on teleportation so we don't flush the caches
-      if (!didTeleport) {
-        Logger::info(str::format("Camera cut detected on frame ", m_device->getCurrentFrameId()));
+      if (m_pReplacer->checkForChanges(ctx)) {
+        // Delay release of textures to the end of the frame, when all commands are executed.
         m_enqueueDelayedClear = true;
       }
-    }
-
-    if (m_pReplacer->checkForChanges(ctx)) {
-      // Delay release of textures to the end of the frame, when all commands are executed.
-      m_enqueueDelayedClear = true;
-    }
 
-    // Initialize/remove opacity micromap manager
-    if (RtxOptions::Get()->getEnableOpacityMicromap()) {
-      if (!m_opacityMicromapManager.get() || 
-          // Reset the manager on camera cuts
-          m_enqueueDelayedClear) {
-        if (m_opacityMicromapManager.get())
-          m_instanceManager.removeEventHandler(m_opacityMicromapManager.get());
-
-        m_opacityMicromapManager = std::make_unique<OpacityMicromapManager>(m_device);
-        m_instanceManager.addEventHandler(m_opacityMicromapManager->getInstanceEventHandler());
-        Logger::info("[RTX] Opacity Micromap: enabled");
+      // Initialize/remove opacity micromap manager
+      if (RtxOptions::Get()->getEnableOpacityMicromap()) {
+        if (!m_opacityMicromapManager.get() || 
+            // Reset the manager on camera cuts
+            m_enqueueDelayedClear) {
+          if (m_opacityMicromapManager.get())
+            m_instanceManager.removeEventHandler(m_opacityMicromapManager.get());
+
+          m_opacityMicromapManager = std::make_unique<OpacityMicromapManager>(m_device);
+          m_instanceManager.addEventHandler(m_opacityMicromapManager->getInstanceEventHandler());
+          Logger::info("[RTX] Opacity Micromap: enabled");
+        }
+      } else if (m_opacityMicromapManager.get()) {
+        m_instanceManager.removeEventHandler(m_opacityMicromapManager.get());
+        m_opacityMicromapManager = nullptr;
+        Logger::info("[RTX] Opacity Micromap: disabled");
       }
-    } else if (m_opacityMicromapManager.get()) {
-      m_instanceManager.removeEventHandler(m_opacityMicromapManager.get());
-      m_opacityMicromapManager = nullptr;
-      Logger::info("[RTX] Opacity Micromap: disabled");
-    }
+    });
 
-    m_instanceManager.findPortalForVirtualInstances(m_cameraManager, m_rayPortalManager);
-    m_instanceManager.createViewModelInstances(ctx, m_cameraManager, m_rayPortalManager);
-    m_instanceManager.createPlayerModelVirtualInstances(ctx, m_cameraManager, m_rayPortalManager);
+    graph.addTask("scene_build.virtual_instances", TaskGraph::Affinity::Main,
+                  SceneResource::Cameras | SceneResource::Portals, SceneResource::Context | SceneResource::Instances, [&] {
+      m_instanceManager.findPortalForVirtualInstances(m_cameraManager, m_rayPortalManager);
+      m_instanceManager.createViewModelInstances(ctx, m_cameraManager, m_rayPortalManager);
+      m_instanceManager.createPlayerModelVirtualInstances(ctx, m_cameraManager, m_rayPortalManager);
+    });
 
-    m_accelManager.mergeInstancesIntoBlas(ctx, execBarriers, textureManager.getTextureTable(), m_cameraManager, m_instanceManager, m_opacityMicromapManager.get(), frameTimeMilliseconds);
+    graph.addTask("scene_build.merge_instances_into_blas", TaskGraph::Affinity::Main,
+                  SceneResource::Cameras, SceneResource::Context | SceneResource::Instances | SceneResource::Accel | SceneResource::OpacityMicromaps, [&] {
+      m_accelManager.mergeInstancesIntoBlas(ctx, execBarriers, textureManager.getTextureTable(), m_cameraManager, m_instanceManager, m_opacityMicromapManager.get(), frameTimeMilliseconds);
+    });
 
     // Call on the other managers to prepare their GPU data for the current scene
-    m_accelManager.prepareSceneData(ctx, execBarriers, m_instanceManager);
-    m_lightManager.prepareSceneData(ctx, m_cameraManager);
+    graph.addTask("scene_build.accel_manager", TaskGraph::Affinity::Main,
+                  SceneResource::Instances, SceneResource::Context | SceneResource::Accel, [&] {
+      m_accelManager.prepareSceneData(ctx, execBarriers, m_instanceManager);
+    });
 
-    // Build the TLAS
-    m_accelManager.buildTlas(ctx);
+    graph.addTask("scene_build.light_manager", TaskGraph::Affinity::Main,
+                  SceneResource::Cameras, SceneResource::Context | SceneResource::Lights, [&] {
+      m_lightManager.prepareSceneData(ctx, m_cameraManager);
+    });
 
-    // Todo: These updates require a lot of temporary buffer allocations and memcopies, ideally we should memcpy directly into a mapped pointer provided by Vulkan,
-    // but we have to create a buffer to pass to DXVK's updateBuffer for now.
-    {
+    // Build the TLAS
+    graph.addTask("scene_build.build_tlas", TaskGraph::Affinity::Main,
+                  SceneResource::Accel, SceneResource::Context, [&] {
+      m_accelManager.buildTlas(ctx);
+    });
+
+    graph.addTask("scene_build.pack_surface_materials", TaskGraph::Affinity::Worker,
+                  SceneResource::MaterialCaches, SceneResource::SurfaceMaterialData, [&] {
+      packDirtyEntries(m_surfaceMaterialCache, m_surfaceMaterialTable, repackAllMaterials);
+    });
+
+    graph.addTask("scene_build.pack_surface_material_extensions", TaskGraph::Affinity::Worker,
+                  SceneResource::MaterialCaches, SceneResource::SurfaceMaterialExtensionData, [&] {
+      packDirtyEntries(m_surfaceMaterialExtensionCache, m_surfaceMaterialExtensionTable, repackAllMaterials);
+    });
+
+    graph.addTask("scene_build.pack_volume_materials", TaskGraph::Affinity::Worker,
+                  SceneResource::MaterialCaches, SceneResource::VolumeMaterialData, [&] {
+      packDirtyEntries(m_volumeMaterialCache, m_volumeMaterialTable, false);
+    });
+
+    // Only the dirty ranges of the material tables are written, small ranges are recorded inline with
+    // updateBuffer and larger ones go through the context's staging ring, see DxvkContext::writeToBuffer.
+    graph.addTask("scene_build.upload_materials", TaskGraph::Affinity::Main,
+                  SceneResource::SurfaceMaterialData | SceneResource::SurfaceMaterialExtensionData | SceneResource::VolumeMaterialData,
+                  SceneResource::Context, [&] {
       // Allocate the instance buffer and copy its contents from host to device memory
       DxvkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
       info.usage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
       info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
       info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-      // Surface Material buffer
-      if (m_surfaceMaterialCache.getTotalCount() > 0) {
-        ScopedGpuProfileZone(ctx, "updateSurfaceMaterials");
-        const auto surfaceMaterialsGPUSize = m_surfaceMaterialCache.getTotalCount() * kSurfaceMaterialGPUSize;
-
-        info.size = align(surfaceMaterialsGPUSize, kBufferAlignment);
+      auto uploadMaterialData = [&](Rc<DxvkBuffer>& buffer, GpuTableUploader& table) {
+        info.size = align(table.getData().size(), kBufferAlignment);
         info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        if (m_surfaceMaterialBuffer == nullptr || info.size > m_surfaceMaterialBuffer->info().size) {
-          m_surfaceMaterialBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
-        }
-
-        std::size_t dataOffset = 0;
-        std::vector<unsigned char> surfaceMaterialsGPUData(surfaceMaterialsGPUSize);
-
-        for (auto&& surfaceMaterial : m_surfaceMaterialCache.getObjectTable()) {
-          surfaceMaterial.writeGPUData(surfaceMaterialsGPUData.data(), dataOffset);
+        bool recreated = false;
+        if (buffer == nullptr || info.size > buffer->info().size) {
+          buffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
+          recreated = true;
         }
 
-        assert(dataOffset == surfaceMaterialsGPUSize);
-        assert(surfaceMaterialsGPUData.size() == surfaceMaterialsGPUSize);
+        // A new buffer has undefined contents, so the whole table is uploaded into it
+        table.upload(recreated, [&](size_t offset, size_t size, const unsigned char* data) {
+          ctx->writeToBuffer(buffer, offset, size, data);
+        });
+      };
 
-        ctx->writeToBuffer(m_surfaceMaterialBuffer, 0, surfaceMaterialsGPUData.size(), surfaceMaterialsGPUData.data());
+      // Surface Material buffer
+      if (m_surfaceMaterialCache.getTotalCount() > 0) {
+        ScopedGpuProfileZone(ctx, "updateSurfaceMaterials");
+        uploadMaterialData(m_surfaceMaterialBuffer, m_surfaceMaterialTable);
       }
 
       // Surface Material Extension Buffer
       if (m_surfaceMaterialExtensionCache.getTotalCount() > 0) {
         ScopedGpuProfileZone(ctx, "updateSurfaceMaterialExtensions");
-        const auto surfaceMaterialExtensionsGPUSize = m_surfaceMaterialExtensionCache.getTotalCount() * kSurfaceMaterialGPUSize;
-
-        info.size = align(surfaceMaterialExtensionsGPUSize, kBufferAlignment);
-        info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        if (m_surfaceMaterialExtensionBuffer == nullptr || info.size > m_surfaceMaterialExtensionBuffer->info().size) {
-          m_surfaceMaterialExtensionBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
-        }
-
-        std::size_t dataOffset = 0;
-        std::vector<unsigned char> surfaceMaterialExtensionsGPUData(surfaceMaterialExtensionsGPUSize);
-
-        for (auto&& surfaceMaterialExtension : m_surfaceMaterialExtensionCache.getObjectTable()) {
-          surfaceMaterialExtension.writeGPUData(surfaceMaterialExtensionsGPUData.data(), dataOffset);
-        }
-
-        assert(dataOffset == surfaceMaterialExtensionsGPUSize);
-        assert(surfaceMaterialExtensionsGPUData.size() == surfaceMaterialExtensionsGPUSize);
-
-        ctx->writeToBuffer(m_surfaceMaterialExtensionBuffer, 0, surfaceMaterialExtensionsGPUData.size(), surfaceMaterialExtensionsGPUData.data());
+        uploadMaterialData(m_surfaceMaterialExtensionBuffer, m_surfaceMaterialExtensionTable);
       }
 
       // Volume Material buffer
       if (m_volumeMaterialCache.getTotalCount() > 0) {
         ScopedGpuProfileZone(ctx, "updateVolumeMaterials");
-        const auto volumeMaterialsGPUSize = m_volumeMaterialCache.getTotalCount() * kVolumeMaterialGPUSize;
-
-        info.size = align(volumeMaterialsGPUSize, kBufferAlignment);
-        info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        if (m_volumeMaterialBuffer == nullptr || info.size > m_volumeMaterialBuffer->info().size) {
-          m_volumeMaterialBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
-        }
+        uploadMaterialData(m_volumeMaterialBuffer, m_volumeMaterialTable);
+      }
 
-        std::size_t dataOffset = 0;
-        std::vector<unsigned char> volumeMaterialsGPUData(volumeMaterialsGPUSize);
+      ctx->emitMemoryBarrier(0,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        VK_ACCESS_SHADER_READ_BIT);
+    });
 
-        for (auto&& volumeMaterial : m_volumeMaterialCache.getObjectTable()) {
-          volumeMaterial.writeGPUData(volumeMaterialsGPUData.data(), dataOffset);
-        }
+    if (RtxOptions::enableParallelSceneBuild() && m_sceneBuildWorkers == nullptr) {
+      m_sceneBuildWorkers = std::make_unique<SceneBuildThreadPool>(kNumSceneBuildWorkers, "rtx-scene-build");
+    } else if (!RtxOptions::enableParallelSceneBuild()) {
+      m_sceneBuildWorkers = nullptr;
+    }
 
-        assert(dataOffset == volumeMaterialsGPUSize);
-        assert(volumeMaterialsGPUData.size() == volumeMaterialsGPUSize);
+    graph.execute(m_sceneBuildWorkers.get());
 
-        ctx->writeToBuffer(m_volumeMaterialBuffer, 0, volumeMaterialsGPUData.size(), volumeMaterialsGPUData.data());
-      }
+    // Per stage timings, the durations sum up to more than the scene build took when stages overlapped
+    for (const TaskGraph::StageTiming& timing : graph.getTimings()) {
+      Metrics::gauge(timing.name).set(timing.durationMs);
     }
 
-    ctx->emitMemoryBarrier(0,
-      VK_PIPELINE_STAGE_TRANSFER_BIT,
-      VK_ACCESS_TRANSFER_WRITE_BIT,
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-      VK_ACCESS_SHADER_READ_BIT);
-
     // Update stats
     m_device->statCounters().setCtr(DxvkStatCounter::RtxBlasCount, AccelManager::getBlasCount());
     m_device->statCounters().setCtr(DxvkStatCounter::RtxBufferCount, m_bufferCache.getActiveCount());
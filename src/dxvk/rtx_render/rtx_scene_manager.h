@@ -34,13 +34,16 @@
 #include "../dxvk_staging.h"
 #include "../dxvk_bind_mask.h"
 #include "../util/util_hashtable.h"
+#include "../util/util_threadpool.h"
 
 #include "rtx_globals.h"
 #include "rtx_types.h"
 #include "rtx_common_object.h"
 #include "rtx_camera_manager.h"
 #include "rtx_draw_call_cache.h"
+#include "rtx_draw_call_trace.h"
 #include "rtx_sparse_unique_cache.h"
+#include "rtx_gpu_table_uploader.h"
 #include "rtx_light_manager.h"
 #include "rtx_instance_manager.h"
 #include "rtx_accel_manager.h"
@@ -73,15 +76,15 @@ protected:
       return (size_t)mat.getHash();
     }
   };
-  SparseUniqueCache<RtSurfaceMaterial, SurfaceMaterialHashFn> m_surfaceMaterialCache;
-  SparseUniqueCache<RtSurfaceMaterial, SurfaceMaterialHashFn> m_surfaceMaterialExtensionCache;
+  SparseUniqueCache<RtSurfaceMaterial, SurfaceMaterialHashFn> m_surfaceMaterialCache { true };
+  SparseUniqueCache<RtSurfaceMaterial, SurfaceMaterialHashFn> m_surfaceMaterialExtensionCache { true };
 
   struct VolumeMaterialHashFn {
     size_t operator() (const RtVolumeMaterial& mat) const {
       return (size_t)mat.getHash();
     }
   };
-  SparseUniqueCache<RtVolumeMaterial, VolumeMaterialHashFn> m_volumeMaterialCache;
+  SparseUniqueCache<RtVolumeMaterial, VolumeMaterialHashFn> m_volumeMaterialCache { true };
 
   struct SamplerHashFn {
     size_t operator() (const Rc<DxvkSampler>& sampler) const {
@@ -128,6 +131,7 @@ public:
   
   bool areReplacementsLoaded() const;
   bool areReplacementsLoading() const;
+  float getReplacementLoadingProgress() const;
   const std::string getReplacementStatus() const;
 
   uint64_t getGameTimeSinceStartMS();
@@ -245,6 +249,9 @@ private:
 
   void createEffectLight(Rc<DxvkContext> ctx, const DrawCallState& input, const RtInstance* instance);
 
+  // Starts, advances and stops draw call trace recording at the end of a frame
+  void updateDrawCallTrace();
+
   uint32_t m_beginUsdExportFrameNum = -1;
   bool m_enqueueDelayedClear = false;
   bool m_previousFrameSceneAvailable = false;
@@ -264,6 +271,10 @@ private:
 
   CameraManager m_cameraManager;
 
+  std::unique_ptr<DrawCallTraceWriter> m_drawCallTraceWriter;
+  // Set once rtx.drawCallTrace.maxFrames were recorded, until recording is disabled
+  bool m_drawCallTraceFinished = false;
+
   std::unique_ptr<AssetReplacer> m_pReplacer;
 
   std::unique_ptr<TerrainBaker> m_terrainBaker;
@@ -275,6 +286,19 @@ private:
   Rc<DxvkBuffer> m_surfaceMaterialExtensionBuffer;
   Rc<DxvkBuffer> m_volumeMaterialBuffer;
 
+  // Host copies of the material buffers, the scene build workers only repack the materials
+  // added or freed since the last frame and only those are uploaded
+  GpuTableUploader m_surfaceMaterialTable { kSurfaceMaterialGPUSize };
+  GpuTableUploader m_surfaceMaterialExtensionTable { kSurfaceMaterialGPUSize };
+  GpuTableUploader m_volumeMaterialTable { kVolumeMaterialGPUSize };
+  // Options the surface material tables were last packed with
+  SurfaceMaterialGPUOptions m_packedSurfaceMaterialGPUOptions;
+
+  // Runs the CPU only stages of prepareSceneData, see rtx.enableParallelSceneBuild
+  static constexpr uint8_t kNumSceneBuildWorkers = 2;
+  using SceneBuildThreadPool = WorkerThreadPool<8, true, false>;
+  std::unique_ptr<SceneBuildThreadPool> m_sceneBuildWorkers;
+
   uint32_t m_currentFrameIdx = -1;
   bool m_useFixedFrameTime = false;
   std::chrono::time_point<std::chrono::steady_clock> m_startTime;
@@ -52,6 +52,10 @@ namespace dxvk
 * 
 *  NOTE: This object does no ref counting - its expected that the user supply T 
    as a ref-counted object if that behavior is desired.
+* 
+*  When constructed with trackDirty, indices whose object was added or freed are
+*  recorded until clearDirty is called, so that a GPU copy of the object table
+*  only needs to update those.
 */
 template<typename T, class HashFn, class KeyEqual = std::equal_to<T>>
 struct SparseUniqueCache
@@ -60,13 +64,14 @@ public:
   SparseUniqueCache(SparseUniqueCache const&) = delete;
   SparseUniqueCache& operator=(SparseUniqueCache const&) = delete;
 
-  SparseUniqueCache() {}
+  explicit SparseUniqueCache(bool trackDirty = false) : m_trackDirty(trackDirty) {}
   ~SparseUniqueCache() {}
 
   void clear() {
     m_freeBuffers = {};
     m_objects.clear();
     m_bufferMap.clear();
+    m_dirtyIndices.clear();
   }
 
   uint32_t track(const T& obj, std::function<T(const T&)> onFirstCache = [](const T& in) { return in; }) {
@@ -82,6 +87,9 @@ public:
         m_objects.push_back(objectToCache);
       }
       m_bufferMap.insert({ objectToCache, idx });
+      if (m_trackDirty) {
+        m_dirtyIndices.push_back(idx);
+      }
     }
     return idx;
   }
@@ -100,6 +108,9 @@ public:
     if (iter != m_bufferMap.end()) {
       m_objects.at(iter->second) = T();
       m_freeBuffers.push(iter->second);
+      if (m_trackDirty) {
+        m_dirtyIndices.push_back(iter->second);
+      }
       m_bufferMap.erase(iter);
     }
   }
@@ -112,10 +123,16 @@ public:
   const std::vector<T>& getObjectTable() const { return m_objects; }
   std::vector<T>& getObjectTable() { return m_objects; }
 
+  // May contain an index more than once if it was freed and reused since the last clearDirty
+  const std::vector<uint32_t>& getDirtyIndices() const { return m_dirtyIndices; }
+  void clearDirty() { m_dirtyIndices.clear(); }
+
 private:
   std::queue<uint32_t> m_freeBuffers;
   std::vector<T> m_objects;
   std::unordered_map<T, uint32_t, HashFn, KeyEqual> m_bufferMap;
+  const bool m_trackDirty;
+  std::vector<uint32_t> m_dirtyIndices;
 };
 
 }  // namespace dxvk
@@ -91,6 +91,16 @@ namespace dxvk {
     }
   }
 
+  // Ensures a texture stays in VidMem
+  void trackAndFinalizeReplacementTexture(Rc<RtxContext>& ctx, TextureRef& texture, const bool hasTexcoords) {
+    uint32_t unusedTextureIndex;
+    ctx->getSceneManager().trackTexture(ctx, texture, unusedTextureIndex, hasTexcoords);
+    // Force the full resolution promotion
+    if (texture.isPromotable()) {
+      texture.finalizePendingPromotion();
+    }
+  }
+
   bool TerrainBaker::isPSReplacementSupportEnabled(const DrawCallState& drawCallState) {
     if (drawCallState.usesPixelShader) {
       return Material::replacementSupportInPS() && 
@@ -111,7 +121,6 @@ namespace dxvk {
       return false;
     }
 
-    SceneManager& sceneManager = ctx->getSceneManager();
     Resources& resourceManager = ctx->getResourceManager();
     const bool hasTexcoords = drawCallState.hasTextureCoordinates();
     // We're going to use this to create a modified sampler for textures.
@@ -132,18 +141,8 @@ namespace dxvk {
                                     "Only single texture legacy materials are supported. Ignoring the second color texture.")));
     }
 
-    // Ensures a texture stays in VidMem
-    auto trackAndFinalizeTexture = [&](TextureRef& texture) {
-      uint32_t unusedTextureIndex;
-      sceneManager.trackTexture(ctx, texture, unusedTextureIndex, hasTexcoords);
-      // Force the full resolution promotion
-      if (texture.isPromotable()) {
-        texture.finalizePendingPromotion();
-      }
-    };
-
     // Track the source albedo opacity texture to keep it in VidMem as it's needed for baking
-    trackAndFinalizeTexture(replacementMaterial->getAlbedoOpacityTexture());
+    trackAndFinalizeReplacementTexture(ctx, replacementMaterial->getAlbedoOpacityTexture(), hasTexcoords);
 
     const DxvkImageCreateInfo& aoImageInfo = replacementMaterial->getAlbedoOpacityTexture().getImageView()->imageInfo();
 
@@ -171,7 +170,7 @@ namespace dxvk {
       // Track the source material texture to keep it in VidMem while it's being used for baking.
       // This needs to be done prior to checking for having valid views 
       // since the views are not created until the texture is promoted
-      trackAndFinalizeTexture(texture);
+      trackAndFinalizeReplacementTexture(ctx, texture, hasTexcoords);
 
       if (!texture.getImageView()) {
         return;
@@ -184,7 +183,6 @@ namespace dxvk {
       if (textureType == ReplacementMaterialTextureType::Height) {
         // Normalize the displaceIn to the previous frame's max displaceIn.
         conversionInfo.scale = m_prevFrameMaxDisplaceIn <= 0.f ? 0.f : replacementMaterial->getDisplaceIn() / m_prevFrameMaxDisplaceIn;
-        m_currFrameMaxDisplaceIn = std::max(m_currFrameMaxDisplaceIn, replacementMaterial->getDisplaceIn());
       }
 
       if (isPSReplacementSupportEnabled(drawCallState)) {
@@ -259,6 +257,75 @@ namespace dxvk {
     return true;
   }
 
+  // Keeps the replacement textures used for baking in VidMem and hashes the image views they currently resolve to.
+  // Replacement textures are skipped by the baking until they are promoted, so this makes the tiles baked
+  // while the textures were still streaming in get rebaked once they arrive
+  XXH64_hash_t TerrainBaker::trackReplacementTextures(Rc<RtxContext> ctx,
+                                                      const DrawCallState& drawCallState,
+                                                      OpaqueMaterialData* replacementMaterial,
+                                                      XXH64_hash_t hash) {
+    if (!replacementMaterial || !replacementMaterial->getAlbedoOpacityTexture().isValid()) {
+      return hash;
+    }
+
+    const bool hasTexcoords = drawCallState.hasTextureCoordinates();
+
+    auto trackAndHashTexture = [&](TextureRef& texture) {
+      if (!texture.isValid()) {
+        return;
+      }
+
+      trackAndFinalizeReplacementTexture(ctx, texture, hasTexcoords);
+
+      const DxvkImageView* imageView = texture.getImageView();
+      const uint64_t imageViewCookie = imageView ? imageView->cookie() : 0;
+      hash = XXH64(&imageViewCookie, sizeof(imageViewCookie), hash);
+    };
+
+    trackAndHashTexture(replacementMaterial->getAlbedoOpacityTexture());
+
+    if (Material::bakeSecondaryPBRTextures()) {
+      trackAndHashTexture(replacementMaterial->getNormalTexture());
+      trackAndHashTexture(replacementMaterial->getTangentTexture());
+      trackAndHashTexture(replacementMaterial->getHeightTexture());
+      trackAndHashTexture(replacementMaterial->getRoughnessTexture());
+      trackAndHashTexture(replacementMaterial->getMetallicTexture());
+      trackAndHashTexture(replacementMaterial->getEmissiveColorTexture());
+    }
+
+    return hash;
+  }
+
+  // Calls func with the scissor of every run of consecutive dirty tiles within a row of the rect
+  template<typename Func>
+  void TerrainBaker::forEachDirtyTileRun(uint32_t iCascade, const TerrainTileMap::TileRect& rect, const Func& func) const {
+    if (rect.isEmpty()) {
+      return;
+    }
+
+    // All tiles are rebaked in the common case of the baking parameters changing, i.e. when the camera moves
+    if (m_tileMap.isEntirelyDirty(iCascade, rect)) {
+      func(calculateTileScissor(iCascade, rect));
+      return;
+    }
+
+    for (uint32_t y = rect.beginY; y < rect.endY; y++) {
+      for (uint32_t x = rect.beginX; x < rect.endX; x++) {
+        if (!m_tileMap.isDirty(iCascade, x, y)) {
+          continue;
+        }
+
+        uint32_t endX = x + 1;
+        while (endX < rect.endX && m_tileMap.isDirty(iCascade, endX, y)) {
+          endX++;
+        }
+
+        func(calculateTileScissor(iCascade, TerrainTileMap::TileRect { x, y, endX, y + 1 }));
+        x = endX;
+      }
+    }
+  }
+
   bool TerrainBaker::bakeDrawCall(Rc<RtxContext> ctx,
                                   const DxvkContextState& dxvkCtxState,
                                   DxvkRaytracingInstanceState& rtState,
@@ -283,8 +350,11 @@ namespace dxvk {
       replacementMaterial = nullptr;
     }
 
+    const AxisAlignedBoundingBox worldAABB =
+      drawCallState.getGeometryData().boundingBox.getTransformed(drawCallState.getTransformData().objectToWorld);
+
     // Register mesh and preprocess state for baking for this frame
-    registerTerrainMesh(ctx, dxvkCtxState, drawCallState);
+    registerTerrainMesh(ctx, dxvkCtxState, worldAABB);
 
     if (!debugDisableBinding()) {
       textureTransformOut = m_bakingParams.viewToCascade0TextureSpace;
@@ -334,6 +404,59 @@ namespace dxvk {
     }
     D3D9SharedPS prevSharedState = *static_cast<D3D9SharedPS*>(rtState.psSharedStateCB->mapPtr(0));
 
+    const Matrix4& world = drawCallState.usesVertexShader ? prevCB.programmablePipeline.normalTransform : prevCB.fixedFunction.World;
+
+    // Height textures are normalized to the deepest displacement of all draw calls in the previous frame,
+    // so it needs to be tracked for all of them whether they end up being rasterized or not
+    if (replacementMaterial && Material::bakeSecondaryPBRTextures() && replacementMaterial->getHeightTexture().isValid()) {
+      m_currFrameMaxDisplaceIn = std::max(m_currFrameMaxDisplaceIn, replacementMaterial->getDisplaceIn());
+    }
+
+    // Hash the draw call's inputs affecting the baked result, other than the per cascade ones overridden below
+    XXH64_hash_t contributorHash = drawCallState.getGeometryData().getHashForRule<rules::FullGeometryHash>();
+    {
+      const XXH64_hash_t materialHashes[] = {
+        drawCallState.getMaterialData().getHash(),
+        replacementMaterial ? replacementMaterial->getHash() : kEmptyHash
+      };
+      contributorHash = XXH64(materialHashes, sizeof(materialHashes), contributorHash);
+      contributorHash = XXH64(&world, sizeof(world), contributorHash);
+      contributorHash = XXH64(&prevSharedState, sizeof(prevSharedState), contributorHash);
+
+      contributorHash = trackReplacementTextures(ctx, drawCallState, replacementMaterial, contributorHash);
+
+      if (!drawCallState.usesVertexShader) {
+        contributorHash = XXH64(&prevCB.fixedFunction.TexcoordMatrices, sizeof(prevCB.fixedFunction.TexcoordMatrices), contributorHash);
+        contributorHash = XXH64(&prevCB.fixedFunction.Material, sizeof(prevCB.fixedFunction.Material), contributorHash);
+      }
+    }
+
+    // Register the draw call with the tiles it covers and only rasterize it into the ones being rebaked
+    bool hasDirtyTiles = false;
+    m_drawTileRects.resize(m_bakingParams.numCascades);
+
+    for (uint32_t iCascade = 0; iCascade < m_bakingParams.numCascades; iCascade++) {
+      TerrainTileMap::TileRect& tileRect = m_drawTileRects[iCascade];
+      tileRect = m_tileMap.calculateTileRect(worldAABB, m_bakingParams.worldToCascadeClip[iCascade]);
+      m_tileMap.addContributor(iCascade, tileRect, contributorHash);
+      hasDirtyTiles |= m_tileMap.hasDirtyTiles(iCascade, tileRect);
+    }
+
+    if (!hasDirtyTiles) {
+      // The covered tiles are up to date, so just keep the baked textures alive
+      for (BakedTexture& texture : m_materialTextures) {
+        if (texture.isBaked()) {
+          texture.markAsBaked();
+        }
+      }
+
+      const bool isBaked = getTerrainTexture(ReplacementMaterialTextureType::AlbedoOpacity).view != nullptr;
+      if (isBaked) {
+        updateMaterialData(ctx);
+      }
+      return isBaked;
+    }
+
     const float2 float2CascadeLevelResolution = float2 {
       static_cast<float>(m_bakingParams.cascadeLevelResolution.width),
       static_cast<float>(m_bakingParams.cascadeLevelResolution.height)
@@ -480,13 +603,16 @@ namespace dxvk {
         m_materialTextures[textureType].markAsBaked();
       }
 
-      const Matrix4& world = drawCallState.usesVertexShader ? prevCB.programmablePipeline.normalTransform : prevCB.fixedFunction.World;
       Matrix4 worldSceneView = m_bakingParams.sceneView * world;
 
       // Render into all cascade levels. 
       // The levels are tiled left to right top to bottom in the combined render target texture
       for (uint32_t iCascade = 0; iCascade < m_bakingParams.numCascades; iCascade++) {
 
+        if (!m_tileMap.hasDirtyTiles(iCascade, m_drawTileRects[iCascade])) {
+          continue;
+        }
+
         Vector2i cascade2DIndex;
         cascade2DIndex.y = iCascade / m_bakingParams.cascadeMapSize.x;
         cascade2DIndex.x = iCascade - cascade2DIndex.y * m_bakingParams.cascadeMapSize.x;
@@ -501,15 +627,6 @@ namespace dxvk {
           0.f, 1.f
         };
 
-        VkOffset2D cascadeOffset = VkOffset2D {
-          static_cast<int>(cascade2DIndex.x * m_bakingParams.cascadeLevelResolution.width),
-          static_cast<int>(cascade2DIndex.y * m_bakingParams.cascadeLevelResolution.height) };
-
-        // Set scissor window which clips the screen space
-        VkRect2D scissor = { cascadeOffset, m_bakingParams.cascadeLevelResolution };
-
-        ctx->setViewports(1, &viewport, &scissor);
-
         // Account for the difference in UV density between the input terrain material and the baked terrain.
         // This part is just pre-multiplying the "multiply by output uv density".  The input UV density is accounted for in `postprocessTextureReadForTerrainBaking`
         float cascadeUvDensity = Material::Properties::displaceInFactor() / std::max(m_bakingParams.cascadeMapResolution.width, m_bakingParams.cascadeMapResolution.height);
@@ -545,11 +662,16 @@ namespace dxvk {
           }
         }
 
-        if (drawParams.indexCount == 0) {
-          ctx->DxvkContext::draw(drawParams.vertexCount, drawParams.instanceCount, drawParams.vertexOffset, 0);
-        } else {
-          ctx->DxvkContext::drawIndexed(drawParams.indexCount, drawParams.instanceCount, drawParams.firstIndex, drawParams.vertexOffset, 0);
-        }
+        // Set scissor windows which clip the screen space to the tiles being rebaked
+        forEachDirtyTileRun(iCascade, m_drawTileRects[iCascade], [&](const VkRect2D& scissor) {
+          ctx->setViewports(1, &viewport, &scissor);
+
+          if (drawParams.indexCount == 0) {
+            ctx->DxvkContext::draw(drawParams.vertexCount, drawParams.instanceCount, drawParams.vertexOffset, 0);
+          } else {
+            ctx->DxvkContext::drawIndexed(drawParams.indexCount, drawParams.instanceCount, drawParams.firstIndex, drawParams.vertexOffset, 0);
+          }
+        });
       }
 
       if (textureType == ReplacementMaterialTextureType::AlbedoOpacity) {
@@ -687,6 +809,9 @@ namespace dxvk {
         ctx, "baked terrain texture", resolution, getTextureFormat(textureType), VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, getClearColor(textureType), getMipLevels(textureType, resolution));
 
       m_needsMaterialDataUpdate = true;
+
+      // Draw calls baked earlier this frame skipped the up to date tiles, so rebake all of them next frame
+      m_tileMap.invalidate();
     }
 
     return texture;
@@ -730,6 +855,7 @@ namespace dxvk {
       ImGui::Checkbox("Enable Runtime Terrain Baking", &enableBakingObject());
       ImGui::Checkbox("Use Terrain Bounding Box", &cascadeMap.useTerrainBBOXObject());
       ImGui::Checkbox("Clear Terrain Textures Before Terrain Baking", &clearTerrainBeforeBakingObject());
+      ImGui::Checkbox("Incremental Baking", &enableIncrementalBakingObject());
 
       if (ImGui::CollapsingHeader("Material", collapsingHeaderClosedFlags)) {
         ImGui::Indent();
@@ -779,6 +905,8 @@ namespace dxvk {
         RTX_OPTION_CLAMP(cascadeMap.maxLevels, 1u, 16u);
         ImGui::DragInt("Texture Resolution Per Cascade Level", &cascadeMap.levelResolutionObject(), 8.f, 1, 32 * 1024);
         RTX_OPTION_CLAMP(cascadeMap.levelResolution, 1u, 32 * 1024u);
+        ImGui::DragInt("Tiles Per Cascade Level Side", &cascadeMap.tilesPerLevelSideObject(), 1.f, 1, 64);
+        RTX_OPTION_CLAMP(cascadeMap.tilesPerLevelSide, 1u, 64u);
         ImGui::Checkbox("Expand Last Cascade Level", &cascadeMap.expandLastCascadeObject());
 
         if (ImGui::CollapsingHeader("Statistics", collapsingHeaderClosedFlags)) {
@@ -787,6 +915,7 @@ namespace dxvk {
           ImGui::Text("Cascade Levels: %u", m_bakingParams.numCascades);
           ImGui::Text("Cascade Level Resolution: %u, %u", m_bakingParams.cascadeLevelResolution.width, m_bakingParams.cascadeLevelResolution.height);
           ImGui::Text("Cascade Map Resolution: %u, %u", m_bakingParams.cascadeMapResolution.width, m_bakingParams.cascadeMapResolution.height);
+          ImGui::Text("Rebaked Tiles: %u / %u", m_tileMap.getNumDirtyTiles(), m_tileMap.getNumTiles());
         
           ImGui::Unindent();
         }
@@ -806,8 +935,8 @@ namespace dxvk {
 
     // Find the union of all terrain mesh BBOXes
     if (m_terrainMeshBBOXes.size() > 0) {
-      for (auto& meshBBOX : m_terrainMeshBBOXes) {
-        m_bakedTerrainBBOX.unionWith(meshBBOX.calculateAABBInWorldSpace());
+      for (const AxisAlignedBoundingBox& meshBBOX : m_terrainMeshBBOXes) {
+        m_bakedTerrainBBOX.unionWith(meshBBOX);
       }
       m_terrainMeshBBOXes.clear();
       m_terrainBBOXFrameIndex = currentFrameIndex;
@@ -823,6 +952,11 @@ namespace dxvk {
       calculateTerrainBBOX(currentFrameIndex);
     }
 
+    // Tiles are only tracked in frames which baked terrain
+    if (m_bakingParams.frameIndex == currentFrameIndex) {
+      m_tileMap.endFrame();
+    }
+
     m_hasInitializedMaterialDataThisFrame = false;
 
     for (BakedTexture& texture : m_materialTextures) {
@@ -913,18 +1047,6 @@ namespace dxvk {
     ctx->clearColorImage(texture.image, getClearColor(textureType), subRange);
   }
 
-  TerrainBaker::AxisAlignedBoundingBoxLink::AxisAlignedBoundingBoxLink(const DrawCallState& drawCallState)
-    : aabbObjectSpace(drawCallState.getGeometryData().boundingBox)
-    , objectToWorld(drawCallState.getTransformData().objectToWorld) {
-  }
-
-  AxisAlignedBoundingBox TerrainBaker::AxisAlignedBoundingBoxLink::calculateAABBInWorldSpace() {
-    AxisAlignedBoundingBox aabb;
-    aabb.minPos = (objectToWorld * Vector4(aabbObjectSpace.minPos, 1.f)).xyz();
-    aabb.maxPos = (objectToWorld * Vector4(aabbObjectSpace.maxPos, 1.f)).xyz();
-    return aabb;
-  }
-
   bool TerrainBaker::needsTerrainBaking() {
     return enableBaking() && RtxOptions::Get()->terrainTextures().size() > 0;
   }
@@ -938,18 +1060,106 @@ namespace dxvk {
 
     updateTextureFormat(dxvkCtxState);
     calculateBakingParameters(ctx, dxvkCtxState);
+    updateTileMap();
 
     // Clear terrain textures
     if (clearTerrainBeforeBaking() && !debugDisableBaking()) {
-      for (uint32_t i = 0; i < ReplacementMaterialTextureType::Count; i++) {
-        if (m_materialTextures[i].texture.isValid()) {
-          clearMaterialTexture(ctx, static_cast<ReplacementMaterialTextureType::Enum>(i));
-        }
+      clearDirtyTiles(ctx);
+    }
+  }
+
+  void TerrainBaker::updateTileMap() {
+    // Inputs affecting the baked result of all draw calls in a cascade level
+    struct CascadeState {
+      Matrix4 worldToCascadeClip;
+      VkExtent2D cascadeLevelResolution;
+      float prevFrameMaxDisplaceIn;
+      float displaceInFactor;
+      uint32_t maxResolutionToUseForReplacementMaterials;
+      uint32_t materialFlags;
+    };
+
+    const VkExtent2D& levelResolution = m_bakingParams.cascadeLevelResolution;
+    const uint32_t tilesPerSide =
+      std::clamp(cascadeMap.tilesPerLevelSide(), 1u, std::max(1u, std::min({ 64u, levelResolution.width, levelResolution.height })));
+
+    std::vector<XXH64_hash_t> cascadeHashes(m_bakingParams.numCascades);
+
+    for (uint32_t iCascade = 0; iCascade < m_bakingParams.numCascades; iCascade++) {
+      CascadeState state {};
+      state.worldToCascadeClip = m_bakingParams.worldToCascadeClip[iCascade];
+      state.cascadeLevelResolution = levelResolution;
+      state.prevFrameMaxDisplaceIn = m_prevFrameMaxDisplaceIn;
+      state.displaceInFactor = Material::Properties::displaceInFactor();
+      state.maxResolutionToUseForReplacementMaterials = Material::maxResolutionToUseForReplacementMaterials();
+      state.materialFlags =
+        (Material::bakeReplacementMaterials() ? 1 << 0 : 0) |
+        (Material::bakeSecondaryPBRTextures() ? 1 << 1 : 0) |
+        (Material::replacementSupportInPS() ? 1 << 2 : 0) |
+        (Material::replacementSupportInPS_fixedFunction() ? 1 << 3 : 0) |
+        (Material::replacementSupportInPS_programmableShaders() ? 1 << 4 : 0);
+
+      cascadeHashes[iCascade] = XXH3_64bits(&state, sizeof(state));
+    }
+
+    m_tileMap.beginFrame(m_bakingParams.numCascades, tilesPerSide, cascadeHashes.data(), !enableIncrementalBaking());
+  }
+
+  VkRect2D TerrainBaker::calculateTileScissor(uint32_t iCascade, const TerrainTileMap::TileRect& rect) const {
+    const uint32_t tilesPerSide = m_tileMap.getTilesPerSide();
+    const VkExtent2D& levelResolution = m_bakingParams.cascadeLevelResolution;
+
+    Vector2i cascade2DIndex;
+    cascade2DIndex.y = iCascade / m_bakingParams.cascadeMapSize.x;
+    cascade2DIndex.x = iCascade - cascade2DIndex.y * m_bakingParams.cascadeMapSize.x;
+
+    // Tile boundaries are rounded down so that the tiles cover a level without gaps
+    const uint32_t beginX = rect.beginX * levelResolution.width / tilesPerSide;
+    const uint32_t beginY = rect.beginY * levelResolution.height / tilesPerSide;
+    const uint32_t endX = rect.endX * levelResolution.width / tilesPerSide;
+    const uint32_t endY = rect.endY * levelResolution.height / tilesPerSide;
+
+    return VkRect2D {
+      VkOffset2D {
+        static_cast<int>(cascade2DIndex.x * levelResolution.width + beginX),
+        static_cast<int>(cascade2DIndex.y * levelResolution.height + beginY) },
+      VkExtent2D { endX - beginX, endY - beginY } };
+  }
+
+  void TerrainBaker::clearDirtyTiles(Rc<DxvkContext> ctx) {
+    const bool clearAll = m_tileMap.getNumDirtyTiles() == m_tileMap.getNumTiles();
+    const TerrainTileMap::TileRect wholeLevel { 0, 0, m_tileMap.getTilesPerSide(), m_tileMap.getTilesPerSide() };
+
+    for (uint32_t i = 0; i < ReplacementMaterialTextureType::Count; i++) {
+      const ReplacementMaterialTextureType::Enum textureType = static_cast<ReplacementMaterialTextureType::Enum>(i);
+      const RtxMipmap::Resource& texture = m_materialTextures[i].texture;
+
+      if (!texture.isValid()) {
+        continue;
+      }
+
+      if (clearAll) {
+        clearMaterialTexture(ctx, textureType);
+        continue;
+      }
+
+      const Rc<DxvkImageView>& textureView = texture.views.empty() ? texture.view : texture.views[0];
+
+      VkClearValue clearValue;
+      clearValue.color = getClearColor(textureType);
+
+      for (uint32_t iCascade = 0; iCascade < m_bakingParams.numCascades; iCascade++) {
+        forEachDirtyTileRun(iCascade, wholeLevel, [&](const VkRect2D& rect) {
+          ctx->clearImageView(textureView,
+                              VkOffset3D { rect.offset.x, rect.offset.y, 0 },
+                              VkExtent3D { rect.extent.width, rect.extent.height, 1 },
+                              VK_IMAGE_ASPECT_COLOR_BIT, clearValue);
+        });
       }
     }
   }
 
-  void TerrainBaker::registerTerrainMesh(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState, const DrawCallState& drawCallState) {
+  void TerrainBaker::registerTerrainMesh(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState, const AxisAlignedBoundingBox& worldAABB) {
     const uint32_t currentFrameIndex = ctx->getDevice()->getCurrentFrameId();
 
     // This is the first call in a frame, set up baking state for the new frame
@@ -958,7 +1168,7 @@ namespace dxvk {
     }
 
     if (cascadeMap.useTerrainBBOX()) { 
-      m_terrainMeshBBOXes.emplace_back(AxisAlignedBoundingBoxLink(drawCallState));
+      m_terrainMeshBBOXes.push_back(worldAABB);
     }
   }
 
@@ -1083,6 +1293,7 @@ namespace dxvk {
     m_bakingParams.cascadeMapSize.y = static_cast<uint32_t>(ceilf(static_cast<float>(m_bakingParams.numCascades) / m_bakingParams.cascadeMapSize.x));
 
     m_bakingParams.bakingCameraOrthoProjection.resize(m_bakingParams.numCascades);
+    m_bakingParams.worldToCascadeClip.resize(m_bakingParams.numCascades);
 
     // Calculate cascade map resolution
     calculateCascadeMapResolution(ctx->getDevice());
@@ -1133,6 +1344,8 @@ namespace dxvk {
       float4x4& newProjection = *reinterpret_cast<float4x4*>(&m_bakingParams.bakingCameraOrthoProjection[iCascade]);
       newProjection.SetupByOrthoProjection(-halfWidth, halfWidth, -halfWidth, halfWidth, zNear, zFar);
 
+      m_bakingParams.worldToCascadeClip[iCascade] = m_bakingParams.bakingCameraOrthoProjection[iCascade] * sceneView;
+
       if (iCascade == 0) {
         // Convert from clip space <-1, 1> to <0, 1> and flip y coordinate for Vulkan
         const Matrix4 textureOffset = Matrix4(Vector4(.5f, 0, 0, 0),
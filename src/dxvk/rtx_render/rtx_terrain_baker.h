@@ -25,6 +25,7 @@
 #include "rtx_geometry_utils.h"
 #include "rtx_resources.h"
 #include "rtx_mipmap.h"
+#include "rtx_terrain_tile_map.h"
 
 namespace dxvk {
 
@@ -59,7 +60,10 @@ namespace dxvk {
                                                               "Only use this system if the game renders terrain surfaces with multiple blended surfaces on top of each other (i.e. sand mixed with dirt, grass, snow, etc.).\n"
                                                               "Requirement: the baked terrain surfaces must not be placed vertically in the game world. Horizontal surfaces will have the best image quality. Requires \"rtx.zUp\" to be set properly.");
 
-    RTX_OPTION("rtx.terrainBaker", bool, clearTerrainBeforeBaking, false, "Performs a clear on the terrain texture before it is baked to in a frame.");
+    RTX_OPTION("rtx.terrainBaker", bool, clearTerrainBeforeBaking, false, "Performs a clear on the terrain texture before it is baked to in a frame.\n"
+                                                                         "With incremental baking enabled only the tiles being rebaked are cleared.");
+    RTX_OPTION("rtx.terrainBaker", bool, enableIncrementalBaking, true, "Only rebakes the tiles of cascade levels whose baking parameters or contributing draw calls changed since they were last baked.\n"
+                                                                        "Changes to the contributing draw calls are picked up with a frame of delay. When disabled, all cascade levels are rebaked every frame.");
     RTX_OPTION("rtx.terrainBaker", bool, debugDisableBaking , false, "Force disables rebaking every frame. Used for debugging only.")
     RTX_OPTION("rtx.terrainBaker", bool, debugDisableBinding, false, "Force disables binding of the baked terrain texture to the terrain meshes. Used for debugging only.");
 
@@ -123,6 +127,7 @@ namespace dxvk {
       RTX_OPTION("rtx.terrainBaker.cascadeMap", float, levelHalfWidth, 10.f, "First cascade level square's half width around the camera [meters].");
       RTX_OPTION_ENV("rtx.terrainBaker.cascadeMap", uint32_t, maxLevels, 8, "RTX_TERRAIN_BAKER_MAX_CASCADE_LEVELS", "Max number of cascade levels.");
       RTX_OPTION_ENV("rtx.terrainBaker.cascadeMap", uint32_t, levelResolution, 4096, "RTX_TERRAIN_BAKER_LEVEL_RESOLUTION", "Texture resolution per cascade level.");
+      RTX_OPTION("rtx.terrainBaker.cascadeMap", uint32_t, tilesPerLevelSide, 8, "Number of tiles along each side of a cascade level. Tiles are the granularity at which cascade levels are rebaked with incremental baking enabled.");
       RTX_OPTION("rtx.terrainBaker.cascadeMap", bool, expandLastCascade, true, 
                  "Expands the last cascade's footprint to cover the whole cascade map.\n"
                  "This ensures whole terrain surface has valid baked texture data to sample from\n"
@@ -141,6 +146,7 @@ namespace dxvk {
       Matrix4 sceneView;  // View matrix for a camera looking along scene's forward axis
       Matrix4 inverseSceneView;
       std::vector<Matrix4> bakingCameraOrthoProjection;  // Ortho projections to bake for all cascades
+      std::vector<Matrix4> worldToCascadeClip;  // Baking view projections for all cascades
       Matrix4 viewToCascade0TextureSpace; // Matrix transforming viwe coordinates to 1st cascade texture space
       float zNear;
       float zFar;
@@ -148,15 +154,21 @@ namespace dxvk {
       uint32_t frameIndex = kInvalidFrameIndex;  // Frame index for which the parameters have been calculated
     };
     bool gatherAndPreprocessReplacementTextures(Rc<RtxContext> ctx, const DrawCallState& drawCallState, OpaqueMaterialData* replacementMaterial, std::vector<RtxGeometryUtils::TextureConversionInfo>& replacementTextures);
+    XXH64_hash_t trackReplacementTextures(Rc<RtxContext> ctx, const DrawCallState& drawCallState, OpaqueMaterialData* replacementMaterial, XXH64_hash_t hash);
     void updateMaterialData(Rc<RtxContext> ctx);
     void onFrameBegin(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState);
-    void registerTerrainMesh(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState, const DrawCallState& drawCallState);
+    void registerTerrainMesh(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState, const AxisAlignedBoundingBox& worldAABB);
     void calculateTerrainBBOX(const uint32_t currentFrameIndex);
     void calculateBakingParameters(Rc<RtxContext> ctx, const DxvkContextState& dxvkCtxState);
     void updateTextureFormat(const DxvkContextState& dxvkCtxState);
     void calculateCascadeMapResolution(const Rc<DxvkDevice>& device);
     const RtxMipmap::Resource& getTerrainTexture(Rc<DxvkContext> ctx, RtxTextureManager& textureManager, ReplacementMaterialTextureType::Enum textureType, uint32_t width, uint32_t height);
     void clearMaterialTexture(Rc<DxvkContext> ctx, ReplacementMaterialTextureType::Enum textureType);
+    void clearDirtyTiles(Rc<DxvkContext> ctx);
+    void updateTileMap();
+    VkRect2D calculateTileScissor(uint32_t iCascade, const TerrainTileMap::TileRect& rect) const;
+    template<typename Func>
+    void forEachDirtyTileRun(uint32_t iCascade, const TerrainTileMap::TileRect& rect, const Func& func) const;
     static bool isPSReplacementSupportEnabled(const DrawCallState& drawCallState);
 
     BakingParameters m_bakingParams;
@@ -177,17 +189,13 @@ namespace dxvk {
 
     VkFormat m_terrainRtColorFormat = VK_FORMAT_UNDEFINED;
 
-    class AxisAlignedBoundingBoxLink {
-    public:
-      AxisAlignedBoundingBoxLink(const DrawCallState& drawCallState);
-      AxisAlignedBoundingBox calculateAABBInWorldSpace();
+    // World space BBOXes of the terrain meshes registered this frame
+    std::vector<AxisAlignedBoundingBox> m_terrainMeshBBOXes;
 
-    private:
-      const AxisAlignedBoundingBox aabbObjectSpace;
-      const Matrix4 objectToWorld;
-    };
+    TerrainTileMap m_tileMap;
 
-    std::list<AxisAlignedBoundingBoxLink> m_terrainMeshBBOXes;
+    // Tiles covered by the draw call being baked, per cascade level
+    std::vector<TerrainTileMap::TileRect> m_drawTileRects;
 
     // Terrain BBOX found during previous frame
     AxisAlignedBoundingBox m_bakedTerrainBBOX = {
@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "rtx_terrain_tile_map.h"
+
+namespace dxvk {
+
+  void TerrainTileMap::beginFrame(uint32_t numCascades, uint32_t tilesPerSide, const XXH64_hash_t* cascadeHashes, bool forceRebake) {
+    const bool layoutChanged = numCascades != m_cascadeHashes.size() || tilesPerSide != m_tilesPerSide;
+
+    if (layoutChanged) {
+      m_tilesPerSide = tilesPerSide;
+      m_tiles.assign(static_cast<size_t>(numCascades) * tilesPerSide * tilesPerSide, Tile());
+      m_cascadeHashes.assign(numCascades, kEmptyHash);
+    }
+
+    m_numDirtyTiles = 0;
+
+    for (uint32_t iCascade = 0; iCascade < numCascades; iCascade++) {
+      const bool cascadeChanged = forceRebake || layoutChanged || cascadeHashes[iCascade] != m_cascadeHashes[iCascade];
+      m_cascadeHashes[iCascade] = cascadeHashes[iCascade];
+
+      Tile* tiles = &m_tiles[tileIndex(iCascade, 0, 0)];
+      for (uint32_t i = 0; i < tilesPerSide * tilesPerSide; i++) {
+        tiles[i].dirty |= cascadeChanged;
+        tiles[i].contentHash = cascadeHashes[iCascade];
+        m_numDirtyTiles += tiles[i].dirty ? 1 : 0;
+      }
+    }
+  }
+
+  TerrainTileMap::TileRect TerrainTileMap::calculateTileRect(const AxisAlignedBoundingBox& worldAABB, const Matrix4& worldToCascadeClip) const {
+    const TileRect wholeLevel { 0, 0, m_tilesPerSide, m_tilesPerSide };
+
+    if (!worldAABB.isValid()) {
+      return wholeLevel;
+    }
+
+    // Note: baking projections are orthographic so no perspective divide is needed
+    const AxisAlignedBoundingBox clipAABB = worldAABB.getTransformed(worldToCascadeClip);
+
+    // Expands the footprint slightly to cover for precision differences with the rasterizer
+    const float epsilon = 1e-3f;
+
+    // Convert to <0, 1> texture space, which has its y axis flipped compared to clip space
+    const float minU = clipAABB.minPos.x * 0.5f + 0.5f - epsilon;
+    const float maxU = clipAABB.maxPos.x * 0.5f + 0.5f + epsilon;
+    const float minV = 0.5f - clipAABB.maxPos.y * 0.5f - epsilon;
+    const float maxV = 0.5f - clipAABB.minPos.y * 0.5f + epsilon;
+
+    if (!std::isfinite(minU) || !std::isfinite(maxU) || !std::isfinite(minV) || !std::isfinite(maxV)) {
+      return wholeLevel;
+    }
+
+    if (maxU < 0.f || minU > 1.f || maxV < 0.f || minV > 1.f) {
+      return TileRect();
+    }
+
+    auto toTile = [&](float t) {
+      return std::min(static_cast<uint32_t>(std::max(t, 0.f) * m_tilesPerSide), m_tilesPerSide - 1);
+    };
+
+    return TileRect { toTile(minU), toTile(minV), toTile(maxU) + 1, toTile(maxV) + 1 };
+  }
+
+  void TerrainTileMap::addContributor(uint32_t cascade, const TileRect& rect, XXH64_hash_t contributorHash) {
+    for (uint32_t y = rect.beginY; y < rect.endY; y++) {
+      for (uint32_t x = rect.beginX; x < rect.endX; x++) {
+        Tile& tile = m_tiles[tileIndex(cascade, x, y)];
+        tile.contentHash = XXH64(&contributorHash, sizeof(contributorHash), tile.contentHash);
+      }
+    }
+  }
+
+  bool TerrainTileMap::isEntirelyDirty(uint32_t cascade, const TileRect& rect) const {
+    for (uint32_t y = rect.beginY; y < rect.endY; y++) {
+      for (uint32_t x = rect.beginX; x < rect.endX; x++) {
+        if (!m_tiles[tileIndex(cascade, x, y)].dirty) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool TerrainTileMap::hasDirtyTiles(uint32_t cascade, const TileRect& rect) const {
+    for (uint32_t y = rect.beginY; y < rect.endY; y++) {
+      for (uint32_t x = rect.beginX; x < rect.endX; x++) {
+        if (m_tiles[tileIndex(cascade, x, y)].dirty) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void TerrainTileMap::endFrame() {
+    for (Tile& tile : m_tiles) {
+      // Dirty tiles were rasterized by all of this frame's contributors
+      if (tile.dirty) {
+        tile.bakedHash = tile.contentHash;
+      }
+
+      tile.dirty = m_invalidated || tile.contentHash != tile.bakedHash;
+    }
+
+    m_invalidated = false;
+  }
+}
@@ -0,0 +1,112 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+
+#include "rtx_types.h"
+
+namespace dxvk {
+
+  // Tracks which parts of the terrain baker's cascade levels need to be rebaked.
+  //
+  // Every cascade level is split into a grid of tiles. A tile's content hash combines its cascade's
+  // baking parameters with the hashes of all draw calls overlapping it, in submission order, since
+  // blending makes the baked result order dependent. A tile is dirty, i.e. rasterized into, when its
+  // cascade's baking parameters changed or its content hash differs from the one it was last baked
+  // with. Draw calls contributing to a frame are only known at its end, so changes to them are picked
+  // up by the following frame, while changes to baking parameters apply right away.
+  class TerrainTileMap {
+  public:
+    // Range of tiles [begin, end) of a cascade level along both axes
+    struct TileRect {
+      uint32_t beginX = 0;
+      uint32_t beginY = 0;
+      uint32_t endX = 0;
+      uint32_t endY = 0;
+
+      bool isEmpty() const {
+        return beginX >= endX || beginY >= endY;
+      }
+    };
+
+    // Starts a new frame with a layout of numCascades levels of tilesPerSide x tilesPerSide tiles.
+    // Cascades whose parameters hash changed, or all of them when the layout changed or forceRebake
+    // is set, are rebaked entirely.
+    void beginFrame(uint32_t numCascades, uint32_t tilesPerSide, const XXH64_hash_t* cascadeHashes, bool forceRebake);
+
+    // Returns the tiles of a cascade level covered by a world space box. worldToCascadeClip maps the
+    // level's footprint to <-1, 1> in x and y. Invalid boxes conservatively cover the whole level.
+    TileRect calculateTileRect(const AxisAlignedBoundingBox& worldAABB, const Matrix4& worldToCascadeClip) const;
+
+    // Registers a draw call rasterized into the given tiles of a cascade level this frame
+    void addContributor(uint32_t cascade, const TileRect& rect, XXH64_hash_t contributorHash);
+
+    // Forces all tiles to be rebaked next frame, i.e. when baked textures were recreated mid frame
+    void invalidate() {
+      m_invalidated = true;
+    }
+
+    // Records the tiles rebaked this frame as up to date and finds the tiles to rebake next frame
+    void endFrame();
+
+    bool isDirty(uint32_t cascade, uint32_t x, uint32_t y) const {
+      return m_tiles[tileIndex(cascade, x, y)].dirty;
+    }
+
+    // Returns true if all tiles in the rect are dirty
+    bool isEntirelyDirty(uint32_t cascade, const TileRect& rect) const;
+
+    // Returns true if any tile in the rect is dirty
+    bool hasDirtyTiles(uint32_t cascade, const TileRect& rect) const;
+
+    uint32_t getNumDirtyTiles() const {
+      return m_numDirtyTiles;
+    }
+
+    uint32_t getNumTiles() const {
+      return static_cast<uint32_t>(m_tiles.size());
+    }
+
+    uint32_t getTilesPerSide() const {
+      return m_tilesPerSide;
+    }
+
+  private:
+    struct Tile {
+      XXH64_hash_t contentHash = kEmptyHash;
+      XXH64_hash_t bakedHash = kEmptyHash;
+      bool dirty = true;
+    };
+
+    size_t tileIndex(uint32_t cascade, uint32_t x, uint32_t y) const {
+      return (static_cast<size_t>(cascade) * m_tilesPerSide + y) * m_tilesPerSide + x;
+    }
+
+    // Tiles of all cascade levels, level by level in row major order
+    std::vector<Tile> m_tiles;
+    std::vector<XXH64_hash_t> m_cascadeHashes;
+    uint32_t m_tilesPerSide = 0;
+    uint32_t m_numDirtyTiles = 0;
+    bool m_invalidated = false;
+  };
+}
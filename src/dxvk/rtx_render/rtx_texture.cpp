@@ -28,6 +28,7 @@
 #include "dxvk_device.h"
 #include "rtx_io.h"
 #include "rtx_texture_manager.h"
+#include "../util/log/metrics.h"
 
 namespace dxvk {
 
@@ -221,6 +222,9 @@ namespace dxvk {
         levelExtent,
         assetData.data(0, level),
         rowPitch, layerPitch);
+
+      static MetricCounter& s_uploadBytes = Metrics::counter("texture.upload_bytes");
+      s_uploadBytes.add(uint64_t(layerPitch) * levelExtent.depth * assetInfo.numLayers);
     }
 
     // Make DxvkImageView
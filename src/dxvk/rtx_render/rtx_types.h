@@ -146,6 +146,24 @@ struct AxisAlignedBoundingBox {
     }
   }
 
+  // returns a box enclosing all 8 transformed corners, or an invalid box if this AABB is invalid
+  AxisAlignedBoundingBox getTransformed(const Matrix4& transform) const {
+    AxisAlignedBoundingBox transformed;
+    if (!isValid()) {
+      return transformed;
+    }
+
+    for (uint32_t i = 0; i < 8; i++) {
+      const Vector3 corner {
+        (i & 1) ? maxPos.x : minPos.x,
+        (i & 2) ? maxPos.y : minPos.y,
+        (i & 4) ? maxPos.z : minPos.z };
+      const Vector3 position = (transform * Vector4(corner, 1.0f)).xyz();
+      transformed.unionWith({ position, position });
+    }
+    return transformed;
+  }
+
   const XXH64_hash_t calculateHash() const {
     return XXH3_64bits(this, sizeof(AxisAlignedBoundingBox));
   }
@@ -514,6 +532,7 @@ private:
   friend struct D3D9Rtx;
   friend class TerrainBaker;
   friend struct RemixAPIPrivateAccessor;
+  friend struct DrawCallTrace;
 
   bool finalizeGeometryHashes();
   void finalizeGeometryBoundingBox();
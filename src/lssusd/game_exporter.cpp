@@ -67,8 +67,11 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -191,16 +194,43 @@ std::string getExtension(std::filesystem::path path) {
   return path.extension().generic_string();
 }
 
+namespace {
+// Logs the wall time spent in an export stage on destruction
+class StageTimer {
+public:
+  StageTimer(const std::string& debugId, const char* stageName)
+    : m_debugId(debugId)
+    , m_stageName(stageName)
+    , m_start(std::chrono::steady_clock::now()) { }
+
+  ~StageTimer() {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start);
+    dxvk::Logger::info(dxvk::str::format("[GameExporter][", m_debugId, "] ", m_stageName, " took ", elapsed.count(), " ms"));
+  }
+
+private:
+  const std::string& m_debugId;
+  const char* m_stageName;
+  const std::chrono::steady_clock::time_point m_start;
+};
+}
+
 void GameExporter::exportUsdInternal(const Export& exportData) {
   dxvk::Logger::info("[GameExporter][" + exportData.debugId + "] Export start");
+  StageTimer exportTimer(exportData.debugId, "Export");
   ExportContext ctx;
   lss::GameExporter::createApertureMdls(exportData.baseExportPath);
   ctx.instanceStage = (exportData.bExportInstanceStage) ? createInstanceStage(exportData) : pxr::UsdStageRefPtr();
   ctx.extension = (exportData.bExportInstanceStage) ? getExtension(exportData.instanceStagePath) : lss::ext::usd;
-  exportMaterials(exportData, ctx);
-  exportMeshes(exportData, ctx);
-  exportSkeletons(exportData, ctx);
+  {
+    StageTimer layersTimer(exportData.debugId, "Material, mesh and skeleton layers");
+    exportLayers(exportData, ctx);
+  }
   if(ctx.instanceStage) {
+    StageTimer instanceStageTimer(exportData.debugId, "Instance stage");
+    instanceMaterials(exportData, ctx);
+    instanceMeshes(exportData, ctx);
+    instanceSkeletons(exportData, ctx);
     exportCamera(exportData, ctx);
     exportSphereLights(exportData, ctx);
     exportDistantLights(exportData, ctx);
@@ -214,6 +244,79 @@ void GameExporter::exportUsdInternal(const Export& exportData) {
   dxvk::Logger::info("[GameExporter][" + exportData.debugId + "] Export end");
 }
 
+void GameExporter::exportLayers(const Export& exportData, ExportContext& ctx) {
+  // Every material, mesh and skeleton is written to its own layer, so these are exported concurrently.
+  // The instance stage is only composed afterwards, since it references all of them.
+  dxvk::env::createDirectory(exportData.baseExportPath + "/" + commonDirName::matDir);
+  dxvk::env::createDirectory(exportData.baseExportPath + "/" + commonDirName::meshDir + "/");
+  dxvk::env::createDirectory(exportData.baseExportPath + "/" + commonDirName::skeletonDir + "/");
+
+  // All context entries are created up front, jobs only ever write to their own entry.
+  for(const auto& [matId, matData] : exportData.materials) {
+    ctx.matReferences[matId] = getMaterialReference(exportData, ctx, matData);
+  }
+  for(const auto& [meshId, mesh] : exportData.meshes) {
+    ctx.meshReferences[meshId] = Reference();
+    if (mesh.numBones > 0) {
+      ctx.skeletons[meshId] = Skeleton();
+    }
+  }
+
+  // Mesh layers reference material layers, and authoring a reference composes (and opens) the target layer.
+  // SdfLayers must not be read while another job is still writing them, so all material layers are
+  // written in a first phase, and mesh and skeleton layers in a second one.
+  std::vector<std::function<void()>> matJobs;
+  matJobs.reserve(exportData.materials.size());
+  for(const auto& [matId, matData] : exportData.materials) {
+    matJobs.emplace_back([&exportData, &ctx, pMatData = &matData, pMatReference = &ctx.matReferences.at(matId)]() {
+      exportMaterial(exportData, ctx, *pMatData, *pMatReference);
+    });
+  }
+
+  std::vector<std::function<void()>> meshAndSkelJobs;
+  meshAndSkelJobs.reserve(exportData.meshes.size() * 2);
+
+  // Start with the heaviest meshes so they don't end up as the long pole
+  std::vector<std::pair<const Mesh*, Reference*>> meshJobs;
+  meshJobs.reserve(exportData.meshes.size());
+  for(const auto& [meshId, mesh] : exportData.meshes) {
+    meshJobs.emplace_back(&mesh, &ctx.meshReferences.at(meshId));
+  }
+  const auto meshCost = [](const Mesh* mesh) {
+    return static_cast<size_t>(mesh->numVertices) * std::max<size_t>(mesh->buffers.positionBufs.size(), 1);
+  };
+  std::sort(meshJobs.begin(), meshJobs.end(), [&meshCost](const auto& a, const auto& b) {
+    return meshCost(a.first) > meshCost(b.first);
+  });
+  for(const auto& [pMesh, pMeshReference] : meshJobs) {
+    meshAndSkelJobs.emplace_back([&exportData, &ctx, pMesh = pMesh, pMeshReference = pMeshReference]() {
+      exportMesh(exportData, ctx, *pMesh, *pMeshReference);
+    });
+  }
+  for(const auto& [meshId, mesh] : exportData.meshes) {
+    if (mesh.numBones > 0) {
+      meshAndSkelJobs.emplace_back([&exportData, &ctx, pMesh = &mesh, pSkeleton = &ctx.skeletons.at(meshId)]() {
+        exportSkeleton(exportData, ctx, *pMesh, *pSkeleton);
+      });
+    }
+  }
+
+  // Report progress in 10% steps across both phases
+  const size_t numJobs = matJobs.size() + meshAndSkelJobs.size();
+  std::atomic<size_t> numJobsDone = 0;
+  const auto runPhase = [&](std::vector<std::function<void()>>& jobs) {
+    parallelFor(jobs.size(), [&](const size_t i) {
+      jobs[i]();
+      const size_t done = ++numJobsDone;
+      if ((done * 10) / numJobs != ((done - 1) * 10) / numJobs) {
+        dxvk::Logger::info(dxvk::str::format("[GameExporter][", exportData.debugId, "] Exported ", done, "/", numJobs, " layers"));
+      }
+    });
+  };
+  runPhase(matJobs);
+  runPhase(meshAndSkelJobs);
+}
+
 pxr::UsdStageRefPtr GameExporter::createInstanceStage(const Export& exportData) {
   assert(exportData.bExportInstanceStage);
   pxr::UsdStageRefPtr instanceStage = pxr::UsdStage::CreateNew(exportData.instanceStagePath);
@@ -337,452 +440,450 @@ static std::unordered_map<Enum,AttrDesc> attrDescs{
 }
 }
 
-void GameExporter::exportMaterials(const Export& exportData, ExportContext& ctx) {
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportMaterials] Begin");
+GameExporter::Reference GameExporter::getMaterialReference(const Export& exportData, const ExportContext& ctx, const Material& matData) {
+  const std::string matName = prefix::mat + matData.matName;
+  Reference matLssReference;
+  matLssReference.stagePath = exportData.baseExportPath + "/" + commonDirName::matDir + matName + ctx.extension;
+  matLssReference.ogSdfPath = gStageRootPath.AppendChild(gTokLooks).AppendElementString(matName);
+  return matLssReference;
+}
+
+void GameExporter::exportMaterial(const Export& exportData, const ExportContext& ctx, const Material& matData, const Reference& matLssReference) {
   const std::string matDirPath = exportData.baseExportPath + "/" + commonDirName::matDir;
   const std::string fullMaterialBasePath = computeLocalPath(matDirPath);
-  
-  dxvk::env::createDirectory(matDirPath);
-  for(const auto& [matId, matData] : exportData.materials) {
-    // Build material stage
-    const std::string matName = prefix::mat + matData.matName;
-    const std::string matStageName = matName + ctx.extension;
-    const std::string matStagePath = matDirPath + matStageName;
-    pxr::UsdStageRefPtr matStage = findOpenOrCreateStage(matStagePath, true);
-    assert(matStage);
-    setCommonStageMetaData(matStage, exportData);
-
-    // Add Looks + RootPrim prims
-    const auto looksSdfPath = gStageRootPath.AppendChild(gTokLooks);
-    const auto looksScopePrim = matStage->DefinePrim(looksSdfPath, gTokScope);
-    assert(looksScopePrim);
-    matStage->SetDefaultPrim(looksScopePrim);
-
-    // Create material prim
-    const auto matSdfPath = looksSdfPath.AppendElementString(matName);
-    const auto matSchema = pxr::UsdShadeMaterial::Define(matStage, matSdfPath);
-    assert(matSchema);
-    const auto matPrim = matSchema.GetPrim();
-    assert(matPrim);
-
-    // Create shader prim under material prim
-    static const pxr::TfToken kTokShader("Shader");
-    const auto shaderPath = matPrim.GetPath().AppendChild(kTokShader);
-    const auto shader = pxr::UsdShadeShader::Define(matStage, shaderPath);
-    const auto shaderPrim = shader.GetPrim();
-    assert(shaderPrim);
-
-    std::unordered_map<ShaderAttr::Enum, pxr::UsdAttribute> shaderAttrs;
-    for(const auto& [attrEnum, desc] : ShaderAttr::attrDescs) {
-      shaderAttrs[attrEnum] =
-        shaderPrim.CreateAttribute(desc.attrName, desc.typeName, desc.custom, desc.sdfVariability);
-      // Cannot assert. Attr "outputs:out" asserts false, but authoring + Setting works just fine.
-      // assert(shaderAttrs[attrEnum]); 
-    }
+  // Build material stage
+  const std::string& matStagePath = matLssReference.stagePath;
+  pxr::UsdStageRefPtr matStage = findOpenOrCreateStage(matStagePath, true);
+  assert(matStage);
+  setCommonStageMetaData(matStage, exportData);
+
+  // Add Looks + RootPrim prims
+  const auto looksSdfPath = gStageRootPath.AppendChild(gTokLooks);
+  const auto looksScopePrim = matStage->DefinePrim(looksSdfPath, gTokScope);
+  assert(looksScopePrim);
+  matStage->SetDefaultPrim(looksScopePrim);
+
+  // Create material prim
+  const auto& matSdfPath = matLssReference.ogSdfPath;
+  const auto matSchema = pxr::UsdShadeMaterial::Define(matStage, matSdfPath);
+  assert(matSchema);
+  const auto matPrim = matSchema.GetPrim();
+  assert(matPrim);
+
+  // Create shader prim under material prim
+  static const pxr::TfToken kTokShader("Shader");
+  const auto shaderPath = matPrim.GetPath().AppendChild(kTokShader);
+  const auto shader = pxr::UsdShadeShader::Define(matStage, shaderPath);
+  const auto shaderPrim = shader.GetPrim();
+  assert(shaderPrim);
+
+  std::unordered_map<ShaderAttr::Enum, pxr::UsdAttribute> shaderAttrs;
+  for(const auto& [attrEnum, desc] : ShaderAttr::attrDescs) {
+    shaderAttrs[attrEnum] =
+      shaderPrim.CreateAttribute(desc.attrName, desc.typeName, desc.custom, desc.sdfVariability);
+    // Cannot assert. Attr "outputs:out" asserts false, but authoring + Setting works just fine.
+    // assert(shaderAttrs[attrEnum]); 
+  }
 
-    // Create and connect material outputs to shader outputs
-    static const pxr::TfToken kTokOutputsMdlSurface("outputs:mdl:surface");
-    const auto outputsMdlSurfaceAttr =
-      matPrim.CreateAttribute(kTokOutputsMdlSurface, pxr::SdfValueTypeNames->Token, false, pxr::SdfVariabilityVarying);
-    outputsMdlSurfaceAttr.AddConnection(shaderAttrs[ShaderAttr::OutputsOut].GetPath(), pxr::UsdListPositionFrontOfAppendList);
+  // Create and connect material outputs to shader outputs
+  static const pxr::TfToken kTokOutputsMdlSurface("outputs:mdl:surface");
+  const auto outputsMdlSurfaceAttr =
+    matPrim.CreateAttribute(kTokOutputsMdlSurface, pxr::SdfValueTypeNames->Token, false, pxr::SdfVariabilityVarying);
+  outputsMdlSurfaceAttr.AddConnection(shaderAttrs[ShaderAttr::OutputsOut].GetPath(), pxr::UsdListPositionFrontOfAppendList);
 
-    // Set shader "Kind"
-    static const pxr::TfToken kTokMaterial("Material");
-    pxr::UsdModelAPI(shader).SetKind(kTokMaterial);
+  // Set shader "Kind"
+  static const pxr::TfToken kTokMaterial("Material");
+  pxr::UsdModelAPI(shader).SetKind(kTokMaterial);
 
-    // Create and set textures asset paths on material
-    const auto relToMaterialsTexPath =
-      std::filesystem::relative(computeLocalPath(matData.albedoTexPath), fullMaterialBasePath).string();
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::DiffuseTex].Set(pxr::SdfAssetPath(relToMaterialsTexPath)));
-    shaderAttrs[ShaderAttr::DiffuseTex].SetColorSpace(pxr::TfToken("auto"));
+  // Create and set textures asset paths on material
+  const auto relToMaterialsTexPath =
+    std::filesystem::relative(computeLocalPath(matData.albedoTexPath), fullMaterialBasePath).string();
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::DiffuseTex].Set(pxr::SdfAssetPath(relToMaterialsTexPath)));
+  shaderAttrs[ShaderAttr::DiffuseTex].SetColorSpace(pxr::TfToken("auto"));
 
-    // Create and set OmniPBR MDL boilerplate attributes on shader
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::ImplSrc].Set(pxr::TfToken("sourceAsset")));
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::MdlSrcAsset].Set(pxr::SdfAssetPath("./AperturePBR_Opacity.mdl")));
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::MdlSrcAssetSubId].Set(pxr::TfToken("AperturePBR_Opacity")));
+  // Create and set OmniPBR MDL boilerplate attributes on shader
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::ImplSrc].Set(pxr::TfToken("sourceAsset")));
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::MdlSrcAsset].Set(pxr::SdfAssetPath("./AperturePBR_Opacity.mdl")));
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::MdlSrcAssetSubId].Set(pxr::TfToken("AperturePBR_Opacity")));
 
-    // Mark whether to enable varying opacity
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::Opacity].Set(matData.enableOpacity));
+  // Mark whether to enable varying opacity
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::Opacity].Set(matData.enableOpacity));
 
-    // Sampler State
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::FilterMode].Set((uint32_t)lss::Mdl::Filter::vkToMdl(matData.sampler.filter)));
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::WrapModeU].Set((uint32_t)lss::Mdl::WrapMode::vkToMdl(matData.sampler.addrModeU)));
-    ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::WrapModeV].Set((uint32_t)lss::Mdl::WrapMode::vkToMdl(matData.sampler.addrModeV)));
+  // Sampler State
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::FilterMode].Set((uint32_t)lss::Mdl::Filter::vkToMdl(matData.sampler.filter)));
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::WrapModeU].Set((uint32_t)lss::Mdl::WrapMode::vkToMdl(matData.sampler.addrModeU)));
+  ASSERT_OR_EXECUTE(shaderAttrs[ShaderAttr::WrapModeV].Set((uint32_t)lss::Mdl::WrapMode::vkToMdl(matData.sampler.addrModeV)));
 
-    matStage->Save();
-    
-    // Cache material reference
-    Reference matLssReference;
-    matLssReference.stagePath = matStagePath;
-    matLssReference.ogSdfPath = matSdfPath;
+  matStage->Save();
+}
 
+void GameExporter::instanceMaterials(const Export& exportData, ExportContext& ctx) {
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceMaterials] Begin");
+  for(const auto& [matId, matData] : exportData.materials) {
     // Build matSchema prim on instance stage
-    if(ctx.instanceStage != nullptr) {
-      const auto matInstanceSdfPath = gRootMaterialsPath.AppendElementString(matName);
-      auto matInstanceSchema = pxr::UsdShadeMaterial::Define(ctx.instanceStage, matInstanceSdfPath);
-      assert(matInstanceSchema);
-      
-      const std::string relMeshStagePath = commonDirName::matDir + matName + ctx.extension;
-      auto matInstanceUsdReferences = matInstanceSchema.GetPrim().GetReferences();
-      matInstanceUsdReferences.AddReference(relMeshStagePath, matSdfPath);
-      
-      matLssReference.instanceSdfPath = matInstanceSdfPath;
-    }
-
-    ctx.matReferences[matId] = matLssReference;
+    Reference& matLssReference = ctx.matReferences.at(matId);
+    const std::string matName = prefix::mat + matData.matName;
+    const auto matInstanceSdfPath = gRootMaterialsPath.AppendElementString(matName);
+    auto matInstanceSchema = pxr::UsdShadeMaterial::Define(ctx.instanceStage, matInstanceSdfPath);
+    assert(matInstanceSchema);
+    
+    const std::string relMeshStagePath = commonDirName::matDir + matName + ctx.extension;
+    auto matInstanceUsdReferences = matInstanceSchema.GetPrim().GetReferences();
+    matInstanceUsdReferences.AddReference(relMeshStagePath, matLssReference.ogSdfPath);
+    
+    matLssReference.instanceSdfPath = matInstanceSdfPath;
   }
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportMaterials] End");
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceMaterials] End");
 }
 
-void GameExporter::exportSkeletons(const Export& exportData, ExportContext& ctx) {
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportSkeletons] Begin");
-  static const pxr::GfMatrix4d identity(1);
+void GameExporter::exportSkeleton(const Export& exportData, const ExportContext& ctx, const Mesh& mesh, Skeleton& skeleton) {
+  assert(mesh.numBones > 0);
   const std::string relDirPath = commonDirName::skeletonDir + "/";
   const std::string dirPath = exportData.baseExportPath + "/" + relDirPath;
-  const std::string fullStagePath = computeLocalPath(dirPath);
-  dxvk::env::createDirectory(dirPath);
+  // Build skeleton stage
+  const std::string name = prefix::skeleton + mesh.meshName;
+  const std::string stagePath = dirPath + name + ctx.extension;
+  pxr::UsdStageRefPtr stage = findOpenOrCreateStage(stagePath, true);
+  assert(stage);
+  setCommonStageMetaData(stage, exportData);
+
+  pxr::VtDictionary customLayerData = stage->GetRootLayer()->GetCustomLayerData();
+  for (auto& component : mesh.componentHashes) {
+    customLayerData.SetValueAtPath(component.first, pxr::VtValue(component.second));
+  }
+  stage->GetRootLayer()->SetCustomLayerData(customLayerData);
+
+  // Build skel root prim on stage
+  const auto defaultPrimPath = gStageRootPath.AppendElementString(name);
+  pxr::UsdSkelRoot skelRootSchema = pxr::UsdSkelRoot::Define(stage, defaultPrimPath);
+
+  assert(skelRootSchema);
+  stage->SetDefaultPrim(skelRootSchema.GetPrim());
+
+  // Build skeleton prim under above xform
+  const auto skeletonSdfPath = defaultPrimPath.AppendChild(gTokSkel);
+  auto skelSchema = pxr::UsdSkelSkeleton::Define(stage, skeletonSdfPath);
+  assert(skelSchema);
+
+
+  // Set bindTransforms attribute
+  auto bindTransformsAttr = skelSchema.CreateBindTransformsAttr();
+  assert(bindTransformsAttr);
+  skeleton = generateSkeleton(mesh.numBones,
+                              mesh.bonesPerVertex,
+                              mesh.buffers.positionBufs.begin()->second,
+                              mesh.buffers.blendWeightBufs.empty() ? nullptr : &mesh.buffers.blendWeightBufs.begin()->second,
+                              mesh.buffers.blendIndicesBufs.empty() ? nullptr : &mesh.buffers.blendIndicesBufs.begin()->second);
+  const Skeleton& skel = skeleton;
+  // pxr::VtMatrix4dArray identities(mesh.numBones, pxr::GfMatrix4d(1));
+  bindTransformsAttr.Set(skel.bindPose);
+
+  // Set restTransforms attribute
+  auto restTransformsAttr = skelSchema.CreateRestTransformsAttr();
+  assert(restTransformsAttr);
+  restTransformsAttr.Set(skel.restPose);
+
+  // Set joints attribute on both the skeleton and the pose
+  auto jointsAttr = skelSchema.CreateJointsAttr();
+  assert(jointsAttr);
+  jointsAttr.Set(skel.jointNames);
+
+  stage->Save();
+}
+
+void GameExporter::instanceSkeletons(const Export& exportData, ExportContext& ctx) {
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceSkeletons] Begin");
+  const std::string relDirPath = commonDirName::skeletonDir + "/";
   for (const auto& [meshId, mesh] : exportData.meshes) {
     if (mesh.numBones == 0) {
       continue;
     }
 
-    // Build skeleton stage
-    const std::string name = prefix::skeleton + mesh.meshName;
-    const std::string stagePath = dirPath + name + ctx.extension;
-    pxr::UsdStageRefPtr stage = findOpenOrCreateStage(stagePath, true);
-    assert(stage);
-    setCommonStageMetaData(stage, exportData);
-
-    pxr::VtDictionary customLayerData = stage->GetRootLayer()->GetCustomLayerData();
-    for (auto& component : mesh.componentHashes) {
-      customLayerData.SetValueAtPath(component.first, pxr::VtValue(component.second));
-    }
-    stage->GetRootLayer()->SetCustomLayerData(customLayerData);
-
-    // Build skel root prim on stage
-    const auto defaultPrimPath = gStageRootPath.AppendElementString(name);
-    pxr::UsdSkelRoot skelRootSchema = pxr::UsdSkelRoot::Define(stage, defaultPrimPath);
-
-    assert(skelRootSchema);
-    stage->SetDefaultPrim(skelRootSchema.GetPrim());
-
-    // Build skeleton prim under above xform
-    const auto skeletonSdfPath = defaultPrimPath.AppendChild(gTokSkel);
-    auto skelSchema = pxr::UsdSkelSkeleton::Define(stage, skeletonSdfPath);
-    assert(skelSchema);
-
-
-    // Set bindTransforms attribute
-    auto bindTransformsAttr = skelSchema.CreateBindTransformsAttr();
-    assert(bindTransformsAttr);
-    ctx.skeletons[meshId] = generateSkeleton(mesh.numBones,
-                                             mesh.bonesPerVertex,
-                                             mesh.buffers.positionBufs.begin()->second,
-                                             mesh.buffers.blendWeightBufs.empty() ? nullptr : &mesh.buffers.blendWeightBufs.begin()->second,
-                                             mesh.buffers.blendIndicesBufs.empty() ? nullptr : &mesh.buffers.blendIndicesBufs.begin()->second);
-    const Skeleton& skel = ctx.skeletons[meshId];
-    // pxr::VtMatrix4dArray identities(mesh.numBones, pxr::GfMatrix4d(1));
-    bindTransformsAttr.Set(skel.bindPose);
-
-    // Set restTransforms attribute
-    auto restTransformsAttr = skelSchema.CreateRestTransformsAttr();
-    assert(restTransformsAttr);
-    restTransformsAttr.Set(skel.restPose);
-
-    // Set joints attribute on both the skeleton and the pose
-    auto jointsAttr = skelSchema.CreateJointsAttr();
-    assert(jointsAttr);
-    jointsAttr.Set(skel.jointNames);
-
-    stage->Save();
-
     // Build meshSchema prim on instance stage
-    if (ctx.instanceStage != nullptr) {
-      const std::string mesh_name = prefix::mesh + mesh.meshName;
-      const std::string relSkelStagePath = relDirPath + name + ctx.extension;
-      const pxr::SdfPath skelInstancePath = gRootMeshesPath.AppendElementString(mesh_name).AppendElementString(gTokSkel);
-
-      auto skelSchema = pxr::UsdSkelSkeleton::Define(ctx.instanceStage, skelInstancePath);
-      auto skelInstanceUsdReferences = skelSchema.GetPrim().GetReferences();
-      skelInstanceUsdReferences.AddReference(relSkelStagePath, skeletonSdfPath);
-    }
+    const std::string name = prefix::skeleton + mesh.meshName;
+    const auto skeletonSdfPath = gStageRootPath.AppendElementString(name).AppendChild(gTokSkel);
+    const std::string mesh_name = prefix::mesh + mesh.meshName;
+    const std::string relSkelStagePath = relDirPath + name + ctx.extension;
+    const pxr::SdfPath skelInstancePath = gRootMeshesPath.AppendElementString(mesh_name).AppendElementString(gTokSkel);
+
+    auto skelSchema = pxr::UsdSkelSkeleton::Define(ctx.instanceStage, skelInstancePath);
+    auto skelInstanceUsdReferences = skelSchema.GetPrim().GetReferences();
+    skelInstanceUsdReferences.AddReference(relSkelStagePath, skeletonSdfPath);
   }
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportSkeletons] End");
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceSkeletons] End");
 }
 
-void GameExporter::exportMeshes(const Export& exportData, ExportContext& ctx) {
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportMeshes] Begin");
-  static const pxr::GfMatrix4d identity(1);
+void GameExporter::exportMesh(const Export& exportData, const ExportContext& ctx, const Mesh& mesh, Reference& meshLssReference) {
   const std::string relMeshDirPath = commonDirName::meshDir + "/";
   const std::string meshDirPath = exportData.baseExportPath + "/" + relMeshDirPath;
   const std::string fullMeshStagePath = computeLocalPath(meshDirPath);
-  dxvk::env::createDirectory(meshDirPath);
   // Determine whether meshes need to be inverted
   const bool bInvX = (!exportData.camera.view.bInv) && (exportData.camera.proj.bInv || exportData.camera.isLHS());
   const bool bInvY = (!exportData.camera.view.bInv) && exportData.camera.proj.bInv;
-  for(const auto& [meshId,mesh] : exportData.meshes) {
-    assert(mesh.numVertices > 0);
-    assert(mesh.numIndices > 0);
+  assert(mesh.numVertices > 0);
+  assert(mesh.numIndices > 0);
 
-    const bool isSkeleton = mesh.numBones > 0;
+  const bool isSkeleton = mesh.numBones > 0;
 
-    // Build mesh stage
-    const std::string meshName = prefix::mesh + mesh.meshName;
-    const std::string meshStagePath = meshDirPath + meshName + ctx.extension;
-    pxr::UsdStageRefPtr meshStage = findOpenOrCreateStage(meshStagePath, true);
-    assert(meshStage);
-    setCommonStageMetaData(meshStage, exportData);
-
-    pxr::VtDictionary customLayerData = meshStage->GetRootLayer()->GetCustomLayerData();
-    for (auto& component : mesh.componentHashes) {
-      customLayerData.SetValueAtPath(component.first, pxr::VtValue(component.second));
-    }
-    meshStage->GetRootLayer()->SetCustomLayerData(customLayerData);
-
-    pxr::SdfPath meshXformSdfPath;
-    const bool visualCorrectionReqd = exportData.meta.bCorrectBakedTransforms || bInvX || bInvY;
-    if (visualCorrectionReqd) {
-      const auto correctionXformSdfPath = gStageRootPath.AppendElementString("visual_correction");
-      auto correctionXformSchema = pxr::UsdGeomXform::Define(meshStage, correctionXformSdfPath);
-      auto correctionXformOp = correctionXformSchema.AddTransformOp();
-      assert(correctionXformOp);
-      pxr::GfMatrix4d xform { 1.0 };
-      const pxr::GfVec3d scale{ (bInvX) ? -1.0 : 1.0,
-                                (bInvY) ? -1.0 : 1.0, 1.0};
-      xform.SetScale(scale);
-      const pxr::GfVec3d dOrigin{
-        (bInvX) ? -mesh.origin[0] : mesh.origin[0],
-        (bInvY) ? -mesh.origin[1] : mesh.origin[1],
-        mesh.origin[2]};
-      xform.SetTranslateOnly(-dOrigin);
-      correctionXformOp.Set(xform);
-      meshXformSdfPath = correctionXformSdfPath.AppendElementString(meshName);
-    } else {
-      meshXformSdfPath = gStageRootPath.AppendElementString(meshName);
-    }
+  // Build mesh stage
+  const std::string meshName = prefix::mesh + mesh.meshName;
+  const std::string meshStagePath = meshDirPath + meshName + ctx.extension;
+  pxr::UsdStageRefPtr meshStage = findOpenOrCreateStage(meshStagePath, true);
+  assert(meshStage);
+  setCommonStageMetaData(meshStage, exportData);
 
-    // Build mesh xform prim on mesh stage, make it visible
-    pxr::UsdGeomXformable meshXformSchema;
-    if (isSkeleton) {
-      meshXformSchema = pxr::UsdSkelRoot::Define(meshStage, meshXformSdfPath);
-    } else {
-      meshXformSchema = pxr::UsdGeomXform::Define(meshStage, meshXformSdfPath);
-    }
-    assert(meshXformSchema);
-    meshStage->SetDefaultPrim(meshXformSchema.GetPrim());
-    auto meshXformVisibilityAttr = meshXformSchema.CreateVisibilityAttr();
-    assert(meshXformVisibilityAttr);
-    meshXformVisibilityAttr.Set(gVisibilityInherited);
-
-    // Build mesh geometry prim under above xform
-    const auto meshSchemaSdfPath = meshXformSdfPath.AppendChild(gTokMesh);
-    pxr::UsdGeomMesh meshSchema = pxr::UsdGeomMesh::Define(meshStage, meshSchemaSdfPath);
-    pxr::UsdGeomPrimvarsAPI primvarsAPI(meshSchema.GetPrim());
-
-    assert(meshSchema);
-    auto meshVisibilityAttr = meshSchema.CreateVisibilityAttr();
-    assert(meshVisibilityAttr);
-    meshVisibilityAttr.Set(gVisibilityInherited);
-
-    auto meshXformOp = meshSchema.AddTransformOp();
-    assert(meshXformOp);
+  pxr::VtDictionary customLayerData = meshStage->GetRootLayer()->GetCustomLayerData();
+  for (auto& component : mesh.componentHashes) {
+    customLayerData.SetValueAtPath(component.first, pxr::VtValue(component.second));
+  }
+  meshStage->GetRootLayer()->SetCustomLayerData(customLayerData);
+
+  pxr::SdfPath meshXformSdfPath;
+  const bool visualCorrectionReqd = exportData.meta.bCorrectBakedTransforms || bInvX || bInvY;
+  if (visualCorrectionReqd) {
+    const auto correctionXformSdfPath = gStageRootPath.AppendElementString("visual_correction");
+    auto correctionXformSchema = pxr::UsdGeomXform::Define(meshStage, correctionXformSdfPath);
+    auto correctionXformOp = correctionXformSchema.AddTransformOp();
+    assert(correctionXformOp);
     pxr::GfMatrix4d xform { 1.0 };
-    xform = mesh.isLhs ? dxvk::swapBasis(xform) : xform;
-    meshXformOp.Set(xform);
-
-    // Set double-sidedness attribute
-    auto doubleSidedAttr = meshSchema.CreateDoubleSidedAttr();
-    assert(doubleSidedAttr);
-    doubleSidedAttr.Set(mesh.isDoubleSided);
-
-    // Set orientation attribute
-    auto orientationAttr = meshSchema.CreateOrientationAttr();
-    assert(orientationAttr);
-    orientationAttr.Set(pxr::VtValue(pxr::UsdGeomTokens->rightHanded));
-
-    // Create corresponding attribute arrays using above populated VtArrays
-    pxr::VtArray<int> faceVertexCounts;
-    faceVertexCounts.assign(mesh.numIndices / 3, 3);
-    auto faceVertexCountsAttr = meshSchema.CreateFaceVertexCountsAttr();
-    assert(faceVertexCountsAttr);
-    faceVertexCountsAttr.Set(faceVertexCounts);
-
-    for (auto& pair : mesh.categoryFlags) {
-      const auto attribute = meshSchema.GetPrim().CreateAttribute(pxr::TfToken(pair.first), pxr::SdfValueTypeNames->Bool, true, pxr::SdfVariabilityUniform);
-      attribute.Set(pxr::VtValue(pair.second));
-    }
+    const pxr::GfVec3d scale{ (bInvX) ? -1.0 : 1.0,
+                              (bInvY) ? -1.0 : 1.0, 1.0};
+    xform.SetScale(scale);
+    const pxr::GfVec3d dOrigin{
+      (bInvX) ? -mesh.origin[0] : mesh.origin[0],
+      (bInvY) ? -mesh.origin[1] : mesh.origin[1],
+      mesh.origin[2]};
+    xform.SetTranslateOnly(-dOrigin);
+    correctionXformOp.Set(xform);
+    meshXformSdfPath = correctionXformSdfPath.AppendElementString(meshName);
+  } else {
+    meshXformSdfPath = gStageRootPath.AppendElementString(meshName);
+  }
 
-    // Indices
-    const bool reduce = exportData.meta.bReduceMeshBuffers;
-    ReducedIdxBufSet reducedIdxBufSet = reduce ? reduceIdxBufferSet(mesh.buffers.idxBufs) : ReducedIdxBufSet();
-    const BufSet<Index>& idxBufSet = reduce ? reducedIdxBufSet.bufSet : mesh.buffers.idxBufs;
-    auto indexAttr = meshSchema.CreateFaceVertexIndicesAttr();
-    assert(indexAttr);
-    exportBufferSet(idxBufSet, indexAttr);
-    // Vertices
-    const auto& posBufs = mesh.buffers.positionBufs;
-    auto pointsAttr = meshSchema.CreatePointsAttr();
-    assert(pointsAttr);
-    exportBufferSet(reduce ? reduceBufferSet(posBufs, reducedIdxBufSet) : posBufs, pointsAttr);
-    // Normals
-    auto normalsAttr = meshSchema.CreateNormalsAttr();
-    assert(normalsAttr);
-    exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.normalBufs, reducedIdxBufSet) : mesh.buffers.normalBufs, normalsAttr);
-    // Set subdivision scheme to None (USD defaults to catmull clark)
-    auto subdivAttr = meshSchema.CreateSubdivisionSchemeAttr();
-    assert(subdivAttr);
-    subdivAttr.Set(pxr::UsdGeomTokens->none);
-    // Texture Coordinates
-    static const pxr::TfToken kTokSt("st");
-    auto stAttr = primvarsAPI.CreatePrimvar(kTokSt, pxr::SdfValueTypeNames->TexCoord2fArray, pxr::UsdGeomTokens->vertex);
-    assert(stAttr);
-    exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.texcoordBufs, reducedIdxBufSet) : mesh.buffers.texcoordBufs, stAttr);
-
-    // Vertex Colors
-    if (mesh.buffers.colorBufs.size() > 0) {
-      auto displayColorPrimvar = meshSchema.CreateDisplayColorPrimvar(pxr::UsdGeomTokens->vertex);
-      auto displayOpacityPrimvar = meshSchema.CreateDisplayOpacityPrimvar(pxr::UsdGeomTokens->vertex);
-      assert(displayColorPrimvar);
-      assert(displayOpacityPrimvar);
-      if (mesh.buffers.colorBufs.cbegin()->second.size() == 1) {
-        // Constant Color
-        displayColorPrimvar.SetInterpolation(pxr::UsdGeomTokens->constant);
-        displayOpacityPrimvar.SetInterpolation(pxr::UsdGeomTokens->constant);
-      }
-      exportColorOpacityBufferSet(reduce ? reduceBufferSet(mesh.buffers.colorBufs, reducedIdxBufSet) : mesh.buffers.colorBufs, displayColorPrimvar, displayOpacityPrimvar);
+  // Build mesh xform prim on mesh stage, make it visible
+  pxr::UsdGeomXformable meshXformSchema;
+  if (isSkeleton) {
+    meshXformSchema = pxr::UsdSkelRoot::Define(meshStage, meshXformSdfPath);
+  } else {
+    meshXformSchema = pxr::UsdGeomXform::Define(meshStage, meshXformSdfPath);
+  }
+  assert(meshXformSchema);
+  meshStage->SetDefaultPrim(meshXformSchema.GetPrim());
+  auto meshXformVisibilityAttr = meshXformSchema.CreateVisibilityAttr();
+  assert(meshXformVisibilityAttr);
+  meshXformVisibilityAttr.Set(gVisibilityInherited);
+
+  // Build mesh geometry prim under above xform
+  const auto meshSchemaSdfPath = meshXformSdfPath.AppendChild(gTokMesh);
+  pxr::UsdGeomMesh meshSchema = pxr::UsdGeomMesh::Define(meshStage, meshSchemaSdfPath);
+  pxr::UsdGeomPrimvarsAPI primvarsAPI(meshSchema.GetPrim());
+
+  assert(meshSchema);
+  auto meshVisibilityAttr = meshSchema.CreateVisibilityAttr();
+  assert(meshVisibilityAttr);
+  meshVisibilityAttr.Set(gVisibilityInherited);
+
+  auto meshXformOp = meshSchema.AddTransformOp();
+  assert(meshXformOp);
+  pxr::GfMatrix4d xform { 1.0 };
+  xform = mesh.isLhs ? dxvk::swapBasis(xform) : xform;
+  meshXformOp.Set(xform);
+
+  // Set double-sidedness attribute
+  auto doubleSidedAttr = meshSchema.CreateDoubleSidedAttr();
+  assert(doubleSidedAttr);
+  doubleSidedAttr.Set(mesh.isDoubleSided);
+
+  // Set orientation attribute
+  auto orientationAttr = meshSchema.CreateOrientationAttr();
+  assert(orientationAttr);
+  orientationAttr.Set(pxr::VtValue(pxr::UsdGeomTokens->rightHanded));
+
+  // Create corresponding attribute arrays using above populated VtArrays
+  pxr::VtArray<int> faceVertexCounts;
+  faceVertexCounts.assign(mesh.numIndices / 3, 3);
+  auto faceVertexCountsAttr = meshSchema.CreateFaceVertexCountsAttr();
+  assert(faceVertexCountsAttr);
+  faceVertexCountsAttr.Set(faceVertexCounts);
+
+  for (auto& pair : mesh.categoryFlags) {
+    const auto attribute = meshSchema.GetPrim().CreateAttribute(pxr::TfToken(pair.first), pxr::SdfValueTypeNames->Bool, true, pxr::SdfVariabilityUniform);
+    attribute.Set(pxr::VtValue(pair.second));
+  }
+
+  // Indices
+  const bool reduce = exportData.meta.bReduceMeshBuffers;
+  ReducedIdxBufSet reducedIdxBufSet = reduce ? reduceIdxBufferSet(mesh.buffers.idxBufs) : ReducedIdxBufSet();
+  const BufSet<Index>& idxBufSet = reduce ? reducedIdxBufSet.bufSet : mesh.buffers.idxBufs;
+  auto indexAttr = meshSchema.CreateFaceVertexIndicesAttr();
+  assert(indexAttr);
+  exportBufferSet(idxBufSet, indexAttr);
+  // Vertices
+  const auto& posBufs = mesh.buffers.positionBufs;
+  auto pointsAttr = meshSchema.CreatePointsAttr();
+  assert(pointsAttr);
+  exportBufferSet(reduce ? reduceBufferSet(posBufs, reducedIdxBufSet) : posBufs, pointsAttr);
+  // Normals
+  auto normalsAttr = meshSchema.CreateNormalsAttr();
+  assert(normalsAttr);
+  exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.normalBufs, reducedIdxBufSet) : mesh.buffers.normalBufs, normalsAttr);
+  // Set subdivision scheme to None (USD defaults to catmull clark)
+  auto subdivAttr = meshSchema.CreateSubdivisionSchemeAttr();
+  assert(subdivAttr);
+  subdivAttr.Set(pxr::UsdGeomTokens->none);
+  // Texture Coordinates
+  static const pxr::TfToken kTokSt("st");
+  auto stAttr = primvarsAPI.CreatePrimvar(kTokSt, pxr::SdfValueTypeNames->TexCoord2fArray, pxr::UsdGeomTokens->vertex);
+  assert(stAttr);
+  exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.texcoordBufs, reducedIdxBufSet) : mesh.buffers.texcoordBufs, stAttr);
+
+  // Vertex Colors
+  if (mesh.buffers.colorBufs.size() > 0) {
+    auto displayColorPrimvar = meshSchema.CreateDisplayColorPrimvar(pxr::UsdGeomTokens->vertex);
+    auto displayOpacityPrimvar = meshSchema.CreateDisplayOpacityPrimvar(pxr::UsdGeomTokens->vertex);
+    assert(displayColorPrimvar);
+    assert(displayOpacityPrimvar);
+    if (mesh.buffers.colorBufs.cbegin()->second.size() == 1) {
+      // Constant Color
+      displayColorPrimvar.SetInterpolation(pxr::UsdGeomTokens->constant);
+      displayOpacityPrimvar.SetInterpolation(pxr::UsdGeomTokens->constant);
     }
-    
-    if (isSkeleton) {
-      pxr::UsdSkelBindingAPI skelBind = pxr::UsdSkelBindingAPI::Apply(meshSchema.GetPrim());
+    exportColorOpacityBufferSet(reduce ? reduceBufferSet(mesh.buffers.colorBufs, reducedIdxBufSet) : mesh.buffers.colorBufs, displayColorPrimvar, displayOpacityPrimvar);
+  }
+  
+  if (isSkeleton) {
+    pxr::UsdSkelBindingAPI skelBind = pxr::UsdSkelBindingAPI::Apply(meshSchema.GetPrim());
 
-      auto jointWeightsAttr = skelBind.CreateJointWeightsPrimvar(0, mesh.bonesPerVertex);
-      assert(jointWeightsAttr);
-      exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.blendWeightBufs, reducedIdxBufSet, mesh.bonesPerVertex) : mesh.buffers.blendWeightBufs, jointWeightsAttr);
+    auto jointWeightsAttr = skelBind.CreateJointWeightsPrimvar(0, mesh.bonesPerVertex);
+    assert(jointWeightsAttr);
+    exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.blendWeightBufs, reducedIdxBufSet, mesh.bonesPerVertex) : mesh.buffers.blendWeightBufs, jointWeightsAttr);
 
-      auto jointIndicesAttr = skelBind.CreateJointIndicesPrimvar(0, mesh.bonesPerVertex);
-      assert(jointIndicesAttr);
-      if (mesh.buffers.blendIndicesBufs.size() > 0) {
-        exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.blendIndicesBufs, reducedIdxBufSet, mesh.bonesPerVertex) : mesh.buffers.blendIndicesBufs, jointIndicesAttr);
-      } else {
-        // D3D9 allows for default bone indices of "0, 1, ... bonesPerVertex" if no joint indices are set.
-        pxr::VtArray<int> defaultIndices(mesh.bonesPerVertex * mesh.numVertices);
-        for (int i = 0; i < mesh.numVertices; ++i) {
-          for (int j = 0; j < mesh.bonesPerVertex; ++j) {
-            defaultIndices[i * mesh.bonesPerVertex + j] = j;
-          }
+    auto jointIndicesAttr = skelBind.CreateJointIndicesPrimvar(0, mesh.bonesPerVertex);
+    assert(jointIndicesAttr);
+    if (mesh.buffers.blendIndicesBufs.size() > 0) {
+      exportBufferSet(reduce ? reduceBufferSet(mesh.buffers.blendIndicesBufs, reducedIdxBufSet, mesh.bonesPerVertex) : mesh.buffers.blendIndicesBufs, jointIndicesAttr);
+    } else {
+      // D3D9 allows for default bone indices of "0, 1, ... bonesPerVertex" if no joint indices are set.
+      pxr::VtArray<int> defaultIndices(mesh.bonesPerVertex * mesh.numVertices);
+      for (int i = 0; i < mesh.numVertices; ++i) {
+        for (int j = 0; j < mesh.bonesPerVertex; ++j) {
+          defaultIndices[i * mesh.bonesPerVertex + j] = j;
         }
-        jointIndicesAttr.Set(defaultIndices);
       }
-
-      auto skelRel = skelBind.CreateSkeletonRel();
-      skelRel.AddTarget(meshXformSdfPath.AppendChild(gTokSkel));
+      jointIndicesAttr.Set(defaultIndices);
     }
 
-    const bool bHasMat = mesh.matId != kInvalidId;
-    const Reference& matLssReference = (bHasMat) ? ctx.matReferences[mesh.matId] : Reference();
-    if(bHasMat) {
-      const auto shaderMatSchema = pxr::UsdShadeMaterial::Define(meshStage, matLssReference.ogSdfPath);
-      assert(shaderMatSchema);
-      auto shaderMatUsdReferences = shaderMatSchema.GetPrim().GetReferences();
-      const std::string fullMatStagePath = computeLocalPath(matLssReference.stagePath);
-      const std::string relMatRefStagePath = std::filesystem::relative(fullMatStagePath,fullMeshStagePath).string();
-      shaderMatUsdReferences.AddReference(relMatRefStagePath, matLssReference.ogSdfPath);
-      pxr::UsdShadeMaterialBindingAPI(meshXformSchema.GetPrim()).Bind(shaderMatSchema);
-    }
+    auto skelRel = skelBind.CreateSkeletonRel();
+    skelRel.AddTarget(meshXformSdfPath.AppendChild(gTokSkel));
+  }
 
-    meshStage->Save();
-    
-    // Cache material reference
-    Reference meshLssReference;
-    meshLssReference.stagePath = meshStagePath;
-    meshLssReference.ogSdfPath = meshXformSdfPath;
-    
-    // Build meshSchema prim on instance stage
-    if(ctx.instanceStage != nullptr) {
-      const auto meshInstanceXformSdfPath = gRootMeshesPath.AppendElementString(meshName);
-      pxr::UsdGeomXformable meshInstanceXformSchema;
-      if (isSkeleton) {
-        meshInstanceXformSchema = pxr::UsdSkelRoot::Define(ctx.instanceStage, meshInstanceXformSdfPath);
-      } else {
-        meshInstanceXformSchema = pxr::UsdGeomXform::Define(ctx.instanceStage, meshInstanceXformSdfPath);
-      }
-      assert(meshInstanceXformSchema);
-
-      const std::string relMeshStagePath = relMeshDirPath + meshName + ctx.extension;
-      auto meshInstanceUsdReferences = meshInstanceXformSchema.GetPrim().GetReferences();
-      meshInstanceUsdReferences.AddReference(relMeshStagePath, meshXformSdfPath);
-
-      auto meshInstanceXformVisibilityAttr = meshInstanceXformSchema.CreateVisibilityAttr();
-      assert(meshInstanceXformVisibilityAttr);
-      meshInstanceXformVisibilityAttr.Set(gVisibilityInvisible);
-      
-      if(bHasMat) {
-        const auto shaderMatInstanceSchema = pxr::UsdShadeMaterial::Get(ctx.instanceStage, matLssReference.instanceSdfPath);
-        assert(shaderMatInstanceSchema);
-        pxr::UsdShadeMaterialBindingAPI(meshInstanceXformSchema.GetPrim()).Bind(shaderMatInstanceSchema);
-      }
+  // Note: Material layers are all written before any mesh layer, see exportLayers
+  const bool bHasMat = mesh.matId != kInvalidId;
+  const Reference& matLssReference = (bHasMat) ? ctx.matReferences.at(mesh.matId) : Reference();
+  if(bHasMat) {
+    const auto shaderMatSchema = pxr::UsdShadeMaterial::Define(meshStage, matLssReference.ogSdfPath);
+    assert(shaderMatSchema);
+    auto shaderMatUsdReferences = shaderMatSchema.GetPrim().GetReferences();
+    const std::string fullMatStagePath = computeLocalPath(matLssReference.stagePath);
+    const std::string relMatRefStagePath = std::filesystem::relative(fullMatStagePath,fullMeshStagePath).string();
+    shaderMatUsdReferences.AddReference(relMatRefStagePath, matLssReference.ogSdfPath);
+    pxr::UsdShadeMaterialBindingAPI(meshXformSchema.GetPrim()).Bind(shaderMatSchema);
+  }
 
-      meshLssReference.instanceSdfPath = meshInstanceXformSdfPath;
+  meshStage->Save();
+  
+  // Cache mesh reference
+  meshLssReference.stagePath = meshStagePath;
+  meshLssReference.ogSdfPath = meshXformSdfPath;
+}
+
+void GameExporter::instanceMeshes(const Export& exportData, ExportContext& ctx) {
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceMeshes] Begin");
+  const std::string relMeshDirPath = commonDirName::meshDir + "/";
+  for(const auto& [meshId,mesh] : exportData.meshes) {
+    // Build meshSchema prim on instance stage
+    Reference& meshLssReference = ctx.meshReferences.at(meshId);
+    const bool isSkeleton = mesh.numBones > 0;
+    const std::string meshName = prefix::mesh + mesh.meshName;
+    const auto meshInstanceXformSdfPath = gRootMeshesPath.AppendElementString(meshName);
+    pxr::UsdGeomXformable meshInstanceXformSchema;
+    if (isSkeleton) {
+      meshInstanceXformSchema = pxr::UsdSkelRoot::Define(ctx.instanceStage, meshInstanceXformSdfPath);
+    } else {
+      meshInstanceXformSchema = pxr::UsdGeomXform::Define(ctx.instanceStage, meshInstanceXformSdfPath);
     }
+    assert(meshInstanceXformSchema);
+
+    const std::string relMeshStagePath = relMeshDirPath + meshName + ctx.extension;
+    auto meshInstanceUsdReferences = meshInstanceXformSchema.GetPrim().GetReferences();
+    meshInstanceUsdReferences.AddReference(relMeshStagePath, meshLssReference.ogSdfPath);
+
+    auto meshInstanceXformVisibilityAttr = meshInstanceXformSchema.CreateVisibilityAttr();
+    assert(meshInstanceXformVisibilityAttr);
+    meshInstanceXformVisibilityAttr.Set(gVisibilityInvisible);
     
-    ctx.meshReferences[meshId] = meshLssReference;
+    if(mesh.matId != kInvalidId) {
+      const Reference& matLssReference = ctx.matReferences.at(mesh.matId);
+      const auto shaderMatInstanceSchema = pxr::UsdShadeMaterial::Get(ctx.instanceStage, matLssReference.instanceSdfPath);
+      assert(shaderMatInstanceSchema);
+      pxr::UsdShadeMaterialBindingAPI(meshInstanceXformSchema.GetPrim()).Bind(shaderMatInstanceSchema);
+    }
+
+    meshLssReference.instanceSdfPath = meshInstanceXformSdfPath;
   }
-  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][exportMeshes] End");
+  dxvk::Logger::debug("[GameExporter][" + exportData.debugId + "][instanceMeshes] End");
 }
 
 GameExporter::ReducedIdxBufSet GameExporter::reduceIdxBufferSet(const BufSet<Index>& idxBufSet) {
   ReducedIdxBufSet reducedIdxBufSet;
+  // Create all per-timecode entries up front, so the (parallel) reduction below never touches the maps
+  struct Job {
+    const Buf<Index>* ogIdxBuf;
+    Buf<Index>* redIdxBuf;
+    IdxReduction* reduction;
+  };
+  std::vector<Job> jobs;
+  jobs.reserve(idxBufSet.size());
   for(const auto& [timeCode, idxBuf] : idxBufSet) {
-    const std::set<int> orderedIndices(idxBuf.cbegin(), idxBuf.cend());
-    int newIdx = 0;
-    ReducedIdxBufSet::IdxMap ogToRed;
-    for(const auto index : orderedIndices) {
-      ogToRed[index] = newIdx++;
-    }
-    for(const auto ogIdx : idxBuf) {
-      const auto redIdx = ogToRed[ogIdx];
-      assert(redIdx <= ogIdx);
-      reducedIdxBufSet.bufSet[timeCode].push_back(redIdx);
-      reducedIdxBufSet.redToOgSet[timeCode][redIdx] = ogIdx;
-    }
+    jobs.push_back({ &idxBuf, &reducedIdxBufSet.bufSet[timeCode], &reducedIdxBufSet.redToOgSet[timeCode] });
   }
+  parallelFor(jobs.size(), [&jobs](const size_t i) {
+    const Job& job = jobs[i];
+    computeIdxReduction(job.ogIdxBuf->cdata(), job.ogIdxBuf->size(), *job.reduction);
+    job.redIdxBuf->assign(job.reduction->reducedIdxs.cbegin(), job.reduction->reducedIdxs.cend());
+  });
   return reducedIdxBufSet;
 }
 
 template<typename T>
 BufSet<T> GameExporter::reduceBufferSet(const BufSet<T>& bufSet, const ReducedIdxBufSet& reducedIdxBufSet, size_t elemsPerIdx) {
   BufSet<T> reducedBufSet;
+  struct Job {
+    const Buf<T>* ogBuf;
+    Buf<T>* redBuf;
+    const IdxReduction* reduction;
+  };
+  std::vector<Job> jobs;
+  jobs.reserve(bufSet.size());
   for(const auto& [timeCode, buf] : bufSet) {
     // There may not be a 1:1 mapping in timecodes b/w index buffers and other buffers
     float idxBufTimeCode = -1.f;
     if(reducedIdxBufSet.bufSet.size() > 1) {
       const auto iPair_timeCode_idxBuf = reducedIdxBufSet.bufSet.lower_bound(timeCode);
       assert(iPair_timeCode_idxBuf != reducedIdxBufSet.bufSet.cend());
-      const float idxTimeCode = iPair_timeCode_idxBuf->first;
       idxBufTimeCode = iPair_timeCode_idxBuf->first;
     } else {
       idxBufTimeCode = reducedIdxBufSet.bufSet.cbegin()->first;
     }
     assert(idxBufTimeCode >= 0.f);
-
-    // Create a scratch space to assign values for new, reduce VtArray, in case there are holes in the indices
-    const auto& redIdxToOgIdx = reducedIdxBufSet.redToOgSet.at(idxBufTimeCode);
-    const int numIdxs = redIdxToOgIdx.size();
-    const size_t numElems = numIdxs * elemsPerIdx;
-    T* const reducedBufScratch = new T[numElems];
-    
-    // Init potential holes to 0
-    memset(reducedBufScratch, 0, sizeof(T) * numElems);
-    for(const auto [redIndex,ogIndex] : redIdxToOgIdx) {
-      for (int elemNum = 0; elemNum < elemsPerIdx; ++elemNum) {
-        const auto ogIdx = (ogIndex * elemsPerIdx) + elemNum;
-        const auto redIdx = (redIndex * elemsPerIdx) + elemNum;
-        assert(redIdx <= ogIdx);
-        reducedBufScratch[redIdx] = buf[ogIdx];
-      }
-    }
-    reducedBufSet[timeCode] = pxr::VtArray<T>(reducedBufScratch, reducedBufScratch + numElems);
+    jobs.push_back({ &buf, &reducedBufSet[timeCode], &reducedIdxBufSet.redToOgSet.at(idxBufTimeCode) });
   }
+  parallelFor(jobs.size(), [&jobs, elemsPerIdx](const size_t i) {
+    const Job& job = jobs[i];
+    // Note: value-initialized, in case the source buffer doesn't cover every referenced vertex
+    *job.redBuf = Buf<T>(job.reduction->numReducedVertices() * elemsPerIdx);
+    applyIdxReduction(job.ogBuf->cdata(), job.ogBuf->size(), *job.reduction, elemsPerIdx, job.redBuf->data());
+  });
   return reducedBufSet;
 }
 
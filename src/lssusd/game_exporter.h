@@ -30,6 +30,7 @@
 #include "game_exporter_common.h"
 #include "game_exporter_types.h"
 #include "game_exporter_paths.h"
+#include "game_exporter_reduce.h"
 
 #include <mutex>
 
@@ -60,13 +61,19 @@ private:
   static pxr::UsdStageRefPtr createInstanceStage(const Export& exportData);
   static void setCommonStageMetaData(pxr::UsdStageRefPtr stage, const Export& exportData);
   static void createApertureMdls(const std::string& baseExportPath);
-  static void exportMaterials(const Export& exportData, ExportContext& ctx);
-  static void exportMeshes(const Export& exportData, ExportContext& ctx);
+  static void exportLayers(const Export& exportData, ExportContext& ctx);
+  static Reference getMaterialReference(const Export& exportData, const ExportContext& ctx, const Material& matData);
+  // Note: The per-layer exporters below may run concurrently, and must only read from the context
+  static void exportMaterial(const Export& exportData, const ExportContext& ctx, const Material& matData, const Reference& matLssReference);
+  static void exportMesh(const Export& exportData, const ExportContext& ctx, const Mesh& mesh, Reference& meshLssReference);
+  static void exportSkeleton(const Export& exportData, const ExportContext& ctx, const Mesh& mesh, Skeleton& skeleton);
+  static void instanceMaterials(const Export& exportData, ExportContext& ctx);
+  static void instanceMeshes(const Export& exportData, ExportContext& ctx);
+  static void instanceSkeletons(const Export& exportData, ExportContext& ctx);
   struct ReducedIdxBufSet {
     BufSet<Index> bufSet;
-    // Per-timecode idx mapping
-    using IdxMap = std::unordered_map<int,int>;
-    std::map<float,IdxMap> redToOgSet;
+    // Per-timecode idx mapping, computed once and shared by all vertex attributes
+    std::map<float,IdxReduction> redToOgSet;
   };
   static ReducedIdxBufSet reduceIdxBufferSet(const BufSet<Index>& idxBufSet);
   template<typename T>
@@ -78,7 +85,6 @@ private:
   static void exportColorOpacityBufferSet(const BufSet<Color>& bufSet,
                                           pxr::UsdAttribute color,
                                           pxr::UsdAttribute opacity);
-  static void exportSkeletons(const Export& exportData, ExportContext& ctx);
   static void exportInstances(const Export& exportData, ExportContext& ctx);
   static void exportCamera(const Export& exportData, ExportContext& ctx);
   static void exportSphereLights(const Export& exportData, ExportContext& ctx);
@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+// Note: This header is intentionally free of any USD dependencies so that the
+//       reduction logic can be unit tested in isolation.
+
+#include <algorithm>
+#include <atomic>
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace lss {
+
+// Compaction of an index buffer to only the vertices it actually references.
+// Reduced indices preserve the relative order of the original indices, i.e.
+// the smallest referenced vertex becomes 0, the next smallest 1, and so on.
+struct IdxReduction {
+  // The index buffer rewritten in terms of the reduced vertex range
+  std::vector<int> reducedIdxs;
+  // For every reduced vertex, the original vertex it was taken from
+  std::vector<int> redToOg;
+
+  size_t numReducedVertices() const { return redToOg.size(); }
+};
+
+namespace reduce {
+
+// Past this ratio of index range to index count a flat remap table would be
+// mostly empty, so sorting the (few) referenced indices is cheaper.
+static constexpr size_t kMaxFlatRangePerIdx = 4;
+static constexpr size_t kMinFlatRange = 64 * 1024;
+
+inline void computeSparse(const int* idxs, const size_t count, IdxReduction& out) {
+  out.redToOg.assign(idxs, idxs + count);
+  std::sort(out.redToOg.begin(), out.redToOg.end());
+  out.redToOg.erase(std::unique(out.redToOg.begin(), out.redToOg.end()), out.redToOg.end());
+
+  out.reducedIdxs.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const auto it = std::lower_bound(out.redToOg.cbegin(), out.redToOg.cend(), idxs[i]);
+    out.reducedIdxs[i] = static_cast<int>(it - out.redToOg.cbegin());
+  }
+}
+
+inline void computeFlat(const int* idxs, const size_t count, const int minIdx, const size_t range, IdxReduction& out) {
+  // Mark every referenced vertex, then turn the marks into reduced indices with
+  // an exclusive prefix sum over the range. Unreferenced slots are left as-is
+  // since they are never read back.
+  std::vector<int> remap(range, 0);
+  for (size_t i = 0; i < count; ++i) {
+    remap[static_cast<size_t>(idxs[i] - minIdx)] = 1;
+  }
+
+  int numReduced = 0;
+  for (size_t slot = 0; slot < range; ++slot) {
+    const int used = remap[slot];
+    remap[slot] = numReduced;
+    numReduced += used;
+  }
+
+  out.redToOg.resize(numReduced);
+  out.reducedIdxs.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const int ogIdx = idxs[i];
+    const int redIdx = remap[static_cast<size_t>(ogIdx - minIdx)];
+    assert(redIdx <= ogIdx - minIdx);
+    out.reducedIdxs[i] = redIdx;
+    out.redToOg[redIdx] = ogIdx;
+  }
+}
+
+}
+
+// Computes the reduction for a single index buffer in O(count + range).
+inline void computeIdxReduction(const int* idxs, const size_t count, IdxReduction& out) {
+  out.reducedIdxs.clear();
+  out.redToOg.clear();
+  if (count == 0) {
+    return;
+  }
+
+  const auto [minIt, maxIt] = std::minmax_element(idxs, idxs + count);
+  const int minIdx = *minIt;
+  const size_t range = static_cast<size_t>(static_cast<int64_t>(*maxIt) - minIdx) + 1;
+
+  if (range <= std::max(count * reduce::kMaxFlatRangePerIdx, reduce::kMinFlatRange)) {
+    reduce::computeFlat(idxs, count, minIdx, range, out);
+  } else {
+    reduce::computeSparse(idxs, count, out);
+  }
+}
+
+// Gathers the elements of a vertex buffer referenced by a reduction into dst,
+// which must have room for numReducedVertices() * elemsPerIdx elements.
+// Source elements outside of the provided buffer are zero filled.
+template<typename T>
+void applyIdxReduction(const T* src, const size_t srcCount,
+                       const IdxReduction& reduction, const size_t elemsPerIdx,
+                       T* dst) {
+  const size_t numReduced = reduction.numReducedVertices();
+  for (size_t redIdx = 0; redIdx < numReduced; ++redIdx) {
+    const size_t ogBase = static_cast<size_t>(reduction.redToOg[redIdx]) * elemsPerIdx;
+    const size_t redBase = redIdx * elemsPerIdx;
+    if (ogBase + elemsPerIdx <= srcCount) {
+      std::copy(src + ogBase, src + ogBase + elemsPerIdx, dst + redBase);
+    } else {
+      std::fill(dst + redBase, dst + redBase + elemsPerIdx, T {});
+    }
+  }
+}
+
+namespace reduce {
+// Set on exporter worker threads, so nested parallel loops run inline instead of oversubscribing
+inline thread_local bool t_isExportWorker = false;
+}
+
+// Runs fn(i) for i in [0, count), spreading the calls across hardware threads.
+// Jobs are handed out dynamically, so uneven job sizes (e.g. mesh layers) still
+// balance well. Calls made from within a job run serially on the calling thread.
+template<typename Fn>
+void parallelFor(const size_t count, Fn&& fn) {
+  const size_t maxThreads = reduce::t_isExportWorker ? 1 : std::max(1u, std::thread::hardware_concurrency());
+  const size_t numThreads = std::min<size_t>(count, maxThreads);
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> nextJob = 0;
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads);
+  for (size_t t = 0; t < numThreads; ++t) {
+    workers.emplace_back([count, &nextJob, &fn]() {
+      reduce::t_isExportWorker = true;
+      for (size_t i = nextJob++; i < count; i = nextJob++) {
+        fn(i);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+}
@@ -1,110 +1,378 @@
+#include <algorithm>
+#include <iterator>
+
 #include "spirv_compression.h"
 
 namespace dxvk {
 
-  SpirvCompressedBuffer::SpirvCompressedBuffer()
-  : m_size(0) {
+  namespace {
 
-  }
+    constexpr uint32_t Ins(spv::Op op, uint32_t wordCount) {
+      return (wordCount << spv::WordCountShift) | uint32_t(op);
+    }
 
+    // Instruction headers, i.e. opcode and word count pairs, commonly
+    // emitted by the shader compilers. Each is encoded as one byte.
+    constexpr uint32_t HeaderDictionary[] = {
+      Ins(spv::OpLoad, 4),
+      Ins(spv::OpStore, 3),
+      Ins(spv::OpAccessChain, 4),
+      Ins(spv::OpAccessChain, 5),
+      Ins(spv::OpAccessChain, 6),
+      Ins(spv::OpCompositeExtract, 5),
+      Ins(spv::OpCompositeExtract, 6),
+      Ins(spv::OpCompositeConstruct, 4),
+      Ins(spv::OpCompositeConstruct, 5),
+      Ins(spv::OpCompositeConstruct, 6),
+      Ins(spv::OpCompositeConstruct, 7),
+      Ins(spv::OpCompositeInsert, 6),
+      Ins(spv::OpVectorShuffle, 6),
+      Ins(spv::OpVectorShuffle, 7),
+      Ins(spv::OpVectorShuffle, 8),
+      Ins(spv::OpVectorShuffle, 9),
+      Ins(spv::OpVectorExtractDynamic, 5),
+      Ins(spv::OpSelect, 6),
+      Ins(spv::OpFAdd, 5),
+      Ins(spv::OpFSub, 5),
+      Ins(spv::OpFMul, 5),
+      Ins(spv::OpFDiv, 5),
+      Ins(spv::OpFNegate, 4),
+      Ins(spv::OpVectorTimesScalar, 5),
+      Ins(spv::OpVectorTimesMatrix, 5),
+      Ins(spv::OpMatrixTimesVector, 5),
+      Ins(spv::OpDot, 5),
+      Ins(spv::OpExtInst, 6),
+      Ins(spv::OpExtInst, 7),
+      Ins(spv::OpExtInst, 8),
+      Ins(spv::OpIAdd, 5),
+      Ins(spv::OpISub, 5),
+      Ins(spv::OpIMul, 5),
+      Ins(spv::OpIEqual, 5),
+      Ins(spv::OpINotEqual, 5),
+      Ins(spv::OpULessThan, 5),
+      Ins(spv::OpSLessThan, 5),
+      Ins(spv::OpSGreaterThanEqual, 5),
+      Ins(spv::OpFOrdEqual, 5),
+      Ins(spv::OpFOrdNotEqual, 5),
+      Ins(spv::OpFOrdLessThan, 5),
+      Ins(spv::OpFOrdGreaterThan, 5),
+      Ins(spv::OpFOrdLessThanEqual, 5),
+      Ins(spv::OpFOrdGreaterThanEqual, 5),
+      Ins(spv::OpFUnordNotEqual, 5),
+      Ins(spv::OpLogicalNot, 4),
+      Ins(spv::OpLogicalAnd, 5),
+      Ins(spv::OpLogicalOr, 5),
+      Ins(spv::OpAny, 4),
+      Ins(spv::OpAll, 4),
+      Ins(spv::OpBitcast, 4),
+      Ins(spv::OpConvertFToS, 4),
+      Ins(spv::OpConvertFToU, 4),
+      Ins(spv::OpConvertSToF, 4),
+      Ins(spv::OpConvertUToF, 4),
+      Ins(spv::OpBitwiseAnd, 5),
+      Ins(spv::OpBitwiseOr, 5),
+      Ins(spv::OpShiftLeftLogical, 5),
+      Ins(spv::OpShiftRightLogical, 5),
+      Ins(spv::OpBitFieldUExtract, 6),
+      Ins(spv::OpSampledImage, 5),
+      Ins(spv::OpImageSampleImplicitLod, 5),
+      Ins(spv::OpImageSampleImplicitLod, 7),
+      Ins(spv::OpImageSampleExplicitLod, 7),
+      Ins(spv::OpImageSampleDrefImplicitLod, 6),
+      Ins(spv::OpImageSampleDrefExplicitLod, 8),
+      Ins(spv::OpImageSampleProjImplicitLod, 5),
+      Ins(spv::OpImageSampleProjExplicitLod, 7),
+      Ins(spv::OpImageFetch, 5),
+      Ins(spv::OpImageFetch, 7),
+      Ins(spv::OpLabel, 2),
+      Ins(spv::OpBranch, 2),
+      Ins(spv::OpBranchConditional, 4),
+      Ins(spv::OpSelectionMerge, 3),
+      Ins(spv::OpLoopMerge, 4),
+      Ins(spv::OpPhi, 5),
+      Ins(spv::OpPhi, 7),
+      Ins(spv::OpKill, 1),
+      Ins(spv::OpReturn, 1),
+      Ins(spv::OpFunction, 5),
+      Ins(spv::OpFunctionEnd, 1),
+      Ins(spv::OpFunctionCall, 4),
+      Ins(spv::OpDecorate, 3),
+      Ins(spv::OpDecorate, 4),
+      Ins(spv::OpMemberDecorate, 4),
+      Ins(spv::OpMemberDecorate, 5),
+      Ins(spv::OpTypeVoid, 2),
+      Ins(spv::OpTypeBool, 2),
+      Ins(spv::OpTypeInt, 4),
+      Ins(spv::OpTypeFloat, 3),
+      Ins(spv::OpTypeVector, 4),
+      Ins(spv::OpTypeMatrix, 4),
+      Ins(spv::OpTypeArray, 4),
+      Ins(spv::OpTypeRuntimeArray, 3),
+      Ins(spv::OpTypeStruct, 2),
+      Ins(spv::OpTypeStruct, 3),
+      Ins(spv::OpTypeStruct, 4),
+      Ins(spv::OpTypeStruct, 5),
+      Ins(spv::OpTypeStruct, 6),
+      Ins(spv::OpTypePointer, 4),
+      Ins(spv::OpTypeFunction, 3),
+      Ins(spv::OpTypeImage, 9),
+      Ins(spv::OpTypeSampledImage, 3),
+      Ins(spv::OpVariable, 4),
+      Ins(spv::OpVariable, 5),
+      Ins(spv::OpConstant, 4),
+      Ins(spv::OpConstantTrue, 3),
+      Ins(spv::OpConstantFalse, 3),
+      Ins(spv::OpConstantComposite, 4),
+      Ins(spv::OpConstantComposite, 5),
+      Ins(spv::OpConstantComposite, 6),
+      Ins(spv::OpConstantComposite, 7),
+      Ins(spv::OpSpecConstant, 4),
+      Ins(spv::OpSpecConstantTrue, 3),
+      Ins(spv::OpUndef, 3),
+      Ins(spv::OpCapability, 2),
+      Ins(spv::OpExecutionMode, 3),
+    };
+
+    constexpr uint32_t HeaderDictionarySize = uint32_t(std::size(HeaderDictionary));
+
+    static_assert(HeaderDictionarySize <= 128,
+      "Dictionary indices must fit into a single byte.");
+
+    // Words of the module header preceding the first instruction,
+    // and index of the ID bound within the module header
+    constexpr uint32_t ModuleHeaderWords = 5;
+    constexpr uint32_t BoundWord = 3;
+
+    // Word encoding state, tracked the same way by the encoder and decoder
+    struct CodingState {
+      uint32_t word       = 0;
+      uint32_t nextHeader = ModuleHeaderWords;
+      uint32_t bound      = 0;
+      uint32_t maxId      = 0;
+
+      bool isHeader() const {
+        return word == nextHeader;
+      }
 
-  SpirvCompressedBuffer::SpirvCompressedBuffer(
-    const SpirvCodeBuffer& code)
-  : m_size(code.dwords()) {
-    const uint32_t* data = code.data();
+      void advance(uint32_t value) {
+        if (isHeader()) {
+          nextHeader += std::max(value >> spv::WordCountShift, 1u);
+        } else if (word == BoundWord) {
+          bound = value;
+        } else if (word >= ModuleHeaderWords && value < bound && value > maxId) {
+          maxId = value;
+        }
+
+        word++;
+      }
+    };
+
+    uint32_t varintBytes(uint64_t value) {
+      uint32_t bytes = 1;
+
+      while (value >= 0x80) {
+        value >>= 7;
+        bytes++;
+      }
+
+      return bytes;
+    }
+
+    void writeVarint(std::vector<uint8_t>& dst, uint64_t value) {
+      while (value >= 0x80) {
+        dst.push_back(uint8_t(value | 0x80));
+        value >>= 7;
+      }
+
+      dst.push_back(uint8_t(value));
+    }
 
-    // The compression works by eliminating leading null bytes
-    // from DWORDs, exploiting that SPIR-V IDs are consecutive
-    // integers that usually fall into the 16-bit range. For
-    // each DWORD, a two-bit integer is stored which indicates
-    // the number of bytes it takes in the compressed buffer.
-    // This way, it can achieve a compression ratio of ~50%.
-    m_mask.reserve((m_size + NumMaskWords - 1) / NumMaskWords);
-    m_code.reserve((m_size + 1) / 2);
+    uint64_t readVarint(const uint8_t*& src) {
+      if (likely(!(*src & 0x80)))
+        return *src++;
 
-    uint64_t dstWord  = 0;
-    uint32_t dstShift = 0;
+      uint64_t value = *src & 0x7f;
+      uint32_t shift = 7;
 
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t byteCounts = 0;
+      while (*src++ & 0x80) {
+        value |= uint64_t(*src & 0x7f) << shift;
+        shift += 7;
+      }
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint64_t word = data[i + w];
-        uint64_t bytes = 0;
+      return value;
+    }
 
-        if      (word < (1 <<  8)) bytes = 0;
-        else if (word < (1 << 16)) bytes = 1;
-        else if (word < (1 << 24)) bytes = 2;
-        else                       bytes = 3;
+    // Words take at most 33 bits before varint encoding
+    constexpr uint32_t MaxVarintBytes = 5;
 
-        byteCounts |= bytes << (2 * w);
+    bool readVarintChecked(const uint8_t*& src, const uint8_t* end, uint64_t& value) {
+      value = 0;
 
-        uint32_t bits = 8 * bytes + 8;
-        uint32_t rem  = bit::pack(dstWord, dstShift, word, bits);
+      for (uint32_t i = 0; i < MaxVarintBytes && src < end; i++) {
+        uint8_t byte = *src++;
+        value |= uint64_t(byte & 0x7f) << (7 * i);
 
-        if (unlikely(rem != 0)) {
-          m_code.push_back(dstWord);
+        if (!(byte & 0x80))
+          return true;
+      }
 
-          dstWord  = 0;
-          dstShift = 0;
+      return false;
+    }
 
-          bit::pack(dstWord, dstShift, word >> (bits - rem), rem);
+    uint32_t zigzag(uint32_t delta) {
+      return (delta << 1) ^ uint32_t(int32_t(delta) >> 31);
+    }
+
+    uint32_t unzigzag(uint32_t value) {
+      return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    uint64_t encodeWord(const CodingState& state, uint32_t word) {
+      if (state.isHeader()) {
+        for (uint32_t i = 0; i < HeaderDictionarySize; i++) {
+          if (HeaderDictionary[i] == word)
+            return i;
         }
+
+        return uint64_t(word) + HeaderDictionarySize;
       }
 
-      m_mask.push_back(byteCounts);
+      // The lowest bit selects between the plain value
+      // and the difference to the largest ID seen so far
+      uint64_t plain = uint64_t(word) << 1;
+      uint64_t delta = (uint64_t(zigzag(word - state.maxId)) << 1) | 1;
+      return varintBytes(delta) < varintBytes(plain) ? delta : plain;
     }
 
-    if (dstShift)
-      m_code.push_back(dstWord);
+    uint32_t decodeWord(const CodingState& state, uint64_t value) {
+      if (state.isHeader()) {
+        return value < HeaderDictionarySize
+          ? HeaderDictionary[value]
+          : uint32_t(value - HeaderDictionarySize);
+      }
+
+      return (value & 1)
+        ? state.maxId + unzigzag(uint32_t(value >> 1))
+        : uint32_t(value >> 1);
+    }
+
+    bool isValidWord(const CodingState& state, uint64_t value) {
+      uint64_t limit = state.isHeader()
+        ? uint64_t(HeaderDictionarySize) + (1ull << 32)
+        : 1ull << 33;
+      return value < limit;
+    }
 
-    m_mask.shrink_to_fit();
-    m_code.shrink_to_fit();
   }
 
-    
-  SpirvCompressedBuffer::~SpirvCompressedBuffer() {
+
+  SpirvCompressedBuffer::Decoder::Decoder(
+    const SpirvCompressedBuffer& buffer)
+  : m_src(buffer.m_data.data()), m_size(buffer.m_size),
+    m_nextHeader(ModuleHeaderWords) {
 
   }
 
 
-  SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
-    SpirvCodeBuffer code(m_size);
-    uint32_t* data = code.data();
+  uint32_t SpirvCompressedBuffer::Decoder::read(uint32_t* dst, uint32_t count) {
+    count = std::min(count, m_size - m_word);
+
+    CodingState state;
+    state.word       = m_word;
+    state.nextHeader = m_nextHeader;
+    state.bound      = m_bound;
+    state.maxId      = m_maxId;
 
-    if (m_size == 0)
-      return code;
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t word = decodeWord(state, readVarint(m_src));
+      state.advance(word);
+      dst[i] = word;
+    }
 
-    uint32_t maskIdx = 0;
-    uint32_t codeIdx = 0;
+    m_word       = state.word;
+    m_nextHeader = state.nextHeader;
+    m_bound      = state.bound;
+    m_maxId      = state.maxId;
+    return count;
+  }
 
-    uint64_t srcWord  = m_code[codeIdx++];
-    uint32_t srcShift = 0;
 
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t srcMask = m_mask[maskIdx++];
+  SpirvCompressedBuffer::SpirvCompressedBuffer()
+  : m_size(0) {
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint32_t bits = 8 * ((srcMask & 3) + 1);
+  }
 
-        uint64_t word = 0;
-        uint32_t rem = bit::unpack(word, srcWord, srcShift, bits);
 
-        if (unlikely(rem != 0)) {
-          srcWord  = m_code[codeIdx++];
-          srcShift = 0;
+  SpirvCompressedBuffer::SpirvCompressedBuffer(
+    const SpirvCodeBuffer& code)
+  : m_size(code.dwords()) {
+    const uint32_t* data = code.data();
 
-          uint64_t tmp = 0;
-          bit::unpack(tmp, srcWord, srcShift, rem);
-          word |= tmp << (bits - rem);
-        }
+    // Most words fit into one or two bytes, reserve for the worst
+    // common case and trim the buffer once everything is encoded
+    m_data.reserve(m_size * 2);
 
-        data[i + w] = word;
-        srcMask >>= 2;
-      }
+    CodingState state;
+
+    for (uint32_t i = 0; i < m_size; i++) {
+      writeVarint(m_data, encodeWord(state, data[i]));
+      state.advance(data[i]);
+    }
+
+    m_data.shrink_to_fit();
+  }
+
+
+  SpirvCompressedBuffer::SpirvCompressedBuffer(
+          uint32_t                dwords,
+          std::vector<uint8_t>&&  data)
+  : m_size(dwords), m_data(std::move(data)) {
+
+  }
+
+    
+  SpirvCompressedBuffer::~SpirvCompressedBuffer() {
+
+  }
+
+
+  bool SpirvCompressedBuffer::isValid() const {
+    const uint8_t* src = m_data.data();
+    const uint8_t* end = m_data.data() + m_data.size();
+
+    CodingState state;
+
+    for (uint32_t i = 0; i < m_size; i++) {
+      uint64_t value = 0;
+
+      if (!readVarintChecked(src, end, value) || !isValidWord(state, value))
+        return false;
+
+      state.advance(decodeWord(state, value));
     }
 
+    // Words are packed back to back, anything
+    // left over means the buffer is malformed
+    return src == end;
+  }
+
+
+  SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
+    SpirvCodeBuffer code(m_size);
+    decompress(code.data());
     return code;
   }
 
+
+  void SpirvCompressedBuffer::decompress(uint32_t* dst) const {
+    Decoder decoder(*this);
+    decoder.read(dst, m_size);
+  }
+
+
+  void SpirvCompressedBuffer::decompress(std::vector<uint32_t>& scratch) const {
+    scratch.resize(m_size);
+    decompress(scratch.data());
+  }
+
 }
\ No newline at end of file
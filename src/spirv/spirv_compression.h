@@ -32,29 +32,114 @@ namespace dxvk {
    *
    * Implements a fast in-memory compression
    * to keep memory footprint low.
+   *
+   * Every word is stored as a variable length integer of one
+   * to five bytes. Instruction headers found in a dictionary of
+   * common opcode and word count pairs take a single byte, and
+   * operands are stored either as is or as the difference to
+   * the largest ID seen so far, whichever is shorter. Since
+   * most operands of generated code refer to recently defined
+   * IDs, this typically takes 25 to 40% of the original size.
    */
   class SpirvCompressedBuffer {
-    constexpr static uint32_t NumMaskWords = 32;
   public:
 
+    /**
+     * \brief Streaming decoder
+     *
+     * Decodes the words of a compressed buffer in
+     * order, without allocating any memory. The
+     * buffer must stay alive while decoding.
+     */
+    class Decoder {
+    public:
+
+      explicit Decoder(const SpirvCompressedBuffer& buffer);
+
+      /**
+       * \brief Decodes the next words
+       *
+       * \param [out] dst Destination for up to \c count words
+       * \param [in] count Maximum number of words to decode
+       * \returns Number of words written, less than
+       *    \c count only at the end of the buffer
+       */
+      uint32_t read(uint32_t* dst, uint32_t count);
+
+      /**
+       * \brief Checks whether all words were decoded
+       */
+      bool atEnd() const {
+        return m_word == m_size;
+      }
+
+    private:
+
+      const uint8_t* m_src;
+      uint32_t       m_size;
+      uint32_t       m_word       = 0;
+      uint32_t       m_nextHeader = 0;
+      uint32_t       m_bound      = 0;
+      uint32_t       m_maxId      = 0;
+
+    };
+
     SpirvCompressedBuffer();
 
     SpirvCompressedBuffer(
       const SpirvCodeBuffer&  code);
+
+    /**
+     * \brief Restores a previously compressed buffer
+     *
+     * Takes the raw representation as returned by
+     * \c dwords and \c getData, e.g. when loading
+     * code from a disk cache.
+     */
+    SpirvCompressedBuffer(
+            uint32_t                dwords,
+            std::vector<uint8_t>&&  data);
     
     ~SpirvCompressedBuffer();
     
     SpirvCodeBuffer decompress() const;
 
-    const std::vector<uint64_t>& getCode() const {
-      return m_code;
+    /**
+     * \brief Decompresses into a caller provided buffer
+     *
+     * \param [out] dst Destination, must hold \c dwords words
+     */
+    void decompress(uint32_t* dst) const;
+
+    /**
+     * \brief Decompresses into a reusable scratch buffer
+     *
+     * Resizes the vector to \c dwords words, which only
+     * allocates if its capacity is too small.
+     * \param [out] scratch Destination
+     */
+    void decompress(std::vector<uint32_t>& scratch) const;
+
+    /**
+     * \brief Checks that the data decodes to exactly \c dwords words
+     *
+     * Must be used before decompressing a buffer
+     * restored from untrusted data.
+     */
+    bool isValid() const;
+
+    uint32_t dwords() const {
+      return m_size;
+    }
+
+    const std::vector<uint8_t>& getData() const {
+      return m_data;
     }
 
   private:
 
-    uint32_t              m_size;
-    std::vector<uint64_t> m_mask;
-    std::vector<uint64_t> m_code;
+    uint32_t             m_size;
+    std::vector<uint8_t> m_data;
 
   };
 
@@ -20,6 +20,7 @@
 * DEALINGS IN THE SOFTWARE.
 */
 #include <array>
+#include <charconv>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -953,7 +954,7 @@ namespace dxvk {
   }
 
 
-  static size_t skipWhitespace(const std::string& line, size_t n) {
+  static size_t skipWhitespace(std::string_view line, size_t n) {
     while (n < line.size() && isWhitespace(line[n]))
       n += 1;
     return n;
@@ -965,10 +966,8 @@ namespace dxvk {
   };
 
 
-  static void parseUserConfigLine(Config& config, ConfigContext& ctx, const std::string& line) {
-    std::stringstream key;
-    std::stringstream value;
-
+  // NV-DXVK start: parse lines in place instead of copying them char by char
+  static void parseUserConfigLine(Config& config, ConfigContext& ctx, std::string_view line) {
     // Extract the key
     size_t n = skipWhitespace(line, 0);
 
@@ -979,44 +978,49 @@ namespace dxvk {
       while (e > n && line[e] != ']')
         e -= 1;
 
-      while (n < e)
-        key << line[n++];
-      
-      ctx.active = key.str() == env::getExeName();
+      ctx.active = line.substr(n, e - n) == env::getExeName();
     } else {
+      const size_t keyStart = n;
       while (n < line.size() && isValidKeyChar(line[n]))
-        key << line[n++];
-      
+        n += 1;
+
+      std::string_view key = line.substr(keyStart, n - keyStart);
+
       // Check whether the next char is a '='
       n = skipWhitespace(line, n);
       if (n >= line.size() || line[n] != '=')
         return;
 
-      // Extract the value
-      bool insideString = false;
+      if (!ctx.active)
+        return;
+
+      // Extract the value, white-space is kept and quotes are dropped
       n = skipWhitespace(line, n + 1);
 
+      std::string value;
+      value.reserve(line.size() - n);
+
       while (n < line.size()) {
-        // NV-DXVK start: allow white-space in vector entries within a line
-        // NV-DXVK end
-        if (line[n] == '"') {
-          insideString = !insideString;
-          n++;
-        } else
-          value << line[n++];
+        const size_t quote = line.find('"', n);
+        value.append(line.substr(n, quote - n));
+
+        if (quote == std::string_view::npos)
+          break;
+
+        n = quote + 1;
       }
-      
-      if (ctx.active)
-        config.setOption(key.str(), value.str());
+
+      config.setOptionMove(std::string(key), std::move(value));
     }
   }
+  // NV-DXVK end
 
   // NV-DXVK start: Configuration parsing logic moved out for sharing between multiple configuration loading functions
   static Config parseConfigFile(std::string filePath) {
     Config config;
     
     // Open the file if it exists
-    std::ifstream stream(str::tows(filePath.c_str()).c_str());
+    std::ifstream stream(str::tows(filePath.c_str()).c_str(), std::ios_base::binary | std::ios_base::ate);
 
     if (!stream) {
       Logger::info(str::format("No config file found at: ", filePath));
@@ -1027,15 +1031,38 @@ namespace dxvk {
     // help when debugging configuration issues
     Logger::info(str::format("Found config file: ", filePath));
 
+    // Read the whole file at once, rtx.conf files can contain hash lists
+    // with tens of thousands of entries which are parsed in place
+    const std::streamoff size = stream.tellg();
+    std::string data(size > 0 ? size_t(size) : 0, '\0');
+    stream.seekg(0);
+
+    if (!stream.read(data.data(), data.size())) {
+      Logger::warn(str::format("Failed to read config file: ", filePath));
+      return config;
+    }
+
     // Initialize parser context
     ConfigContext ctx;
     ctx.active = true;
 
     // Parse the file line by line
-    std::string line;
+    std::string_view remaining = data;
+
+    while (!remaining.empty()) {
+      const size_t end = remaining.find('\n');
+      std::string_view line = remaining.substr(0, end);
+
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
 
-    while (std::getline(stream, line))
       parseUserConfigLine(config, ctx, line);
+
+      if (end == std::string_view::npos)
+        break;
+
+      remaining.remove_prefix(end + 1);
+    }
     
     Logger::info("Parsed config file.");
     return config;
@@ -1163,6 +1190,35 @@ namespace dxvk {
       ? iter->second : std::string();
   }
 
+  // NV-DXVK start: single pass list parsing
+  const std::string* Config::findOptionValue(const char* option) const {
+    auto iter = m_options.find(option);
+
+    return iter != m_options.end()
+      ? &iter->second : nullptr;
+  }
+
+  bool Config::parseHashListEntry(std::string_view entry, uint64_t& result) {
+    size_t n = skipWhitespace(entry, 0);
+
+    if (entry.size() - n >= 2 && entry[n] == '0' && (entry[n + 1] == 'x' || entry[n + 1] == 'X'))
+      n += 2;
+
+    const char* end = entry.data() + entry.size();
+    return std::from_chars(entry.data() + n, end, result, 16).ec == std::errc();
+  }
+
+  bool Config::parseIntListEntry(std::string_view entry, int32_t& result) {
+    size_t n = skipWhitespace(entry, 0);
+
+    if (n < entry.size() && entry[n] == '+')
+      n += 1;
+
+    const char* end = entry.data() + entry.size();
+    return std::from_chars(entry.data() + n, end, result, 10).ec == std::errc();
+  }
+  // NV-DXVK end
+
   bool Config::parseOptionValue(
     const std::string&  value,
           std::string&  result) {
@@ -1175,11 +1231,9 @@ namespace dxvk {
   bool Config::parseOptionValue(
     const std::string& value,
     std::vector<std::string>& result) {
-    std::stringstream ss(value);
-    std::string s;
-    while (std::getline(ss, s, ',')) {
-      result.push_back(s);
-    }
+    forEachListEntry(value, [&result] (std::string_view entry) {
+      result.emplace_back(entry);
+    });
     return true;
   }
 
@@ -1416,11 +1470,24 @@ namespace dxvk {
   // NV-DXVK end 
 
   Config Config::getAppConfig(const std::string& appName) {
-    auto appConfig = std::find_if(g_appDefaults.begin(), g_appDefaults.end(),
-      [&appName] (const std::pair<const char*, Config>& pair) {
-        std::regex expr(pair.first, std::regex::extended | std::regex::icase);
+    // NV-DXVK start: compile the app profile patterns only once
+    static const std::vector<std::regex> s_appPatterns = [] {
+      std::vector<std::regex> patterns;
+      patterns.reserve(g_appDefaults.size());
+
+      for (const auto& pair : g_appDefaults)
+        patterns.emplace_back(pair.first, std::regex::extended | std::regex::icase | std::regex::optimize);
+
+      return patterns;
+    }();
+
+    auto appPattern = std::find_if(s_appPatterns.begin(), s_appPatterns.end(),
+      [&appName] (const std::regex& expr) {
         return std::regex_search(appName, expr);
       });
+
+    auto appConfig = g_appDefaults.begin() + (appPattern - s_appPatterns.begin());
+    // NV-DXVK end
     
     if (appConfig != g_appDefaults.end()) {
       // NV-DXVK change: Update getAppConfig logging
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -295,6 +296,60 @@ namespace dxvk {
       return result;
     }
 
+    // NV-DXVK start: single pass list parsing
+    /**
+     * \brief Finds the raw value of an option
+     *
+     * Unlike \ref getOption, this does not copy the
+     * value, which matters for long hash lists.
+     * \param [in] option Option name
+     * \returns The option value, or \c nullptr if it is not set
+     */
+    const std::string* findOptionValue(const char* option) const;
+
+    /**
+     * \brief Calls a function for every entry of a comma separated list
+     *
+     * Entries are views into the value and keep any whitespace,
+     * matching what \c std::getline with a ',' delimiter returns.
+     * \param [in] value List value
+     * \param [in] fn Function called with each entry
+     */
+    template<typename Fn>
+    static void forEachListEntry(std::string_view value, Fn&& fn) {
+      while (!value.empty()) {
+        const size_t comma = value.find(',');
+        fn(value.substr(0, comma));
+
+        if (comma == std::string_view::npos)
+          break;
+
+        value.remove_prefix(comma + 1);
+      }
+    }
+
+    /**
+     * \brief Parses a hexadecimal hash list entry
+     *
+     * Accepts leading whitespace and an optional 0x prefix and stops
+     * at the first character that is not a hex digit, like \c std::stoull
+     * with base 16 does.
+     * \param [in] entry List entry
+     * \param [out] result Parsed hash
+     * \returns \c false if the entry does not start with a hash
+     */
+    static bool parseHashListEntry(std::string_view entry, uint64_t& result);
+
+    /**
+     * \brief Parses a decimal integer list entry, see \c std::stoi
+     *
+     * \param [in] entry List entry
+     * \param [out] result Parsed integer
+     * \returns \c false if the entry does not start with an integer
+     */
+    static bool parseIntListEntry(std::string_view entry, int32_t& result);
+    // NV-DXVK end
+
     // NV-DXVK start: Extend logOptions function
     /**
      * \brief Logs option values
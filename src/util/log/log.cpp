@@ -21,6 +21,9 @@
 */
 #include "log.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "../util_env.h"
 
 
@@ -46,7 +49,9 @@ namespace{
     struct timeval tv;
     gettimeofday(&tv, NULL);
 
-    struct tm* lt = localtime(&tv.tv_sec);
+    // Messages are timestamped outside of any lock
+    struct tm ltStorage;
+    struct tm* lt = localtime_r(&tv.tv_sec, &ltStorage);
 
     sprintf_s(timeString, format,
               lt->tm_hour, lt->tm_min, lt->tm_sec, (tv.tv_usec / 1000) % 1000);
@@ -55,24 +60,138 @@ namespace{
 }
 // NV-DXVK end
 
+// NV-DXVK start: Asynchronous logging
+namespace {
+  uint64_t getTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void appendJsonString(std::string& out, const std::string& str) {
+    out += '"';
+    for (const char c : str) {
+      switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+          out += escaped;
+        } else {
+          out += c;
+        }
+      }
+    }
+    out += '"';
+  }
+
+  // Window over which identical messages are counted for rate limiting
+  constexpr uint64_t kRepeatWindowMs = 1000;
+  // Upper bound of tracked messages before expired windows are swept outside of the writer tick
+  constexpr size_t kMaxTrackedRepeats = 1024;
+}
+// NV-DXVK end
+
 namespace dxvk {
 
+  // NV-DXVK start: Asynchronous logging
+  /**
+   * \brief Per-thread log record ring
+   *
+   * Single producer, single consumer ring. The owning thread
+   * pushes, whoever holds the logger's write mutex drains.
+   */
+  struct LogThreadBuffer {
+    static constexpr uint32_t Capacity = 256;
+
+    std::array<LogRecord, Capacity> records;
+    std::atomic<uint32_t> head = { 0u };
+    std::atomic<uint32_t> tail = { 0u };
+
+    bool push(LogRecord& record) {
+      const uint32_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) == Capacity)
+        return false;
+
+      records[t % Capacity] = std::move(record);
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    uint32_t size() const {
+      return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    template<typename Fn>
+    void drain(const Fn& fn) {
+      const uint32_t t = tail.load(std::memory_order_acquire);
+      uint32_t h = head.load(std::memory_order_relaxed);
+
+      for (; h != t; h++)
+        fn(std::move(records[h % Capacity]));
+
+      head.store(h, std::memory_order_release);
+    }
+  };
+  // NV-DXVK end
+
   Logger::Logger(const std::string& file_name)
   : m_minLevel(getMinLogLevel())
   // NV-DXVK start: Don't double print every line
   , m_doublePrintToStdErr(getDoublePrintToStdErr())
   // NV-DXVK end
+  // NV-DXVK start: Asynchronous logging
+  , m_async(getAsync())
+  , m_rateLimit(getRateLimit())
+  // NV-DXVK end
   {
     if (m_minLevel != LogLevel::None) {
       auto path = getFileName(file_name);
 
-      if (!path.empty())
+      if (!path.empty()) {
         m_fileStream = std::ofstream(str::tows(path.c_str()).c_str());
+
+        // NV-DXVK start: Asynchronous logging
+        if (getJsonOutput())
+          m_jsonStream = std::ofstream(str::tows((path + ".jsonl").c_str()).c_str());
+        // NV-DXVK end
+      }
     }
   }
   
   
-  Logger::~Logger() { }
+  Logger::~Logger() {
+    // NV-DXVK start: Asynchronous logging
+    if (m_writer.joinable()) {
+      {
+        std::lock_guard<dxvk::mutex> lock(m_writerMutex);
+        m_stopWriter = true;
+      }
+      m_writerCond.notify_one();
+
+      // Joining could deadlock on the loader lock when the DLL is unloaded, so only wait for the
+      // writer to leave its loop. On process exit the writer has already been terminated.
+      if (!this_thread::isInModuleDetachment()) {
+        while (!m_writerStopped.load())
+          this_thread::yield();
+      }
+
+      m_writer.detach();
+    }
+
+    // A terminated writer may still own the lock, in which case the remaining messages are lost
+    if (m_writeMutex.try_lock()) {
+      drainThreadBuffers();
+      flushRepeats(0, true);
+      flushStreams();
+      m_writeMutex.unlock();
+    }
+    // NV-DXVK end
+  }
   
   
   void Logger::trace(const std::string& message) {
@@ -103,37 +222,250 @@ namespace dxvk {
   void Logger::log(LogLevel level, const std::string& message) {
     s_instance.emitMsg(level, message);
   }
+
+
+  // NV-DXVK start: Asynchronous logging
+  void Logger::flush() {
+    Logger& logger = s_instance;
+
+    std::lock_guard<dxvk::mutex> lock(logger.m_writeMutex);
+    logger.drainThreadBuffers();
+    logger.flushRepeats(0, true);
+    logger.flushStreams();
+  }
+  // NV-DXVK end
   
   
   void Logger::emitMsg(LogLevel level, const std::string& message) {
     if (level >= m_minLevel) {
-      OutputDebugString(str::format(message, "\n\n").c_str());
+      // NV-DXVK start: Asynchronous logging
+      LogRecord record;
+      record.sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
+      record.timeMs = getTimeMs();
+      record.threadId = this_thread::get_id();
+      record.level = level;
+      getLocalTimeString(record.timeString);
+      record.message = message;
+
+      if (!m_async) {
+        std::lock_guard<dxvk::mutex> lock(m_writeMutex);
+        processRecord(record);
+        flushStreams();
+        return;
+      }
+
+      LogThreadBuffer& buffer = getThreadBuffer();
+
+      if (!buffer.push(record)) {
+        // The writer can't keep up, or can't run yet because the loader lock is
+        // held, so drain on this thread rather than dropping the message.
+        std::lock_guard<dxvk::mutex> lock(m_writeMutex);
+        drainThreadBuffers();
+        buffer.push(record);
+      }
+
+      if (level >= LogLevel::Error) {
+        // Errors often precede a crash, write them out right away
+        std::lock_guard<dxvk::mutex> lock(m_writeMutex);
+        drainThreadBuffers();
+        flushStreams();
+      } else if (!m_writerStarted.load(std::memory_order_relaxed)) {
+        startWriter();
+      } else if (buffer.size() >= LogThreadBuffer::Capacity / 2) {
+        m_writerCond.notify_one();
+      }
+      // NV-DXVK end
+    }
+  }
 
-      std::lock_guard<dxvk::mutex> lock(m_mutex);
-      
-      static std::array<const char*, 5> s_prefixes
-        = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
-      
-      const char* prefix = s_prefixes.at(static_cast<uint32_t>(level));
 
-      std::stringstream stream(message);
-      std::string       line;
+  // NV-DXVK start: Asynchronous logging
+  LogThreadBuffer& Logger::getThreadBuffer() {
+    thread_local std::shared_ptr<LogThreadBuffer> t_buffer;
+    if (!t_buffer) {
+      t_buffer = std::make_shared<LogThreadBuffer>();
+      std::lock_guard<dxvk::mutex> lock(m_threadBuffersMutex);
+      m_threadBuffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+  }
+
+
+  void Logger::startWriter() {
+    if (m_writerStarted.exchange(true))
+      return;
+
+    try {
+      m_writer = dxvk::thread([this] { runWriter(); });
+    } catch (...) {
+      // Producers drain their own buffers once they fill up
+    }
+  }
+
 
-      char timeString[64];
-      getLocalTimeString(timeString);
+  void Logger::runWriter() {
+    env::setThreadName("dxvk-log");
+
+    std::unique_lock<dxvk::mutex> lock(m_writerMutex);
+
+    while (!m_stopWriter) {
+      m_writerCond.wait_for(lock, std::chrono::milliseconds(20), [this] { return m_stopWriter; });
+      lock.unlock();
+
+      {
+        std::lock_guard<dxvk::mutex> writeLock(m_writeMutex);
+        drainThreadBuffers();
+
+        if (!m_repeats.empty())
+          flushRepeats(getTimeMs(), false);
+
+        flushStreams();
+      }
+
+      lock.lock();
+    }
 
-      while (std::getline(stream, line, '\n')) {
-        // NV-DXVK start: Don't double print every line
-        if(m_doublePrintToStdErr) {
-          std::cerr << timeString << prefix << line << std::endl;
+    lock.unlock();
+    m_writerStopped.store(true);
+  }
+
+
+  void Logger::drainThreadBuffers() {
+    {
+      std::lock_guard<dxvk::mutex> lock(m_threadBuffersMutex);
+
+      for (auto iter = m_threadBuffers.begin(); iter != m_threadBuffers.end(); ) {
+        // Check before draining, a thread may still push right before it exits
+        const bool threadExited = iter->use_count() == 1;
+
+        (*iter)->drain([this] (LogRecord&& record) {
+          m_batch.push_back(std::move(record));
+        });
+
+        if (threadExited) {
+          iter = m_threadBuffers.erase(iter);
+        } else {
+          ++iter;
         }
-        // NV-DXVK end
+      }
+    }
+
+    // Restore the global order of messages from different threads
+    std::sort(m_batch.begin(), m_batch.end(), [] (const LogRecord& a, const LogRecord& b) {
+      return a.sequence < b.sequence;
+    });
+
+    for (const LogRecord& record : m_batch)
+      processRecord(record);
+
+    m_batch.clear();
+  }
+
+
+  void Logger::processRecord(const LogRecord& record) {
+    // Errors are never suppressed
+    if (m_rateLimit != 0 && record.level != LogLevel::Error) {
+      const size_t key = std::hash<std::string>()(record.message) + static_cast<size_t>(record.level);
+      RepeatState& state = m_repeats[key];
+
+      if (state.count == 0 || record.timeMs - state.windowStartMs >= kRepeatWindowMs) {
+        if (state.suppressed != 0)
+          writeRecord(state.lastSuppressed, state.suppressed);
+
+        state.windowStartMs = record.timeMs;
+        state.count = 0;
+        state.suppressed = 0;
+      }
+
+      if (++state.count > m_rateLimit) {
+        state.suppressed++;
+        state.lastSuppressed = record;
+        return;
+      }
+
+      if (m_repeats.size() > kMaxTrackedRepeats)
+        flushRepeats(record.timeMs, false);
+    }
+
+    writeRecord(record, 0);
+  }
+
+
+  void Logger::flushRepeats(uint64_t nowMs, bool all) {
+    for (auto iter = m_repeats.begin(); iter != m_repeats.end(); ) {
+      RepeatState& state = iter->second;
+
+      if (all || nowMs - state.windowStartMs >= kRepeatWindowMs) {
+        if (state.suppressed != 0)
+          writeRecord(state.lastSuppressed, state.suppressed);
+
+        iter = m_repeats.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
 
-        if (m_fileStream)
-          m_fileStream << timeString << prefix << line << std::endl;
+  void Logger::flushStreams() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_fileStream)
+      m_fileStream.flush();
+
+    if (m_jsonStream)
+      m_jsonStream.flush();
+  }
+
+
+  void Logger::writeRecord(const LogRecord& record, uint32_t suppressed) {
+    const std::string message = suppressed == 0 ? record.message
+      : str::format("(suppressed ", suppressed, " repeats of) ", record.message);
+
+    OutputDebugString(str::format(message, "\n\n").c_str());
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    static std::array<const char*, 5> s_prefixes
+      = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
+
+    const char* prefix = s_prefixes.at(static_cast<uint32_t>(record.level));
+
+    std::stringstream stream(message);
+    std::string       line;
+
+    while (std::getline(stream, line, '\n')) {
+      // NV-DXVK start: Don't double print every line
+      if(m_doublePrintToStdErr) {
+        std::cerr << record.timeString << prefix << line << '\n';
       }
+      // NV-DXVK end
+
+      if (m_fileStream)
+        m_fileStream << record.timeString << prefix << line << '\n';
+    }
+
+    if (m_jsonStream) {
+      static std::array<const char*, 5> s_levels
+        = {{ "trace", "debug", "info", "warn", "error" }};
+
+      // Time without the brackets and trailing space of the text prefix
+      const std::string time(record.timeString);
+
+      std::string json = str::format("{\"seq\":", record.sequence,
+                                     ",\"time\":\"", time.substr(1, time.size() > 3 ? time.size() - 3 : 0),
+                                     "\",\"level\":\"", s_levels.at(static_cast<uint32_t>(record.level)),
+                                     "\",\"thread\":", record.threadId,
+                                     ",\"message\":");
+      appendJsonString(json, record.message);
+
+      if (suppressed != 0)
+        json += str::format(",\"suppressed\":", suppressed);
+
+      m_jsonStream << json << "}\n";
     }
   }
+  // NV-DXVK end
   
   
   LogLevel Logger::getMinLogLevel() {
@@ -157,6 +489,33 @@ namespace dxvk {
   }
   
   
+  // NV-DXVK start: Asynchronous logging
+  bool Logger::getAsync() {
+    return env::getEnvVar("DXVK_LOG_ASYNC") != "0";
+  }
+
+
+  uint32_t Logger::getRateLimit() {
+    const std::string str = env::getEnvVar("DXVK_LOG_RATE_LIMIT");
+
+    if (str.empty())
+      return 10;
+
+    try {
+      return static_cast<uint32_t>(std::stoul(str));
+    } catch (...) {
+      return 10;
+    }
+  }
+
+
+  bool Logger::getJsonOutput() {
+    const std::string str = env::getEnvVar("DXVK_LOG_JSON");
+    return !str.empty() && str != "0";
+  }
+  // NV-DXVK end
+
+
   std::string Logger::getFileName(const std::string& base) {
     std::string path = env::getEnvVar("DXVK_LOG_PATH");
     
@@ -22,10 +22,17 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "../util_once.h"
+// NV-DXVK start: Lazy formatting
+#include "../util_string.h"
+// NV-DXVK end
 
 #include "../thread.h"
 
@@ -40,11 +47,30 @@ namespace dxvk {
     None  = 5,
   };
 
+  // NV-DXVK start: Asynchronous logging
+  struct LogRecord {
+    uint64_t    sequence = 0;
+    uint64_t    timeMs = 0;
+    uint32_t    threadId = 0;
+    LogLevel    level = LogLevel::Info;
+    char        timeString[32] = { };
+    std::string message;
+  };
+
+  struct LogThreadBuffer;
+  // NV-DXVK end
+
   /**
    * \brief Logger
    * 
    * Logger for one DLL. Creates a text file and
    * writes all log messages to that file.
+   *
+   * Messages are queued in per-thread ring buffers and written by
+   * a background thread, so logging never blocks on file I/O. Errors
+   * are written synchronously. Identical non-error messages repeated more
+   * than \c DXVK_LOG_RATE_LIMIT times per second are suppressed, and
+   * \c DXVK_LOG_JSON additionally writes a JSON-lines copy of the log.
    */
   class Logger {
     
@@ -59,6 +85,34 @@ namespace dxvk {
     static void warn (const std::string& message);
     static void err  (const std::string& message);
     static void log  (LogLevel level, const std::string& message);
+
+    // NV-DXVK start: Lazy formatting, the arguments are only passed to
+    // str::format when the message is not filtered out by the log level
+    template<typename... Args>
+    static void trace(const Args&... args) { log(LogLevel::Trace, args...); }
+    template<typename... Args>
+    static void debug(const Args&... args) { log(LogLevel::Debug, args...); }
+    template<typename... Args>
+    static void info (const Args&... args) { log(LogLevel::Info, args...); }
+    template<typename... Args>
+    static void warn (const Args&... args) { log(LogLevel::Warn, args...); }
+    template<typename... Args>
+    static void err  (const Args&... args) { log(LogLevel::Error, args...); }
+
+    template<typename... Args>
+    static void log(LogLevel level, const Args&... args) {
+      if (level >= logLevel())
+        s_instance.emitMsg(level, str::format(args...));
+    }
+
+    /**
+     * \brief Writes out all queued messages
+     *
+     * Blocks until every message logged before
+     * the call has been written to the log file.
+     */
+    static void flush();
+    // NV-DXVK end
     
     static LogLevel logLevel() {
       return s_instance.m_minLevel;
@@ -75,6 +129,61 @@ namespace dxvk {
     
     dxvk::mutex   m_mutex;
     std::ofstream m_fileStream;
+
+    // NV-DXVK start: Asynchronous logging
+    struct RepeatState {
+      uint64_t  windowStartMs = 0;
+      uint32_t  count = 0;
+      uint32_t  suppressed = 0;
+      LogRecord lastSuppressed;
+    };
+
+    const bool     m_async;
+    const uint32_t m_rateLimit;
+
+    std::ofstream m_jsonStream;
+
+    std::atomic<uint64_t> m_sequence = { 0u };
+
+    // Protects the list of thread buffers
+    dxvk::mutex m_threadBuffersMutex;
+    std::vector<std::shared_ptr<LogThreadBuffer>> m_threadBuffers;
+
+    // Held by whoever drains the thread buffers, which makes that the single
+    // consumer of every buffer. m_mutex only guards the output streams.
+    dxvk::mutex m_writeMutex;
+    std::vector<LogRecord> m_batch;
+    std::unordered_map<size_t, RepeatState> m_repeats;
+
+    dxvk::mutex              m_writerMutex;
+    dxvk::condition_variable m_writerCond;
+    dxvk::thread             m_writer;
+    std::atomic<bool>        m_writerStarted = { false };
+    std::atomic<bool>        m_writerStopped = { false };
+    bool                     m_stopWriter = false;
+
+    LogThreadBuffer& getThreadBuffer();
+
+    void startWriter();
+
+    void runWriter();
+
+    void drainThreadBuffers();
+
+    void processRecord(const LogRecord& record);
+
+    void flushStreams();
+
+    void writeRecord(const LogRecord& record, uint32_t suppressed);
+
+    void flushRepeats(uint64_t nowMs, bool all);
+
+    static bool getAsync();
+
+    static uint32_t getRateLimit();
+
+    static bool getJsonOutput();
+    // NV-DXVK end
     
     void emitMsg(LogLevel level, const std::string& message);
     
@@ -21,13 +21,124 @@
 */
 #include "metrics.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
 #include "../util_env.h"
+#include "../util_string.h"
+#include "log.h"
 #include "util_math.h"
 
 namespace dxvk {
+
+  namespace {
+    enum class MetricType {
+      Counter,
+      Gauge,
+      Histogram,
+    };
+
+    struct MetricEntry {
+      std::string name;
+      MetricType  type;
+      uint32_t    firstColumn = 0;
+      uint64_t    lastCounterValue = 0;
+
+      std::unique_ptr<MetricCounter>   counter;
+      std::unique_ptr<MetricGauge>     gauge;
+      std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    struct MetricSample {
+      uint64_t            frameId = 0;
+      std::vector<double> values;
+    };
+
+    struct MetricsRegistry {
+      dxvk::mutex mutex;
+
+      // In registration order, which is also the column order of the time series
+      std::vector<std::unique_ptr<MetricEntry>> entries;
+      std::unordered_map<std::string, MetricEntry*> entriesByName;
+      std::vector<std::string> columns;
+
+      // Samples are written into a fixed ring which is exported once full
+      std::vector<MetricSample> samples;
+      uint32_t numSamples = 0;
+
+      std::ofstream stream;
+      bool streamOpened = false;
+    };
+
+    MetricsRegistry& getRegistry() {
+      static MetricsRegistry s_registry;
+      return s_registry;
+    }
+
+    uint32_t getExportInterval() {
+      const std::string str = env::getEnvVar("DXVK_METRICS_EXPORT_INTERVAL");
+
+      try {
+        return str.empty() ? 60 : std::max<uint32_t>(static_cast<uint32_t>(std::stoul(str)), 1);
+      } catch (...) {
+        return 60;
+      }
+    }
+
+    MetricEntry& getEntry(const char* name, MetricType type) {
+      MetricsRegistry& registry = getRegistry();
+      std::lock_guard<dxvk::mutex> lock(registry.mutex);
+
+      auto iter = registry.entriesByName.find(name);
+      if (iter != registry.entriesByName.end()) {
+        if (iter->second->type == type) {
+          return *iter->second;
+        }
+
+        // Hand out a detached metric rather than failing, it's just never sampled
+        Logger::err(str::format("Metrics: ", name, " was already registered with a different type."));
+        static std::vector<std::unique_ptr<MetricEntry>> s_detachedEntries;
+        auto& entry = s_detachedEntries.emplace_back(std::make_unique<MetricEntry>());
+        entry->name = name;
+        entry->type = type;
+        entry->counter = std::make_unique<MetricCounter>();
+        entry->gauge = std::make_unique<MetricGauge>();
+        entry->histogram = std::make_unique<MetricHistogram>();
+        return *entry;
+      }
+
+      auto& entry = registry.entries.emplace_back(std::make_unique<MetricEntry>());
+      entry->name = name;
+      entry->type = type;
+      entry->firstColumn = static_cast<uint32_t>(registry.columns.size());
+
+      switch (type) {
+      case MetricType::Counter:
+        entry->counter = std::make_unique<MetricCounter>();
+        registry.columns.push_back(name);
+        break;
+      case MetricType::Gauge:
+        entry->gauge = std::make_unique<MetricGauge>();
+        registry.columns.push_back(name);
+        break;
+      case MetricType::Histogram:
+        entry->histogram = std::make_unique<MetricHistogram>();
+        for (const char* suffix : { ".count", ".mean", ".max", ".p50", ".p95" }) {
+          registry.columns.push_back(str::format(name, suffix));
+        }
+        break;
+      }
+
+      registry.entriesByName.emplace(name, entry.get());
+      return *entry;
+    }
+  }
+
+  std::atomic<bool> Metrics::s_recording = { getTimeSeriesFormat() != TimeSeriesFormat::None };
   
   Metrics::Metrics() {
-    auto path = getFileName();
+    auto path = getFileName("metrics.txt");
 
     if (!path.empty())
       m_fileStream = std::ofstream(str::tows(path.c_str()).c_str());
@@ -48,13 +159,165 @@ namespace dxvk {
       s_instance.emitMsg((Metric)i, s_instance.m_data[i]);
   }
 
+  MetricCounter& Metrics::counter(const char* name) {
+    return *getEntry(name, MetricType::Counter).counter;
+  }
+
+  MetricGauge& Metrics::gauge(const char* name) {
+    return *getEntry(name, MetricType::Gauge).gauge;
+  }
+
+  MetricHistogram& Metrics::histogram(const char* name) {
+    return *getEntry(name, MetricType::Histogram).histogram;
+  }
+
+  void Metrics::endFrame(uint64_t frameId) {
+    if (!isRecording())
+      return;
+
+    MetricsRegistry& registry = getRegistry();
+    {
+      std::lock_guard<dxvk::mutex> lock(registry.mutex);
+
+      if (registry.samples.empty())
+        registry.samples.resize(getExportInterval());
+
+      MetricSample& sample = registry.samples[registry.numSamples++];
+      sample.frameId = frameId;
+      sample.values.resize(registry.columns.size());
+
+      for (const auto& entry : registry.entries) {
+        double* values = sample.values.data() + entry->firstColumn;
+
+        switch (entry->type) {
+        case MetricType::Counter: {
+          const uint64_t value = entry->counter->get();
+          values[0] = static_cast<double>(value - entry->lastCounterValue);
+          entry->lastCounterValue = value;
+          break;
+        }
+        case MetricType::Gauge:
+          values[0] = entry->gauge->get();
+          break;
+        case MetricType::Histogram: {
+          const MetricHistogram::Snapshot snapshot = entry->histogram->takeSnapshot();
+          values[0] = static_cast<double>(snapshot.count);
+          values[1] = snapshot.count ? snapshot.sum / snapshot.count : 0.0;
+          values[2] = snapshot.max;
+          values[3] = snapshot.p50;
+          values[4] = snapshot.p95;
+          break;
+        }
+        }
+      }
+
+      if (registry.numSamples < registry.samples.size())
+        return;
+    }
+
+    exportTimeSeries();
+  }
+
+  void Metrics::exportTimeSeries() {
+    MetricsRegistry& registry = getRegistry();
+    std::lock_guard<dxvk::mutex> lock(registry.mutex);
+
+    const TimeSeriesFormat format = getTimeSeriesFormat();
+    if (format == TimeSeriesFormat::None || registry.numSamples == 0)
+      return;
+
+    if (!registry.streamOpened) {
+      registry.streamOpened = true;
+
+      const std::string path = getFileName(format == TimeSeriesFormat::Csv ? "metrics_time_series.csv" : "metrics_time_series.json");
+      if (!path.empty()) {
+        registry.stream = std::ofstream(str::tows(path.c_str()).c_str());
+        registry.stream << std::setprecision(15);
+      }
+
+      // Note: Long format, so metrics registered later on don't change the layout
+      if (format == TimeSeriesFormat::Csv)
+        registry.stream << "frame,metric,value\n";
+    }
+
+    if (registry.stream) {
+      for (uint32_t i = 0; i < registry.numSamples; i++) {
+        const MetricSample& sample = registry.samples[i];
+
+        if (format == TimeSeriesFormat::Csv) {
+          for (size_t column = 0; column < sample.values.size(); column++)
+            registry.stream << sample.frameId << ',' << registry.columns[column] << ',' << sample.values[column] << '\n';
+        } else {
+          registry.stream << "{\"frame\":" << sample.frameId << ",\"metrics\":{";
+          for (size_t column = 0; column < sample.values.size(); column++) {
+            // Note: Metric names are identifiers, so they are written without escaping
+            registry.stream << (column ? ",\"" : "\"") << registry.columns[column] << "\":" << sample.values[column];
+          }
+          registry.stream << "}}\n";
+        }
+      }
+
+      registry.stream.flush();
+    }
+
+    registry.numSamples = 0;
+  }
+
+  void MetricHistogram::record(double value) {
+    if (!Metrics::isRecording())
+      return;
+
+    int bucket = 0;
+    if (value > 0.0) {
+      int exponent;
+      std::frexp(value, &exponent);
+      bucket = std::clamp(exponent + kBucketOffset, 0, kNumBuckets - 1);
+    }
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    double sum = m_sum.load(std::memory_order_relaxed);
+    while (!m_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) { }
+
+    double max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+  }
+
+  MetricHistogram::Snapshot MetricHistogram::takeSnapshot() {
+    std::array<uint64_t, kNumBuckets> counts;
+
+    Snapshot snapshot;
+    for (int i = 0; i < kNumBuckets; i++) {
+      counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+      snapshot.count += counts[i];
+    }
+    snapshot.sum = m_sum.exchange(0.0, std::memory_order_relaxed);
+    snapshot.max = m_max.exchange(0.0, std::memory_order_relaxed);
+
+    // Percentiles are reported as the upper bound of their bucket, capped by the max
+    const uint64_t p50Rank = (snapshot.count + 1) / 2;
+    const uint64_t p95Rank = (snapshot.count * 95 + 99) / 100;
+    uint64_t rank = 0;
+    for (int i = 0; i < kNumBuckets && rank < p95Rank; i++) {
+      const uint64_t prevRank = rank;
+      rank += counts[i];
+
+      const double upperBound = std::min(std::ldexp(1.0, i - kBucketOffset), snapshot.max);
+      if (prevRank < p50Rank && rank >= p50Rank)
+        snapshot.p50 = upperBound;
+      if (rank >= p95Rank)
+        snapshot.p95 = upperBound;
+    }
+
+    return snapshot;
+  }
+
   template<typename T>
   void Metrics::emitMsg(Metric metric, const T& value) {
     if(m_fileStream)
       m_fileStream << m_metricNames[(uint32_t)metric] << " " << value << std::endl;
   }
   
-  std::string Metrics::getFileName() {
+  std::string Metrics::getFileName(const std::string& name) {
     std::string path = env::getEnvVar("DXVK_METRICS_PATH");
     
     if (path == "none")
@@ -63,7 +326,17 @@ namespace dxvk {
     if (!path.empty() && *path.rbegin() != '/')
       path += '/';
 
-    path += "metrics.txt";
+    path += name;
     return path;
   }
+
+  Metrics::TimeSeriesFormat Metrics::getTimeSeriesFormat() {
+    const std::string format = env::getEnvVar("DXVK_METRICS_TIME_SERIES");
+
+    if (format == "csv")
+      return TimeSeriesFormat::Csv;
+    if (format == "json")
+      return TimeSeriesFormat::Json;
+    return TimeSeriesFormat::None;
+  }
 }
@@ -22,11 +22,15 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "../thread.h"
 
@@ -40,20 +44,69 @@ namespace dxvk {
     kCount
   };
 
+  class MetricCounter;
+  class MetricGauge;
+  class MetricHistogram;
+
   /**
    * \brief Metrics
    * 
    * Metrics for one DLL. Creates a text file and
    * writes all metrics messages to that file.
+   *
+   * Also holds a registry of named counters, gauges and histograms, which
+   * subsystems look up once and then update directly. When enabled through
+   * \c DXVK_METRICS_TIME_SERIES, every registered metric is sampled once per
+   * frame into a ring, which is exported every \c DXVK_METRICS_EXPORT_INTERVAL
+   * frames as CSV or JSON lines. Updating a metric costs a single relaxed atomic
+   * load when the time series is disabled.
    */
   class Metrics {
   public:
+    enum class TimeSeriesFormat {
+      None,
+      Csv,
+      Json,
+    };
+
     Metrics();
     ~Metrics();
     
     static void log(Metric metric, const float& value);
     static void serialize();
 
+    /**
+     * \brief Looks up or registers a metric
+     *
+     * The returned reference stays valid for the lifetime of the
+     * process, so callers should look it up once and keep it, e.g.
+     * in a function local static. Names are unique across types.
+     */
+    static MetricCounter& counter(const char* name);
+    static MetricGauge& gauge(const char* name);
+    static MetricHistogram& histogram(const char* name);
+
+    static bool isRecording() {
+      return s_recording.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Samples all registered metrics
+     *
+     * Called once per frame, from a single thread. Counters
+     * and histograms are sampled as their change since the
+     * last frame, gauges as their current value.
+     */
+    static void endFrame(uint64_t frameId);
+
+    /**
+     * \brief Exports the time series
+     *
+     * Writes all samples not exported yet. Called automatically
+     * by endFrame once the export interval has passed.
+     */
+    static void exportTimeSeries();
+
   private:
     inline static const std::string m_metricNames[kCount] = {
       "average_frame_time",
@@ -65,6 +118,8 @@ namespace dxvk {
     std::array<float, Metric::kCount> m_data = {};
 
     static Metrics s_instance;
+
+    static std::atomic<bool> s_recording;
     
     dxvk::mutex    m_mutex;
     std::ofstream m_fileStream;
@@ -72,6 +127,107 @@ namespace dxvk {
     template<typename T>
     void emitMsg(Metric metric, const T& value);
     
-    static std::string getFileName();
+    static std::string getFileName(const std::string& name);
+
+    static TimeSeriesFormat getTimeSeriesFormat();
+  };
+
+
+  /**
+   * \brief Monotonic counter, sampled per frame as its increment
+   */
+  class MetricCounter {
+  public:
+    void add(uint64_t value = 1) {
+      if (Metrics::isRecording())
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const {
+      return m_value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint64_t> m_value = { 0ull };
+  };
+
+
+  /**
+   * \brief Last set value, sampled per frame as is
+   */
+  class MetricGauge {
+  public:
+    void set(double value) {
+      if (Metrics::isRecording())
+        m_value.store(value, std::memory_order_relaxed);
+    }
+
+    double get() const {
+      return m_value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<double> m_value = { 0.0 };
+  };
+
+
+  /**
+   * \brief Distribution of recorded values
+   *
+   * Values are binned into power of two buckets, so percentiles
+   * are reported as the upper bound of their bucket.
+   */
+  class MetricHistogram {
+  public:
+    static constexpr int kNumBuckets = 64;
+    // Bucket i holds values in [2^(i - kBucketOffset - 1), 2^(i - kBucketOffset))
+    static constexpr int kBucketOffset = 32;
+
+    struct Snapshot {
+      uint64_t count = 0;
+      double   sum = 0.0;
+      double   max = 0.0;
+      double   p50 = 0.0;
+      double   p95 = 0.0;
+    };
+
+    void record(double value);
+
+    /**
+     * \brief Returns and resets the values recorded since the last snapshot
+     */
+    Snapshot takeSnapshot();
+
+  private:
+    std::array<std::atomic<uint64_t>, kNumBuckets> m_buckets = {};
+    std::atomic<double> m_sum = { 0.0 };
+    std::atomic<double> m_max = { 0.0 };
+  };
+
+
+  /**
+   * \brief Records the lifetime of the scope in milliseconds
+   */
+  class ScopedMetricTimer {
+  public:
+    explicit ScopedMetricTimer(MetricHistogram& histogram) {
+      if (Metrics::isRecording()) {
+        m_histogram = &histogram;
+        m_start = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~ScopedMetricTimer() {
+      if (m_histogram) {
+        m_histogram->record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count());
+      }
+    }
+
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator = (const ScopedMetricTimer&) = delete;
+
+  private:
+    MetricHistogram* m_histogram = nullptr;
+    std::chrono::steady_clock::time_point m_start;
   };
 }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include "sync_spinlock.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Adaptive event
+   *
+   * Lets threads wait for a condition that other threads
+   * make true through lock-free updates. Waiters spin for
+   * a while before falling back to a condition variable,
+   * and the spin budget adapts to how often spinning was
+   * enough in the past. Notifying is a fence and a load
+   * as long as no thread is actually blocked. Spinning
+   * is disabled entirely on single-core systems, where
+   * it can only delay the thread we are waiting for.
+   */
+  class AdaptiveEvent {
+    constexpr static uint32_t MinSpinCount = 64;
+    constexpr static uint32_t MaxSpinCount = 8192;
+  public:
+
+    AdaptiveEvent()
+    : m_spinCount(dxvk::thread::hardware_concurrency() > 1 ? MinSpinCount : 0u) { }
+    ~AdaptiveEvent() { }
+
+    AdaptiveEvent             (const AdaptiveEvent&) = delete;
+    AdaptiveEvent& operator = (const AdaptiveEvent&) = delete;
+
+    /**
+     * \brief Waits for a condition
+     *
+     * The condition must only change from \c false to
+     * \c true through stores that are followed by a call
+     * to \ref notify, otherwise wakeups can get lost.
+     * \param [in] fn Condition to wait for
+     * \returns \c true if the calling thread had to block
+     */
+    template<typename Fn>
+    bool wait(const Fn& fn) {
+      if (fn())
+        return false;
+
+      const uint32_t spinCount = m_spinCount.load(std::memory_order_relaxed);
+
+      if (spinCount) {
+        for (uint32_t i = 0; i < spinCount; i++) {
+          _mm_pause();
+
+          if (fn()) {
+            m_spinCount.store(std::min(spinCount * 2, MaxSpinCount), std::memory_order_relaxed);
+            return false;
+          }
+        }
+
+        m_spinCount.store(std::max(spinCount / 2, MinSpinCount), std::memory_order_relaxed);
+      }
+
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_waiters.fetch_add(1, std::memory_order_relaxed);
+
+      // Pairs with the fence in notify: either the waiter
+      // observes the new state, or the notifier observes
+      // the waiter and takes the lock before waking it up.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      m_cond.wait(lock, fn);
+      m_waiters.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    /**
+     * \brief Wakes up blocked waiters
+     *
+     * Must be called after making a condition
+     * true that other threads may wait for.
+     */
+    void notify() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (likely(!m_waiters.load(std::memory_order_relaxed)))
+        return;
+
+      { std::lock_guard<dxvk::mutex> lock(m_mutex); }
+      m_cond.notify_all();
+    }
+
+  private:
+
+    std::atomic<uint32_t>     m_waiters   = { 0u };
+    std::atomic<uint32_t>     m_spinCount;
+
+    dxvk::mutex               m_mutex;
+    dxvk::condition_variable  m_cond;
+
+  };
+
+}
@@ -21,7 +21,9 @@
 */
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <utility>
 
@@ -75,4 +77,109 @@ namespace dxvk {
     std::atomic<uint32_t> m_head;
     std::atomic<uint32_t> m_tail;
   };
+
+  /**
+    * \brief Bounded lock-free MPSC queue.
+    *        Ring buffer where every slot carries a sequence number
+    *        telling whether it is free for the producer claiming
+    *        that position or holds a published item for the consumer.
+    *        Any number of threads may "push" concurrently, while a
+    *        single thread may "pop". Items are popped in the order
+    *        in which their positions were claimed, which is the
+    *        order reported back by "push".
+    *  T: Type of the object
+    *  Capacity: Number of elements in the ring buffer, must be a power of two.
+    */
+  template <typename T, uint32_t Capacity>
+  class AtomicMpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+      "AtomicMpscQueue capacity must be a power of two");
+
+    constexpr static uint64_t Mask = Capacity - 1;
+  public:
+    AtomicMpscQueue() {
+      for (uint32_t i = 0; i < Capacity; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    AtomicMpscQueue(const AtomicMpscQueue&) = delete;
+    AtomicMpscQueue& operator = (const AtomicMpscQueue&) = delete;
+
+    /**
+      * \brief Pushes an item from any thread.
+      *        The item is only consumed on success.
+      * \param [in] item Item to push
+      * \param [out] position Zero-based position of the item in the queue
+      * \returns \c false if the queue is full
+      */
+    bool push(T&& item, uint64_t& position) {
+      uint64_t pos = m_pushPos.load(std::memory_order_relaxed);
+
+      while (true) {
+        Slot& slot = m_slots[pos & Mask];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const int64_t diff = int64_t(sequence - pos);
+
+        if (diff == 0) {
+          if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            break;
+          }
+        } else if (diff < 0) {
+          return false;  // queue is full
+        } else {
+          pos = m_pushPos.load(std::memory_order_relaxed);
+        }
+      }
+
+      Slot& slot = m_slots[pos & Mask];
+      slot.item = std::move(item);
+      slot.sequence.store(pos + 1, std::memory_order_release);
+
+      position = pos;
+      return true;
+    }
+
+    /**
+      * \brief Pops the next item. Consumer thread only.
+      * \returns \c false if the next item has not been published yet
+      */
+    bool pop(T& item) {
+      Slot& slot = m_slots[m_popPos & Mask];
+
+      if (slot.sequence.load(std::memory_order_acquire) != m_popPos + 1) {
+        return false;  // queue is empty
+      }
+
+      item = std::move(slot.item);
+      slot.sequence.store(m_popPos + Capacity, std::memory_order_release);
+      m_popPos++;
+      return true;
+    }
+
+    /**
+      * \brief Checks whether the next item is published. Consumer thread only.
+      */
+    bool isEmpty() const {
+      return m_slots[m_popPos & Mask].sequence.load(std::memory_order_acquire) != m_popPos + 1;
+    }
+
+    /**
+      * \brief Number of positions claimed by producers so far,
+      *        including items that are still being published.
+      */
+    uint64_t getPushCount() const {
+      return m_pushPos.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct Slot {
+      std::atomic<uint64_t> sequence;
+      T item;
+    };
+
+    std::array<Slot, Capacity> m_slots;
+    alignas(64) std::atomic<uint64_t> m_pushPos = { 0 };
+    alignas(64) uint64_t m_popPos = 0;
+  };
 } //dxvk
@@ -23,6 +23,7 @@
 #pragma once
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "xxHash/xxhash.h"
 
 
@@ -68,6 +69,69 @@ namespace dxvk {
     }
   };
 
+  // An immutable open addressing table for use ONLY with already hashed keys. Maps keys to
+  // pointers to values owned elsewhere. Since it is never modified after construction, any
+  // number of threads can look up entries without synchronization.
+  template<class T>
+  class fast_frozen_cache {
+  public:
+    fast_frozen_cache() = default;
+
+    // Builds the table from the entries of an associative container with XXH64_hash_t
+    // keys. The values must outlive the table.
+    template<class Container>
+    explicit fast_frozen_cache(Container& container) {
+      if (container.empty()) {
+        return;
+      }
+
+      // Keep the load factor at or below 0.5 so probe sequences stay short
+      size_t capacity = 1;
+      while (capacity < container.size() * 2) {
+        capacity <<= 1;
+      }
+
+      m_entries.resize(capacity);
+      m_mask = capacity - 1;
+
+      for (auto& [key, value] : container) {
+        size_t slot = key & m_mask;
+        while (m_entries[slot].value != nullptr) {
+          slot = (slot + 1) & m_mask;
+        }
+        m_entries[slot] = { key, &value };
+      }
+      m_size = container.size();
+    }
+
+    T* find(const XXH64_hash_t key) const {
+      if (m_entries.empty()) {
+        return nullptr;
+      }
+
+      for (size_t slot = key & m_mask; m_entries[slot].value != nullptr; slot = (slot + 1) & m_mask) {
+        if (m_entries[slot].key == key) {
+          return m_entries[slot].value;
+        }
+      }
+      return nullptr;
+    }
+
+    size_t size() const {
+      return m_size;
+    }
+
+  private:
+    struct Entry {
+      XXH64_hash_t key = 0;
+      T* value = nullptr;
+    };
+
+    std::vector<Entry> m_entries;
+    size_t m_mask = 0;
+    size_t m_size = 0;
+  };
+
   // A fast set for use ONLY with already hashed keys.
   struct fast_unordered_set : public std::unordered_set<XXH64_hash_t, XXH64_hash_passthrough> { };
 
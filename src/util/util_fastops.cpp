@@ -931,6 +931,93 @@ namespace fast {
   template void copySubtract<uint16_t>(uint16_t* dstData, const uint16_t* srcData, const uint32_t count, const uint16_t value, const bool ignoreSentinel, const uint16_t sentinelValue);
   template void copySubtract<uint32_t>(uint32_t* dstData, const uint32_t* srcData, const uint32_t count, const uint32_t value, const bool ignoreSentinel, const uint32_t sentinelValue);
 
+  __forceinline void packBlendIndices_slow(uint32_t* dstData, const uint32_t* srcData, const uint32_t vertexCount, const uint32_t bonesPerVertex) {
+    const uint32_t wordsPerVertex = (bonesPerVertex + 3) / 4;
+    for (uint32_t vert = 0; vert < vertexCount; vert++) {
+      const uint32_t* src = &srcData[vert * bonesPerVertex];
+      uint32_t* dst = &dstData[vert * wordsPerVertex];
+
+      for (uint32_t j = 0; j < bonesPerVertex; j += 4) {
+        uint32_t packed = 0;
+        for (uint32_t k = 0; k < 4 && j + k < bonesPerVertex; ++k) {
+          packed |= (src[j + k] & 0xFF) << 8 * k;
+        }
+        dst[j / 4] = packed;
+      }
+    }
+  }
+
+  // When the number of bones per vertex is a multiple of 4, packing is a plain narrowing
+  // of the whole index array from 32 to 8 bits.
+  __forceinline void packBlendIndices8_SSE(uint8_t* dstData, const uint32_t* srcData, const uint32_t count) {
+    const uint32_t numLanes = 16;
+    const uint32_t alignedCount = dxvk::alignDown(count, numLanes);
+
+    // Masking first keeps the signed saturation of the packs below exact
+    const __m128i mask = _mm_set1_epi32(0xFF);
+
+    for (uint32_t i = 0; i < alignedCount; i += numLanes) {
+      __m128i a = _mm_and_si128(_mm_loadu_si128((__m128i*) &srcData[i + 0]), mask);
+      __m128i b = _mm_and_si128(_mm_loadu_si128((__m128i*) &srcData[i + 4]), mask);
+      __m128i c = _mm_and_si128(_mm_loadu_si128((__m128i*) &srcData[i + 8]), mask);
+      __m128i d = _mm_and_si128(_mm_loadu_si128((__m128i*) &srcData[i + 12]), mask);
+      __m128i dst = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+      _mm_storeu_si128((__m128i*) &dstData[i], dst);
+    }
+
+    // Process remaining elements
+    for (uint32_t i = alignedCount; i < count; ++i) {
+      dstData[i] = srcData[i] & 0xFF;
+    }
+  }
+
+  __forceinline void packBlendIndices8_AVX2(uint8_t* dstData, const uint32_t* srcData, const uint32_t count) {
+    const uint32_t numLanes = 32;
+    const uint32_t alignedCount = dxvk::alignDown(count, numLanes);
+
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    // The AVX2 packs work per 128-bit lane, this restores the element order afterwards
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    for (uint32_t i = 0; i < alignedCount; i += numLanes) {
+      __m256i a = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &srcData[i + 0]), mask);
+      __m256i b = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &srcData[i + 8]), mask);
+      __m256i c = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &srcData[i + 16]), mask);
+      __m256i d = _mm256_and_si256(_mm256_loadu_si256((__m256i*) &srcData[i + 24]), mask);
+      __m256i dst = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+      dst = _mm256_permutevar8x32_epi32(dst, order);
+      _mm256_storeu_si256((__m256i*) &dstData[i], dst);
+    }
+
+    // Process remaining elements
+    for (uint32_t i = alignedCount; i < count; ++i) {
+      dstData[i] = srcData[i] & 0xFF;
+    }
+  }
+
+  void packBlendIndices(uint32_t* dstData, const uint32_t* srcData, const uint32_t vertexCount, const uint32_t bonesPerVertex) {
+    const uint32_t count = vertexCount * bonesPerVertex;
+    const bool useSSE = SSE_ENABLE && (bonesPerVertex % 4) == 0 && count >= 32;
+
+    if (useSSE) {
+      switch (g_simdSupportLevel) {
+      case SIMD::AVX512:
+      case SIMD::AVX2:
+        packBlendIndices8_AVX2((uint8_t*) dstData, srcData, count);
+        break;
+      case SIMD::SSE4_1:
+      case SIMD::SSE3:
+      case SIMD::SSE2:
+        packBlendIndices8_SSE((uint8_t*) dstData, srcData, count);
+        break;
+      default:
+        throw;
+      }
+    } else {
+      packBlendIndices_slow(dstData, srcData, vertexCount, bonesPerVertex);
+    }
+  }
+
   void parallel_memcpy(void* dst, const void* src, const size_t count, const size_t chunkSize) {
     const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
     uint8_t* dstBytes = static_cast<uint8_t*>(dst);
@@ -70,6 +70,18 @@ namespace fast {
   template<typename T>
   void copySubtract(T* dstData, const T* srcData, const uint32_t count, const T value, const bool ignoreSentinel = false, const T sentinelValue = 0);
 
+  /**
+    * \brief Packs 32-bit blend indices into bytes, 4 bones per 32-bit word
+    *
+    * dstData: array receiving vertexCount * ceil(bonesPerVertex / 4) words
+    * srcData: array of vertexCount * bonesPerVertex indices
+    * vertexCount: number of vertices
+    * bonesPerVertex: number of indices per vertex, unused bytes of the last word of a vertex are zeroed
+    *
+    * Indices are truncated to their lowest 8 bits.
+    */
+  void packBlendIndices(uint32_t* dstData, const uint32_t* srcData, const uint32_t vertexCount, const uint32_t bonesPerVertex);
+
   /**
     * \brief Memory copy function that uses threads internally, can be useful for very large memcpy's
     *
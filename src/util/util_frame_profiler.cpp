@@ -0,0 +1,294 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "util_frame_profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+#include "util_env.h"
+#include "util_string.h"
+#include "log/log.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Per-thread event ring
+   *
+   * Single producer, single consumer ring. The owning thread
+   * pushes, FrameProfiler::endFrame drains.
+   */
+  struct FrameProfilerThreadBuffer {
+    static constexpr uint32_t Capacity = 16384;
+
+    uint32_t threadId = 0;
+    std::array<FrameProfiler::Event, Capacity> events;
+    std::atomic<uint32_t> head = { 0u };
+    std::atomic<uint32_t> tail = { 0u };
+
+    bool push(const FrameProfiler::Event& event) {
+      const uint32_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) == Capacity)
+        return false;
+
+      events[t % Capacity] = event;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    template<typename Fn>
+    void drain(const Fn& fn) {
+      const uint32_t t = tail.load(std::memory_order_acquire);
+      uint32_t h = head.load(std::memory_order_relaxed);
+
+      for (; h != t; h++)
+        fn(events[h % Capacity]);
+
+      head.store(h, std::memory_order_release);
+    }
+  };
+
+
+  std::atomic<bool> FrameProfiler::s_recording = { false };
+
+
+  FrameProfiler::FrameProfiler()
+  : m_startTicks(now()),
+    m_startTime(std::chrono::steady_clock::now()) {
+    m_lastFrameEnd = m_startTicks;
+  }
+
+
+  FrameProfiler& FrameProfiler::get() {
+    static FrameProfiler s_instance;
+    return s_instance;
+  }
+
+
+  void FrameProfiler::recordEvent(const char* name, uint64_t begin, uint64_t end) {
+    FrameProfiler& profiler = get();
+
+    if (!profiler.getThreadBuffer().push(Event { name, begin, end }))
+      profiler.m_numDroppedEvents++;
+  }
+
+
+  FrameProfilerThreadBuffer& FrameProfiler::getThreadBuffer() {
+    thread_local std::shared_ptr<FrameProfilerThreadBuffer> t_buffer;
+    if (!t_buffer) {
+      t_buffer = std::make_shared<FrameProfilerThreadBuffer>();
+      t_buffer->threadId = this_thread::get_id();
+      std::lock_guard<dxvk::mutex> lock(m_threadBuffersMutex);
+      m_threadBuffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+  }
+
+
+  void FrameProfiler::setEnabled(bool enabled) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_enabled != enabled) {
+      m_enabled = enabled;
+      updateRecording();
+    }
+  }
+
+
+  bool FrameProfiler::requestCapture(uint32_t numFrames, const std::string& filePath) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (numFrames == 0 || m_captureFramesRequested != 0 || m_captureFramesLeft != 0)
+      return false;
+
+    m_captureFramesRequested = numFrames;
+    m_captureFilePath = filePath;
+    updateRecording();
+    return true;
+  }
+
+
+  bool FrameProfiler::isCapturing() const {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_captureFramesRequested != 0 || m_captureFramesLeft != 0;
+  }
+
+
+  void FrameProfiler::endFrame() {
+    const uint64_t frameEnd = now();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    const bool capturing = m_captureFramesLeft != 0;
+
+    m_zones.clear();
+    {
+      std::lock_guard<dxvk::mutex> buffersLock(m_threadBuffersMutex);
+
+      for (auto iter = m_threadBuffers.begin(); iter != m_threadBuffers.end(); ) {
+        // Check before draining, a thread may still record right before it exits
+        const bool threadExited = iter->use_count() == 1;
+        const uint32_t threadId = (*iter)->threadId;
+
+        (*iter)->drain([&] (const Event& event) {
+          ZoneAccumulator& zone = m_zones[event.name];
+          const uint64_t ticks = event.end - event.begin;
+          zone.count++;
+          zone.totalTicks += ticks;
+          zone.maxTicks = std::max(zone.maxTicks, ticks);
+
+          if (capturing)
+            m_captureEvents.emplace_back(threadId, event);
+        });
+
+        if (threadExited) {
+          iter = m_threadBuffers.erase(iter);
+        } else {
+          ++iter;
+        }
+      }
+    }
+
+    const double ticksPerMs = getTicksPerUs() * 1000.0;
+
+    m_frameStats.clear();
+    for (const auto& [name, zone] : m_zones) {
+      ZoneStats& stats = m_frameStats.emplace_back();
+      stats.name = name;
+      stats.count = zone.count;
+      stats.totalMs = double(zone.totalTicks) / ticksPerMs;
+      stats.maxMs = double(zone.maxTicks) / ticksPerMs;
+    }
+
+    std::sort(m_frameStats.begin(), m_frameStats.end(), [] (const ZoneStats& a, const ZoneStats& b) {
+      return a.totalMs > b.totalMs;
+    });
+
+    if (capturing) {
+      // Frames are written as zones of their own, on a thread ID no real thread uses
+      m_captureEvents.emplace_back(0u, Event { "Frame", m_lastFrameEnd, frameEnd });
+
+      if (--m_captureFramesLeft == 0) {
+        try {
+          // Writing a capture can take a while, keep it off the frame
+          dxvk::thread([
+            filePath   = std::move(m_captureFilePath),
+            events     = std::move(m_captureEvents),
+            startTicks = m_captureStartTicks,
+            ticksPerUs = getTicksPerUs()
+          ] {
+            env::setThreadName("dxvk-profiler-export");
+
+            if (writeChromeTrace(filePath, events, startTicks, ticksPerUs)) {
+              Logger::info(str::format("[FrameProfiler] Wrote ", events.size(), " events to ", filePath));
+            } else {
+              Logger::err(str::format("[FrameProfiler] Failed to write ", filePath));
+            }
+          }).detach();
+        } catch (const std::system_error&) {
+          Logger::err("[FrameProfiler] Failed to start the capture export thread");
+        }
+
+        m_captureFilePath.clear();
+        m_captureEvents.clear();
+      }
+    }
+
+    // A requested capture starts at the frame boundary, so it only contains full frames
+    if (m_captureFramesRequested != 0 && m_captureFramesLeft == 0) {
+      m_captureFramesLeft = std::exchange(m_captureFramesRequested, 0u);
+      m_captureStartTicks = frameEnd;
+    }
+
+    m_lastFrameTimeMs = double(frameEnd - m_lastFrameEnd) / ticksPerMs;
+    m_lastFrameEnd = frameEnd;
+
+    updateRecording();
+  }
+
+
+  std::vector<FrameProfiler::ZoneStats> FrameProfiler::getFrameStats() const {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_frameStats;
+  }
+
+
+  double FrameProfiler::getLastFrameTimeMs() const {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_lastFrameTimeMs;
+  }
+
+
+  double FrameProfiler::getTicksPerUs() const {
+    const uint64_t ticks = now() - m_startTicks;
+    const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+      std::chrono::steady_clock::now() - m_startTime);
+
+    // Note: Guard against the first frame, a ratio over a few microseconds is meaningless
+    return elapsed.count() > 1000.0 ? double(ticks) / elapsed.count() : 1000.0;
+  }
+
+
+  void FrameProfiler::updateRecording() {
+    s_recording.store(m_enabled || m_captureFramesRequested != 0 || m_captureFramesLeft != 0);
+  }
+
+
+  bool FrameProfiler::writeChromeTrace(
+    const std::string&                                filePath,
+    const std::vector<std::pair<uint32_t, Event>>&    events,
+          uint64_t                                    startTicks,
+          double                                      ticksPerUs) {
+    std::ofstream file(str::tows(filePath.c_str()).c_str(), std::ios_base::trunc);
+    if (!file) {
+      return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\""
+         << env::getExeBaseName() << "\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+
+    char buffer[64];
+    for (const auto& [threadId, event] : events) {
+      // Zones may begin before the first collected frame, clamp them to time zero
+      const double ts = event.begin > startTicks ? double(event.begin - startTicks) / ticksPerUs : 0.0;
+      const uint64_t begin = std::max(event.begin, startTicks);
+      const double dur = event.end > begin ? double(event.end - begin) / ticksPerUs : 0.0;
+
+      file << ",\n{\"name\":\"";
+      for (const char* c = event.name; *c; c++) {
+        if (*c == '"' || *c == '\\')
+          file << '\\';
+        file << *c;
+      }
+      snprintf(buffer, sizeof(buffer), "%.3f", ts);
+      file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId << ",\"ts\":" << buffer;
+      snprintf(buffer, sizeof(buffer), "%.3f", dur);
+      file << ",\"dur\":" << buffer << "}";
+    }
+
+    file << "\n]}\n";
+    return bool(file);
+  }
+
+}
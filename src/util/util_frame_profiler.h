@@ -0,0 +1,211 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util_bit.h"
+#include "thread.h"
+
+namespace dxvk {
+
+  struct FrameProfilerThreadBuffer;
+
+  /**
+   * \brief Built-in frame profiler
+   *
+   * Backend of the CPU profile zone macros that works without Tracy. Zones are
+   * recorded as complete events into per-thread rings and collected once per
+   * frame in endFrame(), which aggregates them per zone and, while a capture
+   * is running, keeps them for export as a Chrome trace JSON file that can be
+   * opened in chrome://tracing or Perfetto.
+   *
+   * Timestamps are raw TSC values, converted using a frequency calibrated
+   * against the steady clock since the profiler was created. Recording costs
+   * a single relaxed atomic load per zone when the profiler is inactive.
+   */
+  class FrameProfiler {
+
+  public:
+
+    struct Event {
+      const char* name = nullptr;
+      uint64_t    begin = 0;
+      uint64_t    end = 0;
+    };
+
+    struct ZoneStats {
+      const char* name = nullptr;
+      uint32_t    count = 0;
+      double      totalMs = 0.0;
+      double      maxMs = 0.0;
+    };
+
+    static FrameProfiler& get();
+
+    static bool isRecording() {
+      return s_recording.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t now() {
+      return __rdtsc();
+    }
+
+    static void recordEvent(const char* name, uint64_t begin, uint64_t end);
+
+    /**
+     * \brief Enables per-frame aggregates
+     *
+     * Zones are recorded every frame while enabled,
+     * independently of captures.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * \brief Requests a capture
+     *
+     * The capture starts with the next frame and is written to
+     * \c filePath once \c numFrames frames have been recorded.
+     * Ignored while another capture is pending or running.
+     * \returns \c true if the capture was requested
+     */
+    bool requestCapture(uint32_t numFrames, const std::string& filePath);
+
+    bool isCapturing() const;
+
+    /**
+     * \brief Collects the zones recorded during the last frame
+     *
+     * Must be called once per frame, from a single thread. Zones are attributed
+     * to the frame in which they were collected, so work of threads lagging a
+     * frame behind is counted towards the frame it was recorded in.
+     */
+    void endFrame();
+
+    /**
+     * \brief Per-zone aggregates of the last frame
+     *
+     * Sorted by total time, in descending order.
+     */
+    std::vector<ZoneStats> getFrameStats() const;
+
+    double getLastFrameTimeMs() const;
+
+    uint64_t getNumDroppedEvents() const {
+      return m_numDroppedEvents.load();
+    }
+
+    /**
+     * \brief Writes events as Chrome trace JSON
+     *
+     * \param [in] events Events with the ID of the recording thread
+     * \param [in] startTicks Timestamp written as time zero
+     * \param [in] ticksPerUs Timestamp frequency
+     */
+    static bool writeChromeTrace(
+      const std::string&                                filePath,
+      const std::vector<std::pair<uint32_t, Event>>&    events,
+            uint64_t                                    startTicks,
+            double                                      ticksPerUs);
+
+  private:
+
+    FrameProfiler();
+
+    static std::atomic<bool> s_recording;
+
+    struct ZoneAccumulator {
+      uint32_t count = 0;
+      uint64_t totalTicks = 0;
+      uint64_t maxTicks = 0;
+    };
+
+    const uint64_t m_startTicks;
+    const std::chrono::steady_clock::time_point m_startTime;
+
+    mutable dxvk::mutex m_mutex;
+
+    dxvk::mutex m_threadBuffersMutex;
+    std::vector<std::shared_ptr<FrameProfilerThreadBuffer>> m_threadBuffers;
+
+    bool m_enabled = false;
+
+    uint32_t    m_captureFramesRequested = 0;
+    uint32_t    m_captureFramesLeft = 0;
+    std::string m_captureFilePath;
+    uint64_t    m_captureStartTicks = 0;
+    std::vector<std::pair<uint32_t, Event>> m_captureEvents;
+
+    uint64_t m_lastFrameEnd = 0;
+    double   m_lastFrameTimeMs = 0.0;
+
+    std::unordered_map<const char*, ZoneAccumulator> m_zones;
+    std::vector<ZoneStats> m_frameStats;
+
+    std::atomic<uint64_t> m_numDroppedEvents = { 0ull };
+
+    FrameProfilerThreadBuffer& getThreadBuffer();
+
+    double getTicksPerUs() const;
+
+    void updateRecording();
+
+  };
+
+
+  /**
+   * \brief Scoped frame profiler zone
+   *
+   * \c name must outlive the profiler, e.g. a string literal.
+   */
+  class FrameProfilerZone {
+
+  public:
+
+    explicit FrameProfilerZone(const char* name) {
+      if (unlikely(FrameProfiler::isRecording())) {
+        m_name = name;
+        m_begin = FrameProfiler::now();
+      }
+    }
+
+    ~FrameProfilerZone() {
+      if (unlikely(m_name != nullptr))
+        FrameProfiler::recordEvent(m_name, m_begin, FrameProfiler::now());
+    }
+
+    FrameProfilerZone(const FrameProfilerZone&) = delete;
+    FrameProfilerZone& operator = (const FrameProfilerZone&) = delete;
+
+  private:
+
+    const char* m_name = nullptr;
+    uint64_t    m_begin = 0;
+
+  };
+
+}
@@ -0,0 +1,261 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace dxvk {
+  // Intrusive containers link elements through hooks embedded in the elements themselves,
+  // so that adding, moving and removing elements never allocates. Elements are not owned
+  // and must stay at a fixed address while they are linked. An element can be linked into
+  // only one container per hook at a time.
+
+  template<typename T>
+  struct IntrusiveListHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+    bool isLinked = false;
+  };
+
+  // Doubly linked list of elements.
+  template<typename T, IntrusiveListHook<T> T::*Hook>
+  class IntrusiveList {
+  public:
+    bool empty() const {
+      return m_size == 0;
+    }
+
+    size_t size() const {
+      return m_size;
+    }
+
+    T* front() const {
+      return m_front;
+    }
+
+    T* back() const {
+      return m_back;
+    }
+
+    static T* next(const T& item) {
+      return (item.*Hook).next;
+    }
+
+    static bool isLinked(const T& item) {
+      return (item.*Hook).isLinked;
+    }
+
+    void pushBack(T& item) {
+      IntrusiveListHook<T>& hook = item.*Hook;
+      assert(!hook.isLinked);
+
+      hook.prev = m_back;
+      hook.next = nullptr;
+      hook.isLinked = true;
+
+      if (m_back) {
+        (m_back->*Hook).next = &item;
+      } else {
+        m_front = &item;
+      }
+      m_back = &item;
+      m_size++;
+    }
+
+    void erase(T& item) {
+      IntrusiveListHook<T>& hook = item.*Hook;
+      assert(hook.isLinked);
+
+      if (hook.prev) {
+        (hook.prev->*Hook).next = hook.next;
+      } else {
+        m_front = hook.next;
+      }
+
+      if (hook.next) {
+        (hook.next->*Hook).prev = hook.prev;
+      } else {
+        m_back = hook.prev;
+      }
+
+      hook = IntrusiveListHook<T>();
+      m_size--;
+    }
+
+    void moveToBack(T& item) {
+      if (m_back != &item) {
+        erase(item);
+        pushBack(item);
+      }
+    }
+
+    void clear() {
+      while (m_front) {
+        erase(*m_front);
+      }
+    }
+
+  private:
+    T* m_front = nullptr;
+    T* m_back = nullptr;
+    size_t m_size = 0;
+  };
+
+  struct IntrusivePriorityQueueHook {
+    static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    uint32_t index = kInvalidIndex;
+  };
+
+  // Binary max heap of elements that track their own heap position, which allows for
+  // removing or reprioritizing any element in O(log n). As with std::priority_queue,
+  // Compare(a, b) returns true when a has a lower priority than b. Priorities of linked
+  // elements must only change with update() called right after.
+  template<typename T, IntrusivePriorityQueueHook T::*Hook, typename Compare>
+  class IntrusivePriorityQueue {
+  public:
+    explicit IntrusivePriorityQueue(Compare compare = Compare())
+      : m_compare(compare) { }
+
+    bool empty() const {
+      return m_heap.empty();
+    }
+
+    size_t size() const {
+      return m_heap.size();
+    }
+
+    bool contains(const T& item) const {
+      const uint32_t index = (item.*Hook).index;
+      return index < m_heap.size() && m_heap[index] == &item;
+    }
+
+    // Returns the element with the highest priority
+    T& top() const {
+      assert(!empty());
+      return *m_heap.front();
+    }
+
+    // Elements in heap order, i.e. only the first one is ordered
+    const std::vector<T*>& elements() const {
+      return m_heap;
+    }
+
+    void reserve(size_t capacity) {
+      m_heap.reserve(capacity);
+    }
+
+    void push(T& item) {
+      assert((item.*Hook).index == IntrusivePriorityQueueHook::kInvalidIndex);
+
+      m_heap.push_back(&item);
+      siftUp(static_cast<uint32_t>(m_heap.size() - 1));
+    }
+
+    T& pop() {
+      T& item = top();
+      erase(item);
+      return item;
+    }
+
+    void erase(T& item) {
+      assert(contains(item));
+
+      const uint32_t index = (item.*Hook).index;
+      const uint32_t lastIndex = static_cast<uint32_t>(m_heap.size() - 1);
+      (item.*Hook).index = IntrusivePriorityQueueHook::kInvalidIndex;
+
+      if (index != lastIndex) {
+        place(index, m_heap[lastIndex]);
+        m_heap.pop_back();
+        update(*m_heap[index]);
+      } else {
+        m_heap.pop_back();
+      }
+    }
+
+    // Restores the heap order after the priority of an element changed
+    void update(T& item) {
+      assert(contains(item));
+
+      const uint32_t index = (item.*Hook).index;
+      if (index > 0 && m_compare(*m_heap[parent(index)], item)) {
+        siftUp(index);
+      } else {
+        siftDown(index);
+      }
+    }
+
+    void clear() {
+      for (T* item : m_heap) {
+        (item->*Hook).index = IntrusivePriorityQueueHook::kInvalidIndex;
+      }
+      m_heap.clear();
+    }
+
+  private:
+    static uint32_t parent(uint32_t index) {
+      return (index - 1) / 2;
+    }
+
+    void place(uint32_t index, T* item) {
+      m_heap[index] = item;
+      (item->*Hook).index = index;
+    }
+
+    void siftUp(uint32_t index) {
+      T* item = m_heap[index];
+
+      while (index > 0 && m_compare(*m_heap[parent(index)], *item)) {
+        place(index, m_heap[parent(index)]);
+        index = parent(index);
+      }
+      place(index, item);
+    }
+
+    void siftDown(uint32_t index) {
+      T* item = m_heap[index];
+      const uint32_t size = static_cast<uint32_t>(m_heap.size());
+
+      while (true) {
+        uint32_t child = 2 * index + 1;
+        if (child >= size) {
+          break;
+        }
+        if (child + 1 < size && m_compare(*m_heap[child], *m_heap[child + 1])) {
+          child++;
+        }
+        if (!m_compare(*item, *m_heap[child])) {
+          break;
+        }
+        place(index, m_heap[child]);
+        index = child;
+      }
+      place(index, item);
+    }
+
+    Compare m_compare;
+    std::vector<T*> m_heap;
+  };
+}
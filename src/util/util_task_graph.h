@@ -0,0 +1,257 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "thread.h"
+#include "util_frame_profiler.h"
+#include "util_threadpool.h"
+
+namespace dxvk {
+
+  /**
+    * \brief A small graph of tasks executed once, with dependencies derived
+    *        from the resources each task reads and writes.
+    *
+    *  Resources are bits in a 64 bit mask, the meaning of each bit is up to
+    *  the user. A task depends on every task added before it which writes a
+    *  resource it accesses, or reads a resource it writes, so the result is
+    *  the same as running all tasks in the order they were added.
+    *
+    *  Main tasks run on the thread calling execute, in the order they were
+    *  added. Worker tasks are scheduled on a WorkerThreadPool as soon as their
+    *  dependencies finished, and overlap with the main tasks that do not
+    *  depend on them. Since WorkerThreadPool is single producer, all tasks are
+    *  scheduled from the executing thread.
+    *
+    *  Example usage:
+    *   TaskGraph graph;
+    *   graph.addTask("pack", TaskGraph::Affinity::Worker, kMaterials, kPacked, [&] { pack(); });
+    *   graph.addTask("build", TaskGraph::Affinity::Main, kInstances, kInstances, [&] { build(); });
+    *   graph.addTask("upload", TaskGraph::Affinity::Main, kPacked, 0, [&] { upload(); });
+    *   graph.execute(&threadPool);
+    */
+  class TaskGraph {
+  public:
+    using ResourceMask = uint64_t;
+
+    enum class Affinity {
+      Main,
+      Worker
+    };
+
+    struct StageTiming {
+      const char* name;
+      // Relative to the start of execute
+      double startMs;
+      double durationMs;
+      bool onWorker;
+    };
+
+    // Note: name must be a string with static storage duration
+    void addTask(const char* name, Affinity affinity, ResourceMask reads, ResourceMask writes, std::function<void()> fn) {
+      const uint32_t index = static_cast<uint32_t>(m_tasks.size());
+      Node& node = m_tasks.emplace_back();
+      node.name = name;
+      node.affinity = affinity;
+      node.reads = reads;
+      node.writes = writes;
+      node.fn = std::move(fn);
+
+      for (uint32_t i = 0; i < index; i++) {
+        Node& other = m_tasks[i];
+        if ((other.writes & (reads | writes)) != 0 || (other.reads & writes) != 0) {
+          other.dependents.push_back(index);
+          node.numDependencies++;
+        }
+      }
+    }
+
+    /**
+      * \brief Runs all tasks and returns once they finished
+      *
+      *  Without a pool, or when the pool is out of space, worker tasks run
+      *  on the calling thread instead. The pool must not be used by anything
+      *  else while the graph executes.
+      */
+    template<typename ThreadPool>
+    void execute(ThreadPool* pool) {
+      m_start = Clock::now();
+      m_timings.resize(m_tasks.size());
+
+      std::vector<uint32_t> pending(m_tasks.size());
+      std::vector<uint32_t> readyWorker;
+      std::vector<std::pair<uint32_t, Future<void>>> inFlight;
+      // Tasks in the order they were scheduled on the pool, to not reuse a task slot with a pending result
+      std::vector<uint32_t> scheduled;
+      std::vector<bool> consumed(m_tasks.size(), false);
+      uint32_t nextMain = 0;
+      size_t numFinished = 0;
+
+      auto finish = [&](uint32_t index) {
+        for (uint32_t dependent : m_tasks[index].dependents) {
+          if (--pending[dependent] == 0 && m_tasks[dependent].affinity == Affinity::Worker) {
+            readyWorker.push_back(dependent);
+          }
+        }
+        numFinished++;
+      };
+
+      for (uint32_t i = 0; i < m_tasks.size(); i++) {
+        pending[i] = m_tasks[i].numDependencies;
+        m_tasks[i].done.store(false);
+        if (pending[i] == 0 && m_tasks[i].affinity == Affinity::Worker) {
+          readyWorker.push_back(i);
+        }
+      }
+
+      while (numFinished < m_tasks.size()) {
+        bool progress = false;
+
+        // Note: finishing inline tasks can make more worker tasks ready
+        while (!readyWorker.empty()) {
+          const uint32_t index = readyWorker.back();
+          readyWorker.pop_back();
+
+          Future<void> future;
+          if (pool != nullptr &&
+              (scheduled.size() < pool->getTaskCapacity() || consumed[scheduled[scheduled.size() - pool->getTaskCapacity()]])) {
+            future = pool->Schedule([this, index] {
+              run(index, true);
+              std::unique_lock<dxvk::mutex> lock(m_doneMutex);
+              m_tasks[index].done.store(true, std::memory_order_release);
+              m_doneCond.notify_one();
+            });
+          }
+          if (future.valid()) {
+            inFlight.emplace_back(index, future);
+            scheduled.push_back(index);
+          } else {
+            run(index, false);
+            finish(index);
+            progress = true;
+          }
+        }
+
+        for (size_t i = 0; i < inFlight.size(); ) {
+          const uint32_t index = inFlight[i].first;
+          if (m_tasks[index].done.load(std::memory_order_acquire)) {
+            // Consume the result right away, the pool reuses its task slots
+            inFlight[i].second.get();
+            consumed[index] = true;
+            inFlight[i] = inFlight.back();
+            inFlight.pop_back();
+            finish(index);
+            progress = true;
+          } else {
+            i++;
+          }
+        }
+
+        // Main tasks keep their order, skip over the worker tasks in between
+        while (nextMain < m_tasks.size() && m_tasks[nextMain].affinity != Affinity::Main) {
+          nextMain++;
+        }
+        if (nextMain < m_tasks.size() && pending[nextMain] == 0) {
+          run(nextMain, false);
+          finish(nextMain++);
+          progress = true;
+        }
+
+        if (!progress && readyWorker.empty()) {
+          // Everything left depends on worker tasks in flight, sleep until one of them finishes
+          std::unique_lock<dxvk::mutex> lock(m_doneMutex);
+          m_doneCond.wait(lock, [&] {
+            return inFlight.empty() || std::any_of(inFlight.begin(), inFlight.end(), [this](const auto& task) {
+              return m_tasks[task.first].done.load(std::memory_order_acquire);
+            });
+          });
+        }
+      }
+
+    }
+
+    const std::vector<StageTiming>& getTimings() const {
+      return m_timings;
+    }
+
+    size_t size() const {
+      return m_tasks.size();
+    }
+
+    void clear() {
+      m_tasks.clear();
+      m_timings.clear();
+    }
+
+  private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Node {
+      const char* name = nullptr;
+      Affinity affinity = Affinity::Main;
+      ResourceMask reads = 0;
+      ResourceMask writes = 0;
+      std::function<void()> fn;
+      std::vector<uint32_t> dependents;
+      uint32_t numDependencies = 0;
+      std::atomic<bool> done = false;
+
+      Node() = default;
+      Node(Node&& other) noexcept
+        : name(other.name), affinity(other.affinity), reads(other.reads), writes(other.writes)
+        , fn(std::move(other.fn)), dependents(std::move(other.dependents)), numDependencies(other.numDependencies) { }
+    };
+
+    void run(uint32_t index, bool onWorker) {
+      Node& node = m_tasks[index];
+      const Clock::time_point begin = Clock::now();
+      {
+        FrameProfilerZone zone(node.name);
+        node.fn();
+      }
+      const Clock::time_point end = Clock::now();
+
+      StageTiming& timing = m_timings[index];
+      timing.name = node.name;
+      timing.startMs = std::chrono::duration<double, std::milli>(begin - m_start).count();
+      timing.durationMs = std::chrono::duration<double, std::milli>(end - begin).count();
+      timing.onWorker = onWorker;
+    }
+
+    std::vector<Node> m_tasks;
+    std::vector<StageTiming> m_timings;
+    Clock::time_point m_start;
+
+    // Signaled by worker tasks when they finish
+    dxvk::mutex m_doneMutex;
+    dxvk::condition_variable m_doneCond;
+  };
+
+}
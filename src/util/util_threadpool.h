@@ -368,6 +368,10 @@ namespace dxvk {
         // Place task into queue
         m_workerTasks[thread]->push(std::move(taskId));
 
+        // Note: count the task before notifying, a worker woken up earlier would find no
+        // work to do and go back to sleep until the next task is scheduled
+        ++m_numTasks;
+
         if constexpr (!LowLatency) {
           std::unique_lock<TaskMutex> lock(m_taskMutex);
           if constexpr (WorkStealing) {
@@ -378,13 +382,22 @@ namespace dxvk {
             m_condOnAdd.notify_all();
           }
         }
-
-        ++m_numTasks;
       }
 
       return future;
     }
 
+    // Number of tasks scheduled and not finished yet
+    uint32_t getNumQueuedTasks() const {
+      return m_numTasks.load();
+    }
+
+    // Task slots are reused round robin, a future must be consumed before
+    // this many further tasks are scheduled
+    uint32_t getTaskCapacity() const {
+      return m_taskCount;
+    }
+
   private:
     void processWork(const uint32_t workerId) {
       while (true) {
@@ -470,6 +483,6 @@ namespace dxvk {
     //  1. Non-circular queue incurs allocation overhead thats unacceptable
     //  2. Use of mutex, and CVs, incur overhead thats unacceptable
     std::vector<QueuePtr> m_workerTasks;
-    std::atomic_uint32_t m_numTasks;
+    std::atomic_uint32_t m_numTasks = 0;
   };
 } //dxvk
\ No newline at end of file
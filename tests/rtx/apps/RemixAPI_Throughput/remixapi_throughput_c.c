@@ -0,0 +1,380 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Measures instance submission throughput of the Remix API: a grid of instances is submitted
+// every frame from several threads, alternating between per-instance 'DrawInstance' calls and
+// batched 'DrawInstances' calls.
+//
+// Usage: RemixAPI_Throughput [numFrames] [numInstances] [numThreads]
+
+#include <remix/remix_c.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_THREADS 64
+
+remixapi_Interface g_remix = { 0 };
+HMODULE g_remix_dll = NULL;
+
+remixapi_MeshHandle g_scene_mesh = NULL;
+remixapi_LightHandle g_scene_light = NULL;
+
+remixapi_InstanceInfo* g_instances = NULL;
+uint32_t g_instances_count = 0;
+
+typedef struct SubmitJob {
+  uint32_t first;
+  uint32_t count;
+  BOOL batched;
+  HANDLE startEvent;
+  HANDLE doneEvent;
+  volatile LONG quit;
+} SubmitJob;
+
+remixapi_HardcodedVertex makeVertex(float x, float y, float z) {
+  remixapi_HardcodedVertex v = {
+    .position = {x,y,z},
+    .normal = {0,0,-1},
+    .texcoord = {0,0},
+    .color = 0xFFFFFFFF,
+  };
+  return v;
+}
+
+double nowMs(void) {
+  static LARGE_INTEGER freq = { 0 };
+  LARGE_INTEGER counter;
+  if (freq.QuadPart == 0) {
+    QueryPerformanceFrequency(&freq);
+  }
+  QueryPerformanceCounter(&counter);
+  return (double) counter.QuadPart * 1000.0 / (double) freq.QuadPart;
+}
+
+remixapi_ErrorCode init(HWND hwnd) {
+  const wchar_t* path = L"d3d9.dll";
+  if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) {
+    path = L"bin\\d3d9.dll";
+    if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) {
+      printf("d3d9.dll not found.\nPlease, place it in the same folder as this .exe");
+    }
+  }
+
+  {
+    remixapi_ErrorCode status = remixapi_lib_loadRemixDllAndInitialize(path, &g_remix, &g_remix_dll);
+    if (status != REMIXAPI_ERROR_CODE_SUCCESS) {
+      printf("remixapi_lib_loadRemixDllAndInitialize failed: %d", status);
+      return status;
+    }
+  }
+
+  {
+    remixapi_StartupInfo startInfo = {
+      .sType = REMIXAPI_STRUCT_TYPE_STARTUP_INFO,
+      .pNext = NULL,
+      .hwnd = hwnd,
+      .disableSrgbConversionForOutput = FALSE,
+      .forceNoVkSwapchain = FALSE,
+    };
+    remixapi_ErrorCode r = g_remix.Startup(&startInfo);
+    if (r != REMIXAPI_ERROR_CODE_SUCCESS) {
+      printf("remix::Startup() failed: %d", r);
+      return r;
+    }
+  }
+
+  {
+    remixapi_LightInfoDistantEXT distantLight = {
+      .sType = REMIXAPI_STRUCT_TYPE_LIGHT_INFO_DISTANT_EXT,
+      .pNext = NULL,
+      .direction = { 0.3f, -1, 0.5f },
+      .angularDiameterDegrees = 0.5f,
+    };
+    remixapi_LightInfo lightInfo = {
+      .sType = REMIXAPI_STRUCT_TYPE_LIGHT_INFO,
+      .pNext = &distantLight,
+      .hash = 0x3,
+      .radiance = { 5, 5, 5 },
+    };
+
+    remixapi_ErrorCode r = g_remix.CreateLight(&lightInfo, &g_scene_light);
+    if (r != REMIXAPI_ERROR_CODE_SUCCESS) {
+      printf("remix::CreateLight() failed: %d", r);
+      return r;
+    }
+  }
+  {
+    remixapi_HardcodedVertex verts[] = {
+      makeVertex( 0.4f, -0.4f, 0),
+      makeVertex( 0,     0.4f, 0),
+      makeVertex(-0.4f, -0.4f, 0),
+    };
+
+    remixapi_MeshInfoSurfaceTriangles triangles = {
+      .vertices_values = verts,
+      .vertices_count = ARRAYSIZE(verts),
+      .indices_values = NULL,
+      .indices_count = 0,
+      .skinning_hasvalue = FALSE,
+      .skinning_value = { 0 },
+      .material = NULL,
+    };
+
+    remixapi_MeshInfo meshInfo = {
+      .sType = REMIXAPI_STRUCT_TYPE_MESH_INFO,
+      .pNext = NULL,
+      .hash = 0x1,
+      .surfaces_values = &triangles,
+      .surfaces_count = 1,
+    };
+
+    remixapi_ErrorCode r = g_remix.CreateMesh(&meshInfo, &g_scene_mesh);
+    if (r != REMIXAPI_ERROR_CODE_SUCCESS) {
+      printf("remix::CreateMesh() failed: %d", r);
+      return r;
+    }
+  }
+  if (!g_remix.DrawInstances || !g_remix.DrawLightInstances) {
+    printf("Remix runtime doesn't support batched submission");
+    return REMIXAPI_ERROR_CODE_INCOMPATIBLE_VERSION;
+  }
+  return REMIXAPI_ERROR_CODE_SUCCESS;
+}
+
+void initInstances(uint32_t count) {
+  const uint32_t side = (uint32_t) ceil(sqrt((double) count));
+  g_instances = (remixapi_InstanceInfo*) calloc(count, sizeof(remixapi_InstanceInfo));
+  g_instances_count = count;
+  for (uint32_t i = 0; i < count; i++) {
+    const float x = (float) (i % side) - (float) side * 0.5f;
+    const float y = (float) (i / side) - (float) side * 0.5f;
+    remixapi_InstanceInfo info = {
+      .sType = REMIXAPI_STRUCT_TYPE_INSTANCE_INFO,
+      .categoryFlags = 0,
+      .mesh = g_scene_mesh,
+      .transform = { {
+        {1,0,0,x},
+        {0,1,0,y},
+        {0,0,1,(float) side},
+      } },
+      .doubleSided = 1,
+    };
+    g_instances[i] = info;
+  }
+}
+
+void submit(const SubmitJob* job) {
+  if (job->batched) {
+    g_remix.DrawInstances(&g_instances[job->first], job->count);
+  } else {
+    for (uint32_t i = 0; i < job->count; i++) {
+      g_remix.DrawInstance(&g_instances[job->first + i]);
+    }
+  }
+}
+
+DWORD WINAPI submitThread(LPVOID param) {
+  SubmitJob* job = (SubmitJob*) param;
+  while (TRUE) {
+    WaitForSingleObject(job->startEvent, INFINITE);
+    if (job->quit) {
+      break;
+    }
+    submit(job);
+    SetEvent(job->doneEvent);
+  }
+  return 0;
+}
+
+void renderFrame(uint32_t windowWidth, uint32_t windowHeight, SubmitJob* jobs, HANDLE* doneEvents, uint32_t numThreads, BOOL batched, double* submitMs) {
+  {
+    remixapi_CameraInfoParameterizedEXT parametersForCamera = {
+      .sType = REMIXAPI_STRUCT_TYPE_CAMERA_INFO_PARAMETERIZED_EXT,
+      .position = { 0,0,0 },
+      .forward = { 0,0,1 },
+      .up = { 0,1,0 },
+      .right = { 1,0,0 },
+      .fovYInDegrees = 70,
+      .aspect = windowHeight > 0 ? (float) windowWidth / (float) windowHeight : 1.0f,
+      .nearPlane = 0.1f,
+      .farPlane = 1000.0f,
+    };
+    remixapi_CameraInfo cameraInfo = {
+      .sType = REMIXAPI_STRUCT_TYPE_CAMERA_INFO,
+      .pNext = &parametersForCamera,
+    };
+    g_remix.SetupCamera(&cameraInfo);
+  }
+
+  const double start = nowMs();
+  for (uint32_t t = 0; t < numThreads; t++) {
+    jobs[t].batched = batched;
+    SetEvent(jobs[t].startEvent);
+  }
+  WaitForMultipleObjects(numThreads, doneEvents, TRUE, INFINITE);
+  if (batched) {
+    g_remix.DrawLightInstances(&g_scene_light, 1);
+  } else {
+    g_remix.DrawLightInstance(g_scene_light);
+  }
+  *submitMs += nowMs() - start;
+
+  g_remix.Present(NULL);
+}
+
+void destroy(void) {
+  if (g_remix.Shutdown) {
+    remixapi_lib_shutdownAndUnloadRemixDll(&g_remix, g_remix_dll);
+  }
+  free(g_instances);
+}
+
+
+
+#pragma region HWND boilerplate
+
+LRESULT WINAPI MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+  switch (msg) {
+  case WM_DESTROY:
+    PostQuitMessage(0);
+    return 0;
+  default:
+    break;
+  }
+  return DefWindowProc(hwnd, msg, wParam, lParam);
+}
+
+int main(int argc, char* argv[]) {
+  int numFrames = argc >= 2 ? atoi(argv[1]) : 200;
+  int numInstances = argc >= 3 ? atoi(argv[2]) : 20000;
+  int numThreads = argc >= 4 ? atoi(argv[3]) : 4;
+  if (numFrames <= 0 || numInstances <= 0 || numThreads <= 0 || numThreads > MAX_THREADS) {
+    printf("Usage: RemixAPI_Throughput [numFrames] [numInstances] [numThreads <= %d]\n", MAX_THREADS);
+    return 1;
+  }
+
+  WNDCLASSEX wc = {
+    .cbSize = sizeof(WNDCLASSEX),
+    .style = CS_CLASSDC,
+    .lpfnWndProc = MsgProc,
+    .cbClsExtra = 0L,
+    .cbWndExtra = 0L,
+    .hInstance = GetModuleHandle(NULL),
+    .hIcon = NULL,
+    .hCursor = NULL,
+    .hbrBackground = NULL,
+    .lpszMenuName = NULL,
+    .lpszClassName = "Remix API Throughput",
+    .hIconSm = NULL,
+  };
+  RegisterClassEx(&wc);
+
+  DWORD dwStyle = WS_OVERLAPPEDWINDOW;
+  // readjust, so the client area as specified, not the window size
+  RECT clientRect = { 0, 0, 1600, 900 };
+  AdjustWindowRect(&clientRect, dwStyle, FALSE);
+
+  HWND hwnd = CreateWindow(wc.lpszClassName, "Remix API Throughput",
+                            dwStyle,
+                            CW_USEDEFAULT, CW_USEDEFAULT,
+                            clientRect.right - clientRect.left,
+                            clientRect.bottom - clientRect.top,
+                            GetDesktopWindow(), NULL, wc.hInstance, NULL);
+
+  if (init(hwnd) == REMIXAPI_ERROR_CODE_SUCCESS) {
+    ShowWindow(hwnd, SW_SHOWDEFAULT);
+    UpdateWindow(hwnd);
+
+    initInstances((uint32_t) numInstances);
+
+    SubmitJob jobs[MAX_THREADS] = { 0 };
+    HANDLE threads[MAX_THREADS] = { 0 };
+    HANDLE doneEvents[MAX_THREADS] = { 0 };
+    const uint32_t perThread = ((uint32_t) numInstances + numThreads - 1) / numThreads;
+    for (int t = 0; t < numThreads; t++) {
+      const uint32_t first = min((uint32_t) t * perThread, (uint32_t) numInstances);
+      jobs[t].first = first;
+      jobs[t].count = min(perThread, (uint32_t) numInstances - first);
+      jobs[t].startEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+      jobs[t].doneEvent = doneEvents[t] = CreateEvent(NULL, FALSE, FALSE, NULL);
+      threads[t] = CreateThread(NULL, 0, submitThread, &jobs[t], 0, NULL);
+    }
+
+    // First half of the frames submits instance by instance, second half in batches
+    double submitMs[2] = { 0, 0 };
+    double frameMs[2] = { 0, 0 };
+    int framesDone[2] = { 0, 0 };
+
+    MSG msg = { 0 };
+    int frameIdx = 0;
+    while (msg.message != WM_QUIT && frameIdx < numFrames) {
+      if (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+      } else {
+        RECT hwndRect = { 0 };
+        GetClientRect(hwnd, &hwndRect);
+        LONG w = hwndRect.right - hwndRect.left;
+        LONG h = hwndRect.bottom - hwndRect.top;
+
+        const int mode = frameIdx * 2 < numFrames ? 0 : 1;
+        const double start = nowMs();
+        renderFrame(w > 0 ? (uint32_t) w : 0, h > 0 ? (uint32_t) h : 0, jobs, doneEvents, (uint32_t) numThreads, mode == 1, &submitMs[mode]);
+        frameMs[mode] += nowMs() - start;
+        framesDone[mode]++;
+        ++frameIdx;
+      }
+    }
+
+    for (int t = 0; t < numThreads; t++) {
+      jobs[t].quit = 1;
+      SetEvent(jobs[t].startEvent);
+    }
+    WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE);
+    for (int t = 0; t < numThreads; t++) {
+      CloseHandle(threads[t]);
+      CloseHandle(jobs[t].startEvent);
+      CloseHandle(jobs[t].doneEvent);
+    }
+
+    const char* names[2] = { "DrawInstance ", "DrawInstances" };
+    printf("%d instances per frame, %d submission threads\n", numInstances, numThreads);
+    for (int mode = 0; mode < 2; mode++) {
+      if (framesDone[mode] == 0) {
+        continue;
+      }
+      const double avgSubmitMs = submitMs[mode] / framesDone[mode];
+      printf("%s: submission %8.3f ms/frame (%10.0f instances/s), frame %8.3f ms\n",
+             names[mode], avgSubmitMs, avgSubmitMs > 0 ? numInstances * 1000.0 / avgSubmitMs : 0.0,
+             frameMs[mode] / framesDone[mode]);
+    }
+  }
+
+  destroy();
+
+  UnregisterClass(wc.lpszClassName, wc.hInstance);
+  return 0;
+}
+
+#pragma endregion
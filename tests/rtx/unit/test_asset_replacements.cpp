@@ -0,0 +1,247 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_asset_replacer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_asset_replacements.log");
+}
+
+namespace test_asset_replacements {
+  using namespace dxvk;
+
+  constexpr uint32_t kNumKeys = 1024;
+  constexpr uint32_t kNumReaders = 4;
+  constexpr uint32_t kNumFrames = 500;
+
+  XXH64_hash_t keyHash(uint32_t index) {
+    return XXH3_64bits(&index, sizeof(index));
+  }
+
+  // Replacements of a key describe themselves: their count and transforms are derived from the key index
+  std::vector<AssetReplacement> makeReplacements(uint32_t index, MaterialData* material) {
+    std::vector<AssetReplacement> replacements;
+    for (uint32_t i = 0; i <= index % 4; i++) {
+      Matrix4 transform;
+      transform[3][0] = static_cast<float>(index);
+      transform[3][1] = static_cast<float>(i);
+      replacements.emplace_back(nullptr, material, Categorizer(), transform);
+    }
+    return replacements;
+  }
+
+  // Materials referenced by the replacements of a key are stored with the key hash ^ 1, while
+  // unreferenced ones, which may be removed at any time, are stored with the key hash ^ 2.
+  MaterialData makeMaterial(XXH64_hash_t hash) {
+    MaterialData material { OpaqueMaterialData() };
+    material.setHashOverride(hash);
+    return material;
+  }
+
+  bool isValid(uint32_t index, const std::vector<AssetReplacement>& replacements) {
+    if (replacements.size() != index % 4 + 1) {
+      return false;
+    }
+    for (uint32_t i = 0; i < replacements.size(); i++) {
+      const AssetReplacement& replacement = replacements[i];
+      if (replacement.replacementToObject[3][0] != static_cast<float>(index) ||
+          replacement.replacementToObject[3][1] != static_cast<float>(i) ||
+          replacement.materialData == nullptr ||
+          replacement.materialData->getHash() != (keyHash(index) ^ 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Stages the replacements of the given key range the way the mod loader does, then merges them in.
+  void load(AssetReplacements& replacements, uint32_t begin, uint32_t end) {
+    AssetReplacements staging;
+    for (uint32_t index = begin; index < end; index++) {
+      MaterialData& material = staging.storeObject(keyHash(index) ^ 1, makeMaterial(keyHash(index) ^ 1));
+      staging.storeObject(keyHash(index) ^ 2, makeMaterial(keyHash(index) ^ 2));
+      staging.set<AssetReplacement::eMesh>(keyHash(index), makeReplacements(index, &material));
+    }
+    replacements.merge(staging);
+  }
+
+  void testPublish() {
+    AssetReplacements replacements;
+    load(replacements, 0, 16);
+
+    // Modifications are visible to the locked accessors right away, but only published to lookups
+    if (replacements.get<AssetReplacement::eMesh>(keyHash(3)) == nullptr)
+      throw DxvkError("stored replacements are not visible to get()");
+
+    if (replacements.find<AssetReplacement::eMesh>(keyHash(3)) != nullptr)
+      throw DxvkError("replacements are visible to find() before publishing");
+
+    replacements.publish();
+
+    for (uint32_t index = 0; index < 16; index++) {
+      const auto* found = replacements.find<AssetReplacement::eMesh>(keyHash(index));
+      if (found == nullptr || !isValid(index, *found))
+        throw DxvkError(str::format("published replacements of key ", index, " are missing or invalid"));
+
+      if (replacements.findMaterial(keyHash(index) ^ 1) == nullptr)
+        throw DxvkError(str::format("published material of key ", index, " is missing"));
+    }
+
+    if (replacements.find<AssetReplacement::eMesh>(keyHash(16)) != nullptr)
+      throw DxvkError("find() returned replacements for a key never stored");
+
+    if (replacements.find<AssetReplacement::eLight>(keyHash(3)) != nullptr)
+      throw DxvkError("find() returned mesh replacements as light replacements");
+
+    // Removed objects stay reachable through the published snapshot until the next publish
+    replacements.removeObject<MaterialData>(keyHash(3) ^ 2);
+    if (replacements.findMaterial(keyHash(3) ^ 2) == nullptr)
+      throw DxvkError("removed material disappeared before publishing");
+
+    replacements.publish();
+    if (replacements.findMaterial(keyHash(3) ^ 2) != nullptr)
+      throw DxvkError("removed material is still visible after publishing");
+
+    replacements.clear();
+    if (replacements.find<AssetReplacement::eMesh>(keyHash(5)) == nullptr)
+      throw DxvkError("cleared replacements disappeared before publishing");
+
+    replacements.publish();
+    if (replacements.find<AssetReplacement::eMesh>(keyHash(5)) != nullptr)
+      throw DxvkError("cleared replacements are still visible after publishing");
+
+    // Publishing without modifications must keep the current snapshot
+    load(replacements, 0, 4);
+    replacements.publish();
+    replacements.publish();
+    replacements.publish();
+    if (replacements.find<AssetReplacement::eMesh>(keyHash(2)) == nullptr)
+      throw DxvkError("replacements disappeared after publishing without modifications");
+  }
+
+  // A writer keeps loading and clearing replacements while readers look them up and a "render loop"
+  // publishes once per frame. Each reader reports the frame it last started a batch of lookups in,
+  // and the render loop waits for all of them to move past the previous frame before publishing
+  // again, which is the guarantee the renderer gives by only looking up replacements within a frame.
+  void testConcurrentAccess() {
+    AssetReplacements replacements;
+
+    std::atomic<bool> done { false };
+    std::atomic<uint32_t> frame { 0 };
+    std::atomic<uint32_t> failures { 0 };
+    std::atomic<uint64_t> hits { 0 };
+    std::atomic<uint32_t> readerFrames[kNumReaders] = {};
+
+    std::thread writer([&] {
+      uint32_t iteration = 0;
+      while (!done.load()) {
+        const uint32_t begin = (iteration * 97) % kNumKeys;
+        load(replacements, begin, std::min(begin + 64, kNumKeys));
+        replacements.removeObject<MaterialData>(keyHash((iteration * 31) % kNumKeys) ^ 2);
+
+        if (++iteration % 64 == 0) {
+          replacements.clear();
+        }
+      }
+    });
+
+    std::vector<std::thread> readers;
+    for (uint32_t r = 0; r < kNumReaders; r++) {
+      readers.emplace_back([&, r] {
+        uint32_t index = r;
+        while (!done.load()) {
+          const uint32_t currentFrame = frame.load(std::memory_order_acquire);
+          uint64_t localHits = 0;
+
+          for (uint32_t i = 0; i < 256; i++) {
+            index = (index * 1664525u + 1013904223u) % kNumKeys;
+
+            if (const auto* found = replacements.find<AssetReplacement::eMesh>(keyHash(index))) {
+              localHits++;
+              if (!isValid(index, *found)) {
+                failures++;
+              }
+            }
+
+            if (const MaterialData* material = replacements.findMaterial(keyHash(index) ^ 2)) {
+              if (material->getHash() != (keyHash(index) ^ 2)) {
+                failures++;
+              }
+            }
+          }
+
+          hits += localHits;
+          readerFrames[r].store(currentFrame, std::memory_order_release);
+        }
+      });
+    }
+
+    for (uint32_t f = 1; f <= kNumFrames; f++) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+      replacements.publish();
+      frame.store(f, std::memory_order_release);
+
+      for (auto& readerFrame : readerFrames) {
+        while (readerFrame.load(std::memory_order_acquire) < f) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    done = true;
+    writer.join();
+    for (auto& reader : readers) {
+      reader.join();
+    }
+
+    if (failures > 0)
+      throw DxvkError(str::format("concurrent lookups returned ", failures.load(), " invalid results"));
+
+    if (hits == 0)
+      throw DxvkError("concurrent lookups never observed published replacements");
+  }
+
+  void run() {
+    testPublish();
+    testConcurrentAccess();
+  }
+}
+
+int main() {
+  try {
+    test_asset_replacements::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
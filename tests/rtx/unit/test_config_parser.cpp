@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/config/config.h"
+#include "../../../src/util/util_fast_cache.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_config_parser.log");
+}
+
+namespace test_config_parser {
+  using namespace dxvk;
+
+  constexpr uint32_t kNumHashes = 50000;
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  // What the option parsing did before lists were parsed in place, used as the benchmark baseline
+  void legacyFillHashTable(const std::string& value, fast_unordered_set& hashTable) {
+    std::stringstream ss(value);
+    std::string s;
+    std::vector<std::string> entries;
+    while (std::getline(ss, s, ',')) {
+      entries.push_back(s);
+    }
+    for (auto&& hashStr : entries) {
+      hashTable.insert(std::stoull(hashStr, nullptr, 16));
+    }
+  }
+
+  void fillHashTable(const std::string& value, fast_unordered_set& hashTable) {
+    Config::forEachListEntry(value, [&](std::string_view entry) {
+      uint64_t h;
+      if (!Config::parseHashListEntry(entry, h)) {
+        throw DxvkError(str::format("Failed to parse hash '", std::string(entry), "'"));
+      }
+      hashTable.insert(h);
+    });
+  }
+
+  void testListEntries() {
+    std::vector<std::string> entries;
+    Config::forEachListEntry("a, b,,c,", [&](std::string_view entry) { entries.emplace_back(entry); });
+    if (entries != std::vector<std::string> { "a", " b", "", "c" }) {
+      throw DxvkError("List entries differ from std::getline");
+    }
+
+    uint64_t h = 0;
+    if (!Config::parseHashListEntry(" 0xDEADbeef", h) || h != 0xdeadbeef ||
+        !Config::parseHashListEntry("1234 ", h) || h != 0x1234 ||
+        Config::parseHashListEntry("", h) || Config::parseHashListEntry(" 0x", h) ||
+        Config::parseHashListEntry("0x1FFFFFFFFFFFFFFFF", h)) {
+      throw DxvkError("Hash entries are not parsed like std::stoull");
+    }
+
+    int32_t i = 0;
+    if (!Config::parseIntListEntry(" -12", i) || i != -12 ||
+        !Config::parseIntListEntry("+7", i) || i != 7 ||
+        Config::parseIntListEntry("x", i)) {
+      throw DxvkError("Int entries are not parsed like std::stoi");
+    }
+
+    std::cout << "List entries passed" << std::endl;
+  }
+
+  void testLargeConfig() {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "test_config_parser";
+    std::filesystem::create_directories(dir);
+
+    // A config shaped like a production rtx.conf, a few long hash lists between scalar options
+    std::mt19937_64 rng(99);
+    std::vector<uint64_t> hashes(kNumHashes);
+    for (auto& hash : hashes) {
+      hash = rng();
+    }
+
+    {
+      std::ofstream file(dir / "dxvk.conf", std::ios_base::binary);
+      file << "# Generated by test_config_parser\r\n";
+      file << "rtx.someFloat = 0.5\r\n";
+      file << "rtx.quoted = \"with spaces\"\r\n";
+      for (uint32_t list = 0; list < 4; list++) {
+        file << "rtx.textures" << list << " = ";
+        for (uint32_t i = list; i < kNumHashes; i += 4) {
+          file << (i == list ? "" : ", ") << "0x" << std::uppercase << std::hex << hashes[i] << std::dec;
+        }
+        file << "\n";
+      }
+      file << "[other.exe]\n";
+      file << "rtx.someFloat = 2.0\n";
+    }
+
+    const auto loadStart = Clock::now();
+    const Config config = Config::getConfig<Config::Type_User>(dir.string());
+    const double loadMs = elapsedMs(loadStart);
+
+    if (config.getOption<float>("rtx.someFloat") != 0.5f || config.getOption<std::string>("rtx.quoted") != "with spaces") {
+      throw DxvkError("Scalar options were not parsed correctly");
+    }
+
+    fast_unordered_set parsed;
+    fast_unordered_set legacy;
+
+    const auto parseStart = Clock::now();
+    for (uint32_t list = 0; list < 4; list++) {
+      fillHashTable(*config.findOptionValue(str::format("rtx.textures", list).c_str()), parsed);
+    }
+    const double parseMs = elapsedMs(parseStart);
+
+    const auto legacyStart = Clock::now();
+    for (uint32_t list = 0; list < 4; list++) {
+      legacyFillHashTable(config.getOption<std::string>(str::format("rtx.textures", list).c_str()), legacy);
+    }
+    const double legacyMs = elapsedMs(legacyStart);
+
+    if (parsed.size() != kNumHashes || parsed != legacy) {
+      throw DxvkError(str::format("Parsed ", parsed.size(), " hashes, expected ", kNumHashes));
+    }
+
+    std::filesystem::remove_all(dir);
+
+    std::cout << "Large config passed: loaded " << kNumHashes << " hashes in " << loadMs << " ms, "
+              << "hash lists parsed in " << parseMs << " ms, " << legacyMs << " ms with std::getline and std::stoull" << std::endl;
+  }
+
+  void run() {
+    testListEntries();
+    testLargeConfig();
+  }
+}
+
+int main() {
+  try {
+    test_config_parser::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
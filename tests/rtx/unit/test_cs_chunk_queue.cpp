@@ -0,0 +1,363 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/dxvk_cs.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_cs_chunk_queue.log");
+}
+
+namespace test_cs_chunk_queue {
+  using namespace dxvk;
+
+  constexpr uint32_t kNumProducers = 4;
+
+  void testQueueOrder() {
+    AtomicMpscQueue<uint32_t, 8> queue;
+    uint64_t pos;
+    uint32_t value;
+
+    // Several rounds so that positions wrap around the ring
+    for (uint32_t round = 0; round < 3; round++) {
+      for (uint32_t i = 0; i < 8; i++) {
+        value = round * 8 + i;
+
+        if (!queue.push(std::move(value), pos) || pos != round * 8 + i)
+          throw DxvkError("push returned an unexpected position");
+      }
+
+      value = 0;
+
+      if (queue.push(std::move(value), pos))
+        throw DxvkError("full queue accepted an item");
+
+      for (uint32_t i = 0; i < 8; i++) {
+        if (queue.isEmpty() || !queue.pop(value) || value != round * 8 + i)
+          throw DxvkError("pop returned items out of order");
+      }
+
+      if (!queue.isEmpty() || queue.pop(value))
+        throw DxvkError("drained queue is not empty");
+    }
+
+    if (queue.getPushCount() != 24)
+      throw DxvkError("unexpected push count");
+  }
+
+  void testConcurrentPush() {
+    constexpr uint32_t kItemsPerProducer = 100000;
+    constexpr uint32_t kNumItems = kNumProducers * kItemsPerProducer;
+
+    // Small ring so that producers regularly run into a full queue
+    AtomicMpscQueue<uint64_t, 64> queue;
+
+    std::vector<std::vector<uint64_t>> positions(kNumProducers, std::vector<uint64_t>(kItemsPerProducer));
+    std::vector<std::thread> producers;
+
+    for (uint32_t p = 0; p < kNumProducers; p++) {
+      producers.emplace_back([&queue, &positions, p] {
+        for (uint32_t i = 0; i < kItemsPerProducer; i++) {
+          uint64_t item = (uint64_t(p) << 32) | i;
+          uint64_t pos;
+
+          while (!queue.push(std::move(item), pos))
+            std::this_thread::yield();
+
+          positions[p][i] = pos;
+        }
+      });
+    }
+
+    std::vector<uint64_t> popped;
+    popped.reserve(kNumItems);
+
+    while (popped.size() < kNumItems) {
+      uint64_t item;
+
+      if (queue.pop(item))
+        popped.push_back(item);
+      else
+        std::this_thread::yield();
+    }
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+
+    std::vector<uint32_t> nextIndex(kNumProducers, 0);
+
+    for (uint64_t item : popped) {
+      const uint32_t p = uint32_t(item >> 32);
+      const uint32_t i = uint32_t(item);
+
+      if (p >= kNumProducers || i != nextIndex[p]++)
+        throw DxvkError("items of a producer were popped out of order");
+    }
+
+    for (uint32_t p = 0; p < kNumProducers; p++) {
+      for (uint32_t i = 0; i < kItemsPerProducer; i++) {
+        if (popped[positions[p][i]] != ((uint64_t(p) << 32) | i))
+          throw DxvkError("pop order does not match the positions returned by push");
+      }
+    }
+  }
+
+  void testChunkReuse() {
+    DxvkCsChunkPool pool;
+
+    DxvkCsChunk* chunk = pool.allocChunk(DxvkCsChunkFlags());
+    pool.freeChunk(chunk);
+
+    if (pool.allocChunk(DxvkCsChunkFlags()) != chunk)
+      throw DxvkError("chunk freed on the same thread was not reused");
+
+    pool.freeChunk(chunk);
+
+    // Chunks recorded on one thread and released on another
+    // must find their way back to the allocating thread
+    std::vector<DxvkCsChunk*> chunks;
+
+    for (uint32_t i = 0; i < 40; i++)
+      chunks.push_back(pool.allocChunk(DxvkCsChunkFlags()));
+
+    std::thread releaser([&pool, &chunks] {
+      for (DxvkCsChunk* chunk : chunks)
+        pool.freeChunk(chunk);
+    });
+    releaser.join();
+
+    std::unordered_set<DxvkCsChunk*> released(chunks.begin(), chunks.end());
+
+    for (uint32_t i = 0; i < 40; i++) {
+      chunks[i] = pool.allocChunk(DxvkCsChunkFlags());
+
+      if (!released.count(chunks[i]))
+        throw DxvkError("chunk released on another thread was not reused");
+    }
+
+    for (DxvkCsChunk* chunk : chunks)
+      pool.freeChunk(chunk);
+  }
+
+  void testPoolLifetime() {
+    auto pool = std::make_unique<DxvkCsChunkPool>();
+    DxvkCsChunkPool otherPool;
+
+    std::atomic<uint32_t> stage = { 0u };
+
+    std::thread worker([&] {
+      // Leave chunks of the first pool in this thread's cache
+      for (uint32_t i = 0; i < 4; i++)
+        pool->freeChunk(pool->allocChunk(DxvkCsChunkFlags()));
+
+      stage = 1;
+
+      while (stage.load() != 2)
+        std::this_thread::yield();
+
+      // The first pool is gone by now, so switching pools
+      // must dispose of its chunks rather than return them
+      otherPool.freeChunk(otherPool.allocChunk(DxvkCsChunkFlags()));
+    });
+
+    while (stage.load() != 1)
+      std::this_thread::yield();
+
+    pool.reset();
+    stage = 2;
+
+    worker.join();
+  }
+
+  // Mirrors the submission path of DxvkCsThread, without a device
+  // or context, so that it can be exercised and timed headless.
+  class HeadlessCsThread {
+    constexpr static uint32_t MaxChunksInFlight = 256;
+  public:
+
+    HeadlessCsThread()
+    : m_thread([this] { threadFunc(); }) { }
+
+    ~HeadlessCsThread() {
+      m_stopped.store(true);
+      m_eventOnAdd.notify();
+      m_thread.join();
+    }
+
+    uint64_t dispatchChunk(DxvkCsChunkRef&& chunk) {
+      uint64_t pos;
+
+      while (!m_chunksQueued.push(std::move(chunk), pos))
+        waitForChunks(m_chunksExecuted.load(std::memory_order_acquire) + 1);
+
+      m_eventOnAdd.notify();
+      return pos + 1;
+    }
+
+    void synchronize(uint64_t seq) {
+      if (seq == DxvkCsThread::SynchronizeAll)
+        seq = m_chunksQueued.getPushCount();
+
+      waitForChunks(seq);
+    }
+
+    uint64_t lastSequenceNumber() const {
+      return m_chunksExecuted.load();
+    }
+
+  private:
+
+    std::atomic<uint64_t>   m_chunksExecuted = { 0ull };
+    std::atomic<bool>       m_stopped = { false };
+    sync::AdaptiveEvent     m_eventOnAdd;
+    sync::AdaptiveEvent     m_eventOnSync;
+    AtomicMpscQueue<DxvkCsChunkRef, MaxChunksInFlight> m_chunksQueued;
+    std::thread             m_thread;
+
+    void waitForChunks(uint64_t seq) {
+      m_eventOnSync.wait([this, seq] {
+        return m_chunksExecuted.load(std::memory_order_acquire) >= seq;
+      });
+    }
+
+    void threadFunc() {
+      DxvkCsChunkRef chunk;
+
+      while (!m_stopped.load()) {
+        if (!m_chunksQueued.pop(chunk)) {
+          m_eventOnAdd.wait([this] {
+            return !m_chunksQueued.isEmpty()
+                || m_stopped.load();
+          });
+
+          continue;
+        }
+
+        chunk->executeAll(nullptr);
+        chunk = DxvkCsChunkRef();
+
+        m_chunksExecuted.fetch_add(1, std::memory_order_release);
+        m_eventOnSync.notify();
+      }
+    }
+  };
+
+  void testChunkSubmission() {
+    constexpr uint32_t kChunksPerProducer = 20000;
+    constexpr uint32_t kCommandsPerChunk = 8;
+    constexpr uint32_t kSyncInterval = 64;
+
+    DxvkCsChunkPool pool;
+
+    std::vector<uint64_t> executed(kNumProducers, 0);
+    std::atomic<uint32_t> failures = { 0u };
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    { HeadlessCsThread csThread;
+      std::vector<std::thread> producers;
+
+      for (uint32_t p = 0; p < kNumProducers; p++) {
+        producers.emplace_back([&, p] {
+          uint64_t expected = 0;
+
+          for (uint32_t i = 0; i < kChunksPerProducer; i++) {
+            DxvkCsChunk* chunk = pool.allocChunk(DxvkCsChunkFlag::SingleUse);
+
+            for (uint32_t c = 0; c < kCommandsPerChunk; c++) {
+              auto command = [&executed, &failures, p, value = ++expected] (DxvkContext*) {
+                if (executed[p] + 1 != value)
+                  failures++;
+
+                executed[p] = value;
+              };
+
+              if (!chunk->push(command))
+                failures++;
+            }
+
+            uint64_t seq = csThread.dispatchChunk(DxvkCsChunkRef(chunk, &pool));
+
+            if (i % kSyncInterval == kSyncInterval - 1) {
+              csThread.synchronize(p == 0 ? DxvkCsThread::SynchronizeAll : seq);
+
+              if (csThread.lastSequenceNumber() < seq || executed[p] != expected)
+                failures++;
+            }
+          }
+        });
+      }
+
+      for (auto& producer : producers) {
+        producer.join();
+      }
+
+      csThread.synchronize(DxvkCsThread::SynchronizeAll);
+
+      if (csThread.lastSequenceNumber() != kNumProducers * kChunksPerProducer)
+        throw DxvkError("not all chunks were executed");
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+    Logger::info(str::format("Headless CS submission: ",
+      ns / (kNumProducers * kChunksPerProducer), " ns per chunk"));
+
+    if (failures > 0)
+      throw DxvkError(str::format("chunk submission observed ", failures.load(), " ordering failures"));
+
+    for (uint32_t p = 0; p < kNumProducers; p++) {
+      if (executed[p] != uint64_t(kChunksPerProducer) * kCommandsPerChunk)
+        throw DxvkError("commands of a producer were lost");
+    }
+  }
+
+  void run() {
+    testQueueOrder();
+    testConcurrentPush();
+    testChunkReuse();
+    testPoolLifetime();
+    testChunkSubmission();
+  }
+}
+
+int main() {
+  try {
+    test_cs_chunk_queue::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
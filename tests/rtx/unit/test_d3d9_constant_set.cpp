@@ -0,0 +1,185 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <array>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/d3d9/d3d9_constant_set.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_d3d9_constant_set.log");
+}
+
+namespace test_d3d9_constant_set {
+  using namespace dxvk;
+
+  constexpr uint32_t kNumRegisters = 256;
+
+  struct Stats {
+    uint32_t numUploads = 0;
+    uint32_t numBytesCopied = 0;
+  };
+
+  // Replays the constant handling of D3D9DeviceEx on a single float constant set:
+  // SetShaderConstants, the shader switch dirty rules and UploadConstantSet.
+  class ConstantSetModel {
+  public:
+    explicit ConstantSetModel(bool registerGranular)
+      : m_registerGranular(registerGranular) {
+      m_state.fill(Vector4(0.0f));
+      m_buffer.fill(Vector4(-1.0f));
+    }
+
+    void setConstants(uint32_t startRegister, const std::vector<Vector4>& values) {
+      const uint32_t count = uint32_t(values.size());
+      m_floatCount = std::max(m_floatCount, startRegister + count);
+
+      if (m_registerGranular) {
+        D3D9Range changed = FindChangedConstants(m_state[startRegister].data, values.data(), startRegister, count);
+        if (changed.IsDegenerate())
+          return;
+
+        m_set.dirtyFloats.Conjoin(changed);
+      } else {
+        m_set.dirty |= startRegister < m_set.meta.maxConstIndexF;
+      }
+
+      std::copy(values.begin(), values.end(), m_state.begin() + startRegister);
+    }
+
+    void setShader(uint32_t maxConstIndexF) {
+      m_set.dirty |= maxConstIndexF > m_set.meta.maxConstIndexF;
+      m_set.meta.maxConstIndexF = maxConstIndexF;
+    }
+
+    void draw() {
+      if (m_registerGranular ? !m_set.NeedsUpload() : !m_set.dirty)
+        return;
+
+      m_set.ClearDirty();
+
+      // Every upload is a complete snapshot of the registers set so far
+      const uint32_t floatCount = std::min(m_floatCount, m_set.meta.maxConstIndexF);
+      std::copy(m_state.begin(), m_state.begin() + floatCount, m_buffer.begin());
+      m_stats.numUploads++;
+      m_stats.numBytesCopied += floatCount * sizeof(Vector4);
+    }
+
+    // The registers the bound shader reads must match the application state
+    bool isBufferCurrent() const {
+      const uint32_t floatCount = std::min(m_floatCount, m_set.meta.maxConstIndexF);
+      for (uint32_t i = 0; i < floatCount; i++) {
+        if (std::memcmp(m_state[i].data, m_buffer[i].data, sizeof(Vector4)) != 0)
+          return false;
+      }
+      return true;
+    }
+
+    const Stats& getStats() const { return m_stats; }
+
+  private:
+    const bool m_registerGranular;
+    D3D9ConstantSets m_set;
+    uint32_t m_floatCount = 0;
+    std::array<Vector4, kNumRegisters> m_state;
+    std::array<Vector4, kNumRegisters> m_buffer;
+    Stats m_stats;
+  };
+
+  void testFindChangedConstants() {
+    std::vector<Vector4> current(8, Vector4(1.0f));
+    std::vector<Vector4> next = current;
+
+    if (!FindChangedConstants(current.data(), next.data(), 10, 8).IsDegenerate())
+      throw DxvkError("Identical registers were reported as changed");
+
+    next[2].y = 2.0f;
+    next[5].w = 3.0f;
+    D3D9Range changed = FindChangedConstants(current.data(), next.data(), 10, 8);
+    if (changed.min != 12 || changed.max != 16)
+      throw DxvkError("Changed register range is wrong");
+
+    std::cout << "Find changed constants passed" << std::endl;
+  }
+
+  void testConstantSetDiff() {
+    std::mt19937 rng(4242);
+    ConstantSetModel legacy(false);
+    ConstantSetModel granular(true);
+
+    // Per draw matrices which are set again with the same values most of the time,
+    // plus occasional changes and shader switches, like a typical D3D9 title.
+    std::vector<std::vector<Vector4>> palette;
+    for (uint32_t i = 0; i < 16; i++) {
+      palette.emplace_back(4, Vector4(float(i), float(i) * 0.5f, 1.0f, float(i * i)));
+    }
+
+    for (uint32_t draw = 0; draw < 20000; draw++) {
+      const uint32_t numSets = 1 + rng() % 4;
+      for (uint32_t i = 0; i < numSets; i++) {
+        const uint32_t startRegister = (rng() % 16) * 4;
+        const std::vector<Vector4>& values = palette[rng() % 100 < 90 ? startRegister / 4 : rng() % palette.size()];
+        legacy.setConstants(startRegister, values);
+        granular.setConstants(startRegister, values);
+      }
+
+      if (rng() % 50 == 0) {
+        const uint32_t maxConstIndexF = 8 + (rng() % 8) * 8;
+        legacy.setShader(maxConstIndexF);
+        granular.setShader(maxConstIndexF);
+      }
+
+      legacy.draw();
+      granular.draw();
+
+      if (!legacy.isBufferCurrent() || !granular.isBufferCurrent())
+        throw DxvkError(str::format("Constant buffer is stale on draw ", draw));
+    }
+
+    const Stats& before = legacy.getStats();
+    const Stats& after = granular.getStats();
+    if (after.numUploads >= before.numUploads)
+      throw DxvkError(str::format("Register granular tracking did not skip any upload: ", after.numUploads, " vs ", before.numUploads));
+
+    std::cout << "Constant set diff passed, " << after.numUploads << " uploads and " << after.numBytesCopied
+              << " bytes copied instead of " << before.numUploads << " uploads and " << before.numBytesCopied << " bytes" << std::endl;
+  }
+
+  void run() {
+    testFindChangedConstants();
+    testConstantSetDiff();
+  }
+}
+
+int main() {
+  try {
+    test_d3d9_constant_set::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,379 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/d3d9/d3d9_shader_cache.h"
+#include "../../../src/dxso/dxso_module.h"
+#include "../../../src/dxso/dxso_modinfo.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_d3d9_shader_cache.log");
+}
+
+namespace test_d3d9_shader_cache {
+  using namespace dxvk;
+
+  struct DxsoBlob {
+    const char*           name;
+    VkShaderStageFlagBits stage;
+    std::vector<uint32_t> tokens;
+  };
+
+  // Hand assembled SM2 shaders, enough to exercise inputs, outputs, constants,
+  // samplers and the flat shading permutation of pixel shaders.
+  const std::vector<DxsoBlob>& getCorpus() {
+    static const std::vector<DxsoBlob> corpus = {
+      { "vs_2_0 transform", VK_SHADER_STAGE_VERTEX_BIT, {
+        0xFFFE0200,                                         // vs_2_0
+        0x0200001F, 0x80000000, 0x900F0000,                 // dcl_position v0
+        0x03000009, 0xC0010000, 0x90E40000, 0xA0E40000,     // dp4 oPos.x, v0, c0
+        0x03000009, 0xC0020000, 0x90E40000, 0xA0E40001,     // dp4 oPos.y, v0, c1
+        0x03000009, 0xC0040000, 0x90E40000, 0xA0E40002,     // dp4 oPos.z, v0, c2
+        0x03000009, 0xC0080000, 0x90E40000, 0xA0E40003,     // dp4 oPos.w, v0, c3
+        0x02000001, 0xD00F0000, 0xA0E40004,                 // mov oD0, c4
+        0x0000FFFF } },                                     // end
+      { "vs_2_0 passthrough", VK_SHADER_STAGE_VERTEX_BIT, {
+        0xFFFE0200,                                         // vs_2_0
+        0x0200001F, 0x80000000, 0x900F0000,                 // dcl_position v0
+        0x02000001, 0xC00F0000, 0x90E40000,                 // mov oPos, v0
+        0x0000FFFF } },                                     // end
+      { "ps_2_0 modulate", VK_SHADER_STAGE_FRAGMENT_BIT, {
+        0xFFFF0200,                                         // ps_2_0
+        0x0200001F, 0x80000000, 0xB00F0000,                 // dcl t0
+        0x0200001F, 0x90000000, 0xA00F0800,                 // dcl_2d s0
+        0x03000042, 0x800F0000, 0xB0E40000, 0xA0E40800,     // texld r0, t0, s0
+        0x03000005, 0x800F0000, 0x80E40000, 0xA0E40000,     // mul r0, r0, c0
+        0x02000001, 0x800F0800, 0x80E40000,                 // mov oC0, r0
+        0x0000FFFF } },                                     // end
+    };
+    return corpus;
+  }
+
+  D3D9ConstantLayout getLayout(VkShaderStageFlagBits stage) {
+    D3D9ConstantLayout layout;
+    layout.floatCount   = stage == VK_SHADER_STAGE_VERTEX_BIT ? 256 : 32;
+    layout.intCount     = 16;
+    layout.boolCount    = 16;
+    layout.bitmaskCount = 1;
+    return layout;
+  }
+
+  D3D9CachedShaderModule compile(const DxsoBlob& blob, const DxsoModuleInfo& moduleInfo) {
+    DxsoReader reader(reinterpret_cast<const char*>(blob.tokens.data()));
+    DxsoModule module(reader);
+
+    if (module.info().shaderStage() != blob.stage)
+      throw DxvkError(str::format(blob.name, ": unexpected shader stage"));
+
+    const DxsoAnalysisInfo analysis = module.analyze();
+
+    D3D9CachedShaderModule result;
+    result.shaders         = module.compile(moduleInfo, blob.name, analysis, getLayout(blob.stage));
+    result.isgn            = module.isgn();
+    result.osgn            = module.osgn();
+    result.usedSamplers    = module.usedSamplers();
+    result.usedRTs         = module.usedRTs();
+    result.meta            = module.meta();
+    result.constants       = module.constants();
+    result.maxDefinedConst = module.maxDefinedConstant();
+    return result;
+  }
+
+  Sha1Hash computeKey(const DxsoBlob& blob, const DxsoModuleInfo& moduleInfo) {
+    const Sha1Hash bytecodeHash = Sha1Hash::compute(blob.tokens.data(), blob.tokens.size() * sizeof(uint32_t));
+    return D3D9ShaderCache::ComputeKey(blob.stage, bytecodeHash, moduleInfo.options, getLayout(blob.stage));
+  }
+
+  std::vector<uint32_t> getCode(const Rc<DxvkShader>& shader) {
+    SpirvCodeBuffer code = shader->compressedCode().decompress();
+    return std::vector<uint32_t>(code.data(), code.data() + code.dwords());
+  }
+
+  void compareShader(const char* name, const Rc<DxvkShader>& a, const Rc<DxvkShader>& b) {
+    if ((a == nullptr) != (b == nullptr))
+      throw DxvkError(str::format(name, ": permutation mismatch"));
+
+    if (a == nullptr)
+      return;
+
+    if (a->stage() != b->stage())
+      throw DxvkError(str::format(name, ": stage mismatch"));
+
+    if (getCode(a) != getCode(b))
+      throw DxvkError(str::format(name, ": SPIR-V mismatch"));
+
+    const auto& slotsA = a->resourceSlots();
+    const auto& slotsB = b->resourceSlots();
+
+    if (slotsA.size() != slotsB.size())
+      throw DxvkError(str::format(name, ": resource slot count mismatch"));
+
+    for (size_t i = 0; i < slotsA.size(); i++) {
+      if (slotsA[i].slot   != slotsB[i].slot
+       || slotsA[i].type   != slotsB[i].type
+       || slotsA[i].view   != slotsB[i].view
+       || slotsA[i].access != slotsB[i].access
+       || slotsA[i].count  != slotsB[i].count
+       || slotsA[i].flags  != slotsB[i].flags)
+        throw DxvkError(str::format(name, ": resource slot mismatch"));
+    }
+
+    const DxvkInterfaceSlots ifaceA = a->interfaceSlots();
+    const DxvkInterfaceSlots ifaceB = b->interfaceSlots();
+
+    if (std::memcmp(&ifaceA, &ifaceB, sizeof(ifaceA)))
+      throw DxvkError(str::format(name, ": interface slot mismatch"));
+  }
+
+  bool isgnEqual(const DxsoIsgn& a, const DxsoIsgn& b) {
+    if (a.elemCount != b.elemCount)
+      return false;
+
+    for (uint32_t i = 0; i < a.elemCount; i++) {
+      if (a.elems[i].regNumber != b.elems[i].regNumber
+       || a.elems[i].slot      != b.elems[i].slot
+       || a.elems[i].semantic  != b.elems[i].semantic
+       || a.elems[i].mask      != b.elems[i].mask
+       || a.elems[i].centroid  != b.elems[i].centroid)
+        return false;
+    }
+
+    return true;
+  }
+
+  void compareModule(const char* name, const D3D9CachedShaderModule& a, const D3D9CachedShaderModule& b) {
+    if (!isgnEqual(a.isgn, b.isgn) || !isgnEqual(a.osgn, b.osgn))
+      throw DxvkError(str::format(name, ": signature mismatch"));
+
+    if (a.usedSamplers != b.usedSamplers
+     || a.usedRTs != b.usedRTs
+     || a.maxDefinedConst != b.maxDefinedConst
+     || a.constants.size() != b.constants.size()
+     || a.meta.maxConstIndexF != b.meta.maxConstIndexF
+     || a.meta.boolConstantMask != b.meta.boolConstantMask)
+      throw DxvkError(str::format(name, ": module info mismatch"));
+
+    for (size_t i = 0; i < a.shaders.size(); i++)
+      compareShader(name, a.shaders[i], b.shaders[i]);
+  }
+
+  // Large enough to never limit the tests that don't exercise it
+  constexpr uint64_t kMaxFileSize = 1ull << 30;
+
+  uint64_t getFileSize(const std::string& path) {
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+    return file ? uint64_t(file.tellg()) : 0;
+  }
+
+  bool waitForLookup(D3D9ShaderCache& cache, const Sha1Hash& key, D3D9CachedShaderModule& module) {
+    // The cache file is loaded asynchronously, lookups fail until it is
+    const auto start = std::chrono::steady_clock::now();
+
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+      if (cache.Lookup(key, module))
+        return true;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+  }
+
+  void testDeterminism(const DxsoModuleInfo& moduleInfo) {
+    for (const auto& blob : getCorpus())
+      compareModule(blob.name, compile(blob, moduleInfo), compile(blob, moduleInfo));
+
+    std::cout << "Compiling the corpus twice produced identical modules" << std::endl;
+  }
+
+  void testSerialization(const DxsoModuleInfo& moduleInfo) {
+    for (const auto& blob : getCorpus()) {
+      std::vector<uint8_t> data;
+      D3D9ShaderCache::Serialize(compile(blob, moduleInfo), data);
+
+      D3D9CachedShaderModule restored;
+
+      if (!D3D9ShaderCache::Deserialize(data, restored))
+        throw DxvkError(str::format(blob.name, ": failed to deserialize"));
+
+      compareModule(blob.name, restored, compile(blob, moduleInfo));
+
+      // Truncated data must be rejected rather than read out of bounds
+      data.resize(data.size() / 2);
+
+      if (D3D9ShaderCache::Deserialize(data, restored))
+        throw DxvkError(str::format(blob.name, ": truncated entry was accepted"));
+    }
+
+    std::cout << "Serialization round trip passed" << std::endl;
+  }
+
+  void testKeys(const DxsoModuleInfo& moduleInfo) {
+    const DxsoBlob& blob = getCorpus().front();
+
+    DxsoModuleInfo otherInfo = moduleInfo;
+    otherInfo.options.longMad = !otherInfo.options.longMad;
+
+    if (computeKey(blob, moduleInfo) != computeKey(blob, moduleInfo))
+      throw DxvkError("Cache key is not stable");
+
+    if (computeKey(blob, moduleInfo) == computeKey(blob, otherInfo))
+      throw DxvkError("Cache key ignores compile options");
+
+    if (computeKey(getCorpus()[0], moduleInfo) == computeKey(getCorpus()[1], moduleInfo))
+      throw DxvkError("Cache key ignores the bytecode");
+
+    std::cout << "Cache keys passed" << std::endl;
+  }
+
+  void testPersistence(const DxsoModuleInfo& moduleInfo) {
+    const std::string path = "test_d3d9_shader_cache.dxvk-shaders";
+    std::remove(path.c_str());
+
+    // First run: everything is compiled and stored
+    { Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, kMaxFileSize);
+
+      for (const auto& blob : getCorpus())
+        cache->Store(computeKey(blob, moduleInfo), compile(blob, moduleInfo));
+    }
+
+    // Simulate a write interrupted by a crash
+    { std::ofstream file(path, std::ios_base::binary | std::ios_base::app);
+      const char garbage[] = "interrupted write";
+      file.write(garbage, sizeof(garbage));
+    }
+
+    // Second run: everything comes from the cache, and matches a fresh compile
+    for (uint32_t run = 0; run < 2; run++) {
+      Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, kMaxFileSize);
+
+      for (const auto& blob : getCorpus()) {
+        D3D9CachedShaderModule cached;
+
+        if (!waitForLookup(*cache, computeKey(blob, moduleInfo), cached))
+          throw DxvkError(str::format(blob.name, ": not found in the cache file"));
+
+        compareModule(blob.name, cached, compile(blob, moduleInfo));
+      }
+    }
+
+    std::remove(path.c_str());
+    std::cout << "Cache file round trip passed" << std::endl;
+  }
+
+  void testSizeLimit(const DxsoModuleInfo& moduleInfo) {
+    const std::string path = "test_d3d9_shader_cache_limit.dxvk-shaders";
+    std::remove(path.c_str());
+
+    const auto& corpus = getCorpus();
+
+    { Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, kMaxFileSize);
+
+      for (const auto& blob : corpus)
+        cache->Store(computeKey(blob, moduleInfo), compile(blob, moduleInfo));
+    }
+
+    const uint64_t fullSize = getFileSize(path);
+
+    // A run below the limit that only uses the first module compacts the file down to it
+    { Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, fullSize - 1);
+      D3D9CachedShaderModule cached;
+
+      if (!waitForLookup(*cache, computeKey(corpus[0], moduleInfo), cached))
+        throw DxvkError(str::format(corpus[0].name, ": not found in the cache file"));
+    }
+
+    if (getFileSize(path) >= fullSize)
+      throw DxvkError("Shader cache was not compacted");
+
+    { Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, kMaxFileSize);
+      D3D9CachedShaderModule cached;
+
+      if (!waitForLookup(*cache, computeKey(corpus[0], moduleInfo), cached))
+        throw DxvkError(str::format(corpus[0].name, ": used module was dropped by the compaction"));
+
+      // The file is loaded at this point
+      for (size_t i = 1; i < corpus.size(); i++) {
+        if (cache->Lookup(computeKey(corpus[i], moduleInfo), cached))
+          throw DxvkError(str::format(corpus[i].name, ": unused module survived the compaction"));
+      }
+    }
+
+    // Appending past the limit compacts as well, the used modules that don't fit are dropped
+    const uint64_t compactedSize = getFileSize(path);
+
+    { Rc<D3D9ShaderCache> cache = new D3D9ShaderCache(path, compactedSize);
+      D3D9CachedShaderModule cached;
+      waitForLookup(*cache, computeKey(corpus[0], moduleInfo), cached);
+
+      for (size_t i = 1; i < corpus.size(); i++)
+        cache->Store(computeKey(corpus[i], moduleInfo), compile(corpus[i], moduleInfo));
+    }
+
+    if (getFileSize(path) > compactedSize)
+      throw DxvkError("Shader cache grew past its size limit");
+
+    std::remove(path.c_str());
+    std::cout << "Cache size limit passed" << std::endl;
+  }
+
+  void run() {
+    // Note: The default constructor leaves the options uninitialized
+    DxsoModuleInfo moduleInfo;
+    moduleInfo.options.useDemoteToHelperInvocation     = false;
+    moduleInfo.options.useSubgroupOpsForEarlyDiscard   = false;
+    moduleInfo.options.strictConstantCopies            = false;
+    moduleInfo.options.d3d9FloatEmulation              = D3D9FloatEmulation::Enabled;
+    moduleInfo.options.strictPow                       = true;
+    moduleInfo.options.shaderModel                     = 3;
+    moduleInfo.options.invariantPosition               = true;
+    moduleInfo.options.forceSamplerTypeSpecConstants   = false;
+    moduleInfo.options.vertexFloatConstantBufferAsSSBO = false;
+    moduleInfo.options.longMad                         = false;
+    moduleInfo.options.alphaTestWiggleRoom             = false;
+    moduleInfo.options.robustness2Supported            = true;
+
+    testDeterminism(moduleInfo);
+    testSerialization(moduleInfo);
+    testKeys(moduleInfo);
+    testPersistence(moduleInfo);
+    testSizeLimit(moduleInfo);
+  }
+}
+
+int main() {
+  try {
+    test_d3d9_shader_cache::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_cache.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_trace.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_draw_call_cache.log");
+}
+
+namespace test_draw_call_cache {
+  using namespace dxvk;
+
+  // Builds a draw call through the trace conversion, which fills in all the hashes the cache keys on
+  DrawCallState makeCacheTestDraw(uint32_t topology, uint32_t material) {
+    DrawCallTraceDraw draw = {};
+    for (uint32_t i = 0; i < (uint32_t) HashComponents::Count; i++) {
+      draw.geometryHashes[i] = XXH3_64bits_withSeed(&topology, sizeof(topology), i);
+    }
+    draw.materialHash = XXH3_64bits(&material, sizeof(material));
+    draw.objectToWorld = Matrix4();
+    draw.cameraType = (uint32_t) CameraType::Main;
+    return DrawCallTrace::toDrawCallState(draw);
+  }
+
+  void testDrawCallCache() {
+    constexpr uint32_t kNumEntries = 1000;
+    DrawCallCache cache { nullptr };
+
+    std::vector<BlasEntry*> entries(kNumEntries, nullptr);
+    std::vector<DrawCallCache::Handle> handles(kNumEntries);
+    for (uint32_t i = 0; i < kNumEntries; i++) {
+      if (cache.get(makeCacheTestDraw(i, i), &entries[i], 1) != DrawCallCache::CacheState::kNew) {
+        throw DxvkError("Unique geometry was found in an empty cache");
+      }
+      cache.touch(entries[i], 1);
+      handles[i] = cache.getHandle(entries[i]);
+    }
+
+    // Keep the even entries alive, only the odd ones may be visited by the collection
+    for (uint32_t frameId = 2; frameId <= 10; frameId++) {
+      for (uint32_t i = 0; i < kNumEntries; i += 2) {
+        BlasEntry* entry = nullptr;
+        if (cache.get(makeCacheTestDraw(i, i), &entry, frameId) != DrawCallCache::CacheState::kExisted || entry != entries[i]) {
+          throw DxvkError(str::format("Entry ", i, " was not found at its original address"));
+        }
+        cache.touch(entry, frameId);
+      }
+    }
+
+    size_t numVisited = 0;
+    cache.eraseExpired(5, [&](const BlasEntry& blas) {
+      if (blas.frameLastTouched != 1) {
+        throw DxvkError("Garbage collection visited a live entry");
+      }
+      numVisited++;
+    });
+    if (numVisited != kNumEntries / 2 || cache.size() != kNumEntries / 2) {
+      throw DxvkError(str::format("Unexpected garbage collection result: ", numVisited, " erased, ", cache.size(), " left"));
+    }
+    for (uint32_t i = 0; i < kNumEntries; i++) {
+      if (cache.resolve(handles[i]) != (i % 2 == 0 ? entries[i] : nullptr)) {
+        throw DxvkError(str::format("Handle ", i, " resolved to the wrong entry"));
+      }
+    }
+
+    // Freed slots are reused, stale handles must not see the new entries
+    for (uint32_t i = 1; i < kNumEntries; i += 2) {
+      BlasEntry* entry = nullptr;
+      cache.get(makeCacheTestDraw(kNumEntries + i, i), &entry, 11);
+      cache.touch(entry, 11);
+      if (cache.resolve(handles[i]) != nullptr) {
+        throw DxvkError("Stale handle resolved to a reused slot");
+      }
+    }
+
+    // Topology hash collisions beyond the inline bucket size
+    constexpr uint32_t kNumCollisions = 9;
+    BlasEntry* collisions[kNumCollisions] = {};
+    for (uint32_t i = 0; i < kNumCollisions; i++) {
+      cache.get(makeCacheTestDraw(5 * kNumEntries, 5 * kNumEntries + i), &collisions[i], 12);
+      cache.touch(collisions[i], 12);
+    }
+    for (uint32_t i = 0; i < kNumCollisions; i++) {
+      BlasEntry* entry = nullptr;
+      if (cache.get(makeCacheTestDraw(5 * kNumEntries, 5 * kNumEntries + i), &entry, 13) != DrawCallCache::CacheState::kExisted || entry != collisions[i]) {
+        throw DxvkError(str::format("Colliding entry ", i, " was not matched exactly"));
+      }
+      cache.touch(entry, 13);
+    }
+
+    size_t numCounted = 0;
+    cache.forEach([&](BlasEntry&) { numCounted++; });
+    if (numCounted != cache.size() || cache.size() != kNumEntries + kNumCollisions) {
+      throw DxvkError("Dense iteration does not match the cache size");
+    }
+
+    cache.eraseIf([](const BlasEntry& blas) { return blas.frameLastTouched < 11; });
+    if (cache.size() != kNumEntries / 2 + kNumCollisions) {
+      throw DxvkError(str::format("Unexpected number of entries after eraseIf: ", cache.size()));
+    }
+
+    const DrawCallCache::Handle collisionHandle = cache.getHandle(collisions[0]);
+    cache.clear();
+    if (cache.size() != 0 || cache.resolve(collisionHandle) != nullptr) {
+      throw DxvkError("Entries survived clearing the cache");
+    }
+
+    std::cout << "Draw call cache passed" << std::endl;
+  }
+
+  void run() {
+    testDrawCallCache();
+  }
+}
+
+int main() {
+  try {
+    test_draw_call_cache::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,430 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Replays a draw call trace (see rtx.drawCallTrace.enableRecording) through the device independent
+// parts of scene building, i.e. decoding draw calls and lights, the real DrawCallCache (lookups and
+// garbage collection), instance matching (InstanceManager::findSimilarInstance on the BLAS spatial maps)
+// and light matching (LightManager::matchLight and garbageCollectLights), and reports per stage timings.
+// No device or GPU is needed.
+// Note: Instance updates beyond the transform (materials, surfaces, view model and portal handling) need
+// a device and are not covered.
+//
+// Usage: draw_call_trace_replay [trace.rdct]
+// Without a trace, a synthetic one is generated, validated and replayed.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_cache.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_trace.h"
+#include "../../../src/dxvk/rtx_render/rtx_instance_manager.h"
+#include "../../../src/dxvk/rtx_render/rtx_light_manager.h"
+#include "../../../src/dxvk/rtx_render/rtx_options.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_draw_call_trace_replay.log");
+}
+
+namespace test_draw_call_trace_replay {
+  using namespace dxvk;
+
+  struct StageTimes {
+    static constexpr uint32_t kNumStages = 5;
+    static constexpr const char* kNames[kNumStages] = {
+      "Draw call states",
+      "Draw call cache",
+      "Instance matching",
+      "Light matching",
+      "Garbage collection",
+    };
+
+    double us[kNumStages] = {};
+  };
+
+  class ScopedStage {
+  public:
+    ScopedStage(StageTimes& times, uint32_t stage)
+      : m_time(times.us[stage])
+      , m_start(std::chrono::high_resolution_clock::now()) { }
+
+    ~ScopedStage() {
+      const auto end = std::chrono::high_resolution_clock::now();
+      m_time += std::chrono::duration<double, std::micro>(end - m_start).count();
+    }
+
+  private:
+    double& m_time;
+    const std::chrono::high_resolution_clock::time_point m_start;
+  };
+
+  struct ReplayStats {
+    size_t numDraws = 0;
+    size_t numNewBlas = 0;
+    size_t numNewInstances = 0;
+    size_t numLights = 0;
+  };
+
+  // Drives the device independent parts of the scene manager: the draw call state and light
+  // conversions, the real draw call cache, instance and light matching, and their garbage collection.
+  class TraceReplayer {
+  public:
+    ~TraceReplayer() {
+      for (RtInstance* instance : m_instances) {
+        instance->removeFromSpatialCache();
+        delete instance;
+      }
+    }
+
+    void replayFrame(const DrawCallTrace::Frame& frame, uint32_t frameId, StageTimes& times, ReplayStats& stats) {
+      std::vector<DrawCallState> drawCalls;
+      {
+        ScopedStage stage(times, 0);
+        drawCalls.reserve(frame.draws.size());
+        for (const DrawCallTraceDraw& draw : frame.draws) {
+          drawCalls.emplace_back(DrawCallTrace::toDrawCallState(draw));
+        }
+      }
+
+      std::vector<BlasEntry*> blasEntries(drawCalls.size(), nullptr);
+      {
+        ScopedStage stage(times, 1);
+        for (size_t i = 0; i < drawCalls.size(); i++) {
+          if (m_drawCallCache.get(drawCalls[i], &blasEntries[i], frameId) == DrawCallCache::CacheState::kNew) {
+            stats.numNewBlas++;
+          }
+          m_drawCallCache.touch(blasEntries[i], frameId);
+        }
+      }
+
+      {
+        ScopedStage stage(times, 2);
+        const float uniqueObjectDistanceSqr = RtxOptions::getUniqueObjectDistanceSqr();
+        for (size_t i = 0; i < drawCalls.size(); i++) {
+          BlasEntry& blas = *blasEntries[i];
+          // Note: The legacy material hash stands in for the surface material hash, which needs the material processing
+          const XXH64_hash_t materialHash = drawCalls[i].getMaterialData().getHash();
+          const Matrix4& objectToWorld = drawCalls[i].getTransformData().objectToWorld;
+
+          float nearestDistSqr = FLT_MAX;
+          RtInstance* instance = InstanceManager::findSimilarInstance(blas, materialHash, objectToWorld, frameId, uniqueObjectDistanceSqr, nearestDistSqr);
+          if (instance == nullptr) {
+            instance = new RtInstance(m_nextInstanceId++, m_instances.size());
+            m_instances.push_back(instance);
+            instance->setFrameCreated(frameId);
+            instance->setBlas(blas);
+            instance->setMaterialHash(materialHash);
+            instance->setFrameLastUpdated(frameId);
+            instance->teleport(objectToWorld);
+            stats.numNewInstances++;
+          } else if (instance->setFrameLastUpdated(frameId)) {
+            instance->move(objectToWorld);
+          } else {
+            instance->moveAgain(objectToWorld);
+          }
+        }
+      }
+
+      {
+        ScopedStage stage(times, 3);
+        for (const DrawCallTraceLight& record : frame.lights) {
+          LightManager::matchLight(m_lights, DrawCallTrace::toLight(record), kEmptyHash, frameId);
+        }
+        stats.numLights += frame.lights.size();
+      }
+
+      {
+        ScopedStage stage(times, 4);
+        const uint32_t instanceFrames = RtxOptions::getNumFramesToKeepInstances();
+        for (size_t i = 0; i < m_instances.size();) {
+          RtInstance* instance = m_instances[i];
+          if (instance->getFrameLastUpdated() + instanceFrames <= frameId) {
+            instance->removeFromSpatialCache();
+            delete instance;
+            m_instances[i] = m_instances.back();
+            m_instances.pop_back();
+            continue;
+          }
+          i++;
+        }
+
+        const uint32_t geometryFrames = RtxOptions::numFramesToKeepGeometryData();
+        if (frameId > geometryFrames) {
+          m_drawCallCache.eraseExpired(frameId - geometryFrames, [this](const BlasEntry& blas) {
+            // Instances are kept for fewer frames than geometry, so none may still reference the BLAS
+            for (const RtInstance* instance : m_instances) {
+              if (instance->getBlas() == &blas) {
+                throw DxvkError("Garbage collected a BLAS with live instances");
+              }
+            }
+          });
+        }
+
+        LightManager::garbageCollectLights(m_lights, frameId);
+      }
+
+      stats.numDraws += drawCalls.size();
+    }
+
+    size_t getNumBlasEntries() {
+      return m_drawCallCache.size();
+    }
+
+    size_t getNumInstances() const {
+      return m_instances.size();
+    }
+
+    size_t getNumTrackedLights() const {
+      return m_lights.size();
+    }
+
+  private:
+    DrawCallCache m_drawCallCache { nullptr };
+    std::vector<RtInstance*> m_instances;
+    uint64_t m_nextInstanceId = 0;
+    std::unordered_map<XXH64_hash_t, RtLight> m_lights;
+  };
+
+  void replay(const DrawCallTrace& trace, ReplayStats& stats, TraceReplayer& replayer) {
+    StageTimes times;
+    // Frame 0 is reserved, entries are never considered touched during it
+    uint32_t frameId = 1;
+    for (const DrawCallTrace::Frame& frame : trace.frames) {
+      replayer.replayFrame(frame, frameId++, times, stats);
+    }
+
+    const size_t numFrames = std::max<size_t>(trace.frames.size(), 1);
+    std::cout << "Replayed " << trace.frames.size() << " frames, " << stats.numDraws << " draw calls" << std::endl;
+    double total = 0.0;
+    for (uint32_t i = 0; i < StageTimes::kNumStages; i++) {
+      std::printf("  %-20s %12.1f us total %10.2f us/frame\n", StageTimes::kNames[i], times.us[i], times.us[i] / numFrames);
+      total += times.us[i];
+    }
+    std::printf("  %-20s %12.1f us total %10.2f us/frame\n", "Total", total, total / numFrames);
+  }
+
+  // Synthetic scene: static props (some sharing topology with a different material), props
+  // moving every frame, skinned meshes with a new pose every frame, a few static lights and a few
+  // lights whose hash changes every frame while they jitter in place (e.g. due to precision loss).
+  DrawCallTrace generateTrace(uint32_t numFrames) {
+    constexpr uint32_t kNumStatic = 2000;
+    constexpr uint32_t kNumMoving = 200;
+    constexpr uint32_t kNumSkinned = 50;
+    constexpr uint32_t kNumLights = 16;
+    constexpr uint32_t kNumJitteringLights = 4;
+
+    std::mt19937_64 rng(0x5eed);
+    std::uniform_real_distribution<float> pos(-5000.f, 5000.f);
+
+    auto makeDraw = [&rng](uint32_t topology, uint32_t material, const Vector3& position) {
+      DrawCallTraceDraw draw = {};
+      for (uint32_t i = 0; i < (uint32_t) HashComponents::Count; i++) {
+        draw.geometryHashes[i] = XXH3_64bits_withSeed(&topology, sizeof(topology), i);
+      }
+      draw.materialHash = XXH3_64bits(&material, sizeof(material));
+      draw.objectToWorld = Matrix4();
+      draw.objectToWorld[3] = Vector4(position.x, position.y, position.z, 1.f);
+      draw.boundingBoxMin = Vector3(-1.f);
+      draw.boundingBoxMax = Vector3(1.f);
+      draw.vertexCount = 24 + topology % 1000;
+      draw.indexCount = 36 + topology % 3000;
+      draw.cameraType = (uint32_t) CameraType::Main;
+      return draw;
+    };
+
+    std::vector<DrawCallTraceDraw> staticDraws;
+    for (uint32_t i = 0; i < kNumStatic; i++) {
+      // Every 4 props share a mesh, every 8 a material
+      staticDraws.push_back(makeDraw(i / 4, i / 8, Vector3(pos(rng), pos(rng), pos(rng))));
+    }
+
+    DrawCallTrace trace;
+    for (uint32_t frameIdx = 0; frameIdx < numFrames; frameIdx++) {
+      DrawCallTrace::Frame& frame = trace.frames.emplace_back();
+      frame.frame.frameId = frameIdx;
+      frame.frame.worldToView = Matrix4();
+      frame.frame.viewToProjection = Matrix4();
+
+      frame.draws = staticDraws;
+      for (uint32_t i = 0; i < kNumMoving; i++) {
+        const float offset = 10.f * frameIdx;
+        frame.draws.push_back(makeDraw(100000 + i, 100000 + i, Vector3(i * 100.f + offset, 0.f, 0.f)));
+      }
+      for (uint32_t i = 0; i < kNumSkinned; i++) {
+        DrawCallTraceDraw draw = makeDraw(200000 + i, 200000 + i, Vector3(0.f, i * 100.f, 0.f));
+        const uint64_t pose = (uint64_t(i) << 32) | frameIdx;
+        draw.boneHash = XXH3_64bits(&pose, sizeof(pose));
+        draw.numBones = 32;
+        frame.draws.push_back(draw);
+      }
+      for (uint32_t i = 0; i < kNumLights; i++) {
+        DrawCallTraceLight light = {};
+        light.hash = XXH3_64bits(&i, sizeof(i));
+        light.type = (uint32_t) RtLightType::Sphere;
+        light.position = Vector3(i * 50.f, 10.f, 0.f);
+        light.direction = Vector3(0.f, 0.f, 1.f);
+        light.radiance = Vector3(10.f);
+        light.radius = 1.f;
+        frame.lights.push_back(light);
+      }
+      for (uint32_t i = 0; i < kNumJitteringLights; i++) {
+        DrawCallTraceLight light = {};
+        const uint64_t key = (uint64_t(kNumLights + i) << 32) | frameIdx;
+        light.hash = XXH3_64bits(&key, sizeof(key));
+        light.type = (uint32_t) RtLightType::Sphere;
+        light.position = Vector3(i * 50.f, 100.f + 0.5f * (frameIdx % 2), 0.f);
+        light.direction = Vector3(0.f, 0.f, 1.f);
+        light.radiance = Vector3(10.f);
+        light.radius = 1.f;
+        frame.lights.push_back(light);
+      }
+    }
+    return trace;
+  }
+
+  std::vector<uint8_t> serialize(const DrawCallTrace& trace, const char* filePath) {
+    {
+      // Goes through the real draw call state conversion, like the scene manager does
+      DrawCallTraceWriter writer(filePath);
+      if (!writer.isOpen()) {
+        throw DxvkError("Failed to create the trace file");
+      }
+      for (const DrawCallTrace::Frame& frame : trace.frames) {
+        for (const DrawCallTraceDraw& draw : frame.draws) {
+          writer.recordDraw(DrawCallTrace::toDrawCallState(draw));
+        }
+        for (const DrawCallTraceLight& light : frame.lights) {
+          writer.recordLight(DrawCallTrace::toLight(light));
+        }
+        writer.recordFrameEnd(frame.frame.frameId, frame.frame.worldToView, frame.frame.viewToProjection);
+      }
+    }
+
+    std::ifstream file(filePath, std::ios_base::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  template<typename T>
+  bool recordsEqual(const std::vector<T>& a, const std::vector<T>& b) {
+    // Records are free of padding, see the static_asserts below
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+  }
+
+  static_assert(sizeof(DrawCallTraceDraw) == 200);
+  static_assert(sizeof(DrawCallTraceLight) == 56);
+  static_assert(sizeof(DrawCallTraceFrame) == 132);
+
+  void testRoundTrip(const DrawCallTrace& trace) {
+    const char* filePath = "test_draw_call_trace_replay.rdct";
+    const std::vector<uint8_t> data = serialize(trace, filePath);
+
+    DrawCallTrace loaded;
+    if (!DrawCallTrace::load(filePath, loaded)) {
+      throw DxvkError("Failed to load the recorded trace");
+    }
+    std::remove(filePath);
+
+    if (loaded.frames.size() != trace.frames.size()) {
+      throw DxvkError("Frame count mismatch after a round trip");
+    }
+    for (size_t i = 0; i < trace.frames.size(); i++) {
+      if (!recordsEqual(loaded.frames[i].draws, trace.frames[i].draws) ||
+          loaded.frames[i].lights.size() != trace.frames[i].lights.size() ||
+          loaded.frames[i].frame.frameId != trace.frames[i].frame.frameId) {
+        throw DxvkError(str::format("Frame ", i, " differs after a round trip"));
+      }
+      for (size_t l = 0; l < trace.frames[i].lights.size(); l++) {
+        if (loaded.frames[i].lights[l].hash != trace.frames[i].lights[l].hash) {
+          throw DxvkError(str::format("Light ", l, " of frame ", i, " differs after a round trip"));
+        }
+      }
+    }
+
+    // Truncated records and foreign data must be rejected
+    DrawCallTrace rejected;
+    if (DrawCallTrace::parse(data.data(), data.size() - 1, rejected)) {
+      throw DxvkError("Truncated trace was accepted");
+    }
+    const uint8_t garbage[16] = { 1, 2, 3, 4 };
+    if (DrawCallTrace::parse(garbage, sizeof(garbage), rejected)) {
+      throw DxvkError("Invalid trace was accepted");
+    }
+
+    std::cout << "Round trip passed (" << data.size() << " bytes)" << std::endl;
+  }
+
+  void testSyntheticReplay(const DrawCallTrace& trace) {
+    TraceReplayer replayer;
+    ReplayStats stats;
+    replay(trace, stats, replayer);
+
+    // Static props and moving props keep their BLAS across frames. Skinned meshes change bone
+    // hash every frame, which still pairs with the previous frame's BLAS as the material matches.
+    const size_t numDrawsPerFrame = trace.frames.front().draws.size();
+    if (stats.numNewBlas != replayer.getNumBlasEntries() || replayer.getNumBlasEntries() > numDrawsPerFrame) {
+      throw DxvkError(str::format("Unexpected number of BLAS entries: ", replayer.getNumBlasEntries(), " created ", stats.numNewBlas));
+    }
+    // Every instance is matched to itself in the following frames, the moving props stay well within
+    // rtx.uniqueObjectDistance and the skinned meshes keep their BLAS
+    if (stats.numNewInstances != numDrawsPerFrame || replayer.getNumInstances() != numDrawsPerFrame) {
+      throw DxvkError(str::format("Unexpected number of instances: ", replayer.getNumInstances(), " created ", stats.numNewInstances));
+    }
+    // Jittering lights get a new hash every frame and must be matched to their previous self by similarity
+    if (replayer.getNumTrackedLights() != trace.frames.front().lights.size()) {
+      throw DxvkError(str::format("Unexpected number of tracked lights: ", replayer.getNumTrackedLights()));
+    }
+    std::cout << "Synthetic replay passed" << std::endl;
+  }
+
+  void run(int argc, char** argv) {
+    if (argc > 1) {
+      DrawCallTrace trace;
+      if (!DrawCallTrace::load(argv[1], trace)) {
+        throw DxvkError(str::format("Failed to load draw call trace ", argv[1]));
+      }
+      TraceReplayer replayer;
+      ReplayStats stats;
+      replay(trace, stats, replayer);
+      std::cout << stats.numNewBlas << " BLAS entries created, " << stats.numNewInstances << " instances created, "
+                << stats.numLights << " lights matched (" << replayer.getNumTrackedLights() << " tracked)" << std::endl;
+      return;
+    }
+
+    const DrawCallTrace trace = generateTrace(120);
+    testRoundTrip(trace);
+    testSyntheticReplay(trace);
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    test_draw_call_trace_replay::run(argc, argv);
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
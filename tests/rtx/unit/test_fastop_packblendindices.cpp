@@ -0,0 +1,133 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_fastops.h"
+#include "../../../src/util/util_timer.h"
+
+using namespace dxvk;
+
+namespace fast {
+  extern void packBlendIndices_slow(uint32_t* dstData, const uint32_t* srcData, const uint32_t vertexCount, const uint32_t bonesPerVertex);
+
+  extern void packBlendIndices8_SSE(uint8_t* dstData, const uint32_t* srcData, const uint32_t count);
+  extern void packBlendIndices8_AVX2(uint8_t* dstData, const uint32_t* srcData, const uint32_t count);
+
+class PackBlendIndicesTestApp {
+public:
+  static void run() {
+    test_correctness();
+
+    for (uint32_t bonesPerVertex : { 4u, 8u }) {
+      std::cout << "Begin test (" << bonesPerVertex << " bones per vertex)" << std::endl;
+      test_smoke(bonesPerVertex);
+    }
+  }
+
+private:
+  static void test_smoke(const uint32_t bonesPerVertex) {
+    std::random_device rd;
+    std::mt19937 rng(rd());
+    // Include out of range indices to check that SIMD and scalar paths truncate the same way
+    std::uniform_int_distribution<uint32_t> uni(0, 1024);
+
+    const uint32_t vertexCount = 64 * 1024 * 7 + 3;
+    const uint32_t count = vertexCount * bonesPerVertex;
+    const uint32_t wordCount = vertexCount * bonesPerVertex / 4;
+
+    std::vector<uint32_t> src(count);
+    for (uint32_t i = 0; i < count; i++) {
+      src[i] = uni(rng);
+    }
+
+    std::vector<uint32_t> expected(wordCount, 0);
+    {
+      std::cout << "Running: packBlendIndices_slow --> ";
+      Timer time;
+      packBlendIndices_slow(expected.data(), src.data(), vertexCount, bonesPerVertex);
+    }
+
+    std::vector<uint32_t> result(wordCount, 0);
+    {
+      std::cout << "Running: packBlendIndices8_SSE --> ";
+      Timer time;
+      packBlendIndices8_SSE((uint8_t*) result.data(), src.data(), count);
+    }
+    if (memcmp(result.data(), expected.data(), wordCount * sizeof(uint32_t)) != 0)
+      throw dxvk::DxvkError("Output not matching packBlendIndices8_SSE");
+
+    if (getSimdSupportLevel() >= SIMD::AVX2) {
+      std::fill(result.begin(), result.end(), 0);
+      {
+        std::cout << "Running: packBlendIndices8_AVX2 --> ";
+        Timer time;
+        packBlendIndices8_AVX2((uint8_t*) result.data(), src.data(), count);
+      }
+      if (memcmp(result.data(), expected.data(), wordCount * sizeof(uint32_t)) != 0)
+        throw dxvk::DxvkError("Output not matching packBlendIndices8_AVX2");
+    } else {
+      std::cout << "AVX2 not supported by this processor" << std::endl;
+    }
+
+    std::cout << "PackBlendIndices fast ops successfully smoke tested" << std::endl;
+  }
+
+  static void test_correctness() {
+    // 3 bones per vertex, the last byte of every word must stay zero
+    const uint32_t src[] = { 1, 2, 3,  4, 5, 6,  0xFF, 0x101, 7 };
+    const uint32_t expected[] = { 0x00030201, 0x00060504, 0x000701FF };
+
+    uint32_t result[3] = { ~0u, ~0u, ~0u };
+    packBlendIndices(result, src, 3, 3);
+
+    if (memcmp(result, expected, sizeof(expected)) != 0)
+      throw dxvk::DxvkError("Output not matching expected (3 bones per vertex)");
+
+    // 5 bones per vertex, spans two words per vertex
+    const uint32_t src5[] = { 1, 2, 3, 4, 5,  6, 7, 8, 9, 10 };
+    const uint32_t expected5[] = { 0x04030201, 0x00000005, 0x09080706, 0x0000000A };
+
+    uint32_t result5[4] = { ~0u, ~0u, ~0u, ~0u };
+    packBlendIndices(result5, src5, 2, 5);
+
+    if (memcmp(result5, expected5, sizeof(expected5)) != 0)
+      throw dxvk::DxvkError("Output not matching expected (5 bones per vertex)");
+
+    std::cout << "PackBlendIndices fast ops successfully tested for correctness" << std::endl;
+  }
+};
+}
+
+int main() {
+  try {
+    fast::PackBlendIndicesTestApp::run();
+  }
+  catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
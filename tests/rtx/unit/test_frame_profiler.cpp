@@ -0,0 +1,179 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_frame_profiler.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_frame_profiler.log");
+}
+
+namespace test_frame_profiler {
+  using namespace dxvk;
+
+  const FrameProfiler::ZoneStats* findZone(const std::vector<FrameProfiler::ZoneStats>& stats, const char* name) {
+    for (const FrameProfiler::ZoneStats& zone : stats) {
+      if (zone.name == name) {
+        return &zone;
+      }
+    }
+    return nullptr;
+  }
+
+  void recordZones(const char* name, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      FrameProfilerZone zone(name);
+    }
+  }
+
+  void testInactive() {
+    static const char* kName = "inactive";
+
+    FrameProfiler& profiler = FrameProfiler::get();
+    profiler.setEnabled(false);
+    profiler.endFrame();
+
+    recordZones(kName, 10);
+    profiler.endFrame();
+
+    if (findZone(profiler.getFrameStats(), kName)) {
+      throw DxvkError("Zones were recorded while the profiler was inactive");
+    }
+
+    std::cout << "Inactive profiler passed" << std::endl;
+  }
+
+  void testAggregates() {
+    static const char* kOuter = "outer";
+    static const char* kInner = "inner";
+    constexpr uint32_t kNumThreads = 4;
+    constexpr uint32_t kNumZones = 1000;
+
+    FrameProfiler& profiler = FrameProfiler::get();
+    profiler.setEnabled(true);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([] {
+        FrameProfilerZone zone(kOuter);
+        recordZones(kInner, kNumZones);
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    profiler.endFrame();
+    const std::vector<FrameProfiler::ZoneStats> stats = profiler.getFrameStats();
+
+    const FrameProfiler::ZoneStats* outer = findZone(stats, kOuter);
+    const FrameProfiler::ZoneStats* inner = findZone(stats, kInner);
+    if (!outer || !inner || outer->count != kNumThreads || inner->count != kNumThreads * kNumZones) {
+      throw DxvkError("Unexpected zone counts");
+    }
+    if (outer->totalMs < inner->totalMs / kNumThreads || outer->maxMs > outer->totalMs) {
+      throw DxvkError("Unexpected zone times");
+    }
+
+    // Zones are only attributed to the frame they were collected in
+    profiler.endFrame();
+    if (findZone(profiler.getFrameStats(), kOuter)) {
+      throw DxvkError("Zones of the previous frame were counted again");
+    }
+
+    profiler.setEnabled(false);
+    std::cout << "Aggregates passed" << std::endl;
+  }
+
+  void testCapture() {
+    static const char* kName = "captured \"zone\"";
+    constexpr uint32_t kNumFrames = 3;
+    const std::string filePath = "test_frame_profiler.json";
+    std::remove(filePath.c_str());
+
+    FrameProfiler& profiler = FrameProfiler::get();
+    if (!profiler.requestCapture(kNumFrames, filePath) || profiler.requestCapture(kNumFrames, filePath)) {
+      throw DxvkError("Only a single capture may be pending");
+    }
+
+    // The capture starts with the next frame
+    profiler.endFrame();
+    for (uint32_t i = 0; i < kNumFrames; i++) {
+      recordZones(kName, 2);
+      profiler.endFrame();
+    }
+
+    if (profiler.isCapturing()) {
+      throw DxvkError("Capture did not finish");
+    }
+
+    // The capture is written on a separate thread
+    std::string trace;
+    for (uint32_t i = 0; i < 100 && trace.find("\n]}") == std::string::npos; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      std::ifstream file(filePath);
+      std::stringstream stream;
+      stream << file.rdbuf();
+      trace = stream.str();
+    }
+
+    size_t numZones = 0;
+    size_t numFrames = 0;
+    for (size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos + 1)) {
+      const size_t lineStart = trace.rfind('\n', pos);
+      const std::string line = trace.substr(lineStart, pos - lineStart);
+      numZones += line.find("captured \\\"zone\\\"") != std::string::npos;
+      numFrames += line.find("\"Frame\"") != std::string::npos;
+    }
+
+    if (numZones != 2 * kNumFrames || numFrames != kNumFrames) {
+      throw DxvkError(str::format("Unexpected capture contents: ", numZones, " zones, ", numFrames, " frames"));
+    }
+
+    std::remove(filePath.c_str());
+    std::cout << "Capture passed" << std::endl;
+  }
+
+  void run() {
+    testInactive();
+    testAggregates();
+    testCapture();
+  }
+}
+
+int main() {
+  try {
+    test_frame_profiler::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
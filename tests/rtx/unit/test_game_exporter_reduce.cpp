@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <atomic>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_timer.h"
+#include "../../../src/lssusd/game_exporter_reduce.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_game_exporter_reduce.log");
+}
+
+namespace test_game_exporter_reduce {
+  // Reference implementation, matching the std::set/std::unordered_map based
+  // reduction the exporter originally shipped with.
+  struct ReferenceReduction {
+    std::vector<int> reducedIdxs;
+    std::unordered_map<int, int> redToOg;
+  };
+
+  ReferenceReduction reduceReference(const std::vector<int>& idxBuf) {
+    ReferenceReduction out;
+    const std::set<int> orderedIndices(idxBuf.cbegin(), idxBuf.cend());
+    int newIdx = 0;
+    std::unordered_map<int, int> ogToRed;
+    for (const auto index : orderedIndices) {
+      ogToRed[index] = newIdx++;
+    }
+    for (const auto ogIdx : idxBuf) {
+      const auto redIdx = ogToRed[ogIdx];
+      out.reducedIdxs.push_back(redIdx);
+      out.redToOg[redIdx] = ogIdx;
+    }
+    return out;
+  }
+
+  template<typename T>
+  std::vector<T> applyReference(const std::vector<T>& buf, const ReferenceReduction& reduction, const size_t elemsPerIdx) {
+    std::vector<T> out(reduction.redToOg.size() * elemsPerIdx, T {});
+    for (const auto [redIndex, ogIndex] : reduction.redToOg) {
+      for (size_t elemNum = 0; elemNum < elemsPerIdx; ++elemNum) {
+        out[redIndex * elemsPerIdx + elemNum] = buf[ogIndex * elemsPerIdx + elemNum];
+      }
+    }
+    return out;
+  }
+
+  void checkIdxBuf(const std::vector<int>& idxBuf, const size_t elemsPerIdx) {
+    const ReferenceReduction ref = reduceReference(idxBuf);
+
+    lss::IdxReduction reduction;
+    lss::computeIdxReduction(idxBuf.data(), idxBuf.size(), reduction);
+
+    if (reduction.reducedIdxs != ref.reducedIdxs) {
+      throw dxvk::DxvkError("Reduced index buffer doesn't match the reference");
+    }
+    if (reduction.numReducedVertices() != ref.redToOg.size()) {
+      throw dxvk::DxvkError("Reduced vertex count doesn't match the reference");
+    }
+    for (const auto [redIndex, ogIndex] : ref.redToOg) {
+      if (reduction.redToOg[redIndex] != ogIndex) {
+        throw dxvk::DxvkError("Reduced to original vertex mapping doesn't match the reference");
+      }
+    }
+
+    if (idxBuf.empty()) {
+      return;
+    }
+
+    // Vertex attribute with a unique value per element
+    const int maxIdx = *std::max_element(idxBuf.cbegin(), idxBuf.cend());
+    std::vector<float> vertexBuf((maxIdx + 1) * elemsPerIdx);
+    for (size_t i = 0; i < vertexBuf.size(); ++i) {
+      vertexBuf[i] = static_cast<float>(i) * 0.5f;
+    }
+
+    const std::vector<float> refBuf = applyReference(vertexBuf, ref, elemsPerIdx);
+    std::vector<float> redBuf(reduction.numReducedVertices() * elemsPerIdx);
+    lss::applyIdxReduction(vertexBuf.data(), vertexBuf.size(), reduction, elemsPerIdx, redBuf.data());
+
+    if (redBuf != refBuf) {
+      throw dxvk::DxvkError("Reduced vertex buffer doesn't match the reference");
+    }
+  }
+
+  void testEdgeCases() {
+    checkIdxBuf({ }, 1);
+    checkIdxBuf({ 0 }, 1);
+    checkIdxBuf({ 7, 7, 7 }, 1);
+    checkIdxBuf({ 0, 1, 2, 2, 1, 3 }, 1);
+    checkIdxBuf({ 9, 5, 7, 5, 9, 11 }, 4);
+    // Sparse range, takes the sorting path
+    checkIdxBuf({ 3, 1000000, 42, 3, 999999, 42 }, 1);
+    std::cout << "Edge cases passed" << std::endl;
+  }
+
+  void testRandom() {
+    std::mt19937 rng(0x1234);
+    for (uint32_t iteration = 0; iteration < 64; ++iteration) {
+      // Mix dense and sparse distributions
+      const int range = (iteration % 4 == 3) ? 4 * 1024 * 1024 : 1 + (rng() % 20000);
+      const size_t count = 3 * (1 + (rng() % 10000));
+      std::uniform_int_distribution<int> uni(0, range - 1);
+
+      std::vector<int> idxBuf(count);
+      for (auto& idx : idxBuf) {
+        idx = uni(rng);
+      }
+
+      checkIdxBuf(idxBuf, 1 + (iteration % 4));
+    }
+    std::cout << "Random index buffers passed" << std::endl;
+  }
+
+  void testParallelFor() {
+    const size_t numSamples = 1000;
+    std::vector<std::atomic<uint32_t>> visited(numSamples);
+    lss::parallelFor(numSamples, [&visited](const size_t i) {
+      ++visited[i];
+    });
+    for (const auto& v : visited) {
+      if (v != 1) {
+        throw dxvk::DxvkError("Job was not processed exactly once");
+      }
+    }
+    std::cout << "Parallel job processing passed" << std::endl;
+  }
+
+  void testPerformance() {
+    std::mt19937 rng(0x5678);
+    const size_t count = 3 * 1000 * 1000;
+    std::uniform_int_distribution<int> uni(0, 500 * 1000);
+    std::vector<int> idxBuf(count);
+    for (auto& idx : idxBuf) {
+      idx = uni(rng);
+    }
+
+    {
+      std::cout << "Reference reduction --> ";
+      Timer t;
+      reduceReference(idxBuf);
+    }
+    {
+      std::cout << "Flat reduction --> ";
+      Timer t;
+      lss::IdxReduction reduction;
+      lss::computeIdxReduction(idxBuf.data(), idxBuf.size(), reduction);
+    }
+  }
+
+  void run() {
+    testEdgeCases();
+    testRandom();
+    testParallelFor();
+    testPerformance();
+  }
+}
+
+int main() {
+  try {
+    test_game_exporter_reduce::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
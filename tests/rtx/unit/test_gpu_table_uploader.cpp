@@ -0,0 +1,301 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_sparse_unique_cache.h"
+#include "../../../src/dxvk/rtx_render/rtx_gpu_table_uploader.h"
+#include "../../../src/dxvk/rtx_render/rtx_materials.h"
+#include "../../../src/dxvk/rtx_render/rtx_options.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_gpu_table_uploader.log");
+}
+
+namespace test_gpu_table_uploader {
+  using namespace dxvk;
+
+  constexpr size_t kMaterialGPUSize = 16;
+
+  struct Material {
+    uint32_t id = 0;
+    uint32_t value = 0;
+
+    bool operator==(const Material& other) const {
+      return id == other.id && value == other.value;
+    }
+
+    void writeGPUData(unsigned char* data, std::size_t& offset) const {
+      const uint32_t words[4] = { id, value, id ^ value, ~id };
+      memcpy(data + offset, words, sizeof(words));
+      offset += sizeof(words);
+    }
+  };
+
+  struct MaterialHashFn {
+    size_t operator() (const Material& material) const {
+      return std::hash<uint32_t>()(material.id) ^ (std::hash<uint32_t>()(material.value) << 1);
+    }
+  };
+
+  // Mimics a device buffer which is only recreated when it needs to grow
+  struct GpuBuffer {
+    std::vector<unsigned char> data;
+
+    void upload(GpuTableUploader& table, size_t& numBytesUploaded) {
+      bool recreated = false;
+      if (table.getData().size() > data.size()) {
+        // A new buffer has undefined contents
+        data.assign(table.getData().size() * 2, 0xcd);
+        recreated = true;
+      }
+
+      table.upload(recreated, [&](size_t offset, size_t size, const unsigned char* src) {
+        if (offset + size > table.getData().size()) {
+          throw DxvkError("Uploaded range is out of bounds");
+        }
+        memcpy(data.data() + offset, src, size);
+        numBytesUploaded += size;
+      });
+    }
+
+    bool matches(const std::vector<unsigned char>& expected) const {
+      return expected.empty() || (expected.size() <= data.size() && memcmp(data.data(), expected.data(), expected.size()) == 0);
+    }
+  };
+
+  template<typename Cache>
+  std::vector<unsigned char> packEverything(const Cache& cache, size_t entrySize = kMaterialGPUSize) {
+    std::vector<unsigned char> data(cache.getTotalCount() * entrySize);
+    size_t offset = 0;
+    for (const auto& material : cache.getObjectTable()) {
+      material.writeGPUData(data.data(), offset);
+    }
+    return data;
+  }
+
+  void testCoalescing() {
+    GpuTableUploader table(kMaterialGPUSize);
+    table.resize(64);
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    auto collect = [&](size_t offset, size_t size, const unsigned char*) { ranges.emplace_back(offset, size); };
+
+    table.upload(false, collect);
+    if (ranges.size() != 1 || ranges[0] != std::make_pair(size_t(0), 64 * kMaterialGPUSize) || table.getNumDirty() != 0) {
+      throw DxvkError("Grown table was not uploaded as one range");
+    }
+
+    // Entries 10 and 12 are merged across the gap, 40 is too far away
+    ranges.clear();
+    for (uint32_t index : { 40u, 12u, 10u, 12u }) {
+      table.write(index, [&](unsigned char* data, size_t& offset) { Material { index, 1 }.writeGPUData(data, offset); });
+    }
+    table.upload(false, collect);
+    if (ranges.size() != 2 ||
+        ranges[0] != std::make_pair(10 * kMaterialGPUSize, 3 * kMaterialGPUSize) ||
+        ranges[1] != std::make_pair(40 * kMaterialGPUSize, kMaterialGPUSize)) {
+      throw DxvkError("Dirty entries were not coalesced as expected");
+    }
+
+    // Unchanged entries are not uploaded
+    ranges.clear();
+    const bool changed = table.writeIfChanged(40, [&](unsigned char* data, size_t& offset) { Material { 40, 1 }.writeGPUData(data, offset); });
+    table.upload(false, collect);
+    if (changed || !ranges.empty()) {
+      throw DxvkError("Unchanged entry was uploaded");
+    }
+
+    // Shrinking drops dirty entries past the end
+    table.markDirty(63);
+    table.resize(32);
+    table.upload(false, collect);
+    if (!ranges.empty()) {
+      throw DxvkError("Entry past the end of the table was uploaded");
+    }
+
+    std::cout << "Coalescing passed" << std::endl;
+  }
+
+  void testSparseCacheReplay() {
+    std::mt19937 rng(1234);
+    SparseUniqueCache<Material, MaterialHashFn> cache(true);
+    GpuTableUploader table(kMaterialGPUSize);
+    GpuBuffer buffer;
+    std::vector<Material> live;
+    size_t numBytesUploaded = 0;
+    size_t numBytesFull = 0;
+
+    for (uint32_t frame = 0; frame < 500; frame++) {
+      // Churn a few materials per frame, with occasional bursts and a full reset
+      const uint32_t numChanges = frame % 97 == 0 ? 200 : rng() % 8;
+      for (uint32_t i = 0; i < numChanges; i++) {
+        if (!live.empty() && rng() % 3 == 0) {
+          const size_t victim = rng() % live.size();
+          cache.free(live[victim]);
+          live[victim] = live.back();
+          live.pop_back();
+        } else {
+          const Material material { static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng() % 4) };
+          uint32_t index;
+          if (!cache.find(material, index)) {
+            live.push_back(material);
+          }
+          cache.track(material);
+        }
+      }
+
+      if (frame == 250) {
+        cache.clear();
+        live.clear();
+      }
+
+      // Same packing as SceneManager::prepareSceneData
+      packDirtyEntries(cache, table, false);
+
+      buffer.upload(table, numBytesUploaded);
+
+      const std::vector<unsigned char> expected = packEverything(cache);
+      numBytesFull += expected.size();
+      if (table.getData() != expected || !buffer.matches(expected)) {
+        throw DxvkError(str::format("GPU table diverged from a full rewrite on frame ", frame));
+      }
+    }
+
+    if (numBytesUploaded * 4 > numBytesFull) {
+      throw DxvkError(str::format("Delta uploads wrote ", numBytesUploaded, " bytes, a full rewrite every frame wrote ", numBytesFull));
+    }
+
+    std::cout << "Sparse cache replay passed, uploaded " << numBytesUploaded << " of " << numBytesFull << " bytes" << std::endl;
+  }
+
+  void testWriteIfChanged() {
+    std::mt19937 rng(5678);
+    std::vector<Material> surfaces;
+    GpuTableUploader table(kMaterialGPUSize);
+    GpuBuffer buffer;
+    size_t numBytesUploaded = 0;
+
+    for (uint32_t frame = 0; frame < 200; frame++) {
+      // Surfaces are appended, dropped from the end and mutated in place without any change tracking
+      surfaces.resize(std::max<int>(0, int(surfaces.size()) + int(rng() % 9) - 3));
+      for (uint32_t i = 0; i < 4 && !surfaces.empty(); i++) {
+        surfaces[rng() % surfaces.size()].value = static_cast<uint32_t>(rng());
+      }
+
+      table.resize(surfaces.size());
+      for (uint32_t i = 0; i < surfaces.size(); i++) {
+        table.writeIfChanged(i, [&](unsigned char* data, size_t& offset) { surfaces[i].writeGPUData(data, offset); });
+      }
+
+      buffer.upload(table, numBytesUploaded);
+
+      std::vector<unsigned char> expected(surfaces.size() * kMaterialGPUSize);
+      size_t offset = 0;
+      for (const Material& surface : surfaces) {
+        surface.writeGPUData(expected.data(), offset);
+      }
+      if (!buffer.matches(expected)) {
+        throw DxvkError(str::format("Surface table diverged from a full rewrite on frame ", frame));
+      }
+    }
+
+    std::cout << "Write if changed passed" << std::endl;
+  }
+
+  struct SurfaceMaterialHashFn {
+    size_t operator() (const RtSurfaceMaterial& material) const {
+      return (size_t) material.getHash();
+    }
+  };
+
+  // Global options baked into the packed surface materials must reach the GPU for materials which were
+  // packed before the option changed, even though the material caches themselves are unchanged
+  void testSurfaceMaterialOptionChange() {
+    SparseUniqueCache<RtSurfaceMaterial, SurfaceMaterialHashFn> cache(true);
+    GpuTableUploader table(kSurfaceMaterialGPUSize);
+    GpuBuffer buffer;
+    size_t numBytesUploaded = 0;
+
+    cache.track(RtSurfaceMaterial(RtOpaqueSurfaceMaterial(
+      1, 2, 3, 4, 5, 6, 7, 0.f, 40.f, Vector4(0.2f, 0.3f, 0.4f, 1.f), 0.5f, 0.f, Vector3(1.f, 0.1f, 0.1f),
+      false, false, false, 200.f, 8, 0.05f, kSurfaceMaterialInvalidTextureIndex)));
+    cache.track(RtSurfaceMaterial(RtTranslucentSurfaceMaterial(
+      1, 2, 3, 1.3f, 1.f, Vector3(0.97f), false, 40.f, Vector3(1.f, 0.1f, 0.1f), false, 0.001f, false, 4)));
+
+    // Same packing as SceneManager::prepareSceneData
+    SurfaceMaterialGPUOptions packedOptions;
+    std::vector<unsigned char> prevData;
+    auto packFrame = [&](const char* what) {
+      const SurfaceMaterialGPUOptions options = SurfaceMaterialGPUOptions::get();
+      packDirtyEntries(cache, table, options != packedOptions);
+      packedOptions = options;
+
+      buffer.upload(table, numBytesUploaded);
+
+      const std::vector<unsigned char> expected = packEverything(cache, kSurfaceMaterialGPUSize);
+      if (expected == prevData) {
+        throw DxvkError(str::format(what, ": packed materials do not depend on the option"));
+      }
+      if (!buffer.matches(expected)) {
+        throw DxvkError(str::format(what, ": GPU table is stale"));
+      }
+      prevData = expected;
+    };
+
+    packFrame("initial");
+
+    RtxOptions::Displacement::displacementFactorObject().setValue(2.f);
+    packFrame("rtx.displacement.displacementFactor");
+
+    TranslucentMaterialOptions::enableDiffuseLayerOverrideObject().setValue(true);
+    packFrame("rtx.translucentMaterial.enableDiffuseLayerOverride");
+
+    RtxOptions::Displacement::displacementFactorObject().setValue(1.f);
+    TranslucentMaterialOptions::enableDiffuseLayerOverrideObject().setValue(false);
+
+    std::cout << "Surface material option change passed" << std::endl;
+  }
+
+  void run() {
+    testCoalescing();
+    testSparseCacheReplay();
+    testWriteIfChanged();
+    testSurfaceMaterialOptionChange();
+  }
+}
+
+int main() {
+  try {
+    test_gpu_table_uploader::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
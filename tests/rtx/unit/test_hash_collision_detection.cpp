@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_hash_collision_detection.h"
+#include "../../../src/dxvk/rtx_render/rtx_opacity_micromap_manager.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_hash_collision_detection.log");
+}
+
+namespace test_hash_collision_detection {
+  using namespace dxvk;
+
+  // Hashes are picked by the test rather than computed, which makes any two registrations
+  // with different source data under the same hash a synthetic collision.
+
+  void expectCollisions(HashSourceDataCategory category, uint64_t expected, const char* what) {
+    const uint64_t count = HashCollisionDetection::getCollisionCount(category);
+    if (count != expected)
+      throw DxvkError(str::format(what, ": expected ", expected, " collisions, got ", count));
+  }
+
+  void setup(uint32_t sampleRate, bool storeFullSourceData) {
+    HashCollisionDetectionOptions::enableObject().setValue(true);
+    HashCollisionDetectionOptions::sampleRateObject().setValue(sampleRate);
+    HashCollisionDetectionOptions::storeFullSourceDataObject().setValue(storeFullSourceData);
+    HashCollisionDetection::reset();
+  }
+
+  void testDefaults() {
+    // Detection validates every hash against its full source data unless sampling is opted into
+    if (HashCollisionDetectionOptions::sampleRate() != 1 || !HashCollisionDetectionOptions::storeFullSourceData())
+      throw DxvkError("Hash collision detection defaults to sampled validation");
+  }
+
+  void testFingerprints() {
+    setup(1, false);
+
+    const std::vector<uint32_t> indicesA = { 0, 1, 2, 2, 1, 3 };
+    const std::vector<uint32_t> indicesB = { 0, 1, 2, 2, 3, 1 };
+    const HashSourceDataCategory category = HashSourceDataCategory::GeometryHashes;
+
+    HashCollisionDetection::registerHashedSourceData(0x1000, indicesA.data(), indicesA.size() * sizeof(uint32_t), category);
+    HashCollisionDetection::registerHashedSourceData(0x1000, indicesA.data(), indicesA.size() * sizeof(uint32_t), category);
+    expectCollisions(category, 0, "Identical source data");
+
+    HashCollisionDetection::registerHashedSourceData(0x1000, indicesB.data(), indicesB.size() * sizeof(uint32_t), category);
+    expectCollisions(category, 1, "Different source data");
+
+    // A colliding hash is only reported once
+    HashCollisionDetection::registerHashedSourceData(0x1000, indicesB.data(), indicesB.size() * sizeof(uint32_t), category);
+    expectCollisions(category, 1, "Repeated collision");
+
+    // Categories are tracked separately
+    HashCollisionDetection::registerHashedSourceData(0x1000, indicesB.data(), indicesB.size() * sizeof(uint32_t), HashSourceDataCategory::Textures);
+    expectCollisions(HashSourceDataCategory::Textures, 0, "Other category");
+
+    HashCollisionDetection::registerHashFingerprint(0x2000, 1, category);
+    HashCollisionDetection::registerHashFingerprint(0x2000, 2, category);
+    expectCollisions(category, 2, "Different fingerprint");
+  }
+
+  void testSampling() {
+    setup(16, false);
+
+    const uint32_t a = 1;
+    const uint32_t b = 2;
+    const HashSourceDataCategory category = HashSourceDataCategory::Textures;
+
+    for (XXH64_hash_t hash = 1; hash <= 64; hash++) {
+      if (HashCollisionDetection::isSampled(hash) != (hash % 16 == 0))
+        throw DxvkError(str::format("Unexpected sampling of hash ", hash));
+
+      HashCollisionDetection::registerHashedSourceData(hash, &a, sizeof(a), category);
+      HashCollisionDetection::registerHashedSourceData(hash, &b, sizeof(b), category);
+    }
+    expectCollisions(category, 4, "Sampled hashes");
+
+    HashCollisionDetectionOptions::enableObject().setValue(false);
+    if (HashCollisionDetection::isSampled(16))
+      throw DxvkError("Hash sampled while detection is disabled");
+  }
+
+  void testFullSourceData() {
+    setup(1, true);
+
+    OpacityMicromapHashSourceData a;
+    a.materialHash = 1;
+    OpacityMicromapHashSourceData b = a;
+    const HashSourceDataCategory category = HashSourceDataCategory::OpacityMicromap;
+
+    HashCollisionDetection::registerHashedSourceData(0x3000, &a, category);
+    HashCollisionDetection::registerHashedSourceData(0x3000, &b, category);
+    expectCollisions(category, 0, "Identical full source data");
+
+    b.indexHash = 2;
+    HashCollisionDetection::registerHashedSourceData(0x3000, &b, category);
+    expectCollisions(category, 1, "Different full source data");
+  }
+
+  void testConcurrentRegistration() {
+    setup(1, false);
+
+    constexpr uint32_t kNumThreads = 8;
+    constexpr uint32_t kNumHashes = 4096;
+    const HashSourceDataCategory category = HashSourceDataCategory::GeometryHashes;
+
+    // All threads register the same source data for every hash, except for the last thread which
+    // registers different data for every 8th hash. Shards are picked from the upper bits of the hash.
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([t, category]() {
+        for (uint32_t i = 0; i < kNumHashes; i++) {
+          const XXH64_hash_t hash = (XXH64_hash_t(i) << 32) | i;
+          const uint64_t data = (t == kNumThreads - 1 && i % 8 == 0) ? ~hash : hash;
+          HashCollisionDetection::registerHashedSourceData(hash, &data, sizeof(data), category);
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+
+    expectCollisions(category, kNumHashes / 8, "Concurrent registration");
+  }
+
+  void run() {
+    testDefaults();
+    testFingerprints();
+    testSampling();
+    testFullSourceData();
+    testConcurrentRegistration();
+    HashCollisionDetection::reset();
+
+    std::cout << "Hash collision detection passed" << std::endl;
+  }
+}
+
+int main() {
+  try {
+    test_hash_collision_detection::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
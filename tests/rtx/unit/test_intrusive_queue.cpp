@@ -0,0 +1,159 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_intrusive_queue.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_intrusive_queue.log");
+}
+
+namespace test_intrusive_queue {
+  using namespace dxvk;
+
+  struct Item {
+    uint32_t id = 0;
+    uint32_t priority = 0;
+    IntrusiveListHook<Item> listHook;
+    IntrusivePriorityQueueHook queueHook;
+  };
+
+  struct ItemPriority {
+    bool operator()(const Item& a, const Item& b) const {
+      return a.priority != b.priority ? a.priority < b.priority : a.id > b.id;
+    }
+  };
+
+  typedef IntrusiveList<Item, &Item::listHook> ItemList;
+  typedef IntrusivePriorityQueue<Item, &Item::queueHook, ItemPriority> ItemQueue;
+
+  std::vector<uint32_t> getIds(const ItemList& list) {
+    std::vector<uint32_t> ids;
+    for (const Item* item = list.front(); item; item = ItemList::next(*item)) {
+      ids.push_back(item->id);
+    }
+    return ids;
+  }
+
+  void testList() {
+    std::vector<Item> items(5);
+    for (uint32_t i = 0; i < items.size(); i++) {
+      items[i].id = i;
+    }
+
+    ItemList list;
+    for (Item& item : items) {
+      list.pushBack(item);
+    }
+
+    list.moveToBack(items[0]);
+    list.erase(items[2]);
+    list.moveToBack(items[4]);
+
+    if (getIds(list) != std::vector<uint32_t> { 1, 3, 0, 4 } || list.size() != 4 || ItemList::isLinked(items[2])) {
+      throw DxvkError("Unexpected list order");
+    }
+
+    list.erase(items[1]);
+    list.erase(items[4]);
+    if (getIds(list) != std::vector<uint32_t> { 3, 0 } || list.front() != &items[3] || list.back() != &items[0]) {
+      throw DxvkError("Unexpected list order after erasing the ends");
+    }
+
+    list.clear();
+    if (!list.empty() || std::any_of(items.begin(), items.end(), [](const Item& item) { return ItemList::isLinked(item); })) {
+      throw DxvkError("Cleared list still links items");
+    }
+
+    std::cout << "List passed" << std::endl;
+  }
+
+  void testPriorityQueue() {
+    std::mt19937 rng(7);
+    std::vector<Item> items(1000);
+    for (uint32_t i = 0; i < items.size(); i++) {
+      items[i].id = i;
+      items[i].priority = rng() % 100;
+    }
+
+    ItemQueue queue;
+    for (Item& item : items) {
+      queue.push(item);
+    }
+
+    // Remove some items and reprioritize others while they are queued
+    for (uint32_t i = 0; i < items.size(); i += 7) {
+      queue.erase(items[i]);
+    }
+    for (uint32_t i = 3; i < items.size(); i += 7) {
+      items[i].priority = rng() % 100;
+      queue.update(items[i]);
+    }
+
+    for (uint32_t i = 0; i < items.size(); i++) {
+      if (queue.contains(items[i]) != (i % 7 != 0)) {
+        throw DxvkError(str::format("Unexpected membership of item ", i));
+      }
+    }
+
+    std::vector<Item*> expected;
+    for (Item& item : items) {
+      if (queue.contains(item)) {
+        expected.push_back(&item);
+      }
+    }
+    std::sort(expected.begin(), expected.end(), [](const Item* a, const Item* b) { return ItemPriority()(*b, *a); });
+
+    for (Item* item : expected) {
+      if (&queue.pop() != item) {
+        throw DxvkError("Items were not popped in priority order");
+      }
+    }
+
+    if (!queue.empty() || std::any_of(items.begin(), items.end(), [&](const Item& item) { return queue.contains(item); })) {
+      throw DxvkError("Drained queue still contains items");
+    }
+
+    std::cout << "Priority queue passed" << std::endl;
+  }
+
+  void run() {
+    testList();
+    testPriorityQueue();
+  }
+}
+
+int main() {
+  try {
+    test_intrusive_queue::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_env.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("test_logger.log");
+}
+
+namespace test_logger {
+  using namespace dxvk;
+
+  // Note: Mirrors Logger::getFileName
+  std::string getLogPath() {
+    std::string path = env::getEnvVar("DXVK_LOG_PATH");
+    if (!path.empty() && *path.rbegin() != '/') {
+      path += '/';
+    }
+    return path + env::getExeBaseName() + "_test_logger.log";
+  }
+
+  std::vector<std::string> readLog() {
+    Logger::flush();
+
+    std::ifstream file(str::tows(getLogPath().c_str()).c_str());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  size_t countLines(const std::vector<std::string>& lines, const std::string& text) {
+    size_t count = 0;
+    for (const std::string& line : lines) {
+      if (line.find(text) != std::string::npos) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  void testMultithreaded() {
+    constexpr uint32_t kNumThreads = 4;
+    // More messages than a thread's ring buffer holds, so producers also drain on their own
+    constexpr uint32_t kNumMessages = 2000;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([t] {
+        for (uint32_t i = 0; i < kNumMessages; i++) {
+          Logger::info("thread ", t, " message ", i, " ");
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    const std::vector<std::string> lines = readLog();
+    for (uint32_t t = 0; t < kNumThreads; t++) {
+      const std::string prefix = str::format("thread ", t, " message ");
+      uint32_t next = 0;
+      for (const std::string& line : lines) {
+        const size_t pos = line.find(prefix);
+        if (pos == std::string::npos) {
+          continue;
+        }
+        if (line.find(str::format(prefix, next, " ")) != pos) {
+          throw DxvkError(str::format("Messages of thread ", t, " are out of order at ", next));
+        }
+        next++;
+      }
+      if (next != kNumMessages) {
+        throw DxvkError(str::format("Expected ", kNumMessages, " messages from thread ", t, ", found ", next));
+      }
+    }
+
+    std::cout << "Multithreaded logging passed" << std::endl;
+  }
+
+  void testFiltering() {
+    Logger::trace("trace level message");
+    Logger::info("info level message");
+
+    const std::vector<std::string> lines = readLog();
+    if (countLines(lines, "info level message") != 1) {
+      throw DxvkError("Info message was not written");
+    }
+    if (Logger::logLevel() > LogLevel::Trace && countLines(lines, "trace level message") != 0) {
+      throw DxvkError("Filtered message was written");
+    }
+
+    std::cout << "Filtering passed" << std::endl;
+  }
+
+  void testRateLimit() {
+    if (!env::getEnvVar("DXVK_LOG_RATE_LIMIT").empty()) {
+      std::cout << "Rate limit skipped, DXVK_LOG_RATE_LIMIT is set" << std::endl;
+      return;
+    }
+
+    // Note: Matches the default rate limit
+    constexpr uint32_t kRateLimit = 10;
+    constexpr uint32_t kNumRepeats = 100;
+
+    for (uint32_t i = 0; i < kNumRepeats; i++) {
+      Logger::warn("repeated message");
+      Logger::err("repeated error");
+    }
+
+    const std::vector<std::string> lines = readLog();
+    // Allow for the repeats to span two rate limiting windows
+    const size_t numWritten = countLines(lines, "repeated message");
+    if (numWritten < kRateLimit + 1 || numWritten > 2 * (kRateLimit + 1)) {
+      throw DxvkError(str::format("Unexpected number of repeated messages written: ", numWritten));
+    }
+    if (countLines(lines, "(suppressed ") == 0) {
+      throw DxvkError("Suppressed repeats were not reported");
+    }
+    // Errors are never suppressed
+    if (countLines(lines, "repeated error") != kNumRepeats) {
+      throw DxvkError(str::format("Repeated errors were suppressed: ", countLines(lines, "repeated error"), " written"));
+    }
+
+    std::cout << "Rate limit passed" << std::endl;
+  }
+
+  void run() {
+    if (Logger::logLevel() > LogLevel::Info || env::getEnvVar("DXVK_LOG_PATH") == "none") {
+      std::cout << "Logger test skipped, logging is disabled" << std::endl;
+      return;
+    }
+
+    testMultithreaded();
+    testFiltering();
+    testRateLimit();
+  }
+}
+
+int main() {
+  try {
+    test_logger::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,257 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <functional>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_materials.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_material_hash.log");
+}
+
+namespace test_material_hash {
+  using namespace dxvk;
+
+  // Builds the material once from the base parameters and once per perturbation, each of which changes
+  // exactly one field. Identical parameters must result in identical hashes and compare equal, while
+  // any single perturbation must change the hash and break equality.
+  template<typename Params, typename Build>
+  void checkPerturbations(const char* name, const Params& base, Build build,
+                          const std::vector<std::function<void(Params&)>>& perturbations) {
+    const auto reference = build(base);
+
+    if (build(base).getHash() != reference.getHash() || !(build(base) == reference))
+      throw DxvkError(str::format(name, ": hash of identical parameters is not stable"));
+
+    for (size_t i = 0; i < perturbations.size(); i++) {
+      Params params = base;
+      perturbations[i](params);
+
+      const auto perturbed = build(params);
+
+      if (perturbed.getHash() == reference.getHash())
+        throw DxvkError(str::format(name, ": perturbation ", i, " does not change the hash"));
+
+      if (perturbed == reference)
+        throw DxvkError(str::format(name, ": perturbation ", i, " still compares equal"));
+    }
+  }
+
+  struct OpaqueParams {
+    uint32_t albedoOpacityTexture = 1, normalTexture = 2, tangentTexture = 3, heightTexture = 4;
+    uint32_t roughnessTexture = 5, metallicTexture = 6, emissiveColorTexture = 7;
+    float anisotropy = 0.25f, emissiveIntensity = 40.f;
+    Vector4 albedoOpacity = Vector4(0.2f, 0.3f, 0.4f, 1.f);
+    float roughness = 0.5f, metallic = 0.f;
+    Vector3 emissiveColor = Vector3(1.f, 0.1f, 0.1f);
+    bool enableEmission = false, enableThinFilm = false, alphaIsThinFilmThickness = false;
+    float thinFilmThickness = 200.f;
+    uint32_t sampler = 8;
+    float displaceIn = 0.05f;
+    uint32_t subsurfaceMaterial = kSurfaceMaterialInvalidTextureIndex;
+  };
+
+  void testOpaqueSurfaceMaterial() {
+    auto build = [](const OpaqueParams& p) {
+      return RtOpaqueSurfaceMaterial(
+        p.albedoOpacityTexture, p.normalTexture, p.tangentTexture, p.heightTexture, p.roughnessTexture,
+        p.metallicTexture, p.emissiveColorTexture, p.anisotropy, p.emissiveIntensity, p.albedoOpacity,
+        p.roughness, p.metallic, p.emissiveColor, p.enableEmission, p.enableThinFilm, p.alphaIsThinFilmThickness,
+        p.thinFilmThickness, p.sampler, p.displaceIn, p.subsurfaceMaterial);
+    };
+
+    checkPerturbations<OpaqueParams>("RtOpaqueSurfaceMaterial", OpaqueParams(), build, {
+      [](OpaqueParams& p) { p.albedoOpacityTexture = 11; },
+      [](OpaqueParams& p) { p.normalTexture = 12; },
+      [](OpaqueParams& p) { p.tangentTexture = 13; },
+      [](OpaqueParams& p) { p.heightTexture = 14; },
+      [](OpaqueParams& p) { p.roughnessTexture = 15; },
+      [](OpaqueParams& p) { p.metallicTexture = 16; },
+      [](OpaqueParams& p) { p.emissiveColorTexture = 17; },
+      // Swapping two textures must not cancel out
+      [](OpaqueParams& p) { std::swap(p.normalTexture, p.tangentTexture); },
+      [](OpaqueParams& p) { p.anisotropy = 0.5f; },
+      [](OpaqueParams& p) { p.emissiveIntensity = 41.f; },
+      [](OpaqueParams& p) { p.albedoOpacity.w = 0.5f; },
+      [](OpaqueParams& p) { p.roughness = 0.75f; },
+      [](OpaqueParams& p) { p.metallic = 1.f; },
+      [](OpaqueParams& p) { p.emissiveColor.z = 0.2f; },
+      [](OpaqueParams& p) { p.enableEmission = true; },
+      [](OpaqueParams& p) { p.enableThinFilm = true; },
+      [](OpaqueParams& p) { p.alphaIsThinFilmThickness = true; },
+      [](OpaqueParams& p) { p.thinFilmThickness = 300.f; },
+      [](OpaqueParams& p) { p.sampler = 9; },
+      [](OpaqueParams& p) { p.displaceIn = 0.1f; },
+      [](OpaqueParams& p) { p.subsurfaceMaterial = 0; },
+    });
+  }
+
+  struct TranslucentParams {
+    uint32_t normalTexture = 1, transmittanceTexture = 2, emissiveColorTexture = 3;
+    float refractiveIndex = 1.3f, transmittanceMeasurementDistance = 1.f;
+    Vector3 transmittanceColor = Vector3(0.97f);
+    bool enableEmission = false;
+    float emissiveIntensity = 40.f;
+    Vector3 emissiveColor = Vector3(1.f, 0.1f, 0.1f);
+    bool isThinWalled = false;
+    float thinWallThickness = 0.001f;
+    bool useDiffuseLayer = false;
+    uint32_t sampler = 4;
+  };
+
+  void testTranslucentSurfaceMaterial() {
+    auto build = [](const TranslucentParams& p) {
+      return RtTranslucentSurfaceMaterial(
+        p.normalTexture, p.transmittanceTexture, p.emissiveColorTexture, p.refractiveIndex,
+        p.transmittanceMeasurementDistance, p.transmittanceColor, p.enableEmission, p.emissiveIntensity,
+        p.emissiveColor, p.isThinWalled, p.thinWallThickness, p.useDiffuseLayer, p.sampler);
+    };
+
+    checkPerturbations<TranslucentParams>("RtTranslucentSurfaceMaterial", TranslucentParams(), build, {
+      [](TranslucentParams& p) { p.normalTexture = 11; },
+      [](TranslucentParams& p) { p.transmittanceTexture = 12; },
+      [](TranslucentParams& p) { p.emissiveColorTexture = 13; },
+      [](TranslucentParams& p) { p.refractiveIndex = 1.5f; },
+      [](TranslucentParams& p) { p.transmittanceMeasurementDistance = 2.f; },
+      [](TranslucentParams& p) { p.transmittanceColor.y = 0.5f; },
+      [](TranslucentParams& p) { p.enableEmission = true; },
+      [](TranslucentParams& p) { p.emissiveIntensity = 41.f; },
+      [](TranslucentParams& p) { p.emissiveColor.x = 0.5f; },
+      [](TranslucentParams& p) { p.isThinWalled = true; },
+      [](TranslucentParams& p) { p.thinWallThickness = 0.01f; },
+      [](TranslucentParams& p) { p.useDiffuseLayer = true; },
+      [](TranslucentParams& p) { p.sampler = 5; },
+    });
+  }
+
+  struct RayPortalParams {
+    uint32_t maskTexture = 1, maskTexture2 = 2;
+    uint8_t rayPortalIndex = 0;
+    float rotationSpeed = 0.f;
+    bool enableEmission = false;
+    float emissiveIntensity = 40.f;
+    uint32_t sampler = 3, sampler2 = 4;
+  };
+
+  void testRayPortalSurfaceMaterial() {
+    auto build = [](const RayPortalParams& p) {
+      return RtRayPortalSurfaceMaterial(
+        p.maskTexture, p.maskTexture2, p.rayPortalIndex, p.rotationSpeed,
+        p.enableEmission, p.emissiveIntensity, p.sampler, p.sampler2);
+    };
+
+    checkPerturbations<RayPortalParams>("RtRayPortalSurfaceMaterial", RayPortalParams(), build, {
+      [](RayPortalParams& p) { p.maskTexture = 11; },
+      [](RayPortalParams& p) { p.maskTexture2 = 12; },
+      [](RayPortalParams& p) { std::swap(p.maskTexture, p.maskTexture2); },
+      [](RayPortalParams& p) { p.rayPortalIndex = 1; },
+      [](RayPortalParams& p) { p.rotationSpeed = 1.f; },
+      [](RayPortalParams& p) { p.enableEmission = true; },
+      [](RayPortalParams& p) { p.emissiveIntensity = 41.f; },
+      [](RayPortalParams& p) { p.sampler = 13; },
+      [](RayPortalParams& p) { p.sampler2 = 14; },
+    });
+  }
+
+  void testOpaqueMaterialData() {
+    // Note: Merging into a material without any dirty parameters takes over every
+    // parameter of the input, which recomputes the hash from the modified fields.
+    auto build = [](const OpaqueMaterialData& p) {
+      OpaqueMaterialData material;
+      material.merge(p);
+      return material;
+    };
+
+    checkPerturbations<OpaqueMaterialData>("OpaqueMaterialData", OpaqueMaterialData(), build, {
+      [](OpaqueMaterialData& p) { p.getAnisotropyConstant() = 0.5f; },
+      [](OpaqueMaterialData& p) { p.getEmissiveIntensity() = 41.f; },
+      [](OpaqueMaterialData& p) { p.getAlbedoConstant().y = 0.5f; },
+      [](OpaqueMaterialData& p) { p.getOpacityConstant() = 0.5f; },
+      [](OpaqueMaterialData& p) { p.getRoughnessConstant() = 0.75f; },
+      [](OpaqueMaterialData& p) { p.getMetallicConstant() = 1.f; },
+      [](OpaqueMaterialData& p) { p.getEmissiveColorConstant().z = 0.5f; },
+      [](OpaqueMaterialData& p) { p.getEnableEmission() = true; },
+      [](OpaqueMaterialData& p) { p.getSpriteSheetRows() = 2; },
+      [](OpaqueMaterialData& p) { p.getSpriteSheetCols() = 2; },
+      [](OpaqueMaterialData& p) { p.getSpriteSheetFPS() = 30; },
+      [](OpaqueMaterialData& p) { p.getEnableThinFilm() = true; },
+      [](OpaqueMaterialData& p) { p.getAlphaIsThinFilmThickness() = true; },
+      [](OpaqueMaterialData& p) { p.getThinFilmThicknessConstant() = 300.f; },
+      [](OpaqueMaterialData& p) { p.getUseLegacyAlphaState() = false; },
+      [](OpaqueMaterialData& p) { p.getBlendEnabled() = true; },
+      [](OpaqueMaterialData& p) { p.getBlendType() = BlendType::kEmissive; },
+      [](OpaqueMaterialData& p) { p.getInvertedBlend() = true; },
+      [](OpaqueMaterialData& p) { p.getAlphaTestType() = AlphaTestType::kGreater; },
+      [](OpaqueMaterialData& p) { p.getAlphaTestReferenceValue() = 128; },
+      [](OpaqueMaterialData& p) { p.getDisplaceIn() = 0.1f; },
+      [](OpaqueMaterialData& p) { p.getSubsurfaceTransmittanceColor().x = 0.25f; },
+      [](OpaqueMaterialData& p) { p.getSubsurfaceMeasurementDistance() = 1.f; },
+      [](OpaqueMaterialData& p) { p.getSubsurfaceSingleScatteringAlbedo().z = 0.25f; },
+      [](OpaqueMaterialData& p) { p.getSubsurfaceVolumetricAnisotropy() = 0.5f; },
+      [](OpaqueMaterialData& p) { p.getFilterMode() = lss::Mdl::Filter::Nearest; },
+      [](OpaqueMaterialData& p) { p.getWrapModeU() = lss::Mdl::WrapMode::Clamp; },
+      [](OpaqueMaterialData& p) { p.getWrapModeV() = lss::Mdl::WrapMode::Clamp; },
+    });
+  }
+
+  void testTranslucentMaterialData() {
+    auto build = [](const TranslucentMaterialData& p) {
+      TranslucentMaterialData material;
+      material.merge(p);
+      return material;
+    };
+
+    checkPerturbations<TranslucentMaterialData>("TranslucentMaterialData", TranslucentMaterialData(), build, {
+      [](TranslucentMaterialData& p) { p.getRefractiveIndex() = 1.5f; },
+      [](TranslucentMaterialData& p) { p.getTransmittanceColor().x = 0.5f; },
+      [](TranslucentMaterialData& p) { p.getTransmittanceMeasurementDistance() = 2.f; },
+      [](TranslucentMaterialData& p) { p.getEnableEmission() = true; },
+      [](TranslucentMaterialData& p) { p.getEmissiveIntensity() = 41.f; },
+      [](TranslucentMaterialData& p) { p.getEmissiveColorConstant().y = 0.5f; },
+      [](TranslucentMaterialData& p) { p.getEnableThinWalled() = true; },
+      [](TranslucentMaterialData& p) { p.getThinWallThickness() = 0.01f; },
+      [](TranslucentMaterialData& p) { p.getEnableDiffuseLayer() = true; },
+    });
+  }
+
+  void run() {
+    testOpaqueSurfaceMaterial();
+    testTranslucentSurfaceMaterial();
+    testRayPortalSurfaceMaterial();
+    testOpaqueMaterialData();
+    testTranslucentMaterialData();
+  }
+}
+
+int main() {
+  try {
+    test_material_hash::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/log/metrics.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_metrics.log");
+  Metrics Metrics::s_instance;
+}
+
+namespace test_metrics {
+  using namespace dxvk;
+
+  // Note: Must match the test environment in meson.build
+  constexpr uint32_t kExportInterval = 4;
+
+  // Maps frame and metric name to the exported value
+  std::map<std::pair<uint64_t, std::string>, double> readTimeSeries() {
+    std::ifstream file("metrics_time_series.csv");
+    std::map<std::pair<uint64_t, std::string>, double> values;
+
+    std::string line;
+    std::getline(file, line);
+    if (line != "frame,metric,value") {
+      throw DxvkError("Missing time series header");
+    }
+
+    while (std::getline(file, line)) {
+      const size_t first = line.find(',');
+      const size_t second = line.rfind(',');
+      values[{ std::stoull(line.substr(0, first)), line.substr(first + 1, second - first - 1) }] = std::stod(line.substr(second + 1));
+    }
+    return values;
+  }
+
+  void expectValue(const std::map<std::pair<uint64_t, std::string>, double>& values, uint64_t frame, const char* name, double expected) {
+    auto iter = values.find({ frame, name });
+    if (iter == values.end()) {
+      throw DxvkError(str::format("Missing sample of ", name, " in frame ", frame));
+    }
+    if (iter->second != expected) {
+      throw DxvkError(str::format("Sample of ", name, " in frame ", frame, " is ", iter->second, ", expected ", expected));
+    }
+  }
+
+  void testHistogram() {
+    MetricHistogram histogram;
+    for (uint32_t i = 1; i <= 100; i++) {
+      histogram.record(i);
+    }
+
+    const MetricHistogram::Snapshot snapshot = histogram.takeSnapshot();
+    if (snapshot.count != 100 || snapshot.sum != 5050.0 || snapshot.max != 100.0) {
+      throw DxvkError("Unexpected histogram count, sum or max");
+    }
+    // Percentiles are the upper bound of their power of two bucket, capped by the max
+    if (snapshot.p50 != 64.0 || snapshot.p95 != 100.0) {
+      throw DxvkError(str::format("Unexpected histogram percentiles: ", snapshot.p50, ", ", snapshot.p95));
+    }
+    if (histogram.takeSnapshot().count != 0) {
+      throw DxvkError("Snapshot did not reset the histogram");
+    }
+
+    std::cout << "Histogram passed" << std::endl;
+  }
+
+  void testRegistry() {
+    if (&Metrics::counter("test.counter") != &Metrics::counter("test.counter")) {
+      throw DxvkError("Lookup of an existing metric registered a new one");
+    }
+    if (reinterpret_cast<void*>(&Metrics::gauge("test.counter")) == reinterpret_cast<void*>(&Metrics::counter("test.counter"))) {
+      throw DxvkError("Lookup with a different type returned the existing metric");
+    }
+
+    std::cout << "Registry passed" << std::endl;
+  }
+
+  void testTimeSeries() {
+    if (!Metrics::isRecording()) {
+      throw DxvkError("Time series is not enabled, DXVK_METRICS_TIME_SERIES must be set to csv");
+    }
+
+    constexpr uint32_t kNumThreads = 4;
+    constexpr uint32_t kNumAdds = 1000;
+
+    MetricCounter& counter = Metrics::counter("test.counter");
+    MetricGauge& gauge = Metrics::gauge("test.gauge");
+    MetricHistogram& histogram = Metrics::histogram("test.histogram");
+
+    for (uint32_t frame = 0; frame < kExportInterval; frame++) {
+      std::vector<std::thread> threads;
+      for (uint32_t t = 0; t < kNumThreads; t++) {
+        threads.emplace_back([&counter, frame] {
+          for (uint32_t i = 0; i < kNumAdds * (frame + 1); i++) {
+            counter.add();
+          }
+        });
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+
+      gauge.set(frame * 2.0);
+      histogram.record(frame + 1.0);
+      Metrics::endFrame(frame);
+    }
+
+    // The time series is exported once the interval has passed
+    const auto values = readTimeSeries();
+    for (uint32_t frame = 0; frame < kExportInterval; frame++) {
+      // Counters are sampled as their increment since the last frame
+      expectValue(values, frame, "test.counter", kNumThreads * kNumAdds * (frame + 1));
+      expectValue(values, frame, "test.gauge", frame * 2.0);
+      expectValue(values, frame, "test.histogram.count", 1.0);
+      expectValue(values, frame, "test.histogram.mean", frame + 1.0);
+    }
+
+    std::cout << "Time series passed" << std::endl;
+  }
+
+  void run() {
+    testHistogram();
+    testRegistry();
+    testTimeSeries();
+  }
+}
+
+int main() {
+  try {
+    test_metrics::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,258 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_opacity_micromap_disk_cache.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_opacity_micromap_disk_cache.log");
+}
+
+namespace test_opacity_micromap_disk_cache {
+  using namespace dxvk;
+
+  // Mimics a baked array: long opaque and transparent runs with some noisy triangles in between
+  OpacityMicromapDiskCacheEntry generateEntry(uint32_t seed, size_t size) {
+    std::mt19937 rng(seed);
+
+    OpacityMicromapDiskCacheEntry entry;
+    entry.numTriangles = static_cast<uint32_t>(size / 16);
+    entry.subdivisionLevel = 4;
+    entry.ommFormat = 2;
+    entry.arrayData.reserve(size);
+
+    while (entry.arrayData.size() < size) {
+      const size_t runLength = std::min<size_t>(rng() % 512 + 1, size - entry.arrayData.size());
+      switch (rng() % 3) {
+      case 0: entry.arrayData.insert(entry.arrayData.end(), runLength, 0x00); break;
+      case 1: entry.arrayData.insert(entry.arrayData.end(), runLength, 0x55); break;
+      default:
+        for (size_t i = 0; i < runLength; i++) {
+          entry.arrayData.push_back(static_cast<uint8_t>(rng()));
+        }
+        break;
+      }
+    }
+    return entry;
+  }
+
+  void testCompression() {
+    const std::vector<std::vector<uint8_t>> inputs = {
+      {},
+      { 7 },
+      { 7, 7 },
+      { 7, 7, 7 },
+      std::vector<uint8_t>(1000, 0xFF),
+      generateEntry(1, 64 * 1024).arrayData,
+    };
+
+    for (const auto& input : inputs) {
+      std::vector<uint8_t> compressed;
+      OpacityMicromapDiskCacheEntry::compress(input.data(), input.size(), compressed);
+
+      std::vector<uint8_t> output(input.size());
+      if (!OpacityMicromapDiskCacheEntry::decompress(compressed.data(), compressed.size(), output.data(), output.size()) ||
+          output != input) {
+        throw DxvkError(str::format("Compression round trip failed for ", input.size(), " bytes"));
+      }
+
+      // Truncated streams must not decompress
+      if (!compressed.empty() &&
+          OpacityMicromapDiskCacheEntry::decompress(compressed.data(), compressed.size() - 1, output.data(), output.size())) {
+        throw DxvkError("Truncated compressed data was accepted");
+      }
+    }
+
+    std::vector<uint8_t> compressed;
+    OpacityMicromapDiskCacheEntry::compress(inputs[4].data(), inputs[4].size(), compressed);
+    if (compressed.size() > 20) {
+      throw DxvkError(str::format("Uniform data compressed poorly: ", compressed.size(), " bytes"));
+    }
+
+    std::cout << "Compression passed" << std::endl;
+  }
+
+  void testSerialization() {
+    const XXH64_hash_t key = 0x1234567890abcdefull;
+    const OpacityMicromapDiskCacheEntry entry = generateEntry(2, 16 * 1024);
+
+    std::vector<uint8_t> data;
+    OpacityMicromapDiskCacheEntry::serialize(key, entry, data);
+
+    OpacityMicromapDiskCacheEntry loaded;
+    if (!OpacityMicromapDiskCacheEntry::deserialize(key, data.data(), data.size(), loaded) ||
+        loaded.numTriangles != entry.numTriangles ||
+        loaded.subdivisionLevel != entry.subdivisionLevel ||
+        loaded.ommFormat != entry.ommFormat ||
+        loaded.arrayData != entry.arrayData) {
+      throw DxvkError("Entry differs after a round trip");
+    }
+
+    // Entries of another key, another version, truncated or corrupted ones must be rejected
+    if (OpacityMicromapDiskCacheEntry::deserialize(key + 1, data.data(), data.size(), loaded)) {
+      throw DxvkError("Entry of another key was accepted");
+    }
+    if (OpacityMicromapDiskCacheEntry::deserialize(key, data.data(), data.size() - 1, loaded)) {
+      throw DxvkError("Truncated entry was accepted");
+    }
+
+    std::vector<uint8_t> otherVersion = data;
+    otherVersion[offsetof(OpacityMicromapDiskCacheFileHeader, version)]++;
+    if (OpacityMicromapDiskCacheEntry::deserialize(key, otherVersion.data(), otherVersion.size(), loaded)) {
+      throw DxvkError("Entry of another version was accepted");
+    }
+
+    std::vector<uint8_t> corrupted = data;
+    corrupted[sizeof(OpacityMicromapDiskCacheFileHeader) + 1] ^= 0x01;
+    if (OpacityMicromapDiskCacheEntry::deserialize(key, corrupted.data(), corrupted.size(), loaded)) {
+      throw DxvkError("Corrupted entry was accepted");
+    }
+
+    std::cout << "Serialization passed (" << entry.arrayData.size() << " -> " << data.size() << " bytes)" << std::endl;
+  }
+
+  void testIndex() {
+    OpacityMicromapDiskCacheIndex index;
+    for (XXH64_hash_t key = 1; key <= 8; key++) {
+      index.insert(key, 100);
+    }
+    // Make the oldest two entries the most recently used ones
+    index.touch(1);
+    index.touch(2);
+
+    const std::vector<XXH64_hash_t> evicted = index.evict(500);
+    if (evicted != std::vector<XXH64_hash_t> { 3, 4, 5 } || index.getTotalSize() != 500 || index.getNumEntries() != 5) {
+      throw DxvkError("Least recently used entries were not evicted first");
+    }
+
+    std::vector<uint8_t> data;
+    index.serialize(data);
+
+    OpacityMicromapDiskCacheIndex loaded;
+    if (!loaded.deserialize(data.data(), data.size()) ||
+        loaded.getNumEntries() != 5 || loaded.getTotalSize() != 500 || !loaded.contains(1) || loaded.contains(3)) {
+      throw DxvkError("Index differs after a round trip");
+    }
+
+    // The usage order must survive a round trip
+    if (loaded.evict(200) != std::vector<XXH64_hash_t> { 6, 7, 8 }) {
+      throw DxvkError("Usage order was lost in a round trip");
+    }
+
+    if (loaded.deserialize(data.data(), data.size() - 1) || loaded.getNumEntries() != 0) {
+      throw DxvkError("Truncated index was accepted");
+    }
+
+    std::cout << "Index passed" << std::endl;
+  }
+
+  void testDiskCache() {
+    const std::string directory = "test_opacity_micromap_disk_cache.dxvk-omm";
+    std::filesystem::remove_all(directory);
+
+    const OpacityMicromapDiskCacheEntry entry = generateEntry(3, 32 * 1024);
+
+    {
+      OpacityMicromapDiskCache cache(directory, 1024 * 1024);
+      OpacityMicromapDiskCacheEntry loaded;
+      if (cache.load(1, loaded) || cache.getNumMisses() != 1) {
+        throw DxvkError("Empty cache reported a hit");
+      }
+
+      for (XXH64_hash_t key = 1; key <= 4; key++) {
+        cache.store(key, OpacityMicromapDiskCacheEntry(entry));
+      }
+      cache.flush();
+
+      if (cache.getNumEntries() != 4 || !cache.load(2, loaded) || loaded.arrayData != entry.arrayData) {
+        throw DxvkError("Stored entries were not loaded back");
+      }
+    }
+
+    // Entries and their usage must persist across sessions
+    uint64_t entrySize;
+    {
+      OpacityMicromapDiskCache cache(directory, 1024 * 1024);
+      OpacityMicromapDiskCacheEntry loaded;
+      if (cache.getNumEntries() != 4 || !cache.load(3, loaded) || loaded.arrayData != entry.arrayData) {
+        throw DxvkError("Entries did not persist across sessions");
+      }
+      entrySize = cache.getTotalSize() / 4;
+    }
+
+    // Shrinking the max size evicts least recently used entries, 3 and then 2 were used last
+    {
+      OpacityMicromapDiskCache cache(directory, entrySize * 2);
+      if (cache.getNumEntries() != 2 || !cache.contains(2) || !cache.contains(3)) {
+        throw DxvkError("Least recently used entries were not evicted");
+      }
+    }
+
+    // A lost index is rebuilt from the entries on disk, and corrupted entries are dropped on load
+    std::filesystem::remove(directory + "/index.bin");
+    {
+      const std::string entryPath = directory + "/00/0000000000000002.omm";
+      std::fstream file(entryPath, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+      file.seekg(sizeof(OpacityMicromapDiskCacheFileHeader) + 1);
+      const char value = static_cast<char>(file.get());
+      file.seekp(sizeof(OpacityMicromapDiskCacheFileHeader) + 1);
+      file.put(value ^ 0x01);
+    }
+    {
+      OpacityMicromapDiskCache cache(directory, 1024 * 1024);
+      OpacityMicromapDiskCacheEntry loaded;
+      if (cache.getNumEntries() != 2 || !cache.load(3, loaded) || loaded.arrayData != entry.arrayData) {
+        throw DxvkError("Index was not rebuilt");
+      }
+      if (cache.load(2, loaded) || cache.contains(2)) {
+        throw DxvkError("Corrupted entry was not dropped");
+      }
+    }
+
+    std::filesystem::remove_all(directory);
+    std::cout << "Disk cache passed" << std::endl;
+  }
+
+  void run() {
+    testCompression();
+    testSerialization();
+    testIndex();
+    testDiskCache();
+  }
+}
+
+int main() {
+  try {
+    test_opacity_micromap_disk_cache::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
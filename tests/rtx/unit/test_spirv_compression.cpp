@@ -0,0 +1,419 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/spirv/spirv_compression.h"
+#include "../../../src/spirv/spirv_module.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_spirv_compression.log");
+}
+
+namespace test_spirv_compression {
+  using namespace dxvk;
+
+  struct Shader {
+    std::string     name;
+    SpirvCodeBuffer code;
+  };
+
+  // Emits a pixel shader resembling the output of the DXSO compiler, i.e. a
+  // constant buffer, a few samplers and inputs, and a long stream of vector
+  // arithmetic with swizzles. Enough to compare the encodings without
+  // having to ship captured shaders with the test.
+  SpirvCodeBuffer buildShader(uint32_t seed, uint32_t numOps) {
+    std::mt19937 rng(seed);
+
+    SpirvModule module(spvVersion(1, 3));
+    module.enableCapability(spv::CapabilityShader);
+    module.setMemoryModel(spv::AddressingModelLogical, spv::MemoryModelGLSL450);
+
+    const uint32_t voidType  = module.defVoidType();
+    const uint32_t boolType  = module.defBoolType();
+    const uint32_t floatType = module.defFloatType(32);
+    const uint32_t vec4Type  = module.defVectorType(floatType, 4);
+    const uint32_t vec2Type  = module.defVectorType(floatType, 2);
+    const uint32_t uintType  = module.defIntType(32, 0);
+
+    // Constant buffer of 32 vectors
+    const uint32_t constArrayType = module.defArrayTypeUnique(vec4Type, module.constu32(32));
+    module.decorateArrayStride(constArrayType, 16);
+    const uint32_t constStructType = module.defStructTypeUnique(1, &constArrayType);
+    module.memberDecorateOffset(constStructType, 0, 0);
+    module.decorateBlock(constStructType);
+    const uint32_t constBuffer = module.newVar(
+      module.defPointerType(constStructType, spv::StorageClassUniform),
+      spv::StorageClassUniform);
+    module.decorateDescriptorSet(constBuffer, 0);
+    module.decorateBinding(constBuffer, 0);
+    const uint32_t constPtrType = module.defPointerType(vec4Type, spv::StorageClassUniform);
+
+    // Samplers
+    const uint32_t imageType = module.defSampledImageType(module.defImageType(
+      floatType, spv::Dim2D, 0, 0, 0, 1, spv::ImageFormatUnknown));
+    const uint32_t imagePtrType = module.defPointerType(imageType, spv::StorageClassUniformConstant);
+    std::vector<uint32_t> samplers;
+
+    for (uint32_t i = 0; i < 4; i++) {
+      samplers.push_back(module.newVar(imagePtrType, spv::StorageClassUniformConstant));
+      module.decorateDescriptorSet(samplers.back(), 0);
+      module.decorateBinding(samplers.back(), i + 1);
+    }
+
+    // Inputs and output
+    std::vector<uint32_t> interfaces;
+    const uint32_t inputPtrType = module.defPointerType(vec4Type, spv::StorageClassInput);
+
+    for (uint32_t i = 0; i < 4; i++) {
+      interfaces.push_back(module.newVar(inputPtrType, spv::StorageClassInput));
+      module.decorateLocation(interfaces.back(), i);
+    }
+
+    const uint32_t output = module.newVar(
+      module.defPointerType(vec4Type, spv::StorageClassOutput),
+      spv::StorageClassOutput);
+    module.decorateLocation(output, 0);
+    interfaces.push_back(output);
+
+    const uint32_t entryPoint = module.allocateId();
+    module.addEntryPoint(entryPoint, spv::ExecutionModelFragment, "main",
+      uint32_t(interfaces.size()), interfaces.data());
+    module.setExecutionMode(entryPoint, spv::ExecutionModeOriginUpperLeft);
+
+    module.functionBegin(voidType, entryPoint,
+      module.defFunctionType(voidType, 0, nullptr),
+      spv::FunctionControlMaskNone);
+    module.opLabel(module.allocateId());
+
+    std::vector<uint32_t> values;
+
+    for (uint32_t i = 0; i < 4; i++)
+      values.push_back(module.opLoad(vec4Type, interfaces[i]));
+
+    // Operands mostly refer to recent results, like registers of the
+    // original shader, with the occasional reference to an older one
+    auto pick = [&] {
+      uint32_t n = uint32_t(values.size());
+      return values[rng() % 4 ? n - 1 - rng() % std::min(n, 8u) : rng() % n];
+    };
+
+    for (uint32_t i = 0; i < numOps; i++) {
+      uint32_t result = 0;
+
+      switch (rng() % 10) {
+        case 0: {
+          uint32_t index = module.constu32(rng() % 32);
+          uint32_t indices[] = { module.constu32(0), index };
+          result = module.opLoad(vec4Type, module.opAccessChain(constPtrType, constBuffer, 2, indices));
+        } break;
+
+        case 1: {
+          uint32_t swizzle[] = { 0, 1 };
+          uint32_t coord = module.opVectorShuffle(vec2Type, pick(), pick(), 2, swizzle);
+          uint32_t image = module.opLoad(imageType, samplers[rng() % samplers.size()]);
+          result = module.opImageSampleImplicitLod(vec4Type, image, coord, SpirvImageOperands());
+        } break;
+
+        case 2: result = module.opFAdd(vec4Type, pick(), pick()); break;
+        case 3: result = module.opFMul(vec4Type, pick(), pick()); break;
+        case 4: result = module.opFFma(vec4Type, pick(), pick(), pick()); break;
+
+        case 5: {
+          uint32_t dot = module.opDot(floatType, pick(), pick());
+          uint32_t components[] = { dot, dot, dot, dot };
+          result = module.opCompositeConstruct(vec4Type, 4, components);
+        } break;
+
+        case 6: {
+          uint32_t swizzle[] = { uint32_t(rng() % 4), uint32_t(rng() % 4), uint32_t(rng() % 4), uint32_t(rng() % 4) };
+          result = module.opVectorShuffle(vec4Type, pick(), pick(), 4, swizzle);
+        } break;
+
+        case 7: {
+          uint32_t index = rng() % 4;
+          uint32_t a = module.opCompositeExtract(floatType, pick(), 1, &index);
+          uint32_t b = module.opCompositeExtract(floatType, pick(), 1, &index);
+          uint32_t cond = module.opFOrdLessThan(boolType, a, b);
+          result = module.opSelect(vec4Type, cond, pick(), pick());
+        } break;
+
+        case 8: {
+          result = module.opFClamp(vec4Type, pick(),
+            module.constvec4f32(0.0f, 0.0f, 0.0f, 0.0f),
+            module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f));
+        } break;
+
+        case 9: {
+          result = module.opFMul(vec4Type, pick(), module.constvec4f32(
+            float(rng() % 256) / 255.0f, 0.5f, 2.0f, float(rng() % 16)));
+        } break;
+      }
+
+      values.push_back(result);
+    }
+
+    module.opStore(output, values.back());
+    module.opReturn();
+    module.functionEnd();
+    return module.compile();
+  }
+
+  std::vector<Shader> getCorpus(int argc, char** argv) {
+    std::vector<Shader> corpus;
+
+    // Captured shaders, e.g. dumped via DXVK_SHADER_DUMP_PATH,
+    // can be passed on the command line to measure real data
+    for (int i = 1; i < argc; i++) {
+      std::ifstream file(argv[i], std::ios::binary);
+
+      if (!file)
+        throw DxvkError(str::format("Failed to open ", argv[i]));
+
+      corpus.push_back({ argv[i], SpirvCodeBuffer(file) });
+    }
+
+    const uint32_t sizes[] = { 0, 1, 16, 100, 500, 2000 };
+
+    for (uint32_t i = 0; i < std::size(sizes); i++)
+      corpus.push_back({ str::format("generated_", sizes[i]), buildShader(i, sizes[i]) });
+
+    return corpus;
+  }
+
+  // Size of the code in the encoding used before the dictionary encoding,
+  // which stored the byte count of every word in a 2-bit mask followed
+  // by the words themselves with their leading zero bytes stripped.
+  size_t getLegacySize(const SpirvCodeBuffer& code) {
+    size_t numBits = 0;
+
+    for (uint32_t i = 0; i < code.dwords(); i++) {
+      uint32_t word = code.data()[i];
+      uint32_t bytes = word < (1u << 8) ? 1 : word < (1u << 16) ? 2 : word < (1u << 24) ? 3 : 4;
+      numBits += 8 * bytes;
+    }
+
+    size_t numMaskWords = (code.dwords() + 31) / 32;
+    size_t numCodeWords = (numBits + 63) / 64;
+    return 8 * (numMaskWords + numCodeWords);
+  }
+
+  void testRoundTrip(const std::vector<Shader>& corpus) {
+    std::vector<uint32_t> scratch;
+
+    for (const Shader& shader : corpus) {
+      const SpirvCodeBuffer& code = shader.code;
+      SpirvCompressedBuffer compressed(code);
+
+      if (compressed.dwords() != code.dwords() || !compressed.isValid())
+        throw DxvkError(str::format(shader.name, ": invalid compressed buffer"));
+
+      SpirvCodeBuffer decompressed = compressed.decompress();
+
+      if (decompressed.dwords() != code.dwords()
+       || std::memcmp(decompressed.data(), code.data(), code.size()))
+        throw DxvkError(str::format(shader.name, ": decompress() mismatch"));
+
+      compressed.decompress(scratch);
+
+      if (scratch.size() != code.dwords()
+       || std::memcmp(scratch.data(), code.data(), code.size()))
+        throw DxvkError(str::format(shader.name, ": decompress(scratch) mismatch"));
+
+      // Stream in odd sized chunks to make sure the
+      // decoder state carries over between reads
+      std::vector<uint32_t> streamed(code.dwords());
+      SpirvCompressedBuffer::Decoder decoder(compressed);
+      uint32_t offset = 0;
+
+      while (!decoder.atEnd())
+        offset += decoder.read(streamed.data() + offset, 7);
+
+      if (offset != code.dwords() || decoder.read(streamed.data(), 1) != 0
+       || std::memcmp(streamed.data(), code.data(), code.size()))
+        throw DxvkError(str::format(shader.name, ": streaming decoder mismatch"));
+
+      // Restoring from the raw data must result in the same buffer
+      std::vector<uint8_t> data = compressed.getData();
+      SpirvCompressedBuffer restored(compressed.dwords(), std::move(data));
+
+      if (!restored.isValid() || restored.getData() != compressed.getData())
+        throw DxvkError(str::format(shader.name, ": restored buffer mismatch"));
+    }
+  }
+
+  void testArbitraryWords() {
+    // Words the compilers never emit, such as unknown opcodes,
+    // huge IDs and literals, must still survive the round trip
+    std::mt19937 rng(42);
+
+    for (uint32_t i = 0; i < 64; i++) {
+      std::vector<uint32_t> words(rng() % 256);
+
+      for (uint32_t& word : words) {
+        switch (rng() % 4) {
+          case 0: word = rng(); break;
+          case 1: word = ~0u - rng() % 4; break;
+          case 2: word = rng() % 16; break;
+          case 3: word = (rng() % 8) << spv::WordCountShift | rng() % 400; break;
+        }
+      }
+
+      SpirvCodeBuffer code(uint32_t(words.size()), words.data());
+      SpirvCompressedBuffer compressed(code);
+      SpirvCodeBuffer decompressed = compressed.decompress();
+
+      if (!compressed.isValid() || decompressed.dwords() != code.dwords()
+       || std::memcmp(decompressed.data(), code.data(), code.size()))
+        throw DxvkError(str::format("Arbitrary words ", i, ": round trip mismatch"));
+    }
+  }
+
+  void testValidation(const std::vector<Shader>& corpus) {
+    SpirvCompressedBuffer compressed(corpus.back().code);
+    const std::vector<uint8_t>& data = compressed.getData();
+
+    auto isValid = [&] (uint32_t dwords, std::vector<uint8_t> bytes) {
+      return SpirvCompressedBuffer(dwords, std::move(bytes)).isValid();
+    };
+
+    if (!isValid(compressed.dwords(), data))
+      throw DxvkError("Validation: valid buffer rejected");
+
+    if (isValid(compressed.dwords() + 1, data)
+     || isValid(compressed.dwords() - 1, data))
+      throw DxvkError("Validation: word count mismatch accepted");
+
+    if (isValid(compressed.dwords(), std::vector<uint8_t>(data.begin(), data.end() - 1)))
+      throw DxvkError("Validation: truncated buffer accepted");
+
+    std::vector<uint8_t> overlong = data;
+    overlong.back() |= 0x80;
+    overlong.insert(overlong.end(), { 0x80, 0x80, 0x80, 0x80, 0x01 });
+
+    if (isValid(compressed.dwords(), overlong))
+      throw DxvkError("Validation: overlong varint accepted");
+
+    if (isValid(1, { 0xff, 0xff, 0xff, 0xff, 0x7f }))
+      throw DxvkError("Validation: out of range word accepted");
+
+    if (!isValid(0, { }) || isValid(0, { 0x00 }))
+      throw DxvkError("Validation: empty buffer handling");
+  }
+
+  void testCompressionRatio(const std::vector<Shader>& corpus) {
+    size_t totalSize = 0;
+    size_t totalLegacy = 0;
+    size_t totalCompressed = 0;
+
+    for (const Shader& shader : corpus) {
+      SpirvCompressedBuffer compressed(shader.code);
+
+      size_t size = shader.code.size();
+      size_t legacy = getLegacySize(shader.code);
+      size_t current = compressed.getData().size();
+
+      Logger::info(str::format(shader.name, ": ", size, " bytes, legacy ", legacy,
+        " bytes, compressed ", current, " bytes (", size ? 100 * current / size : 0, "%)"));
+
+      totalSize += size;
+      totalLegacy += legacy;
+      totalCompressed += current;
+    }
+
+    Logger::info(str::format("Total: ", totalSize, " bytes, legacy ", totalLegacy,
+      " bytes, compressed ", totalCompressed, " bytes"));
+
+    if (totalCompressed >= totalLegacy)
+      throw DxvkError("Compression ratio: no improvement over the legacy encoding");
+  }
+
+  void testThroughput(const std::vector<Shader>& corpus) {
+    constexpr uint32_t Iterations = 200;
+
+    std::vector<SpirvCompressedBuffer> compressed;
+    size_t totalBytes = 0;
+
+    for (const Shader& shader : corpus) {
+      compressed.emplace_back(shader.code);
+      totalBytes += shader.code.size();
+    }
+
+    uint32_t checksum = 0;
+
+    auto measure = [&] (const char* name, auto&& decode) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+
+      for (uint32_t i = 0; i < Iterations; i++) {
+        for (const SpirvCompressedBuffer& buffer : compressed)
+          checksum += decode(buffer);
+      }
+
+      auto t1 = std::chrono::high_resolution_clock::now();
+      double seconds = std::chrono::duration<double>(t1 - t0).count();
+      double megabytes = double(totalBytes) * Iterations / (1024.0 * 1024.0);
+
+      Logger::info(str::format(name, ": ", uint32_t(megabytes / std::max(seconds, 1e-9)), " MB/s"));
+    };
+
+    measure("Decode into new buffer", [] (const SpirvCompressedBuffer& buffer) {
+      SpirvCodeBuffer code = buffer.decompress();
+      return code.dwords() ? code.data()[code.dwords() - 1] : 0u;
+    });
+
+    std::vector<uint32_t> scratch;
+
+    measure("Decode into scratch buffer", [&scratch] (const SpirvCompressedBuffer& buffer) {
+      buffer.decompress(scratch);
+      return scratch.empty() ? 0u : scratch.back();
+    });
+
+    Logger::info(str::format("Checksum: ", checksum));
+  }
+
+  void run(int argc, char** argv) {
+    const std::vector<Shader> corpus = getCorpus(argc, argv);
+
+    testRoundTrip(corpus);
+    testArbitraryWords();
+    testValidation(corpus);
+    testCompressionRatio(corpus);
+    testThroughput(corpus);
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    test_spirv_compression::run(argc, argv);
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
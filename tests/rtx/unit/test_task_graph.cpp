@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/util/util_task_graph.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_task_graph.log");
+}
+
+namespace test_task_graph {
+  using namespace dxvk;
+
+  using ThreadPool = WorkerThreadPool<8, true, false>;
+
+  enum : TaskGraph::ResourceMask {
+    kResourceA = 1 << 0,
+    kResourceB = 1 << 1,
+    kResourceC = 1 << 2,
+  };
+
+  void sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+
+  // Tasks sharing a resource must observe the order they were added in
+  void testOrdering(ThreadPool* pool) {
+    std::mutex mutex;
+    std::vector<uint32_t> order;
+    auto record = [&](uint32_t index) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(index);
+    };
+
+    TaskGraph graph;
+    graph.addTask("a0", TaskGraph::Affinity::Worker, 0, kResourceA, [&] { sleepMs(5); record(0); });
+    graph.addTask("a1", TaskGraph::Affinity::Main, kResourceA, 0, [&] { record(1); });
+    graph.addTask("a2", TaskGraph::Affinity::Worker, kResourceA, 0, [&] { record(2); });
+    graph.addTask("a3", TaskGraph::Affinity::Worker, 0, kResourceA, [&] { record(3); });
+    graph.addTask("a4", TaskGraph::Affinity::Main, kResourceA, kResourceA, [&] { record(4); });
+    graph.execute(pool);
+
+    // a1 and a2 only read, so they may run in any order
+    if (order.size() != 5 || order[0] != 0 || order[3] != 3 || order[4] != 4) {
+      throw DxvkError("Tasks ran out of dependency order");
+    }
+  }
+
+  // Independent worker tasks overlap with the main thread
+  void testOverlap(ThreadPool* pool) {
+    constexpr uint32_t kTaskMs = 100;
+
+    TaskGraph graph;
+    graph.addTask("main", TaskGraph::Affinity::Main, 0, kResourceA, [&] { sleepMs(kTaskMs); });
+    graph.addTask("worker0", TaskGraph::Affinity::Worker, 0, kResourceB, [&] { sleepMs(kTaskMs); });
+    graph.addTask("worker1", TaskGraph::Affinity::Worker, 0, kResourceC, [&] { sleepMs(kTaskMs); });
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    graph.execute(pool);
+    const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    const std::vector<TaskGraph::StageTiming>& timings = graph.getTimings();
+    if (timings.size() != 3 || timings[0].onWorker || !timings[1].onWorker || !timings[2].onWorker) {
+      throw DxvkError("Tasks ran on the wrong threads");
+    }
+    for (const TaskGraph::StageTiming& timing : timings) {
+      if (timing.durationMs < kTaskMs * 0.9) {
+        throw DxvkError(str::format("Stage ", timing.name, " reported ", timing.durationMs, " ms"));
+      }
+    }
+    if (totalMs > kTaskMs * 2.5) {
+      throw DxvkError(str::format("Independent tasks did not overlap, took ", totalMs, " ms"));
+    }
+  }
+
+  // A main task waits for the worker task producing its input
+  void testWorkerDependency(ThreadPool* pool) {
+    std::atomic<bool> produced = false;
+    bool consumedAfterProduced = false;
+
+    TaskGraph graph;
+    graph.addTask("produce", TaskGraph::Affinity::Worker, 0, kResourceA, [&] { sleepMs(20); produced = true; });
+    graph.addTask("unrelated", TaskGraph::Affinity::Main, 0, kResourceB, [&] { });
+    graph.addTask("consume", TaskGraph::Affinity::Main, kResourceA, 0, [&] { consumedAfterProduced = produced.load(); });
+    graph.execute(pool);
+
+    if (!consumedAfterProduced) {
+      throw DxvkError("Consumer ran before its producer finished");
+    }
+  }
+
+  // Without a pool, or with a full one, worker tasks run inline
+  void testInlineFallback() {
+    uint32_t numRun = 0;
+    TaskGraph graph;
+    for (uint32_t i = 0; i < 4; i++) {
+      graph.addTask("inline", TaskGraph::Affinity::Worker, 0, kResourceA, [&] { numRun++; });
+    }
+    graph.execute<ThreadPool>(nullptr);
+    if (numRun != 4) {
+      throw DxvkError("Tasks were lost without a thread pool");
+    }
+
+    // Queues hold a single task, the rest overflows onto this thread
+    WorkerThreadPool<2, true, false> smallPool(1, "test-task-graph-small");
+    std::atomic<uint32_t> numRunSmall = 0;
+    TaskGraph overflow;
+    for (uint32_t i = 0; i < 16; i++) {
+      overflow.addTask("overflow", TaskGraph::Affinity::Worker, 0, 0, [&] { sleepMs(1); numRunSmall++; });
+    }
+    overflow.execute(&smallPool);
+    if (numRunSmall != 16) {
+      throw DxvkError("Tasks were lost when the thread pool was full");
+    }
+  }
+
+  void run() {
+    ThreadPool pool(2, "test-task-graph");
+    testOrdering(&pool);
+    testOrdering(nullptr);
+    testOverlap(&pool);
+    testWorkerDependency(&pool);
+    testInlineFallback();
+  }
+}
+
+int main() {
+  try {
+    test_task_graph::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,315 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_terrain_tile_map.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_terrain_tile_map.log");
+}
+
+namespace test_terrain_tile_map {
+  using namespace dxvk;
+
+  using TileRect = TerrainTileMap::TileRect;
+
+  constexpr uint32_t kNumCascades = 3;
+  constexpr uint32_t kTilesPerSide = 8;
+
+  struct Draw {
+    uint32_t cascade;
+    TileRect rect;
+    XXH64_hash_t hash;
+  };
+
+  bool overlaps(const TileRect& rect, uint32_t x, uint32_t y) {
+    return x >= rect.beginX && x < rect.endX && y >= rect.beginY && y < rect.endY;
+  }
+
+  void runFrame(TerrainTileMap& tileMap, const XXH64_hash_t* cascadeHashes, const std::vector<Draw>& draws, bool forceRebake = false) {
+    tileMap.beginFrame(kNumCascades, kTilesPerSide, cascadeHashes, forceRebake);
+    for (const Draw& draw : draws) {
+      tileMap.addContributor(draw.cascade, draw.rect, draw.hash);
+    }
+  }
+
+  uint32_t countDirtyTiles(const TerrainTileMap& tileMap, uint32_t cascade) {
+    uint32_t count = 0;
+    for (uint32_t y = 0; y < kTilesPerSide; y++) {
+      for (uint32_t x = 0; x < kTilesPerSide; x++) {
+        count += tileMap.isDirty(cascade, x, y) ? 1 : 0;
+      }
+    }
+    return count;
+  }
+
+  void checkDirty(const TerrainTileMap& tileMap, uint32_t cascade, const TileRect& expected, const char* name) {
+    for (uint32_t y = 0; y < kTilesPerSide; y++) {
+      for (uint32_t x = 0; x < kTilesPerSide; x++) {
+        if (tileMap.isDirty(cascade, x, y) != overlaps(expected, x, y))
+          throw DxvkError(str::format(name, ": unexpected dirty state of tile ", x, ", ", y, " of cascade ", cascade));
+      }
+    }
+  }
+
+  void testTileRect() {
+    TerrainTileMap tileMap;
+    const XXH64_hash_t cascadeHashes[kNumCascades] = { 1, 2, 3 };
+    tileMap.beginFrame(kNumCascades, kTilesPerSide, cascadeHashes, false);
+
+    // An identity projection maps the level to <-1, 1> in world x and y, with rows going down along y
+    const Matrix4 worldToClip;
+
+    const TileRect topLeft = tileMap.calculateTileRect({ Vector3(-0.98f, 0.8f, 0.f), Vector3(-0.8f, 0.98f, 1.f) }, worldToClip);
+    if (topLeft.beginX != 0 || topLeft.endX != 1 || topLeft.beginY != 0 || topLeft.endY != 1)
+      throw DxvkError("box in the top left corner does not map to the top left tile");
+
+    const TileRect center = tileMap.calculateTileRect({ Vector3(-0.1f, -0.1f, 0.f), Vector3(0.1f, 0.1f, 0.f) }, worldToClip);
+    if (center.beginX != 3 || center.endX != 5 || center.beginY != 3 || center.endY != 5)
+      throw DxvkError("box in the center does not map to the four center tiles");
+
+    const TileRect outside = tileMap.calculateTileRect({ Vector3(2.f, 2.f, 0.f), Vector3(3.f, 3.f, 0.f) }, worldToClip);
+    if (!outside.isEmpty())
+      throw DxvkError("box outside of the level covers tiles");
+
+    const TileRect clamped = tileMap.calculateTileRect({ Vector3(0.6f, -5.f, 0.f), Vector3(5.f, -0.6f, 0.f) }, worldToClip);
+    if (clamped.beginX != 6 || clamped.endX != kTilesPerSide || clamped.beginY != 6 || clamped.endY != kTilesPerSide)
+      throw DxvkError("box partially outside of the level is not clamped to it");
+
+    const TileRect invalid = tileMap.calculateTileRect(AxisAlignedBoundingBox(), worldToClip);
+    if (invalid.beginX != 0 || invalid.endX != kTilesPerSide || invalid.beginY != 0 || invalid.endY != kTilesPerSide)
+      throw DxvkError("invalid box does not conservatively cover the whole level");
+
+    // Scaling the projection scales the footprint
+    Matrix4 zoomedOut;
+    zoomedOut[0][0] = 0.5f;
+    zoomedOut[1][1] = 0.5f;
+    const TileRect scaled = tileMap.calculateTileRect({ Vector3(-0.1f, -0.1f, 0.f), Vector3(0.1f, 0.1f, 0.f) }, zoomedOut);
+    if (scaled.beginX != 3 || scaled.endX != 5)
+      throw DxvkError("scaled projection does not map to the center tiles");
+  }
+
+  void testDirtyTiles() {
+    TerrainTileMap tileMap;
+    XXH64_hash_t cascadeHashes[kNumCascades] = { 1, 2, 3 };
+
+    std::vector<Draw> draws = {
+      { 0, { 0, 0, 4, 4 }, 100 },
+      { 0, { 2, 2, 6, 6 }, 200 },
+      { 1, { 0, 0, 8, 8 }, 300 },
+    };
+
+    // Everything is baked in the first frame
+    runFrame(tileMap, cascadeHashes, draws);
+    if (tileMap.getNumDirtyTiles() != tileMap.getNumTiles())
+      throw DxvkError("not all tiles are dirty in the first frame");
+    tileMap.endFrame();
+
+    // Nothing changed
+    runFrame(tileMap, cascadeHashes, draws);
+    if (tileMap.getNumDirtyTiles() != 0)
+      throw DxvkError("tiles are dirty although nothing changed");
+    tileMap.endFrame();
+
+    // A changed draw dirties the tiles it covers, a frame later
+    draws[0].hash = 101;
+    runFrame(tileMap, cascadeHashes, draws);
+    if (tileMap.getNumDirtyTiles() != 0)
+      throw DxvkError("changed draw dirtied tiles in the same frame");
+    tileMap.endFrame();
+
+    runFrame(tileMap, cascadeHashes, draws);
+    checkDirty(tileMap, 0, draws[0].rect, "changed draw");
+    checkDirty(tileMap, 1, TileRect(), "changed draw");
+    tileMap.endFrame();
+
+    // Up to date again after the rebake
+    runFrame(tileMap, cascadeHashes, draws);
+    if (tileMap.getNumDirtyTiles() != 0)
+      throw DxvkError("rebaked tiles are still dirty");
+    tileMap.endFrame();
+
+    // Blending is order dependent, so swapping overlapping draws dirties their overlap only
+    std::swap(draws[0], draws[1]);
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    runFrame(tileMap, cascadeHashes, draws);
+    checkDirty(tileMap, 0, { 2, 2, 4, 4 }, "swapped draws");
+    tileMap.endFrame();
+
+    // A moved draw dirties the tiles it left and entered, but not the ones it still covers
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    draws[2].rect = { 0, 0, 4, 8 };
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    runFrame(tileMap, cascadeHashes, draws);
+    checkDirty(tileMap, 1, { 4, 0, 8, 8 }, "moved draw");
+    tileMap.endFrame();
+
+    // A removed draw dirties the tiles it covered
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    const Draw removed = draws[2];
+    draws.pop_back();
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    runFrame(tileMap, cascadeHashes, draws);
+    checkDirty(tileMap, 1, removed.rect, "removed draw");
+    tileMap.endFrame();
+
+    // Changed baking parameters dirty their cascade right away
+    runFrame(tileMap, cascadeHashes, draws);
+    tileMap.endFrame();
+    cascadeHashes[2] = 4;
+    runFrame(tileMap, cascadeHashes, draws);
+    if (countDirtyTiles(tileMap, 0) != 0 || countDirtyTiles(tileMap, 1) != 0 ||
+        countDirtyTiles(tileMap, 2) != kTilesPerSide * kTilesPerSide)
+      throw DxvkError("changed cascade parameters do not dirty exactly their cascade");
+    tileMap.endFrame();
+
+    // Forced rebakes apply right away, invalidation applies to the next frame
+    runFrame(tileMap, cascadeHashes, draws, true);
+    if (tileMap.getNumDirtyTiles() != tileMap.getNumTiles())
+      throw DxvkError("forced rebake does not dirty all tiles");
+    tileMap.invalidate();
+    tileMap.endFrame();
+
+    runFrame(tileMap, cascadeHashes, draws);
+    if (tileMap.getNumDirtyTiles() != tileMap.getNumTiles())
+      throw DxvkError("invalidation does not dirty all tiles in the next frame");
+    tileMap.endFrame();
+
+    // A different layout is rebaked entirely
+    tileMap.beginFrame(kNumCascades, kTilesPerSide / 2, cascadeHashes, false);
+    if (tileMap.getNumDirtyTiles() != tileMap.getNumTiles() || tileMap.getNumTiles() != kNumCascades * kTilesPerSide * kTilesPerSide / 4)
+      throw DxvkError("changed layout does not dirty all tiles");
+    tileMap.endFrame();
+  }
+
+  // Mutates a synthetic draw set at random over many frames and checks the tile map against a model
+  // which records the exact sequence of draws every tile was last baked with. A tile must be dirty
+  // exactly when the previous frame's sequence of draws covering it differs from that one.
+  void testSyntheticDrawSets() {
+    using Sequence = std::vector<XXH64_hash_t>;
+
+    constexpr uint32_t kNumFrames = 500;
+    constexpr size_t kNumTiles = kNumCascades * kTilesPerSide * kTilesPerSide;
+
+    std::mt19937 rng(7);
+    auto randomRect = [&]() {
+      const uint32_t beginX = rng() % kTilesPerSide;
+      const uint32_t beginY = rng() % kTilesPerSide;
+      return TileRect { beginX, beginY, beginX + 1 + rng() % (kTilesPerSide - beginX), beginY + 1 + rng() % (kTilesPerSide - beginY) };
+    };
+    auto randomDraw = [&]() {
+      return Draw { static_cast<uint32_t>(rng() % kNumCascades), randomRect(), static_cast<XXH64_hash_t>(rng()) };
+    };
+
+    std::vector<Draw> draws;
+    for (uint32_t i = 0; i < 32; i++) {
+      draws.push_back(randomDraw());
+    }
+
+    const XXH64_hash_t cascadeHashes[kNumCascades] = { 1, 2, 3 };
+    std::vector<Sequence> bakedSequences(kNumTiles);
+    std::vector<Sequence> previousSequences(kNumTiles);
+    uint64_t numRebakedTiles = 0;
+
+    TerrainTileMap tileMap;
+    for (uint32_t frame = 0; frame < kNumFrames; frame++) {
+      // Leave every third frame unchanged and change a few draws in the others
+      if (frame % 3 != 0) {
+        const uint32_t numChanges = 1 + rng() % 3;
+        for (uint32_t i = 0; i < numChanges; i++) {
+          const size_t index = rng() % draws.size();
+          switch (rng() % 5) {
+          case 0: draws[index].hash = rng(); break;
+          case 1: draws[index].rect = randomRect(); break;
+          case 2: draws.erase(draws.begin() + index); break;
+          case 3: draws.insert(draws.begin() + index, randomDraw()); break;
+          case 4: std::swap(draws[index], draws[rng() % draws.size()]); break;
+          }
+        }
+
+        if (draws.empty()) {
+          draws.push_back(randomDraw());
+        }
+      }
+
+      runFrame(tileMap, cascadeHashes, draws);
+
+      for (uint32_t cascade = 0; cascade < kNumCascades; cascade++) {
+        for (uint32_t y = 0; y < kTilesPerSide; y++) {
+          for (uint32_t x = 0; x < kTilesPerSide; x++) {
+            const size_t tile = (cascade * kTilesPerSide + y) * kTilesPerSide + x;
+
+            Sequence sequence;
+            for (const Draw& draw : draws) {
+              if (draw.cascade == cascade && overlaps(draw.rect, x, y)) {
+                sequence.push_back(draw.hash);
+              }
+            }
+
+            const bool expectDirty = frame == 0 || bakedSequences[tile] != previousSequences[tile];
+            if (tileMap.isDirty(cascade, x, y) != expectDirty)
+              throw DxvkError(str::format("unexpected dirty state of tile ", x, ", ", y, " of cascade ", cascade, " in frame ", frame));
+
+            if (expectDirty) {
+              bakedSequences[tile] = sequence;
+              numRebakedTiles++;
+            }
+
+            previousSequences[tile] = std::move(sequence);
+          }
+        }
+      }
+
+      tileMap.endFrame();
+    }
+
+    // The few changes per frame should leave most tiles untouched
+    if (numRebakedTiles > kNumTiles * kNumFrames / 2)
+      throw DxvkError(str::format("rebaked ", numRebakedTiles, " tiles, incremental baking is not effective"));
+  }
+
+  void run() {
+    testTileRect();
+    testDirtyTiles();
+    testSyntheticDrawSets();
+  }
+}
+
+int main() {
+  try {
+    test_terrain_tile_map::run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Writes a synthetic mod of light replacements to disk and loads it through the real UsdMod. Checks that
+// the load runs in the background, i.e. the mod stays in the Loading state with nothing merged while the
+// render thread keeps polling checkForChanges, and that every replacement is available once it finished.
+// Light replacements need neither a device nor a context. Mesh and material replacements are not covered,
+// since creating their buffers and loading their textures need a device.
+//
+// Usage: test_usd_mod_loading [numReplacements]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/dxvk_context.h"
+#include "../../../src/dxvk/rtx_render/rtx_mod_usd.h"
+
+#include "../../../src/lssusd/usd_include_begin.h"
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/xformable.h>
+#include <pxr/usd/usdLux/sphereLight.h>
+#include "../../../src/lssusd/usd_include_end.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_usd_mod_loading.log");
+}
+
+namespace test_usd_mod_loading {
+  using namespace dxvk;
+
+  XXH64_hash_t getLightHash(uint32_t index) {
+    return 0x1000 + index;
+  }
+
+  void writeMod(const std::filesystem::path& modPath, uint32_t numReplacements) {
+    pxr::UsdStageRefPtr stage = pxr::UsdStage::CreateNew(modPath.string());
+    if (!stage) {
+      throw DxvkError(str::format("Failed to create the mod stage ", modPath.string()));
+    }
+
+    for (uint32_t i = 0; i < numReplacements; i++) {
+      char pathString[64];
+      snprintf(pathString, sizeof(pathString), "/RootNode/lights/light_%016llX", static_cast<unsigned long long>(getLightHash(i)));
+      pxr::UsdLuxSphereLight light = pxr::UsdLuxSphereLight::Define(stage, pxr::SdfPath(pathString));
+      light.CreateRadiusAttr().Set(1.f + float(i % 8));
+      light.CreateIntensityAttr().Set(100.f);
+      pxr::UsdGeomXformable(light.GetPrim()).AddTranslateOp().Set(pxr::GfVec3d(double(i), 0.0, 0.0));
+    }
+
+    stage->GetRootLayer()->Save();
+  }
+
+  void run(uint32_t numReplacements) {
+    const std::filesystem::path modDirectory = std::filesystem::temp_directory_path() / "test_usd_mod_loading";
+    std::filesystem::create_directories(modDirectory);
+    const std::filesystem::path modPath = modDirectory / "mod.usda";
+    writeMod(modPath, numReplacements);
+
+    std::unique_ptr<Mod> mod = UsdMod::getTypeInfo().construct(modPath);
+
+    using Clock = std::chrono::high_resolution_clock;
+    const auto start = Clock::now();
+
+    mod->load(nullptr);
+    const double loadCallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    if (mod->state() != Mod::State::Loading) {
+      throw DxvkError("Mod is not loading after load() returned");
+    }
+
+    // Poll like the render thread does once per frame
+    uint32_t numPolls = 0;
+    float prevProgress = 0.f;
+    while (!mod->checkForChanges(nullptr)) {
+      if (mod->state() != Mod::State::Loading) {
+        throw DxvkError("Mod failed loading");
+      }
+
+      const float progress = mod->loadingProgress();
+      if (progress < prevProgress || progress > 1.f) {
+        throw DxvkError(str::format("Unexpected loading progress ", progress, " after ", prevProgress));
+      }
+      prevProgress = progress;
+
+      mod->replacements().publish();
+      if (mod->replacements().find<AssetReplacement::eLight>(getLightHash(0)) != nullptr) {
+        throw DxvkError("Replacements were published before loading finished");
+      }
+
+      if (Clock::now() - start > std::chrono::seconds(120)) {
+        throw DxvkError("Timed out waiting for the mod to load");
+      }
+
+      ++numPolls;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    if (mod->state() != Mod::State::Loaded) {
+      throw DxvkError("Mod is not loaded after checkForChanges finished loading");
+    }
+
+    mod->replacements().publish();
+    for (uint32_t i = 0; i < numReplacements; i++) {
+      const std::vector<AssetReplacement>* replacements = mod->replacements().find<AssetReplacement::eLight>(getLightHash(i));
+      if (replacements == nullptr || replacements->size() != 1 || (*replacements)[0].type != AssetReplacement::eLight) {
+        throw DxvkError(str::format("Light replacement ", i, " is missing after loading"));
+      }
+    }
+
+    mod->unload();
+    if (mod->state() != Mod::State::Unloaded) {
+      throw DxvkError("Mod is not unloaded");
+    }
+    mod.reset();
+
+    std::filesystem::remove_all(modDirectory);
+
+    printf("Loaded %u replacements in %.2f ms over %u polls, load() returned after %.2f ms\n",
+           numReplacements, loadMs, numPolls, loadCallMs);
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    const uint32_t numReplacements = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    test_usd_mod_loading::run(std::max(numReplacements, 1u));
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}